@@ -142,6 +142,12 @@ def if_has_ros(a, b = []):
         "//conditions:default": b,
     })
 
+def if_has_vpx(a, b = []):
+    return select({
+        "@com_github_chokobole_felicia//felicia:has_vpx": a,
+        "//conditions:default": b,
+    })
+
 def if_node_binding(a, b = []):
     return select({
         "@com_github_chokobole_felicia//felicia:node_binding": a,
@@ -175,6 +181,7 @@ def fel_zlib_deps():
 def fel_deps():
     return [
         "//felicia/core:felicia_init",
+        "//felicia/core/bag",
         "//felicia/core/communication",
         "//felicia/core/lib",
         "//felicia/core/master:bytes_constants",
@@ -12,6 +12,7 @@ load("//third_party/env:env_configure.bzl", "env_configure")
 load("//third_party/opencv:opencv_configure.bzl", "opencv_configure")
 load("//third_party/py:python_configure.bzl", "python_configure")
 load("//third_party/ros:ros_configure.bzl", "ros_configure")
+load("//third_party/vpx:vpx_configure.bzl", "vpx_configure")
 load("//toolchain/emscripten:jpeg_port_configure.bzl", "jpeg_port_configure")
 load("//tools/cc:cc_configure.bzl", "cc_configure")
 
@@ -142,6 +143,11 @@ def felicia_deps():
         actual = "@local_config_ros//:ros",
     )
 
+    native.bind(
+        name = "vpx",
+        actual = "@local_config_vpx//:vpx",
+    )
+
     native.bind(
         name = "yaml_cpp",
         actual = "@com_github_jbeder_yaml_cpp//:yaml_cpp",
@@ -156,6 +162,7 @@ def felicia_deps():
     opencv_configure(name = "local_config_opencv")
     python_configure(name = "local_config_python")
     ros_configure(name = "local_config_ros")
+    vpx_configure(name = "local_config_vpx")
 
     cc_configure(name = "cc")
 
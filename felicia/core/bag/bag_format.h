@@ -0,0 +1,74 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A bag is laid out as below. Every integer is little endian.
+//
+//   FileHeader
+//   Chunk (ChunkHeader followed by Records)
+//   ...
+//   Chunk
+//   BagIndex, which is a serialized protobuf message
+//   Footer
+//
+// Records are written in the order they arrive, and a chunk is flushed when
+// it's full. The reader finds BagIndex through Footer, and each
+// BagConnection in it indexes the records of a topic by timestamp.
+//
+// BagIndex and Footer are written only when the bag is closed. If the
+// recorder crashes before that, the reader rejects the bag. The records in
+// the flushed chunks are intact, but they can't be recovered by scanning the
+// chunks, because the topics and types of the connections they refer to are
+// known only to BagIndex.
+
+#ifndef FELICIA_CORE_BAG_BAG_FORMAT_H_
+#define FELICIA_CORE_BAG_BAG_FORMAT_H_
+
+#include <stdint.h>
+
+namespace felicia {
+namespace bag {
+
+constexpr char kFileMagic[8] = {'F', 'E', 'L', 'B', 'A', 'G', '\0', '\0'};
+constexpr uint32_t kVersion = 1;
+
+constexpr uint32_t kChunkMagic = 0x4b4e4843;  // "CHNK"
+
+enum Compression : uint32_t {
+  COMPRESSION_NONE = 0,
+};
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct ChunkHeader {
+  uint32_t magic;
+  uint32_t compression;
+  // Size of the records, which follow this.
+  uint64_t size;
+};
+
+struct RecordHeader {
+  uint32_t connection_id;
+  uint32_t size;
+  int64_t timestamp;  // in microseconds
+};
+
+struct Footer {
+  uint64_t index_offset;
+  uint64_t index_size;
+  char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 16, "FileHeader should be packed.");
+static_assert(sizeof(ChunkHeader) == 16, "ChunkHeader should be packed.");
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader should be packed.");
+static_assert(sizeof(Footer) == 24, "Footer should be packed.");
+
+}  // namespace bag
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_BAG_BAG_FORMAT_H_
\ No newline at end of file
@@ -0,0 +1,205 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/bag/bag_player_node.h"
+#include "felicia/core/bag/bag_recorder_node.h"
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/files/scoped_temp_dir.h"
+#include "third_party/chromium/base/synchronization/waitable_event.h"
+#include "third_party/chromium/base/threading/platform_thread.h"
+
+#include "felicia/core/bag/bag_reader.h"
+#include "felicia/core/bag/bag_writer.h"
+#include "felicia/core/communication/serialized_message_subscriber.h"
+#include "felicia/core/lib/error/errors.h"
+#include "felicia/core/thread/main_thread.h"
+
+namespace felicia {
+
+namespace {
+
+const char kTopic[] = "topic";
+const char kTypeName[] = "felicia.test.Message";
+
+std::string MessageAt(int i) { return "message" + std::to_string(i); }
+
+base::TimeDelta Millis(int64_t millis) {
+  return base::TimeDelta::FromMilliseconds(millis);
+}
+
+}  // namespace
+
+class BagNodeTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    MainThread::SetBackground();
+    MainThread::GetInstance().RunBackground();
+    ASSERT_TRUE(dir_.CreateUniqueTempDir());
+    path_ = dir_.GetPath().AppendASCII("test.bag");
+    settings_.period = Millis(1);
+    settings_.buffer_size = Bytes::FromBytes(512);
+  }
+
+  // Writes |num_messages| messages, which are |interval| apart.
+  void WriteBag(int num_messages, base::TimeDelta interval) {
+    BagWriter writer;
+    ASSERT_TRUE(writer.Open(path_).ok());
+    uint32_t id = writer.AddConnection(kTopic, kTypeName, TopicInfo::PROTOBUF);
+    for (int i = 0; i < num_messages; ++i) {
+      ASSERT_TRUE(writer.Write(id, interval * i, MessageAt(i)).ok());
+    }
+    ASSERT_TRUE(writer.Close().ok());
+  }
+
+  // Plays the bag at |rate| with publishers, whose queue holds only a single
+  // message, to a subscriber through TCP. Returns how long the playback took.
+  base::TimeDelta Play(double rate) {
+    base::WaitableEvent finished(
+        base::WaitableEvent::ResetPolicy::MANUAL,
+        base::WaitableEvent::InitialState::NOT_SIGNALED);
+    BagPlayerNode player(path_, settings_, rate,
+                         base::BindOnce(&base::WaitableEvent::Signal,
+                                        base::Unretained(&finished)));
+    player.OnInit();
+    EXPECT_TRUE(player.reader_.IsOpened());
+    SerializedMessageSubscriber subscriber(kTypeName);
+
+    MainThread& main_thread = MainThread::GetInstance();
+    main_thread.PostTask(
+        FROM_HERE, base::BindOnce(&BagNodeTest::Connect, base::Unretained(this),
+                                  &player, &subscriber));
+    // Waits for the subscriber to connect.
+    base::PlatformThread::Sleep(Millis(100));
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    main_thread.PostTask(FROM_HERE,
+                         base::BindOnce(&BagPlayerNode::OnRequestPublish,
+                                        base::Unretained(&player),
+                                        Status::OK()));
+    EXPECT_TRUE(finished.TimedWait(base::TimeDelta::FromSeconds(5)));
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    // Waits for the last messages to arrive.
+    base::PlatformThread::Sleep(Millis(200));
+
+    for (auto& publisher : player.publishers_) {
+      publisher->RequestUnpublishForTesting(kTopic);
+    }
+    subscriber.RequestUnsubscribeForTesting(kTopic);
+    base::PlatformThread::Sleep(Millis(100));
+    return elapsed;
+  }
+
+  void Connect(BagPlayerNode* player, SerializedMessageSubscriber* subscriber) {
+    communication::Settings publisher_settings = settings_;
+    publisher_settings.queue_size = 1;
+    for (const BagConnection& connection : player->reader_.connections()) {
+      auto publisher = std::make_unique<SerializedMessagePublisher>(
+          connection.type_name(), connection.impl_type());
+      publisher->RequestPublishForTesting(
+          connection.topic(), ChannelDef::CHANNEL_TYPE_TCP, publisher_settings);
+      player->publishers_.push_back(std::move(publisher));
+    }
+    subscriber->RequestSubscribeForTesting(
+        kTopic, ChannelDef::CHANNEL_TYPE_TCP, settings_,
+        base::BindRepeating(&BagNodeTest::OnMessage, base::Unretained(this)));
+    subscriber->OnFindPublisher(player->publishers_[0]->topic_info_);
+  }
+
+  // Instead of subscribing through the master, hands |num_messages| messages
+  // to |recorder| as the subscriber does. Returns the id of the connection.
+  uint32_t Record(BagRecorderNode* recorder, int num_messages) {
+    TopicInfo topic_info;
+    topic_info.set_topic(kTopic);
+    topic_info.set_type_name(kTypeName);
+    topic_info.set_impl_type(TopicInfo::PROTOBUF);
+    uint32_t connection_id = recorder->num_connections_++;
+    recorder->thread_.task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&BagRecorderNode::AddConnection,
+                       base::Unretained(recorder), connection_id, topic_info));
+    for (int i = 0; i < num_messages; ++i) {
+      SerializedMessage message;
+      message.set_serialized(MessageAt(i));
+      recorder->OnMessage(connection_id, std::move(message));
+    }
+    return connection_id;
+  }
+
+  void OnMessage(SerializedMessage&& message) {
+    messages_.push_back(std::move(message).serialized());
+  }
+
+  void ExpectMessages(int num_messages) {
+    ASSERT_EQ(static_cast<size_t>(num_messages), messages_.size());
+    for (int i = 0; i < num_messages; ++i) {
+      EXPECT_EQ(MessageAt(i), messages_[i]);
+    }
+  }
+
+  base::ScopedTempDir dir_;
+  base::FilePath path_;
+  communication::Settings settings_;
+  std::vector<std::string> messages_;
+};
+
+TEST_F(BagNodeTest, PlayInOrder) {
+  WriteBag(10, Millis(5));
+  Play(1);
+  ExpectMessages(10);
+}
+
+TEST_F(BagNodeTest, PlayAtRate) {
+  // The messages span 200ms, which are played in 100ms.
+  WriteBag(11, Millis(20));
+  base::TimeDelta elapsed = Play(2);
+  EXPECT_LE(Millis(100), elapsed);
+  EXPECT_GT(Millis(200), elapsed);
+  ExpectMessages(11);
+}
+
+TEST_F(BagNodeTest, PlayAsFastAsPossible) {
+  // It would take 50 seconds if it kept the intervals.
+  WriteBag(50, base::TimeDelta::FromSeconds(1));
+  base::TimeDelta elapsed = Play(0);
+  EXPECT_GT(base::TimeDelta::FromSeconds(5), elapsed);
+  // None is overwritten in the queue of the publisher.
+  ExpectMessages(50);
+}
+
+TEST_F(BagNodeTest, Record) {
+  BagRecorderNode recorder(path_, {kTopic}, settings_);
+  recorder.OnInit();
+
+  uint32_t connection_id = Record(&recorder, 10);
+
+  base::WaitableEvent closed(base::WaitableEvent::ResetPolicy::MANUAL,
+                             base::WaitableEvent::InitialState::NOT_SIGNALED);
+  Status status = errors::Unknown("Not closed.");
+  recorder.Stop(base::BindOnce(
+      [](base::WaitableEvent* closed, Status* status, Status s) {
+        *status = std::move(s);
+        closed->Signal();
+      },
+      &closed, &status));
+  ASSERT_TRUE(closed.TimedWait(base::TimeDelta::FromSeconds(5)));
+  ASSERT_TRUE(status.ok()) << status;
+
+  BagReader reader;
+  ASSERT_TRUE(reader.Open(path_).ok());
+  ASSERT_EQ(1, reader.connections().size());
+  EXPECT_EQ(kTopic, reader.GetConnection(0)->topic());
+  EXPECT_EQ(kTypeName, reader.GetConnection(0)->type_name());
+  ASSERT_EQ(10u, reader.size());
+  for (size_t i = 0; i < reader.size(); ++i) {
+    BagReader::Message message;
+    ASSERT_TRUE(reader.ReadMessage(i, &message).ok());
+    EXPECT_EQ(connection_id, message.connection_id);
+    EXPECT_EQ(MessageAt(i),
+              std::string(reinterpret_cast<const char*>(message.data->front()),
+                          message.data->size()));
+  }
+}
+
+}  // namespace felicia
\ No newline at end of file
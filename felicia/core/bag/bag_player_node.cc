@@ -0,0 +1,149 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/bag/bag_player_node.h"
+
+#include "third_party/chromium/base/bind.h"
+
+#include "felicia/core/lib/error/errors.h"
+#include "felicia/core/thread/main_thread.h"
+
+namespace felicia {
+
+namespace {
+
+// How long to wait for a full queue of a publisher to have room, when
+// playing as fast as possible.
+constexpr base::TimeDelta kQueueFullRetryDelay =
+    base::TimeDelta::FromMilliseconds(1);
+
+}  // namespace
+
+BagPlayerNode::BagPlayerNode(const base::FilePath& path,
+                             const communication::Settings& settings,
+                             double rate,
+                             base::OnceClosure on_finished_callback)
+    : path_(path),
+      settings_(settings),
+      rate_(rate),
+      on_finished_callback_(std::move(on_finished_callback)) {
+  DCHECK_GE(rate_, 0);
+}
+
+BagPlayerNode::~BagPlayerNode() = default;
+
+void BagPlayerNode::OnInit() {
+  Status s = reader_.Open(path_);
+  if (!s.ok()) OnError(s);
+}
+
+void BagPlayerNode::OnDidCreate(NodeInfo node_info) {
+  node_info_ = std::move(node_info);
+  if (!reader_.IsOpened()) return;
+  if (reader_.connections().empty()) {
+    if (!on_finished_callback_.is_null())
+      std::move(on_finished_callback_).Run();
+    return;
+  }
+
+  for (const BagConnection& connection : reader_.connections()) {
+    auto publisher = std::make_unique<SerializedMessagePublisher>(
+        connection.type_name(), connection.impl_type());
+    publisher->RequestPublish(
+        node_info_, connection.topic(), AllChannelTypes(), settings_,
+        base::BindOnce(&BagPlayerNode::OnRequestPublish,
+                       base::Unretained(this)));
+    publishers_.push_back(std::move(publisher));
+  }
+}
+
+void BagPlayerNode::OnError(Status s) { LOG(ERROR) << s; }
+
+void BagPlayerNode::OnRequestPublish(Status s) {
+  if (!s.ok()) {
+    OnError(s);
+    return;
+  }
+  if (++num_publish_requests_ < publishers_.size()) return;
+
+  next_index_ = reader_.LowerBound(reader_.start_timestamp() + start_offset_);
+  if (next_index_ < reader_.size()) {
+    BagReader::Message message;
+    Status s = reader_.ReadMessage(next_index_, &message);
+    if (!s.ok()) {
+      OnError(s);
+      return;
+    }
+    first_timestamp_ = message.timestamp;
+  }
+  start_time_ = base::TimeTicks::Now();
+  Play();
+}
+
+void BagPlayerNode::Play() {
+  if (stopped_) return;
+
+  MainThread& main_thread = MainThread::GetInstance();
+  while (next_index_ < reader_.size()) {
+    BagReader::Message message;
+    Status s = reader_.ReadMessage(next_index_, &message);
+    if (!s.ok()) {
+      OnError(s);
+      return;
+    }
+
+    if (rate_ > 0) {
+      base::TimeTicks due =
+          start_time_ + (message.timestamp - first_timestamp_) / rate_;
+      base::TimeDelta delay = due - base::TimeTicks::Now();
+      if (delay > base::TimeDelta()) {
+        main_thread.PostDelayedTask(
+            FROM_HERE,
+            base::BindOnce(&BagPlayerNode::Play, base::Unretained(this)),
+            delay);
+        return;
+      }
+    }
+
+    SerializedMessagePublisher* publisher =
+        publishers_[message.connection_id].get();
+    if (rate_ == 0 && publisher->IsQueueFull()) {
+      // Publishing now would overwrite the message that isn't sent yet.
+      main_thread.PostDelayedTask(
+          FROM_HERE,
+          base::BindOnce(&BagPlayerNode::Play, base::Unretained(this)),
+          kQueueFullRetryDelay);
+      return;
+    }
+
+    publisher->PublishFromSerialized(std::move(message.data));
+    ++next_index_;
+
+    if (rate_ == 0) {
+      // Yields to the other tasks, for instance, sending the message.
+      main_thread.PostTask(FROM_HERE, base::BindOnce(&BagPlayerNode::Play,
+                                                     base::Unretained(this)));
+      return;
+    }
+  }
+
+  if (!on_finished_callback_.is_null()) std::move(on_finished_callback_).Run();
+}
+
+void BagPlayerNode::Stop() {
+  MainThread& main_thread = MainThread::GetInstance();
+  if (!main_thread.IsBoundToCurrentThread()) {
+    main_thread.PostTask(FROM_HERE, base::BindOnce(&BagPlayerNode::Stop,
+                                                   base::Unretained(this)));
+    return;
+  }
+
+  stopped_ = true;
+  for (size_t i = 0; i < publishers_.size(); ++i) {
+    publishers_[i]->RequestUnpublish(node_info_,
+                                     reader_.connections().Get(i).topic());
+  }
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,81 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_BAG_BAG_PLAYER_NODE_H_
+#define FELICIA_CORE_BAG_BAG_PLAYER_NODE_H_
+
+#include <memory>
+#include <vector>
+
+#include "third_party/chromium/base/callback.h"
+#include "third_party/chromium/base/files/file_path.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/bag/bag_reader.h"
+#include "felicia/core/communication/serialized_message_publisher.h"
+#include "felicia/core/communication/settings.h"
+#include "felicia/core/lib/base/export.h"
+#include "felicia/core/node/node_lifecycle.h"
+
+namespace felicia {
+
+// Publishes every topic recorded in a bag at |path|, keeping the intervals
+// between the messages. The messages are published straight from the mapped
+// file without being copied or parsed.
+//
+// |rate| scales the speed of the playback, e.g, 2 plays twice as fast as it
+// was recorded. If |rate| is 0, the messages are published as fast as
+// they are sent, which is useful for benchmarks. None of them is dropped,
+// since the playback waits whenever a queue of the publishers is full. So the
+// subscribers should connect before it starts, or it waits for them forever.
+class FEL_EXPORT BagPlayerNode : public NodeLifecycle {
+ public:
+  BagPlayerNode(const base::FilePath& path,
+                const communication::Settings& settings, double rate = 1,
+                base::OnceClosure on_finished_callback = base::OnceClosure());
+  ~BagPlayerNode();
+
+  void OnInit() override;
+
+  void OnDidCreate(NodeInfo node_info) override;
+
+  void OnError(Status s) override;
+
+  // Plays from the first message at or after |offset| from the beginning of
+  // the bag. It must be called before the playback starts.
+  void set_start_offset(base::TimeDelta offset) { start_offset_ = offset; }
+
+  // Stops the playback and unpublishes every topic.
+  void Stop();
+
+ private:
+  friend class BagNodeTest;
+
+  void OnRequestPublish(Status s);
+
+  void Play();
+
+  base::FilePath path_;
+  communication::Settings settings_;
+  double rate_;
+  base::OnceClosure on_finished_callback_;
+  base::TimeDelta start_offset_;
+  NodeInfo node_info_;
+
+  BagReader reader_;
+  // Indexed by connection id.
+  std::vector<std::unique_ptr<SerializedMessagePublisher>> publishers_;
+  size_t num_publish_requests_ = 0;
+
+  bool stopped_ = false;
+  size_t next_index_ = 0;
+  base::TimeDelta first_timestamp_;
+  base::TimeTicks start_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(BagPlayerNode);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_BAG_BAG_PLAYER_NODE_H_
\ No newline at end of file
@@ -0,0 +1,192 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/bag/bag_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "third_party/chromium/base/files/memory_mapped_file.h"
+#include "third_party/chromium/base/strings/strcat.h"
+
+#include "felicia/core/bag/bag_format.h"
+#include "felicia/core/lib/error/errors.h"
+
+namespace felicia {
+
+class BagReader::MappedBag : public base::RefCountedThreadSafe<MappedBag> {
+ public:
+  MappedBag() = default;
+
+  base::MemoryMappedFile& file() { return file_; }
+  const uint8_t* data() const { return file_.data(); }
+  size_t length() const { return file_.length(); }
+
+ private:
+  friend class base::RefCountedThreadSafe<MappedBag>;
+  ~MappedBag() = default;
+
+  base::MemoryMappedFile file_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedBag);
+};
+
+// A message in the mapped bag. It keeps the mapping alive.
+class BagReader::MappedRecord : public base::RefCountedMemory {
+ public:
+  MappedRecord(scoped_refptr<MappedBag> mapped_bag, const uint8_t* data,
+               size_t size)
+      : mapped_bag_(std::move(mapped_bag)), data_(data), size_(size) {}
+
+  // base::RefCountedMemory methods
+  const unsigned char* front() const override { return data_; }
+  size_t size() const override { return size_; }
+
+ private:
+  ~MappedRecord() override = default;
+
+  scoped_refptr<MappedBag> mapped_bag_;
+  const uint8_t* data_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedRecord);
+};
+
+BagReader::BagReader() = default;
+
+BagReader::~BagReader() = default;
+
+Status BagReader::Open(const base::FilePath& path) {
+  mapped_bag_ = nullptr;
+  index_.Clear();
+  entries_.clear();
+
+  scoped_refptr<MappedBag> mapped_bag = base::MakeRefCounted<MappedBag>();
+  if (!mapped_bag->file().Initialize(path)) {
+    return errors::InvalidArgument(
+        base::StrCat({"Failed to map ", path.AsUTF8Unsafe()}));
+  }
+  mapped_bag_ = std::move(mapped_bag);
+
+  Status s = ReadIndex();
+  if (!s.ok()) {
+    mapped_bag_ = nullptr;
+    index_.Clear();
+    entries_.clear();
+  }
+  return s;
+}
+
+Status BagReader::ReadIndex() {
+  const uint8_t* data = mapped_bag_->data();
+  size_t length = mapped_bag_->length();
+  if (length < sizeof(bag::FileHeader) + sizeof(bag::Footer))
+    return errors::DataLoss("Bag is too short.");
+
+  bag::FileHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, bag::kFileMagic, sizeof(header.magic)) != 0)
+    return errors::DataLoss("Not a bag.");
+  if (header.version != bag::kVersion)
+    return errors::Unimplemented(base::StrCat(
+        {"Unsupported bag version: ", std::to_string(header.version)}));
+
+  bag::Footer footer;
+  memcpy(&footer, data + length - sizeof(footer), sizeof(footer));
+  if (memcmp(footer.magic, bag::kFileMagic, sizeof(footer.magic)) != 0)
+    return errors::DataLoss("Bag wasn't closed properly.");
+  if (footer.index_offset < sizeof(header) ||
+      footer.index_offset > length - sizeof(footer) ||
+      footer.index_size > length - sizeof(footer) - footer.index_offset)
+    return errors::DataLoss("Index is out of range.");
+  if (!index_.ParseFromArray(data + footer.index_offset, footer.index_size))
+    return errors::DataLoss("Failed to parse index.");
+
+  for (const BagChunkInfo& chunk_info : index_.chunks()) {
+    if (chunk_info.offset() + sizeof(bag::ChunkHeader) > footer.index_offset)
+      return errors::DataLoss("Chunk is out of range.");
+    bag::ChunkHeader chunk_header;
+    memcpy(&chunk_header, data + chunk_info.offset(), sizeof(chunk_header));
+    if (chunk_header.magic != bag::kChunkMagic)
+      return errors::DataLoss("Chunk is corrupted.");
+    if (chunk_header.compression != bag::COMPRESSION_NONE)
+      return errors::Unimplemented("Compressed chunks aren't supported.");
+  }
+
+  size_t size = 0;
+  for (int i = 0; i < index_.connections_size(); ++i) {
+    const BagConnection& connection = index_.connections(i);
+    if (connection.id() != static_cast<uint32_t>(i) ||
+        connection.timestamps_size() != connection.offsets_size())
+      return errors::DataLoss("Connection is corrupted.");
+    size += connection.timestamps_size();
+  }
+
+  entries_.reserve(size);
+  for (const BagConnection& connection : index_.connections()) {
+    for (int i = 0; i < connection.timestamps_size(); ++i) {
+      entries_.push_back(
+          {connection.timestamps(i), connection.offsets(i), connection.id()});
+    }
+  }
+  // Keeps the order of the connections for the messages with the same
+  // timestamp.
+  std::stable_sort(entries_.begin(), entries_.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return a.timestamp < b.timestamp;
+                   });
+  return Status::OK();
+}
+
+const BagConnection* BagReader::GetConnection(uint32_t connection_id) const {
+  if (connection_id >= static_cast<uint32_t>(index_.connections_size()))
+    return nullptr;
+  return &index_.connections(connection_id);
+}
+
+base::TimeDelta BagReader::start_timestamp() const {
+  if (entries_.empty()) return base::TimeDelta();
+  return base::TimeDelta::FromMicroseconds(entries_.front().timestamp);
+}
+
+base::TimeDelta BagReader::end_timestamp() const {
+  if (entries_.empty()) return base::TimeDelta();
+  return base::TimeDelta::FromMicroseconds(entries_.back().timestamp);
+}
+
+size_t BagReader::LowerBound(base::TimeDelta timestamp) const {
+  int64_t timestamp_us = timestamp.InMicroseconds();
+  auto it = std::lower_bound(entries_.begin(), entries_.end(), timestamp_us,
+                             [](const Entry& entry, int64_t timestamp) {
+                               return entry.timestamp < timestamp;
+                             });
+  return static_cast<size_t>(it - entries_.begin());
+}
+
+Status BagReader::ReadMessage(size_t index, Message* message) const {
+  if (index >= entries_.size())
+    return errors::OutOfRange("Index is out of range.");
+
+  const Entry& entry = entries_[index];
+  size_t length = mapped_bag_->length();
+  if (entry.offset + sizeof(bag::RecordHeader) > length)
+    return errors::DataLoss("Record is out of range.");
+
+  const uint8_t* record = mapped_bag_->data() + entry.offset;
+  bag::RecordHeader header;
+  memcpy(&header, record, sizeof(header));
+  if (header.connection_id != entry.connection_id ||
+      header.timestamp != entry.timestamp ||
+      header.size > length - entry.offset - sizeof(header))
+    return errors::DataLoss("Record is corrupted.");
+
+  message->connection_id = header.connection_id;
+  message->timestamp = base::TimeDelta::FromMicroseconds(header.timestamp);
+  message->data = base::MakeRefCounted<MappedRecord>(
+      mapped_bag_, record + sizeof(header), header.size);
+  return Status::OK();
+}
+
+}  // namespace felicia
\ No newline at end of file
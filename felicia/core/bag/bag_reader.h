@@ -0,0 +1,86 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_BAG_BAG_READER_H_
+#define FELICIA_CORE_BAG_BAG_READER_H_
+
+#include <vector>
+
+#include "third_party/chromium/base/files/file_path.h"
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/memory/ref_counted.h"
+#include "third_party/chromium/base/memory/ref_counted_memory.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/lib/base/export.h"
+#include "felicia/core/lib/error/status.h"
+#include "felicia/core/protobuf/bag.pb.h"
+
+namespace felicia {
+
+// Reads a bag written by BagWriter. The file is memory mapped, and the
+// messages are handed out as views into the mapping, which stays alive as
+// long as any of them does. So they can be published without being copied.
+//
+//   BagReader reader;
+//   Status s = reader.Open(path);
+//   for (size_t i = reader.LowerBound(start); i < reader.size(); ++i) {
+//     BagReader::Message message;
+//     s = reader.ReadMessage(i, &message);
+//     ...
+//   }
+class FEL_EXPORT BagReader {
+ public:
+  struct Message {
+    uint32_t connection_id;
+    base::TimeDelta timestamp;
+    scoped_refptr<base::RefCountedMemory> data;
+  };
+
+  BagReader();
+  ~BagReader();
+
+  Status Open(const base::FilePath& path);
+
+  bool IsOpened() const { return !!mapped_bag_; }
+
+  const google::protobuf::RepeatedPtrField<BagConnection>& connections() const {
+    return index_.connections();
+  }
+  const BagConnection* GetConnection(uint32_t connection_id) const;
+
+  // The number of messages of all the connections.
+  size_t size() const { return entries_.size(); }
+
+  base::TimeDelta start_timestamp() const;
+  base::TimeDelta end_timestamp() const;
+
+  // Returns the index of the first message whose timestamp is not less than
+  // |timestamp|. Messages are ordered by timestamp across the connections.
+  size_t LowerBound(base::TimeDelta timestamp) const;
+
+  Status ReadMessage(size_t index, Message* message) const;
+
+ private:
+  class MappedBag;
+  class MappedRecord;
+
+  struct Entry {
+    int64_t timestamp;
+    uint64_t offset;
+    uint32_t connection_id;
+  };
+
+  Status ReadIndex();
+
+  scoped_refptr<MappedBag> mapped_bag_;
+  BagIndex index_;
+  std::vector<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(BagReader);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_BAG_BAG_READER_H_
\ No newline at end of file
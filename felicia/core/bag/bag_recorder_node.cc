@@ -0,0 +1,158 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/bag/bag_recorder_node.h"
+
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/strings/strcat.h"
+
+#include "felicia/core/lib/error/errors.h"
+#include "felicia/core/master/master_proxy.h"
+#include "felicia/core/thread/main_thread.h"
+
+namespace felicia {
+
+BagRecorderNode::BagRecorderNode(const base::FilePath& path,
+                                 const std::vector<std::string>& topics,
+                                 const communication::Settings& settings)
+    : path_(path),
+      topics_(topics),
+      settings_(settings),
+      thread_("BagRecorderThread") {}
+
+BagRecorderNode::~BagRecorderNode() = default;
+
+void BagRecorderNode::OnInit() {
+  thread_.Start();
+  thread_.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&BagRecorderNode::OpenBag, base::Unretained(this)));
+}
+
+void BagRecorderNode::OnDidCreate(NodeInfo node_info) {
+  node_info_ = std::move(node_info);
+
+  MasterProxy& master_proxy = MasterProxy::GetInstance();
+  for (const std::string& topic : topics_) {
+    ListTopicsRequest* request = new ListTopicsRequest();
+    request->mutable_topic_filter()->set_topic(topic);
+    ListTopicsResponse* response = new ListTopicsResponse();
+    master_proxy.ListTopicsAsync(
+        request, response,
+        base::BindOnce(&BagRecorderNode::OnListTopicsAsync,
+                       base::Unretained(this), base::Owned(request),
+                       base::Owned(response)));
+  }
+}
+
+void BagRecorderNode::OnError(Status s) { LOG(ERROR) << s; }
+
+void BagRecorderNode::OnListTopicsAsync(const ListTopicsRequest* request,
+                                        ListTopicsResponse* response,
+                                        Status s) {
+  const std::string& topic = request->topic_filter().topic();
+  if (s.ok() && response->topic_infos_size() == 0) {
+    s = errors::NotFound(base::StrCat({"No publisher for ", topic}));
+  }
+  if (!s.ok()) {
+    OnError(s);
+    return;
+  }
+
+  MainThread& main_thread = MainThread::GetInstance();
+  main_thread.PostTask(
+      FROM_HERE, base::BindOnce(&BagRecorderNode::Subscribe,
+                                base::Unretained(this),
+                                response->topic_infos(0)));
+}
+
+void BagRecorderNode::Subscribe(const TopicInfo& topic_info) {
+  const std::string& topic = topic_info.topic();
+  if (subscribers_.find(topic) != subscribers_.end()) return;
+
+  uint32_t connection_id = num_connections_++;
+  thread_.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&BagRecorderNode::AddConnection, base::Unretained(this),
+                     connection_id, topic_info));
+
+  auto subscriber = std::make_unique<SerializedMessageSubscriber>(
+      topic_info.type_name(), topic_info.impl_type());
+  subscriber->RequestSubscribe(
+      node_info_, topic, AllChannelTypes(), settings_,
+      base::BindRepeating(&BagRecorderNode::OnMessage, base::Unretained(this),
+                          connection_id),
+      base::BindRepeating(&BagRecorderNode::OnError, base::Unretained(this)),
+      base::BindOnce([](Status s) { LOG_IF(ERROR, !s.ok()) << s; }));
+  subscribers_[topic] = std::move(subscriber);
+}
+
+void BagRecorderNode::OnMessage(uint32_t connection_id,
+                                SerializedMessage&& message) {
+  base::TimeDelta timestamp = base::Time::Now() - base::Time::UnixEpoch();
+  thread_.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&BagRecorderNode::WriteMessage, base::Unretained(this),
+                     connection_id, timestamp, std::move(message)));
+}
+
+void BagRecorderNode::Stop(StatusOnceCallback callback) {
+  MainThread& main_thread = MainThread::GetInstance();
+  if (!main_thread.IsBoundToCurrentThread()) {
+    main_thread.PostTask(
+        FROM_HERE, base::BindOnce(&BagRecorderNode::Stop,
+                                  base::Unretained(this), std::move(callback)));
+    return;
+  }
+
+  for (auto& it : subscribers_) {
+    it.second->RequestUnsubscribe(node_info_, it.first);
+  }
+
+  if (!thread_.IsRunning()) {
+    if (!callback.is_null()) {
+      std::move(callback).Run(errors::Unavailable("Bag is not opened."));
+    }
+    return;
+  }
+  thread_.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&BagRecorderNode::CloseBag,
+                                base::Unretained(this), std::move(callback)));
+}
+
+void BagRecorderNode::OpenBag() {
+  Status s = writer_.Open(path_);
+  if (!s.ok()) {
+    MainThread::GetInstance().PostTask(
+        FROM_HERE, base::BindOnce(&BagRecorderNode::OnError,
+                                  base::Unretained(this), std::move(s)));
+  }
+}
+
+void BagRecorderNode::AddConnection(uint32_t connection_id,
+                                    const TopicInfo& topic_info) {
+  uint32_t id = writer_.AddConnection(
+      topic_info.topic(), topic_info.type_name(), topic_info.impl_type());
+  DCHECK_EQ(connection_id, id);
+}
+
+void BagRecorderNode::WriteMessage(uint32_t connection_id,
+                                   base::TimeDelta timestamp,
+                                   SerializedMessage message) {
+  if (!writer_.IsOpened()) return;
+
+  Status s = writer_.Write(connection_id, timestamp, message.serialized());
+  LOG_IF(ERROR, !s.ok()) << s;
+}
+
+void BagRecorderNode::CloseBag(StatusOnceCallback callback) {
+  Status s = writer_.IsOpened() ? writer_.Close()
+                                : errors::Unavailable("Bag is not opened.");
+  if (!callback.is_null()) {
+    MainThread::GetInstance().PostTask(
+        FROM_HERE, base::BindOnce(std::move(callback), std::move(s)));
+  }
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,82 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_BAG_BAG_RECORDER_NODE_H_
+#define FELICIA_CORE_BAG_BAG_RECORDER_NODE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "third_party/chromium/base/containers/flat_map.h"
+#include "third_party/chromium/base/files/file_path.h"
+#include "third_party/chromium/base/threading/thread.h"
+
+#include "felicia/core/bag/bag_writer.h"
+#include "felicia/core/communication/serialized_message_subscriber.h"
+#include "felicia/core/communication/settings.h"
+#include "felicia/core/lib/base/export.h"
+#include "felicia/core/node/node_lifecycle.h"
+#include "felicia/core/protobuf/master.pb.h"
+
+namespace felicia {
+
+// Subscribes to |topics| without deserializing the messages and records them
+// to a bag at |path|. The messages are timestamped when they are received,
+// and written to the file on a dedicated thread, so that a slow disk doesn't
+// hold up the main thread.
+class FEL_EXPORT BagRecorderNode : public NodeLifecycle {
+ public:
+  BagRecorderNode(const base::FilePath& path,
+                  const std::vector<std::string>& topics,
+                  const communication::Settings& settings);
+  ~BagRecorderNode();
+
+  void OnInit() override;
+
+  void OnDidCreate(NodeInfo node_info) override;
+
+  void OnError(Status s) override;
+
+  // Unsubscribes from every topic and closes the bag. |callback| is called
+  // with the result of closing the bag.
+  void Stop(StatusOnceCallback callback = StatusOnceCallback());
+
+ private:
+  friend class BagNodeTest;
+
+  void OnListTopicsAsync(const ListTopicsRequest* request,
+                         ListTopicsResponse* response, Status s);
+
+  void Subscribe(const TopicInfo& topic_info);
+
+  void OnMessage(uint32_t connection_id, SerializedMessage&& message);
+
+  // Runs on |thread_|.
+  void OpenBag();
+  void AddConnection(uint32_t connection_id, const TopicInfo& topic_info);
+  void WriteMessage(uint32_t connection_id, base::TimeDelta timestamp,
+                    SerializedMessage message);
+  void CloseBag(StatusOnceCallback callback);
+
+  base::FilePath path_;
+  std::vector<std::string> topics_;
+  communication::Settings settings_;
+  NodeInfo node_info_;
+
+  base::flat_map<std::string, std::unique_ptr<SerializedMessageSubscriber>>
+      subscribers_;
+  uint32_t num_connections_ = 0;
+
+  // Used only on |thread_|. It's declared before |thread_|, so that it's
+  // destroyed after |thread_| is joined.
+  BagWriter writer_;
+  base::Thread thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(BagRecorderNode);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_BAG_BAG_RECORDER_NODE_H_
\ No newline at end of file
@@ -0,0 +1,138 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/bag/bag_reader.h"
+#include "felicia/core/bag/bag_writer.h"
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/files/file_util.h"
+#include "third_party/chromium/base/files/scoped_temp_dir.h"
+
+namespace felicia {
+
+namespace {
+
+base::TimeDelta Micros(int64_t micros) {
+  return base::TimeDelta::FromMicroseconds(micros);
+}
+
+std::string ToString(const BagReader::Message& message) {
+  return std::string(reinterpret_cast<const char*>(message.data->front()),
+                     message.data->size());
+}
+
+}  // namespace
+
+class BagTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(dir_.CreateUniqueTempDir());
+    path_ = dir_.GetPath().AppendASCII("test.bag");
+  }
+
+  base::ScopedTempDir dir_;
+  base::FilePath path_;
+};
+
+TEST_F(BagTest, WriteAndRead) {
+  BagWriter writer;
+  // Flushes a chunk every few messages.
+  writer.set_chunk_size(64);
+  ASSERT_TRUE(writer.Open(path_).ok());
+  uint32_t imu = writer.AddConnection("imu", "felicia.ImuFrameMessage",
+                                      TopicInfo::PROTOBUF);
+  uint32_t camera = writer.AddConnection(
+      "camera", "felicia.drivers.CameraFrameMessage", TopicInfo::PROTOBUF);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(
+        writer.Write(imu, Micros(i * 10), "imu" + std::to_string(i)).ok());
+    if (i % 2 == 0) {
+      ASSERT_TRUE(writer
+                      .Write(camera, Micros(i * 10 + 5),
+                             "camera" + std::to_string(i))
+                      .ok());
+    }
+  }
+  // Comes late.
+  ASSERT_TRUE(writer.Write(camera, Micros(1), "late").ok());
+  EXPECT_FALSE(writer.Write(2, Micros(0), "unknown").ok());
+  ASSERT_TRUE(writer.Close().ok());
+
+  BagReader reader;
+  ASSERT_TRUE(reader.Open(path_).ok());
+  ASSERT_EQ(2, reader.connections().size());
+  EXPECT_EQ("imu", reader.GetConnection(imu)->topic());
+  EXPECT_EQ("camera", reader.GetConnection(camera)->topic());
+  EXPECT_EQ("felicia.drivers.CameraFrameMessage",
+            reader.GetConnection(camera)->type_name());
+  EXPECT_EQ(nullptr, reader.GetConnection(2));
+  ASSERT_EQ(16u, reader.size());
+  EXPECT_EQ(Micros(0), reader.start_timestamp());
+  EXPECT_EQ(Micros(90), reader.end_timestamp());
+
+  base::TimeDelta last;
+  for (size_t i = 0; i < reader.size(); ++i) {
+    BagReader::Message message;
+    ASSERT_TRUE(reader.ReadMessage(i, &message).ok());
+    EXPECT_LE(last, message.timestamp);
+    last = message.timestamp;
+  }
+
+  BagReader::Message message;
+  ASSERT_TRUE(reader.ReadMessage(1, &message).ok());
+  EXPECT_EQ(camera, message.connection_id);
+  EXPECT_EQ(Micros(1), message.timestamp);
+  EXPECT_EQ("late", ToString(message));
+  EXPECT_FALSE(reader.ReadMessage(reader.size(), &message).ok());
+
+  size_t index = reader.LowerBound(Micros(41));
+  ASSERT_TRUE(reader.ReadMessage(index, &message).ok());
+  EXPECT_EQ(camera, message.connection_id);
+  EXPECT_EQ(Micros(45), message.timestamp);
+  EXPECT_EQ("camera4", ToString(message));
+  EXPECT_EQ(reader.size(), reader.LowerBound(Micros(91)));
+}
+
+TEST_F(BagTest, MessageOutlivesReader) {
+  BagWriter writer;
+  ASSERT_TRUE(writer.Open(path_).ok());
+  uint32_t id = writer.AddConnection("topic", "type", TopicInfo::PROTOBUF);
+  ASSERT_TRUE(writer.Write(id, Micros(0), "message").ok());
+  ASSERT_TRUE(writer.Close().ok());
+
+  BagReader::Message message;
+  {
+    BagReader reader;
+    ASSERT_TRUE(reader.Open(path_).ok());
+    ASSERT_TRUE(reader.ReadMessage(0, &message).ok());
+  }
+  EXPECT_EQ("message", ToString(message));
+}
+
+TEST_F(BagTest, Corrupted) {
+  BagReader reader;
+  EXPECT_FALSE(reader.Open(path_).ok());
+
+  BagWriter writer;
+  ASSERT_TRUE(writer.Open(path_).ok());
+  uint32_t id = writer.AddConnection("topic", "type", TopicInfo::PROTOBUF);
+  ASSERT_TRUE(writer.Write(id, Micros(0), "message").ok());
+  ASSERT_TRUE(writer.Close().ok());
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(path_, &contents));
+  // Not closed.
+  std::string truncated = contents.substr(0, contents.length() - 1);
+  ASSERT_EQ(static_cast<int>(truncated.length()),
+            base::WriteFile(path_, truncated.data(), truncated.length()));
+  EXPECT_FALSE(reader.Open(path_).ok());
+  EXPECT_FALSE(reader.IsOpened());
+
+  contents[0] = 'X';
+  ASSERT_EQ(static_cast<int>(contents.length()),
+            base::WriteFile(path_, contents.data(), contents.length()));
+  EXPECT_FALSE(reader.Open(path_).ok());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,182 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/bag/bag_writer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "third_party/chromium/base/numerics/safe_conversions.h"
+
+#include "felicia/core/bag/bag_format.h"
+#include "felicia/core/lib/error/errors.h"
+
+namespace felicia {
+
+constexpr size_t BagWriter::kDefaultChunkSize;
+
+namespace {
+
+// Sorts |timestamps| and |offsets| of |connection| together by timestamp.
+// Messages of a topic mostly come in order, so this is almost always a no-op.
+void SortConnectionIndex(BagConnection* connection) {
+  auto* timestamps = connection->mutable_timestamps();
+  if (std::is_sorted(timestamps->begin(), timestamps->end())) return;
+
+  auto* offsets = connection->mutable_offsets();
+  std::vector<int> order(timestamps->size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [timestamps](int a, int b) {
+    return timestamps->Get(a) < timestamps->Get(b);
+  });
+
+  google::protobuf::RepeatedField<int64_t> sorted_timestamps;
+  google::protobuf::RepeatedField<uint64_t> sorted_offsets;
+  sorted_timestamps.Reserve(order.size());
+  sorted_offsets.Reserve(order.size());
+  for (int i : order) {
+    sorted_timestamps.Add(timestamps->Get(i));
+    sorted_offsets.Add(offsets->Get(i));
+  }
+  timestamps->Swap(&sorted_timestamps);
+  offsets->Swap(&sorted_offsets);
+}
+
+}  // namespace
+
+BagWriter::BagWriter() = default;
+
+BagWriter::~BagWriter() {
+  if (IsOpened()) {
+    Status s = Close();
+    LOG_IF(ERROR, !s.ok()) << s;
+  }
+}
+
+Status BagWriter::Open(const base::FilePath& path) {
+  if (IsOpened()) return errors::AlreadyExists("Bag is already opened.");
+
+  file_ =
+      base::File(path, base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+  if (!file_.IsValid())
+    return errors::InvalidArgument(
+        base::File::ErrorToString(file_.error_details()));
+
+  index_.Clear();
+  chunk_.clear();
+  chunk_info_.Clear();
+
+  bag::FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, bag::kFileMagic, sizeof(header.magic));
+  header.version = bag::kVersion;
+  chunk_offset_ = 0;
+  return WriteToFile(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+uint32_t BagWriter::AddConnection(const std::string& topic,
+                                  const std::string& type_name,
+                                  TopicInfo::ImplType impl_type) {
+  uint32_t id = static_cast<uint32_t>(index_.connections_size());
+  BagConnection* connection = index_.add_connections();
+  connection->set_id(id);
+  connection->set_topic(topic);
+  connection->set_type_name(type_name);
+  connection->set_impl_type(impl_type);
+  return id;
+}
+
+Status BagWriter::Write(uint32_t connection_id, base::TimeDelta timestamp,
+                        base::StringPiece serialized) {
+  if (!IsOpened()) return errors::Unavailable("Bag is not opened.");
+  if (connection_id >= static_cast<uint32_t>(index_.connections_size()))
+    return errors::InvalidArgument("Unknown connection.");
+  if (!base::IsValueInRangeForNumericType<uint32_t>(serialized.length()))
+    return errors::InvalidArgument("Message is too large.");
+
+  int64_t timestamp_us = timestamp.InMicroseconds();
+  BagConnection* connection = index_.mutable_connections(connection_id);
+  connection->add_timestamps(timestamp_us);
+  connection->add_offsets(chunk_offset_ + sizeof(bag::ChunkHeader) +
+                          chunk_.length());
+
+  bag::RecordHeader header;
+  header.connection_id = connection_id;
+  header.size = static_cast<uint32_t>(serialized.length());
+  header.timestamp = timestamp_us;
+  chunk_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  chunk_.append(serialized.data(), serialized.length());
+
+  if (chunk_info_.message_count() == 0) {
+    chunk_info_.set_start_timestamp(timestamp_us);
+    chunk_info_.set_end_timestamp(timestamp_us);
+  } else {
+    chunk_info_.set_start_timestamp(
+        std::min(chunk_info_.start_timestamp(), timestamp_us));
+    chunk_info_.set_end_timestamp(
+        std::max(chunk_info_.end_timestamp(), timestamp_us));
+  }
+  chunk_info_.set_message_count(chunk_info_.message_count() + 1);
+
+  if (chunk_.length() >= chunk_size_) return FlushChunk();
+  return Status::OK();
+}
+
+Status BagWriter::Close() {
+  if (!IsOpened()) return errors::Unavailable("Bag is not opened.");
+
+  Status s = FlushChunk();
+  if (s.ok()) {
+    for (BagConnection& connection : *index_.mutable_connections()) {
+      SortConnectionIndex(&connection);
+    }
+
+    std::string index;
+    index_.SerializeToString(&index);
+    bag::Footer footer;
+    footer.index_offset = chunk_offset_;
+    footer.index_size = index.length();
+    memcpy(footer.magic, bag::kFileMagic, sizeof(footer.magic));
+    s = WriteToFile(index.data(), index.length());
+    if (s.ok())
+      s = WriteToFile(reinterpret_cast<const char*>(&footer), sizeof(footer));
+  }
+
+  file_.Close();
+  return s;
+}
+
+Status BagWriter::WriteToFile(const char* data, size_t size) {
+  if (file_.WriteAtCurrentPos(data, size) != static_cast<int>(size)) {
+    return errors::Unavailable(
+        base::File::ErrorToString(base::File::GetLastFileError()));
+  }
+  chunk_offset_ += size;
+  return Status::OK();
+}
+
+Status BagWriter::FlushChunk() {
+  if (chunk_.empty()) return Status::OK();
+
+  bag::ChunkHeader header;
+  header.magic = bag::kChunkMagic;
+  header.compression = bag::COMPRESSION_NONE;
+  header.size = chunk_.length();
+
+  chunk_info_.set_offset(chunk_offset_);
+  chunk_info_.set_size(sizeof(header) + chunk_.length());
+  *index_.add_chunks() = chunk_info_;
+  chunk_info_.Clear();
+
+  Status s =
+      WriteToFile(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (s.ok()) s = WriteToFile(chunk_.data(), chunk_.length());
+  chunk_.clear();
+  return s;
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,75 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_BAG_BAG_WRITER_H_
+#define FELICIA_CORE_BAG_BAG_WRITER_H_
+
+#include <string>
+
+#include "third_party/chromium/base/files/file.h"
+#include "third_party/chromium/base/files/file_path.h"
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/strings/string_piece.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/lib/base/export.h"
+#include "felicia/core/lib/error/status.h"
+#include "felicia/core/protobuf/bag.pb.h"
+
+namespace felicia {
+
+// Writes serialized messages to a bag. See bag_format.h for the layout.
+//
+//   BagWriter writer;
+//   Status s = writer.Open(path);
+//   uint32_t id = writer.AddConnection("topic", "felicia.ImuFrameMessage",
+//                                      TopicInfo::PROTOBUF);
+//   s = writer.Write(id, timestamp, serialized);
+//   ...
+//   s = writer.Close();
+//
+// The file isn't readable until it's closed, because the index is written
+// at the end.
+class FEL_EXPORT BagWriter {
+ public:
+  static constexpr size_t kDefaultChunkSize = 1024 * 1024;
+
+  BagWriter();
+  ~BagWriter();
+
+  void set_chunk_size(size_t chunk_size) { chunk_size_ = chunk_size; }
+
+  bool IsOpened() const { return file_.IsValid(); }
+
+  Status Open(const base::FilePath& path);
+
+  // Returns the id of the connection, which is passed to |Write()|.
+  uint32_t AddConnection(const std::string& topic,
+                         const std::string& type_name,
+                         TopicInfo::ImplType impl_type);
+
+  Status Write(uint32_t connection_id, base::TimeDelta timestamp,
+               base::StringPiece serialized);
+
+  // Flushes the pending chunk and writes the index.
+  Status Close();
+
+ private:
+  Status WriteToFile(const char* data, size_t size);
+  Status FlushChunk();
+
+  base::File file_;
+  size_t chunk_size_ = kDefaultChunkSize;
+  // Offset where the current chunk starts.
+  uint64_t chunk_offset_ = 0;
+  std::string chunk_;
+  BagChunkInfo chunk_info_;
+  BagIndex index_;
+
+  DISALLOW_COPY_AND_ASSIGN(BagWriter);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_BAG_BAG_WRITER_H_
\ No newline at end of file
@@ -98,7 +98,7 @@ void Channel::SetDynamicReceiveBuffer(bool is_dynamic) {
   receive_buffer_.SetDynamicBuffer(is_dynamic);
 }
 
-void Channel::Send(const std::string& text, StatusOnceCallback callback) {
+void Channel::Send(base::StringPiece text, StatusOnceCallback callback) {
   send_buffer_.Reset();
   int to_send = text.length();
   if (!send_buffer_.SetEnoughCapacityIfDynamic(to_send)) {
@@ -107,7 +107,7 @@ void Channel::Send(const std::string& text, StatusOnceCallback callback) {
     return;
   }
 
-  memcpy(send_buffer_.StartOfBuffer(), text.c_str(), to_send);
+  memcpy(send_buffer_.StartOfBuffer(), text.data(), to_send);
 
   SendInternalBuffer(to_send, std::move(callback));
 }
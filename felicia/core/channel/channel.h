@@ -5,6 +5,7 @@
 #ifndef FELICIA_CORE_CHANNEL_CHANNEL_H_
 #define FELICIA_CORE_CHANNEL_CHANNEL_H_
 
+#include "third_party/chromium/base/strings/string_piece.h"
 #include "third_party/chromium/net/base/address_list.h"
 #include "third_party/chromium/net/base/io_buffer.h"
 
@@ -61,7 +62,7 @@ class FEL_EXPORT Channel {
 
   bool IsConnected() const;
 
-  void Send(const std::string& text, StatusOnceCallback callback);
+  void Send(base::StringPiece text, StatusOnceCallback callback);
   void Receive(std::string* text, StatusOnceCallback callback);
 
   virtual void SetSendBufferSize(Bytes bytes);
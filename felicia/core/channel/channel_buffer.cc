@@ -6,6 +6,32 @@
 
 namespace felicia {
 
+namespace {
+
+class ChannelBufferView : public base::RefCountedMemory {
+ public:
+  ChannelBufferView(scoped_refptr<net::GrowableIOBuffer> buffer, int offset,
+                    int size)
+      : buffer_(std::move(buffer)),
+        data_(reinterpret_cast<const unsigned char*>(
+            buffer_->StartOfBuffer() + offset)),
+        size_(size) {}
+
+  const unsigned char* front() const override { return data_; }
+  size_t size() const override { return size_; }
+
+ private:
+  ~ChannelBufferView() override = default;
+
+  scoped_refptr<net::GrowableIOBuffer> buffer_;
+  const unsigned char* data_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChannelBufferView);
+};
+
+}  // namespace
+
 ChannelBuffer::ChannelBuffer()
     : buffer_(base::MakeRefCounted<net::GrowableIOBuffer>()) {}
 
@@ -29,9 +55,25 @@ char* ChannelBuffer::StartOfBuffer() { return buffer_->StartOfBuffer(); }
 
 scoped_refptr<net::GrowableIOBuffer> ChannelBuffer::buffer() { return buffer_; }
 
+scoped_refptr<base::RefCountedMemory> ChannelBuffer::Share(int offset,
+                                                           int size) {
+  DCHECK_GE(offset, 0);
+  DCHECK_LE(offset + size, capacity());
+  is_shared_ = true;
+  return base::MakeRefCounted<ChannelBufferView>(buffer_, offset, size);
+}
+
 void ChannelBuffer::SetDynamicBuffer(bool is_dynamic) { is_dynamic_ = true; }
 
 void ChannelBuffer::Reset() {
+  if (is_shared_) {
+    is_shared_ = false;
+    if (!buffer_->HasOneRef()) {
+      int capacity = this->capacity();
+      buffer_ = base::MakeRefCounted<net::GrowableIOBuffer>();
+      buffer_->SetCapacity(capacity);
+    }
+  }
   if (!is_dynamic_ && capacity() == 0) {
     DLOG(WARNING) << "Buffer was not allocated, used default size.";
     SetCapacity(Bytes::FromKilloBytes(1));
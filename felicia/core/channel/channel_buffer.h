@@ -5,6 +5,7 @@
 #ifndef FELICIA_CORE_CHANNEL_CHANNEL_BUFFER_H_
 #define FELICIA_CORE_CHANNEL_CHANNEL_BUFFER_H_
 
+#include "third_party/chromium/base/memory/ref_counted_memory.h"
 #include "third_party/chromium/net/base/io_buffer.h"
 
 #include "felicia/core/lib/base/export.h"
@@ -29,6 +30,8 @@ class FEL_EXPORT ChannelBuffer {
   char* StartOfBuffer();
 
   void SetDynamicBuffer(bool is_dynamic);
+  // If a view returned by |Share()| is still alive, it moves to a new buffer
+  // with the same capacity, so that the view is never overwritten.
   void Reset();
   // Return true if capacity() is higher than or equal to |bytes|,
   // but if |is_dynamic_| is true, set capacity to |btyes| and
@@ -39,9 +42,14 @@ class FEL_EXPORT ChannelBuffer {
 
   scoped_refptr<net::GrowableIOBuffer> buffer();
 
+  // Returns a read only view of |size| bytes from |offset| of the buffer
+  // without copying. The view keeps the buffer alive.
+  scoped_refptr<base::RefCountedMemory> Share(int offset, int size);
+
  private:
   scoped_refptr<net::GrowableIOBuffer> buffer_;
   bool is_dynamic_ = false;
+  bool is_shared_ = false;
 };
 
 }  // namespace felicia
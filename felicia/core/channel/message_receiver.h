@@ -15,6 +15,42 @@
 
 namespace felicia {
 
+namespace internal {
+
+template <typename T>
+MessageIOError DeserializeFromChannelBuffer(ChannelBuffer* buffer, int offset,
+                                            int size, T* message) {
+  return MessageIO<T>::Deserialize(buffer->StartOfBuffer() + offset, size,
+                                   message);
+}
+
+// SerializedMessage refers to the receive buffer instead of copying from it.
+// The channel moves to a new buffer while |message| is alive.
+inline MessageIOError DeserializeFromChannelBuffer(ChannelBuffer* buffer,
+                                                   int offset, int size,
+                                                   SerializedMessage* message) {
+  scoped_refptr<base::RefCountedMemory> view = buffer->Share(offset, size);
+  base::StringPiece serialized(view->front_as<char>(), view->size());
+  message->set_serialized_view(std::move(view), serialized);
+  return MessageIOError::OK;
+}
+
+// A lazy DynamicProtobufMessage keeps the wire bytes until it's accessed, so
+// it refers to the receive buffer in the same way.
+inline MessageIOError DeserializeFromChannelBuffer(
+    ChannelBuffer* buffer, int offset, int size,
+    DynamicProtobufMessage* message) {
+  if (!message->is_lazy()) {
+    return MessageIO<DynamicProtobufMessage>::Deserialize(
+        buffer->StartOfBuffer() + offset, size, message);
+  }
+  if (!message->ParseFromView(buffer->Share(offset, size)))
+    return MessageIOError::ERR_FAILED_TO_PARSE;
+  return MessageIOError::OK;
+}
+
+}  // namespace internal
+
 typedef base::RepeatingCallback<int()> HeaderSizeCallback;
 
 typedef base::RepeatingCallback<MessageIOError(
@@ -47,6 +83,15 @@ class MessageReceiver {
     parse_header_callback_ = parse_header_callback;
   }
 
+  // Sets the version of the default header, which the publisher announces
+  // through TopicInfo.
+  void set_header_version(TopicInfo::HeaderVersion version) {
+    header_.set_version(version);
+  }
+
+  // The default header of the last message.
+  const Header& header() const { return header_; }
+
   T&& message() && { return std::move(message_); }
   T& message() & { return message_; }
   const T& message() const& { return message_; }
@@ -83,8 +128,11 @@ class MessageReceiver {
     const char* buffer = channel_->receive_buffer_.StartOfBuffer();
     MessageIOError err = ParseHeader(buffer, &message_offset, &message_size);
     if (err == MessageIOError::OK) {
-      err = MessageIO<T>::Deserialize(buffer + message_offset, message_size,
-                                      &message_);
+      err = VerifyChecksum(buffer + message_offset, message_size);
+    }
+    if (err == MessageIOError::OK) {
+      err = internal::DeserializeFromChannelBuffer(
+          &channel_->receive_buffer_, message_offset, message_size, &message_);
     }
 
     if (err != MessageIOError::OK) {
@@ -128,9 +176,12 @@ class MessageReceiver {
       std::move(receive_callback_).Run(std::move(s));
       return;
     }
-    const char* buffer = channel_->receive_buffer_.StartOfBuffer();
-    MessageIOError err =
-        MessageIO<T>::Deserialize(buffer, message_size, &message_);
+    MessageIOError err = VerifyChecksum(
+        channel_->receive_buffer_.StartOfBuffer(), message_size);
+    if (err == MessageIOError::OK) {
+      err = internal::DeserializeFromChannelBuffer(
+          &channel_->receive_buffer_, 0, message_size, &message_);
+    }
     if (err != MessageIOError::OK) {
       std::move(receive_callback_)
           .Run(errors::Aborted(MessageIOErrorToString(err)));
@@ -157,6 +208,14 @@ class MessageReceiver {
     }
   }
 
+  MessageIOError VerifyChecksum(const char* buffer, int size) const {
+    if (!parse_header_callback_.is_null() ||
+        header_.VerifyChecksum(base::StringPiece(buffer, size))) {
+      return MessageIOError::OK;
+    }
+    return MessageIOError::ERR_CHECKSUM_MISMATCH;
+  }
+
   // not owned
   Channel* channel_;
   // Default header to parse serialized message.
@@ -5,6 +5,7 @@
 #include "felicia/core/channel/socket/udp_server_socket.h"
 
 #include "third_party/chromium/base/rand_util.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
 
 #include "felicia/core/lib/error/errors.h"
 #include "felicia/core/lib/net/net_util.h"
@@ -55,6 +56,43 @@ StatusOr<ChannelDef> UDPServerSocket::Bind() {
   return ToChannelDef(multicast_ip_endpoint_, ChannelDef::CHANNEL_TYPE_UDP);
 }
 
+StatusOr<ChannelDef> UDPServerSocket::Bind(
+    const net::IPEndPoint& multicast_ip_endpoint) {
+  const net::IPAddress& multicast_address = multicast_ip_endpoint.address();
+  // IPv4 multicast addresses are in 224.0.0.0/4.
+  if (!multicast_address.IsIPv4() ||
+      (multicast_address.bytes()[0] & 0xF0) != 0xE0) {
+    return errors::InvalidArgument(base::StringPrintf(
+        "%s is not a multicast address.",
+        multicast_ip_endpoint.ToString().c_str()));
+  }
+
+  auto server_socket = std::make_unique<net::UDPSocket>(
+      net::DatagramSocket::BindType::DEFAULT_BIND);
+
+  int rv = server_socket->Open(net::ADDRESS_FAMILY_IPV4);
+  if (rv != net::OK) {
+    return errors::NetworkError(net::ErrorToString(rv));
+  }
+
+  rv = server_socket->SetMulticastLoopbackMode(true);
+  if (rv != net::OK) {
+    return errors::NetworkError(net::ErrorToString(rv));
+  }
+
+  net::IPAddress address(0, 0, 0, 0);
+  net::IPEndPoint server_endpoint(address, PickRandomPort(false));
+  rv = server_socket->Bind(server_endpoint);
+  if (rv != net::OK) {
+    return errors::NetworkError(net::ErrorToString(rv));
+  }
+
+  socket_ = std::move(server_socket);
+  multicast_ip_endpoint_ = multicast_ip_endpoint;
+
+  return ToChannelDef(multicast_ip_endpoint_, ChannelDef::CHANNEL_TYPE_UDP);
+}
+
 void UDPServerSocket::WriteAsync(scoped_refptr<net::IOBuffer> buffer, int size,
                                  StatusOnceCallback callback) {
   DCHECK(!callback.is_null());
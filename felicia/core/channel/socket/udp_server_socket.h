@@ -20,6 +20,9 @@ class UDPServerSocket : public UDPSocket {
   bool IsServer() const override;
 
   StatusOr<ChannelDef> Bind();
+  // Bind to a random port and send to a given |multicast_ip_endpoint|,
+  // instead of picking a random multicast group.
+  StatusOr<ChannelDef> Bind(const net::IPEndPoint& multicast_ip_endpoint);
 
   // ChannelImpl methods
   void WriteAsync(scoped_refptr<net::IOBuffer> buffer, int size,
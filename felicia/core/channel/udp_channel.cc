@@ -39,6 +39,17 @@ StatusOr<ChannelDef> UDPChannel::Bind() {
   return server_socket->Bind();
 }
 
+StatusOr<ChannelDef> UDPChannel::Bind(const ChannelDef& channel_def) {
+  DCHECK(!channel_impl_);
+  net::AddressList addrlist;
+  Status s = ToNetAddressList(channel_def, &addrlist);
+  if (!s.ok()) return s;
+  channel_impl_ = std::make_unique<UDPServerSocket>();
+  UDPServerSocket* server_socket =
+      channel_impl_->ToSocket()->ToUDPSocket()->ToUDPServerSocket();
+  return server_socket->Bind(addrlist[0]);
+}
+
 void UDPChannel::Connect(const ChannelDef& channel_def,
                          StatusOnceCallback callback) {
   DCHECK(!channel_impl_);
@@ -20,6 +20,8 @@ class FEL_EXPORT UDPChannel : public Channel {
   bool ShouldReceiveMessageWithHeader() const override;
 
   StatusOr<ChannelDef> Bind();
+  // Bind to send to a multicast group which is specified by |channel_def|.
+  StatusOr<ChannelDef> Bind(const ChannelDef& channel_def);
 
   void Connect(const ChannelDef& channel_def,
                StatusOnceCallback callback) override;
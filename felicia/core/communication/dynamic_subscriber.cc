@@ -64,6 +64,11 @@ void DynamicSubscriber::Unsubscribe(const std::string& topic,
   StopMessageLoop(std::move(callback));
 }
 
+void DynamicSubscriber::SetLazy(const std::vector<std::string>& field_mask) {
+  lazy_ = true;
+  field_mask_ = field_mask;
+}
+
 bool DynamicSubscriber::MaybeResolveMessgaeType(const TopicInfo& topic_info) {
   if (topic_info.impl_type() != TopicInfo::PROTOBUF) {
     LOG(ERROR) << "Can't subscribie dynamically other than protobuf message.";
@@ -75,6 +80,13 @@ bool DynamicSubscriber::MaybeResolveMessgaeType(const TopicInfo& topic_info) {
   if (!protobuf_loader.NewMessage(topic_info.type_name(), &message))
     return false;
   message_receiver_.message().Reset(message->New());
+  if (lazy_) {
+    Status s = message_receiver_.message().SetLazy(field_mask_);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return false;
+    }
+  }
   return true;
 }
 
@@ -5,6 +5,9 @@
 #ifndef FELICIA_CORE_COMMUNICATION_DYNAMIC_SUBSCRIBIER_H_
 #define FELICIA_CORE_COMMUNICATION_DYNAMIC_SUBSCRIBIER_H_
 
+#include <string>
+#include <vector>
+
 #include "felicia/core/communication/subscriber.h"
 #include "felicia/core/message/dynamic_protobuf_message.h"
 
@@ -26,9 +29,18 @@ class DynamicSubscriber : public Subscriber<DynamicProtobufMessage> {
 
   const TopicInfo& topic_info() const { return topic_info_; }
 
+  // Messages are parsed only when they are accessed, and only the fields in
+  // |field_mask| are parsed if it's not empty. See DynamicProtobufMessage.
+  // It should be called before subscribing.
+  void SetLazy(const std::vector<std::string>& field_mask =
+                   std::vector<std::string>());
+
  private:
   bool MaybeResolveMessgaeType(const TopicInfo& topic_info) override;
 
+  bool lazy_ = false;
+  std::vector<std::string> field_mask_;
+
   DISALLOW_COPY_AND_ASSIGN(DynamicSubscriber);
 };
 
@@ -16,6 +16,7 @@
 #include "third_party/chromium/base/callback.h"
 #include "third_party/chromium/base/compiler_specific.h"
 #include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/strings/string_piece.h"
 #include "third_party/chromium/base/strings/stringprintf.h"
 #include "third_party/chromium/base/synchronization/lock.h"
 
@@ -68,7 +69,24 @@ class Publisher {
   void RequestUnpublish(const NodeInfo& node_info, const std::string& topic,
                         StatusOnceCallback callback = StatusOnceCallback());
 
+  // Returns true if the next |Publish()| would overwrite a message that isn't
+  // sent yet. It's safe to call on any thread.
+  bool IsQueueFull() {
+    base::AutoLock l(lock_);
+    return message_queue_ &&
+           message_queue_->size() == message_queue_->capacity();
+  }
+
+  // |callback| is called on the main thread whenever a subscriber connects
+  // through TCP, WS or UDS. Streams whose messages depend on the earlier
+  // ones, e.g, VideoFrameMessage, should start over so that the subscriber
+  // can follow. It should be set before |RequestPublish()|.
+  void set_subscriber_connected_callback(base::RepeatingClosure callback) {
+    subscriber_connected_callback_ = callback;
+  }
+
  private:
+  friend class BagNodeTest;
   friend class PubSubTest;
 
   void RequestPublishForTesting(const std::string& topic, int channel_types,
@@ -92,10 +110,14 @@ class Publisher {
   StatusOr<ChannelDef> Setup(Channel* chanel,
                              const channel::Settings& settings);
 
+  void SetHeaderVersion(const communication::Settings& settings);
   void SendMessage(SendMessageCallback callback);
   void OnSendMessage(SendMessageCallback callback, ChannelDef::Type type,
                      Status s);
   void OnAccept(StatusOr<std::unique_ptr<TCPChannel>> status_or);
+  // Called for every accept of WS and UDS channels.
+  void OnAcceptLoop(Status s);
+  void OnSubscriberConnected();
 
 #if defined(HAS_ROS)
   void OnRosTopicHandshake(std::unique_ptr<Channel> client_channel);
@@ -131,19 +153,29 @@ class Publisher {
     return TopicInfo::PROTOBUF;
   }
 
-  // Because SerializedMessage holds serialized text already, and we want it
-  // to move its content to |serialized| not by copying.
+  // Serializes |message| into |buffer| and points |serialized| to it.
+  // Because SerializedMessage holds serialized text already, it points
+  // |serialized| to its own text instead, not by copying it to |buffer|.
   virtual MessageIOError SerializeToString(MessageTy* message,
-                                           std::string* serialized) {
-    return MessageIO<MessageTy>::Serialize(message, serialized);
+                                           std::string* buffer,
+                                           base::StringPiece* serialized) {
+    MessageIOError err = MessageIO<MessageTy>::Serialize(message, buffer);
+    *serialized = *buffer;
+    return err;
   }
 
   base::Lock lock_;
   std::unique_ptr<Pool<MessageTy, uint8_t>> message_queue_ GUARDED_BY(lock_);
+  // Sequence number of the next message to send. Messages overwritten in
+  // |message_queue_| take their numbers too, so that subscribers count them
+  // as dropped.
+  uint64_t sequence_number_ GUARDED_BY(lock_) = 0;
   TopicInfo topic_info_;
+  bool use_checksum_ = false;
   base::TimeDelta period_;
   std::vector<std::unique_ptr<Channel>> channels_;
   ChannelBuffer send_buffer_;
+  base::RepeatingClosure subscriber_connected_callback_;
 
   communication::RegisterState register_state_;
 
@@ -183,6 +215,7 @@ void Publisher<MessageTy>::RequestPublish(
   topic_info_.set_topic(topic);
   topic_info_.set_type_name(GetMessageTypeName());
   topic_info_.set_impl_type(GetMessageImplType());
+  SetHeaderVersion(settings);
   *request->mutable_topic_info() = topic_info_;
   PublishTopicResponse* response = new PublishTopicResponse();
 
@@ -199,7 +232,11 @@ void Publisher<MessageTy>::Publish(const MessageTy& message,
                                    SendMessageCallback callback) {
   {
     base::AutoLock l(lock_);
-    if (message_queue_) message_queue_->push(message);
+    if (message_queue_) {
+      if (message_queue_->size() == message_queue_->capacity())
+        sequence_number_++;
+      message_queue_->push(message);
+    }
   }
 
   SendMessage(callback);
@@ -210,7 +247,11 @@ void Publisher<MessageTy>::Publish(MessageTy&& message,
                                    SendMessageCallback callback) {
   {
     base::AutoLock l(lock_);
-    if (message_queue_) message_queue_->push(std::move(message));
+    if (message_queue_) {
+      if (message_queue_->size() == message_queue_->capacity())
+        sequence_number_++;
+      message_queue_->push(std::move(message));
+    }
   }
 
   SendMessage(callback);
@@ -275,6 +316,7 @@ void Publisher<MessageTy>::RequestPublishForTesting(
   topic_info_.set_topic(topic);
   topic_info_.set_type_name(GetMessageTypeName());
   topic_info_.set_impl_type(GetMessageImplType());
+  SetHeaderVersion(settings);
 
   OnPublishTopicAsync(nullptr, nullptr, settings, StatusOnceCallback(),
                       Status::OK());
@@ -347,15 +389,15 @@ StatusOr<ChannelDef> Publisher<MessageTy>::Setup(
   } else if (channel->IsWSChannel()) {
     WSChannel* ws_channel = channel->ToWSChannel();
     status_or = ws_channel->Listen();
-    ws_channel->AcceptLoop(
-        base::BindRepeating([](Status s) { LOG_IF(ERROR, !s.ok()) << s; }));
+    ws_channel->AcceptLoop(base::BindRepeating(
+        &Publisher<MessageTy>::OnAcceptLoop, base::Unretained(this)));
   }
 #if defined(OS_POSIX)
   else if (channel->IsUDSChannel()) {
     UDSChannel* uds_channel = channel->ToUDSChannel();
     status_or = uds_channel->BindAndListen();
-    uds_channel->AcceptLoop(
-        base::BindRepeating([](Status s) { LOG_IF(ERROR, !s.ok()) << s; }));
+    uds_channel->AcceptLoop(base::BindRepeating(
+        &Publisher<MessageTy>::OnAcceptLoop, base::Unretained(this)));
   }
 #endif  // defined(OS_POSIX)
   else if (channel->IsShmChannel()) {
@@ -434,6 +476,19 @@ void Publisher<MessageTy>::OnUnpublishTopicAsync(
   internal::LogOrCallback(std::move(callback), std::move(s));
 }
 
+template <typename MessageTy>
+void Publisher<MessageTy>::SetHeaderVersion(
+    const communication::Settings& settings) {
+  TopicInfo::HeaderVersion header_version = settings.header_version;
+  if (IsUsingRosProtocol(topic_info_.topic())) {
+    // ROS expects only the size before every message.
+    header_version = TopicInfo::HEADER_VERSION_1;
+  }
+  topic_info_.set_header_version(header_version);
+  use_checksum_ = settings.use_checksum &&
+                  header_version == TopicInfo::HEADER_VERSION_2;
+}
+
 template <typename MessageTy>
 void Publisher<MessageTy>::SendMessage(SendMessageCallback callback) {
   MainThread& main_thread = MainThread::GetInstance();
@@ -454,19 +509,27 @@ void Publisher<MessageTy>::SendMessage(SendMessageCallback callback) {
 
   if (!can_send) return;
 
-  std::string serialized;
-  MessageIOError err = MessageIOError::ERR_FAILED_TO_SERIALIZE;
+  MessageTy message;
+  Header header(topic_info_.header_version());
   {
     base::AutoLock l(lock_);
     if (message_queue_ && !message_queue_->empty()) {
-      err = SerializeToString(&message_queue_->front(), &serialized);
+      message = std::move(message_queue_->front());
       message_queue_->pop();
+      header.set_sequence_number(sequence_number_++);
     } else {
       return;
     }
   }
 
-  Header header;
+  // |serialized| may refer to |message|, so both must be alive until the
+  // bytes are copied to the send buffers below.
+  std::string buffer;
+  base::StringPiece serialized;
+  MessageIOError err = SerializeToString(&message, &buffer, &serialized);
+
+  header.set_timestamp(base::TimeTicks::Now());
+  header.set_use_checksum(use_checksum_);
   int to_send = header.header_size() + serialized.length();
   if (err == MessageIOError::OK) {
     if (send_buffer_.SetEnoughCapacityIfDynamic(to_send)) {
@@ -529,6 +592,7 @@ void Publisher<MessageTy>::OnAccept(
         } else {
 #endif  // defined(HAS_ROS)
           tcp_channel->AddClientChannel(std::move(status_or).ValueOrDie());
+          OnSubscriberConnected();
 #if defined(HAS_ROS)
         }
 #endif  // defined(HAS_ROS)
@@ -542,6 +606,21 @@ void Publisher<MessageTy>::OnAccept(
   }
 }
 
+template <typename MessageTy>
+void Publisher<MessageTy>::OnAcceptLoop(Status s) {
+  if (s.ok()) {
+    OnSubscriberConnected();
+  } else {
+    LOG(ERROR) << s;
+  }
+}
+
+template <typename MessageTy>
+void Publisher<MessageTy>::OnSubscriberConnected() {
+  if (!subscriber_connected_callback_.is_null())
+    subscriber_connected_callback_.Run();
+}
+
 #if defined(HAS_ROS)
 template <typename MessageTy>
 void Publisher<MessageTy>::OnRosTopicHandshake(
@@ -553,6 +632,7 @@ void Publisher<MessageTy>::OnRosTopicHandshake(
       client_tcp_channel.reset(
           reinterpret_cast<TCPChannel*>(client_channel.release()));
       tcp_channel->AddClientChannel(std::move(client_tcp_channel));
+      OnSubscriberConnected();
       return;
     }
   }
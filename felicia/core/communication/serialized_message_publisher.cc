@@ -16,14 +16,24 @@ SerializedMessagePublisher::~SerializedMessagePublisher() = default;
 
 void SerializedMessagePublisher::PublishFromSerialized(
     const std::string& serialized, SendMessageCallback callback) {
-  message_.set_serialized(serialized);
-  Publisher<SerializedMessage>::Publish(message_, callback);
+  SerializedMessage message;
+  message.set_serialized(serialized);
+  Publisher<SerializedMessage>::Publish(std::move(message), callback);
 }
 
 void SerializedMessagePublisher::PublishFromSerialized(
     std::string&& serialized, SendMessageCallback callback) {
-  message_.set_serialized(std::move(serialized));
-  Publisher<SerializedMessage>::Publish(message_, callback);
+  SerializedMessage message;
+  message.set_serialized(std::move(serialized));
+  Publisher<SerializedMessage>::Publish(std::move(message), callback);
+}
+
+void SerializedMessagePublisher::PublishFromSerialized(
+    scoped_refptr<base::RefCountedMemory> buffer,
+    SendMessageCallback callback) {
+  SerializedMessage message;
+  message.set_serialized_view(std::move(buffer));
+  Publisher<SerializedMessage>::Publish(std::move(message), callback);
 }
 
 #if defined(HAS_ROS)
@@ -45,8 +55,9 @@ TopicInfo::ImplType SerializedMessagePublisher::GetMessageImplType() const {
 }
 
 MessageIOError SerializedMessagePublisher::SerializeToString(
-    SerializedMessage* message, std::string* serialized) {
-  *serialized = std::move(*message).serialized();
+    SerializedMessage* message, std::string* buffer,
+    base::StringPiece* serialized) {
+  *serialized = message->serialized();
   return MessageIOError::OK;
 }
 
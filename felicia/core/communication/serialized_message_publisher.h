@@ -27,6 +27,12 @@ class SerializedMessagePublisher : public Publisher<SerializedMessage> {
       std::string&& serialized,
       SendMessageCallback callback = SendMessageCallback());
 
+  // Publishes |buffer| without copying it. |buffer| must not be modified
+  // until it is sent, which is when the last reference to it is dropped.
+  void PublishFromSerialized(
+      scoped_refptr<base::RefCountedMemory> buffer,
+      SendMessageCallback callback = SendMessageCallback());
+
  protected:
 #if defined(HAS_ROS)
   std::string GetMessageMD5Sum() const override;
@@ -36,9 +42,9 @@ class SerializedMessagePublisher : public Publisher<SerializedMessage> {
   TopicInfo::ImplType GetMessageImplType() const override;
 
   MessageIOError SerializeToString(SerializedMessage* message,
-                                   std::string* serialized) override;
+                                   std::string* buffer,
+                                   base::StringPiece* serialized) override;
 
-  SerializedMessage message_;
 #if defined(HAS_ROS)
   std::string message_md5_sum_;
   std::string message_definition_;
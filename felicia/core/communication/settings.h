@@ -9,6 +9,7 @@
 
 #include "felicia/core/channel/settings.h"
 #include "felicia/core/lib/unit/bytes.h"
+#include "felicia/core/protobuf/master_data.pb.h"
 
 namespace felicia {
 namespace communication {
@@ -24,6 +25,13 @@ struct Settings {
   Bytes buffer_size = Bytes::FromBytes(kDefaultMessageSize);
   bool is_dynamic_buffer = false;
   uint8_t queue_size = kDefaultQueueSize;
+  // Only for publisher. Topics on ROS protocol always use version 1. Version
+  // 2 is opt in, since subscribers built before it only read version 1, and
+  // the version isn't negotiated with them.
+  TopicInfo::HeaderVersion header_version = TopicInfo::HEADER_VERSION_1;
+  // Only for publisher. If it's set, messages carry CRC-32C, which needs
+  // version 2.
+  bool use_checksum = false;
   channel::Settings channel_settings;
 };
 
@@ -12,7 +12,9 @@
 #include "third_party/chromium/base/callback.h"
 #include "third_party/chromium/base/compiler_specific.h"
 #include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/optional.h"
 #include "third_party/chromium/base/strings/stringprintf.h"
+#include "third_party/chromium/base/synchronization/lock.h"
 #include "third_party/chromium/base/time/time.h"
 
 #include "felicia/core/channel/channel_factory.h"
@@ -21,6 +23,7 @@
 #include "felicia/core/communication/register_state.h"
 #include "felicia/core/communication/settings.h"
 #include "felicia/core/communication/subscriber_state.h"
+#include "felicia/core/communication/subscriber_statistics.h"
 #include "felicia/core/lib/containers/pool.h"
 #include "felicia/core/lib/error/status.h"
 #include "felicia/core/master/master_proxy.h"
@@ -65,7 +68,14 @@ class Subscriber {
   void RequestUnsubscribe(const NodeInfo& node_info, const std::string& topic,
                           StatusOnceCallback callback = StatusOnceCallback());
 
+  // It's safe to call on any thread.
+  communication::SubscriberStatistics GetStatistics() const {
+    base::AutoLock l(statistics_lock_);
+    return statistics_;
+  }
+
  private:
+  friend class BagNodeTest;
   friend class PubSubTest;
 
   void RequestSubscribeForTesting(
@@ -101,6 +111,7 @@ class Subscriber {
 
   void ReceiveMessageLoop();
   void OnReceiveMessage(Status s);
+  void UpdateStatistics();
 
   void NotifyMessageLoop();
 
@@ -147,6 +158,12 @@ class Subscriber {
   communication::Settings settings_;
   uint8_t receive_message_failed_cnt_ = 0;
 
+  // Whether the publisher connected now is on this host, so that the latency
+  // can be measured.
+  bool is_publisher_on_same_host_ = false;
+  mutable base::Lock statistics_lock_;
+  communication::SubscriberStatistics statistics_ GUARDED_BY(statistics_lock_);
+
   static constexpr uint8_t kMaximumReceiveMessageFailedAllowed = 5;
 
   DISALLOW_COPY_AND_ASSIGN(Subscriber);
@@ -399,6 +416,8 @@ void Subscriber<MessageTy>::ConnectToPublisher() {
 
   channel_ = ChannelFactory::NewChannel(matched_channel_def.type(),
                                         settings_.channel_settings);
+  is_publisher_on_same_host_ =
+      communication::SubscriberStatistics::IsOnSameHost(matched_channel_def);
 
   channel_->Connect(matched_channel_def,
                     base::BindOnce(&Subscriber<MessageTy>::OnConnectToPublisher,
@@ -414,6 +433,11 @@ void Subscriber<MessageTy>::OnConnectToPublisher(Status s) {
       channel_->SetReceiveBufferSize(settings_.buffer_size);
     }
     message_receiver_.set_channel(channel_.get());
+    message_receiver_.set_header_version(topic_info_.header_version());
+    {
+      base::AutoLock l(statistics_lock_);
+      statistics_.ResetSequenceNumber();
+    }
 
 #if defined(HAS_ROS)
     if (IsUsingRosProtocol(topic_info_.topic())) {
@@ -511,6 +535,7 @@ void Subscriber<MessageTy>::OnReceiveMessage(Status s) {
 
   if (s.ok()) {
     receive_message_failed_cnt_ = 0;
+    UpdateStatistics();
     message_queue_.push(std::move(message_receiver_).message());
   } else {
     Status new_status(s.error_code(),
@@ -540,6 +565,14 @@ void Subscriber<MessageTy>::OnReceiveMessage(Status s) {
   }
 }
 
+template <typename MessageTy>
+void Subscriber<MessageTy>::UpdateStatistics() {
+  base::AutoLock l(statistics_lock_);
+  statistics_.Count(message_receiver_.header(),
+                    message_queue_.size() == message_queue_.capacity(),
+                    is_publisher_on_same_host_);
+}
+
 template <typename MessageTy>
 void Subscriber<MessageTy>::NotifyMessageLoop() {
   if (IsStopped()) return;
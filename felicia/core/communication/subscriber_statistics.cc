@@ -0,0 +1,135 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/communication/subscriber_statistics.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
+#include "third_party/chromium/net/base/ip_address.h"
+
+#include "felicia/core/lib/net/net_util.h"
+
+namespace felicia {
+namespace communication {
+
+constexpr size_t LatencyHistogram::kBucketCount;
+
+LatencyHistogram::LatencyHistogram()
+    : buckets_(),
+      count_(0),
+      min_(base::TimeDelta::Max()),
+      max_(base::TimeDelta::Min()) {}
+
+void LatencyHistogram::Add(base::TimeDelta latency) {
+  DCHECK_GE(latency, base::TimeDelta());
+  int64_t us = latency.InMicroseconds();
+  size_t idx = 0;
+  while (us > 0 && idx < kBucketCount - 1) {
+    us >>= 1;
+    ++idx;
+  }
+  buckets_[idx]++;
+  count_++;
+  sum_ += latency;
+  if (latency < min_) min_ = latency;
+  if (latency > max_) max_ = latency;
+}
+
+base::TimeDelta LatencyHistogram::mean() const {
+  if (count_ == 0) return base::TimeDelta();
+  return sum_ / count_;
+}
+
+base::TimeDelta LatencyHistogram::Percentile(double percentile) const {
+  if (count_ == 0) return base::TimeDelta();
+  uint64_t rank = static_cast<uint64_t>(count_ * percentile / 100);
+  if (rank >= count_) rank = count_ - 1;
+  uint64_t accumulated = 0;
+  for (size_t i = 0; i < kBucketCount - 1; ++i) {
+    accumulated += buckets_[i];
+    if (rank < accumulated) return std::min(BucketUpperBound(i), max_);
+  }
+  return max_;
+}
+
+// static
+base::TimeDelta LatencyHistogram::BucketUpperBound(size_t idx) {
+  if (idx >= kBucketCount - 1) return base::TimeDelta::Max();
+  return base::TimeDelta::FromMicroseconds(int64_t{1} << idx);
+}
+
+std::string LatencyHistogram::ToString() const {
+  if (count_ == 0) return "no samples";
+  return base::StringPrintf(
+      "count: %" PRIu64 ", min: %" PRId64 "us, mean: %" PRId64
+      "us, p50: %" PRId64 "us, p99: %" PRId64 "us, max: %" PRId64 "us",
+      count_, min_.InMicroseconds(), mean().InMicroseconds(),
+      Percentile(50).InMicroseconds(), Percentile(99).InMicroseconds(),
+      max_.InMicroseconds());
+}
+
+SubscriberStatistics::SubscriberStatistics() = default;
+
+SubscriberStatistics::SubscriberStatistics(const SubscriberStatistics& other) =
+    default;
+
+SubscriberStatistics& SubscriberStatistics::operator=(
+    const SubscriberStatistics& other) = default;
+
+SubscriberStatistics::~SubscriberStatistics() = default;
+
+// static
+bool SubscriberStatistics::IsOnSameHost(const ChannelDef& channel_def) {
+  switch (channel_def.type()) {
+    case ChannelDef::CHANNEL_TYPE_SHM:
+    case ChannelDef::CHANNEL_TYPE_UDS:
+      return true;
+    case ChannelDef::CHANNEL_TYPE_UDP:
+    case ChannelDef::CHANNEL_TYPE_TCP:
+    case ChannelDef::CHANNEL_TYPE_WS: {
+      net::IPAddress ip;
+      if (!ip.AssignFromIPLiteral(channel_def.ip_endpoint().ip())) {
+        return false;
+      }
+      return ip.IsLoopback() || ip == HostIPAddress(HOST_IP_ONLY_ALLOW_IPV4);
+    }
+    default:
+      return false;
+  }
+}
+
+void SubscriberStatistics::Count(const Header& header, bool overflowed,
+                                 bool is_on_same_host) {
+  received_count++;
+  if (overflowed) overflowed_count++;
+
+  if (header.version() != TopicInfo::HEADER_VERSION_2) return;
+
+  uint64_t sequence_number = header.sequence_number();
+  // If it goes backward, the publisher must have been restarted.
+  if (last_sequence_number_.has_value() &&
+      sequence_number > last_sequence_number_.value()) {
+    dropped_count += sequence_number - last_sequence_number_.value() - 1;
+  }
+  last_sequence_number_ = sequence_number;
+
+  if (!is_on_same_host) return;
+  // It's the same clock, so it can't go negative.
+  latency.Add(
+      std::max(base::TimeTicks::Now() - header.timestamp(), base::TimeDelta()));
+}
+
+std::string SubscriberStatistics::ToString() const {
+  return base::StringPrintf("received: %" PRIu64 ", overflowed: %" PRIu64
+                            ", dropped: %" PRIu64 ", latency: (%s)",
+                            received_count, overflowed_count, dropped_count,
+                            latency.ToString().c_str());
+}
+
+}  // namespace communication
+}  // namespace felicia
\ No newline at end of file
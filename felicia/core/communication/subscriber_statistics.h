@@ -0,0 +1,97 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_COMMUNICATION_SUBSCRIBER_STATISTICS_H_
+#define FELICIA_CORE_COMMUNICATION_SUBSCRIBER_STATISTICS_H_
+
+#include <stdint.h>
+#include <string>
+
+#include "third_party/chromium/base/optional.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/lib/base/export.h"
+#include "felicia/core/message/header.h"
+#include "felicia/core/protobuf/channel.pb.h"
+
+namespace felicia {
+namespace communication {
+
+// Histogram of latencies, whose buckets are [0, 1us), [1us, 2us),
+// [2us, 4us), ... and the last one is open ended.
+class FEL_EXPORT LatencyHistogram {
+ public:
+  static constexpr size_t kBucketCount = 24;
+
+  LatencyHistogram();
+
+  void Add(base::TimeDelta latency);
+
+  uint64_t count() const { return count_; }
+  uint64_t bucket(size_t idx) const { return buckets_[idx]; }
+  base::TimeDelta min() const { return min_; }
+  base::TimeDelta max() const { return max_; }
+  base::TimeDelta mean() const;
+
+  // Returns the upper bound of the bucket where |percentile|, which is in
+  // [0, 100], falls, or the max latency if it falls in the last bucket.
+  base::TimeDelta Percentile(double percentile) const;
+
+  // Returns the exclusive upper bound of the bucket at |idx|.
+  static base::TimeDelta BucketUpperBound(size_t idx);
+
+  std::string ToString() const;
+
+ private:
+  uint64_t buckets_[kBucketCount];
+  uint64_t count_;
+  base::TimeDelta sum_;
+  base::TimeDelta min_;
+  base::TimeDelta max_;
+};
+
+// Statistics of a subscriber. Only |received_count| and |overflowed_count|
+// are counted, unless the publisher attaches the header version 2, which is
+// opt in through Settings::header_version.
+struct FEL_EXPORT SubscriberStatistics {
+  SubscriberStatistics();
+  SubscriberStatistics(const SubscriberStatistics& other);
+  SubscriberStatistics& operator=(const SubscriberStatistics& other);
+  ~SubscriberStatistics();
+
+  std::string ToString() const;
+
+  // Returns true if the publisher at |channel_def| is on this host, whose
+  // monotonic clock the timestamps of the messages are in.
+  static bool IsOnSameHost(const ChannelDef& channel_def);
+
+  // Counts a message received with |header|. |overflowed| is whether it
+  // overwrote another in the queue. Latency is measured only if
+  // |is_on_same_host|.
+  void Count(const Header& header, bool overflowed, bool is_on_same_host);
+  // Called when it connects to a publisher, whose sequence numbers start
+  // over.
+  void ResetSequenceNumber() { last_sequence_number_.reset(); }
+
+  uint64_t received_count = 0;
+  // Messages which were received, but overwritten in the queue of the
+  // subscriber before they were notified.
+  uint64_t overflowed_count = 0;
+  // Messages which the publisher sent or queued, but never reached the
+  // subscriber, e.g. lost on UDP or overwritten on shared memory. These are
+  // counted from the gaps of the sequence numbers.
+  uint64_t dropped_count = 0;
+  // From when a message is sent to when it is received. It's only measured
+  // when the publisher is on the same host.
+  LatencyHistogram latency;
+
+ private:
+  // Of the last message from the publisher connected now.
+  base::Optional<uint64_t> last_sequence_number_;
+};
+
+}  // namespace communication
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_COMMUNICATION_SUBSCRIBER_STATISTICS_H_
\ No newline at end of file
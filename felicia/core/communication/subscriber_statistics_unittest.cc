@@ -0,0 +1,95 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/communication/subscriber_statistics.h"
+
+#include "gtest/gtest.h"
+
+#include "felicia/core/lib/net/net_util.h"
+
+namespace felicia {
+namespace communication {
+
+TEST(LatencyHistogramTest, Add) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0u, histogram.count());
+  EXPECT_EQ(base::TimeDelta(), histogram.Percentile(50));
+
+  for (int64_t us : {0, 1, 3, 4, 100}) {
+    histogram.Add(base::TimeDelta::FromMicroseconds(us));
+  }
+  EXPECT_EQ(5u, histogram.count());
+  EXPECT_EQ(1u, histogram.bucket(0));
+  EXPECT_EQ(1u, histogram.bucket(1));
+  EXPECT_EQ(1u, histogram.bucket(2));
+  EXPECT_EQ(1u, histogram.bucket(3));
+  EXPECT_EQ(1u, histogram.bucket(7));
+  EXPECT_EQ(base::TimeDelta(), histogram.min());
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(100), histogram.max());
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(21), histogram.mean());
+
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(1), histogram.Percentile(0));
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(4), histogram.Percentile(50));
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(100), histogram.Percentile(99));
+
+  // The last bucket is open ended.
+  histogram.Add(base::TimeDelta::FromSeconds(100));
+  EXPECT_EQ(1u, histogram.bucket(LatencyHistogram::kBucketCount - 1));
+  EXPECT_EQ(base::TimeDelta::FromSeconds(100), histogram.Percentile(100));
+}
+
+TEST(SubscriberStatisticsTest, Count) {
+  SubscriberStatistics statistics;
+  Header header(TopicInfo::HEADER_VERSION_2);
+  header.set_timestamp(base::TimeTicks::Now());
+  for (uint64_t sequence_number : {1, 2, 5}) {
+    header.set_sequence_number(sequence_number);
+    statistics.Count(header, false, true);
+  }
+  statistics.Count(header, true, true);
+  EXPECT_EQ(4u, statistics.received_count);
+  EXPECT_EQ(1u, statistics.overflowed_count);
+  EXPECT_EQ(2u, statistics.dropped_count);
+  EXPECT_EQ(4u, statistics.latency.count());
+
+  // The timestamp of a publisher on another host is on another clock.
+  header.set_sequence_number(6);
+  header.set_timestamp(base::TimeTicks::Now() + base::TimeDelta::FromDays(1));
+  statistics.Count(header, false, false);
+  EXPECT_EQ(5u, statistics.received_count);
+  EXPECT_EQ(2u, statistics.dropped_count);
+  EXPECT_EQ(4u, statistics.latency.count());
+
+  // Sequence numbers start over with a new publisher.
+  statistics.ResetSequenceNumber();
+  header.set_sequence_number(100);
+  statistics.Count(header, false, false);
+  EXPECT_EQ(2u, statistics.dropped_count);
+
+  // Version 1 has neither.
+  statistics.Count(Header(TopicInfo::HEADER_VERSION_1), false, true);
+  EXPECT_EQ(7u, statistics.received_count);
+  EXPECT_EQ(4u, statistics.latency.count());
+}
+
+TEST(SubscriberStatisticsTest, IsOnSameHost) {
+  ChannelDef channel_def;
+  channel_def.set_type(ChannelDef::CHANNEL_TYPE_SHM);
+  EXPECT_TRUE(SubscriberStatistics::IsOnSameHost(channel_def));
+  channel_def.set_type(ChannelDef::CHANNEL_TYPE_UDS);
+  EXPECT_TRUE(SubscriberStatistics::IsOnSameHost(channel_def));
+
+  channel_def.set_type(ChannelDef::CHANNEL_TYPE_TCP);
+  channel_def.mutable_ip_endpoint()->set_ip("127.0.0.1");
+  EXPECT_TRUE(SubscriberStatistics::IsOnSameHost(channel_def));
+  channel_def.mutable_ip_endpoint()->set_ip(
+      HostIPAddress(HOST_IP_ONLY_ALLOW_IPV4).ToString());
+  EXPECT_TRUE(SubscriberStatistics::IsOnSameHost(channel_def));
+  // TEST-NET-1, which no host has.
+  channel_def.mutable_ip_endpoint()->set_ip("192.0.2.1");
+  EXPECT_FALSE(SubscriberStatistics::IsOnSameHost(channel_def));
+}
+
+}  // namespace communication
+}  // namespace felicia
\ No newline at end of file
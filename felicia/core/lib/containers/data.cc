@@ -4,6 +4,8 @@
 
 #include "felicia/core/lib/containers/data.h"
 
+#include "felicia/core/lib/containers/data_pool.h"
+
 namespace felicia {
 
 Data::Data() : type_(DATA_TYPE_CUSTOM_C1) {}
@@ -13,15 +15,49 @@ Data::Data(const std::string& data, uint32_t type) : data_(data), type_(type) {}
 Data::Data(std::string&& data, uint32_t type) noexcept
     : data_(std::move(data)), type_(type) {}
 
-Data::Data(const Data& other) = default;
+// A copy isn't pooled, since its buffer isn't from DataPool.
+Data::Data(const Data& other) : data_(other.data_), type_(other.type_) {}
 
 Data::Data(Data&& other) noexcept
-    : data_(std::move(other.data_)), type_(other.type_) {}
+    : data_(std::move(other.data_)),
+      type_(other.type_),
+      pooled_(other.pooled_) {
+  other.pooled_ = false;
+}
+
+Data::~Data() { ReleaseToPool(); }
+
+// Assigning a copy keeps the buffer of this, pooled or not.
+Data& Data::operator=(const Data& other) {
+  data_ = other.data_;
+  type_ = other.type_;
+  return *this;
+}
+
+Data& Data::operator=(Data&& other) {
+  if (this != &other) {
+    ReleaseToPool();
+    data_ = std::move(other.data_);
+    type_ = other.type_;
+    pooled_ = other.pooled_;
+    other.pooled_ = false;
+  }
+  return *this;
+}
 
-Data::~Data() = default;
+// static
+Data Data::AllocateFromPool(size_t n, uint32_t type) {
+  Data data(DataPool::GetInstance().Acquire(n), type);
+  data.pooled_ = true;
+  return data;
+}
 
-Data& Data::operator=(const Data& other) = default;
-Data& Data::operator=(Data&& other) = default;
+// static
+Data Data::AdoptIntoPool(std::string&& data, uint32_t type) {
+  Data adopted(std::move(data), type);
+  adopted.pooled_ = true;
+  return adopted;
+}
 
 size_t Data::size() const noexcept { return data_.size(); }
 
@@ -35,7 +71,10 @@ void Data::shrink_to_fit() { data_.shrink_to_fit(); }
 
 void Data::clear() { data_.clear(); }
 
-void Data::swap(Data& other) { data_.swap(other.data_); }
+void Data::swap(Data& other) {
+  data_.swap(other.data_);
+  std::swap(pooled_, other.pooled_);
+}
 
 const std::string& Data::data() const& noexcept { return data_; }
 std::string&& Data::data() && noexcept { return std::move(data_); }
@@ -69,4 +108,11 @@ Status Data::FromDataMessage(DataMessage&& message) {
   return Status::OK();
 }
 
+void Data::ReleaseToPool() {
+  if (!pooled_) return;
+  pooled_ = false;
+  DataPool::GetInstance().Release(std::move(data_));
+  data_.clear();
+}
+
 }  // namespace felicia
\ No newline at end of file
@@ -5,6 +5,8 @@
 #ifndef FELICIA_CORE_LIB_CONTAINERS_DATA_H_
 #define FELICIA_CORE_LIB_CONTAINERS_DATA_H_
 
+#include <string.h>
+
 #include <string>
 #include <type_traits>
 
@@ -371,6 +373,27 @@ class FEL_EXPORT Data {
   Data& operator=(const Data& other);
   Data& operator=(Data&& other);
 
+  // These draw the buffer from DataPool, and give it back when the Data is
+  // destroyed. Use them for large buffers made every frame.
+  //
+  // Returns |n| bytes, whose contents are unspecified.
+  static Data AllocateFromPool(size_t n, uint32_t type = DATA_TYPE_CUSTOM_C1);
+  // Copies |n| elements of |s|.
+  template <typename T>
+  static Data CopyFromPool(
+      const T* s, size_t n,
+      uint32_t type = DataMessageTraits<T>::data_type) {
+    Data data = AllocateFromPool(n * sizeof(T), type);
+    memcpy(&data.data_[0], s, n * sizeof(T));
+    return data;
+  }
+  // Takes |data|, e.g, a bytes field of a received message, which goes to
+  // DataPool later.
+  static Data AdoptIntoPool(std::string&& data,
+                            uint32_t type = DATA_TYPE_CUSTOM_C1);
+
+  bool is_pooled() const { return pooled_; }
+
   template <typename T, std::enable_if_t<std::is_pointer<T>::value>* = nullptr>
   T cast() const noexcept {
     return reinterpret_cast<T>(data_.data());
@@ -424,8 +447,12 @@ class FEL_EXPORT Data {
   template <typename T>
   friend class ConstView;
 
+  void ReleaseToPool();
+
   std::string data_;
   uint32_t type_;
+  // Whether |data_| goes back to DataPool.
+  bool pooled_ = false;
 };
 
 }  // namespace felicia
@@ -0,0 +1,130 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/lib/containers/data_pool.h"
+
+#include <algorithm>
+
+#include "third_party/chromium/base/bits.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/build/build_config.h"
+
+#if defined(OS_LINUX)
+#include <sys/mman.h>
+#endif  // defined(OS_LINUX)
+
+namespace felicia {
+
+namespace {
+
+#if defined(OS_LINUX) && defined(MADV_HUGEPAGE)
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Advises the huge pages inside |buffer| before they are touched. It's just
+// a hint, and it's fine if the kernel doesn't take it.
+void AdviseHugePages(std::string* buffer) {
+  if (buffer->capacity() < kHugePageSize) return;
+  uintptr_t begin = reinterpret_cast<uintptr_t>(&(*buffer)[0]);
+  uintptr_t end = begin + buffer->capacity();
+  begin = base::bits::Align(begin, kHugePageSize);
+  end = base::bits::AlignDown(end, kHugePageSize);
+  if (begin >= end) return;
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+}
+#endif  // defined(OS_LINUX) && defined(MADV_HUGEPAGE)
+
+// Sizes in [2^n, 2^(n+1)) are split into 4 classes.
+size_t SizeClassStep(size_t size) {
+  const size_t log2 =
+      sizeof(size_t) * 8 - 1 - base::bits::CountLeadingZeroBitsSizeT(size);
+  return std::max(size_t{1} << log2 >> 2, size_t{1});
+}
+
+}  // namespace
+
+constexpr size_t DataPool::kMinPooledSize;
+constexpr size_t DataPool::kDefaultMaxPooledBytes;
+
+// static
+DataPool& DataPool::GetInstance() {
+  static base::NoDestructor<DataPool> data_pool;
+  return *data_pool;
+}
+
+DataPool::DataPool(size_t max_pooled_bytes)
+    : max_pooled_bytes_(max_pooled_bytes) {}
+
+DataPool::~DataPool() = default;
+
+std::string DataPool::Acquire(size_t size) {
+  if (size < kMinPooledSize) return std::string(size, 0);
+
+  const size_t size_class = CeilSizeClass(size);
+  std::string buffer;
+  {
+    base::AutoLock l(lock_);
+    // Every buffer of |size_class| fits, and some of the class below may.
+    if (TakeLocked(size_class, size, &buffer) ||
+        TakeLocked(FloorSizeClass(size), size, &buffer)) {
+      stats_.hits++;
+      stats_.pooled_bytes -= buffer.capacity();
+    } else {
+      stats_.misses++;
+    }
+  }
+
+  if (buffer.capacity() == 0) {
+    buffer.reserve(size_class);
+#if defined(OS_LINUX) && defined(MADV_HUGEPAGE)
+    AdviseHugePages(&buffer);
+#endif  // defined(OS_LINUX) && defined(MADV_HUGEPAGE)
+  }
+  // Only the bytes beyond the last size are written, which is none for the
+  // frames of the same camera.
+  buffer.resize(size);
+  return buffer;
+}
+
+void DataPool::Release(std::string buffer) {
+  const size_t capacity = buffer.capacity();
+  if (capacity < kMinPooledSize) return;
+
+  base::AutoLock l(lock_);
+  if (stats_.pooled_bytes + capacity > max_pooled_bytes_) return;
+  stats_.pooled_bytes += capacity;
+  free_lists_[FloorSizeClass(capacity)].push_back(std::move(buffer));
+}
+
+DataPool::Stats DataPool::stats() const {
+  base::AutoLock l(lock_);
+  return stats_;
+}
+
+// static
+size_t DataPool::CeilSizeClass(size_t size) {
+  if (size == 0) return 0;
+  return base::bits::Align(size, SizeClassStep(size));
+}
+
+// static
+size_t DataPool::FloorSizeClass(size_t size) {
+  if (size == 0) return 0;
+  return base::bits::AlignDown(size, SizeClassStep(size));
+}
+
+bool DataPool::TakeLocked(size_t size_class, size_t size,
+                          std::string* buffer) {
+  auto it = free_lists_.find(size_class);
+  if (it == free_lists_.end()) return false;
+  std::vector<std::string>& free_list = it->second;
+  for (auto rit = free_list.rbegin(); rit != free_list.rend(); ++rit) {
+    if (rit->capacity() < size) continue;
+    *buffer = std::move(*rit);
+    free_list.erase(std::next(rit).base());
+    return true;
+  }
+  return false;
+}
+
+}  // namespace felicia
\ No newline at end of file
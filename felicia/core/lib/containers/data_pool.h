@@ -0,0 +1,81 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_LIB_CONTAINERS_DATA_POOL_H_
+#define FELICIA_CORE_LIB_CONTAINERS_DATA_POOL_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/no_destructor.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
+
+#include "felicia/core/lib/base/export.h"
+
+namespace felicia {
+
+// Thread safe free lists of large buffers, e.g, camera frames, which Data
+// draws from. Freeing a buffer of megabytes gives its pages back to the
+// system, and the next frame faults them in again, so a buffer is kept
+// here instead to be reused by the next frame of a similar size.
+//
+// Buffers are grouped by size classes, 4 per power of 2, so that a buffer
+// is at most 25% larger than what it's asked for. On linux, buffers of 2MB
+// or larger are advised to be backed by transparent huge pages.
+//
+// Use it through Data.
+//
+//   Data data = Data::AllocateFromPool(camera_format.AllocationSize());
+class FEL_EXPORT DataPool {
+ public:
+  // Smaller buffers are left to malloc.
+  static constexpr size_t kMinPooledSize = 64 * 1024;
+  static constexpr size_t kDefaultMaxPooledBytes = 256 * 1024 * 1024;
+
+  struct Stats {
+    // Acquires which reused a buffer and which allocated one.
+    int64_t hits = 0;
+    int64_t misses = 0;
+    size_t pooled_bytes = 0;
+  };
+
+  static DataPool& GetInstance();
+
+  explicit DataPool(size_t max_pooled_bytes = kDefaultMaxPooledBytes);
+  ~DataPool();
+
+  // Returns a buffer of |size| bytes. The contents of a reused buffer are
+  // left as they were.
+  std::string Acquire(size_t size);
+  // Keeps |buffer| for |Acquire()|, unless it's too small or the pool holds
+  // |max_pooled_bytes| already.
+  void Release(std::string buffer);
+
+  Stats stats() const;
+
+  // Returns the smallest size class which is not less than |size|, and the
+  // largest one which is not greater than |size|.
+  static size_t CeilSizeClass(size_t size);
+  static size_t FloorSizeClass(size_t size);
+
+ private:
+  bool TakeLocked(size_t size_class, size_t size, std::string* buffer)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const size_t max_pooled_bytes_;
+
+  mutable base::Lock lock_;
+  // Keyed by the floor size class of the capacity.
+  std::map<size_t, std::vector<std::string>> free_lists_ GUARDED_BY(lock_);
+  Stats stats_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(DataPool);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_LIB_CONTAINERS_DATA_POOL_H_
\ No newline at end of file
@@ -0,0 +1,47 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/lib/containers/data_pool.h"
+
+#include "benchmark/benchmark.h"
+
+#include "felicia/core/lib/containers/data.h"
+
+namespace felicia {
+
+namespace {
+
+// Writes every page, as a camera driver copying a frame does.
+void Touch(Data* data) {
+  char* ptr = data->cast<char*>();
+  for (size_t i = 0; i < data->size(); i += 4096) ptr[i] = 1;
+  benchmark::DoNotOptimize(ptr);
+}
+
+}  // namespace
+
+// Arg is the frame size, 640x480 I420, 1280x720 YUY2 and 1920x1080 RGB.
+static void BM_AllocateOnHeap(benchmark::State& state) {
+  const size_t size = state.range(0);
+  for (auto _ : state) {
+    Data data;
+    data.resize(size);
+    Touch(&data);
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+
+static void BM_AllocateFromPool(benchmark::State& state) {
+  const size_t size = state.range(0);
+  for (auto _ : state) {
+    Data data = Data::AllocateFromPool(size);
+    Touch(&data);
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_AllocateOnHeap)->Arg(460800)->Arg(1843200)->Arg(6220800);
+BENCHMARK(BM_AllocateFromPool)->Arg(460800)->Arg(1843200)->Arg(6220800);
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,94 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/lib/containers/data_pool.h"
+
+#include "gtest/gtest.h"
+
+#include "felicia/core/lib/containers/data.h"
+
+namespace felicia {
+
+TEST(DataPoolTest, SizeClass) {
+  EXPECT_EQ(0u, DataPool::CeilSizeClass(0));
+  EXPECT_EQ(1024u, DataPool::CeilSizeClass(1024));
+  EXPECT_EQ(1280u, DataPool::CeilSizeClass(1025));
+  EXPECT_EQ(1024u, DataPool::FloorSizeClass(1279));
+  EXPECT_EQ(1280u, DataPool::FloorSizeClass(1280));
+  EXPECT_EQ(1792u, DataPool::FloorSizeClass(2047));
+
+  // 640x480 I420.
+  const size_t size = 640 * 480 * 3 / 2;
+  EXPECT_LE(size, DataPool::CeilSizeClass(size));
+  EXPECT_GE(size, DataPool::FloorSizeClass(size));
+  EXPECT_LE(DataPool::CeilSizeClass(size), size + size / 4);
+}
+
+TEST(DataPoolTest, Reuse) {
+  DataPool data_pool;
+  const size_t size = 640 * 480 * 3 / 2;
+  std::string buffer = data_pool.Acquire(size);
+  EXPECT_EQ(size, buffer.size());
+  const char* ptr = buffer.data();
+  data_pool.Release(std::move(buffer));
+  EXPECT_LT(0u, data_pool.stats().pooled_bytes);
+
+  // A little smaller or larger one takes the same buffer.
+  buffer = data_pool.Acquire(size - 100);
+  EXPECT_EQ(ptr, buffer.data());
+  EXPECT_EQ(size - 100, buffer.size());
+  data_pool.Release(std::move(buffer));
+  buffer = data_pool.Acquire(size + 100);
+  EXPECT_EQ(ptr, buffer.data());
+
+  DataPool::Stats stats = data_pool.stats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(0u, stats.pooled_bytes);
+}
+
+TEST(DataPoolTest, ReleaseSmallOrTooMany) {
+  DataPool data_pool(DataPool::kMinPooledSize * 2);
+  data_pool.Release(std::string(DataPool::kMinPooledSize - 1, 0));
+  EXPECT_EQ(0u, data_pool.stats().pooled_bytes);
+
+  data_pool.Release(data_pool.Acquire(DataPool::kMinPooledSize));
+  size_t pooled_bytes = data_pool.stats().pooled_bytes;
+  EXPECT_LT(0u, pooled_bytes);
+  data_pool.Release(std::string(DataPool::kMinPooledSize * 2, 0));
+  EXPECT_EQ(pooled_bytes, data_pool.stats().pooled_bytes);
+}
+
+TEST(DataPoolTest, PooledData) {
+  const size_t size = 1280 * 720 * 2;
+  Data data = Data::AllocateFromPool(size);
+  EXPECT_TRUE(data.is_pooled());
+  EXPECT_EQ(size, data.size());
+
+  Data copied = data;
+  EXPECT_FALSE(copied.is_pooled());
+
+  Data moved = std::move(data);
+  EXPECT_TRUE(moved.is_pooled());
+  EXPECT_FALSE(data.is_pooled());
+
+  Data swapped;
+  swapped.swap(moved);
+  EXPECT_TRUE(swapped.is_pooled());
+  EXPECT_FALSE(moved.is_pooled());
+
+  const char* ptr = swapped.cast<const char*>();
+  swapped = Data();
+  EXPECT_FALSE(swapped.is_pooled());
+  Data reused = Data::AllocateFromPool(size);
+  EXPECT_EQ(ptr, reused.cast<const char*>());
+
+  std::vector<uint16_t> values(size / 2, 1);
+  Data from_values = Data::CopyFromPool(values.data(), values.size());
+  EXPECT_EQ(DATA_TYPE_16U_C1, from_values.type());
+  EXPECT_EQ(size, from_values.size());
+  EXPECT_EQ(1, from_values.cast<const uint16_t*>()[values.size() - 1]);
+}
+
+}  // namespace felicia
\ No newline at end of file
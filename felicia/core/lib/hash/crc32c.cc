@@ -0,0 +1,68 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/lib/hash/crc32c.h"
+
+#include <string.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace felicia {
+
+namespace {
+
+#if !defined(__SSE4_2__)
+// Reversed polynomial of CRC-32C.
+constexpr uint32_t kPolynomial = 0x82f63b78;
+
+struct Crc32cTable {
+  constexpr Crc32cTable() : values() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+      }
+      values[i] = crc;
+    }
+  }
+
+  uint32_t values[256];
+};
+
+constexpr Crc32cTable kTable;
+#endif  // !defined(__SSE4_2__)
+
+}  // namespace
+
+uint32_t Crc32c(const void* data, size_t length, uint32_t crc) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+#if defined(__SSE4_2__)
+#if defined(__x86_64__) || defined(_M_X64)
+  uint64_t crc64 = crc;
+  while (length >= sizeof(uint64_t)) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(uint64_t));
+    crc64 = _mm_crc32_u64(crc64, value);
+    p += sizeof(uint64_t);
+    length -= sizeof(uint64_t);
+  }
+  crc = static_cast<uint32_t>(crc64);
+#endif
+  while (length > 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+    --length;
+  }
+#else
+  while (length > 0) {
+    crc = kTable.values[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    --length;
+  }
+#endif  // defined(__SSE4_2__)
+  return ~crc;
+}
+
+}  // namespace felicia
\ No newline at end of file
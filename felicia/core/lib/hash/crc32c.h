@@ -0,0 +1,22 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_LIB_HASH_CRC32C_H_
+#define FELICIA_CORE_LIB_HASH_CRC32C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "felicia/core/lib/base/export.h"
+
+namespace felicia {
+
+// Returns the CRC-32C (Castagnoli) of |data|, continuing from |crc|, which is
+// the CRC-32C of the preceding bytes. It uses the crc32 instruction if SSE4.2
+// is enabled at compile time.
+FEL_EXPORT uint32_t Crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_LIB_HASH_CRC32C_H_
\ No newline at end of file
@@ -0,0 +1,35 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/lib/hash/crc32c.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace felicia {
+
+TEST(Crc32cTest, KnownValues) {
+  EXPECT_EQ(0u, Crc32c(nullptr, 0));
+
+  std::string text("123456789");
+  EXPECT_EQ(0xe3069283, Crc32c(text.data(), text.length()));
+
+  std::string zeros(32, '\0');
+  EXPECT_EQ(0x8a9136aa, Crc32c(zeros.data(), zeros.length()));
+
+  std::string ones(32, '\xff');
+  EXPECT_EQ(0x62a8ab43, Crc32c(ones.data(), ones.length()));
+}
+
+TEST(Crc32cTest, Extend) {
+  std::string text("The quick brown fox jumps over the lazy dog");
+  uint32_t crc = Crc32c(text.data(), text.length());
+  for (size_t i = 0; i <= text.length(); ++i) {
+    EXPECT_EQ(crc, Crc32c(text.data() + i, text.length() - i,
+                          Crc32c(text.data(), i)));
+  }
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -8,8 +8,12 @@
 
 #include <setjmp.h>
 
+#include <algorithm>
+
 #include "jpeglib.h"
 
+#include "third_party/chromium/base/logging.h"
+
 #include "felicia/core/lib/error/errors.h"
 
 namespace felicia {
@@ -96,6 +100,89 @@ void TermDestination(j_compress_ptr cinfo) {
   }
 }
 
+// Destination which writes straight into the caller's std::string, instead
+// of copying out of a fixed buffer.
+struct StringDestinationMgr : jpeg_destination_mgr {
+  static constexpr size_t kMinBufferSize = 16 * 1024;
+  std::string* destination;
+  // Bytes reserved for the first call, guessed from the image size.
+  size_t initial_size;
+};
+
+constexpr size_t StringDestinationMgr::kMinBufferSize;
+
+void InitStringDestination(j_compress_ptr cinfo) {
+  StringDestinationMgr* dest = static_cast<StringDestinationMgr*>(cinfo->dest);
+  std::string* destination = dest->destination;
+  size_t cur_size = destination->size();
+  size_t free_size =
+      std::max({dest->initial_size, StringDestinationMgr::kMinBufferSize,
+                destination->capacity() - cur_size});
+  destination->resize(cur_size + free_size);
+  dest->next_output_byte =
+      reinterpret_cast<JOCTET*>(&(*destination)[cur_size]);
+  dest->free_in_buffer = free_size;
+}
+
+// The whole of |destination| is written, so it just grows.
+boolean EmptyStringOutputBuffer(j_compress_ptr cinfo) {
+  StringDestinationMgr* dest = static_cast<StringDestinationMgr*>(cinfo->dest);
+  std::string* destination = dest->destination;
+  size_t cur_size = destination->size();
+  destination->resize(2 * cur_size);
+  dest->next_output_byte =
+      reinterpret_cast<JOCTET*>(&(*destination)[cur_size]);
+  dest->free_in_buffer = destination->size() - cur_size;
+  return TRUE;
+}
+
+void TermStringDestination(j_compress_ptr cinfo) {
+  StringDestinationMgr* dest = static_cast<StringDestinationMgr*>(cinfo->dest);
+  dest->destination->resize(dest->destination->size() - dest->free_in_buffer);
+}
+
+// Maps |pixel_format| to the input color space of |cinfo|. libjpeg-turbo
+// takes all of the packed formats as they are.
+bool SetInputColorSpace(PixelFormat pixel_format, jpeg_compress_struct* cinfo) {
+  switch (pixel_format) {
+    case PIXEL_FORMAT_BGRA:
+      cinfo->in_color_space = JCS_EXT_BGRA;
+      cinfo->input_components = 4;
+      break;
+    case PIXEL_FORMAT_BGR:
+      cinfo->in_color_space = JCS_EXT_BGR;
+      cinfo->input_components = 3;
+      break;
+    case PIXEL_FORMAT_BGRX:
+      cinfo->in_color_space = JCS_EXT_BGRX;
+      cinfo->input_components = 4;
+      break;
+    case PIXEL_FORMAT_Y8:
+      cinfo->in_color_space = JCS_GRAYSCALE;
+      cinfo->input_components = 1;
+      break;
+    case PIXEL_FORMAT_RGBA:
+      cinfo->in_color_space = JCS_EXT_RGBA;
+      cinfo->input_components = 4;
+      break;
+    case PIXEL_FORMAT_RGBX:
+      cinfo->in_color_space = JCS_EXT_RGBX;
+      cinfo->input_components = 4;
+      break;
+    case PIXEL_FORMAT_RGB:
+      cinfo->in_color_space = JCS_RGB;
+      cinfo->input_components = 3;
+      break;
+    case PIXEL_FORMAT_ARGB:
+      cinfo->in_color_space = JCS_EXT_ARGB;
+      cinfo->input_components = 4;
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
 // jpeg_compress_struct Deleter.
 struct JpegCompressStructDeleter {
   void operator()(jpeg_compress_struct* ptr) {
@@ -141,45 +228,11 @@ Status JpegCodec::Encode(const Image& image, const Options& options,
   cinfo->image_width = static_cast<JDIMENSION>(image.width());
   cinfo->image_height = static_cast<JDIMENSION>(image.height());
 
-  switch (image.pixel_format()) {
-    case PIXEL_FORMAT_BGRA:
-      cinfo->in_color_space = JCS_EXT_BGRA;
-      cinfo->input_components = 4;
-      break;
-    case PIXEL_FORMAT_BGR:
-      cinfo->in_color_space = JCS_EXT_BGR;
-      cinfo->input_components = 3;
-      break;
-    case PIXEL_FORMAT_BGRX:
-      cinfo->in_color_space = JCS_EXT_BGRX;
-      cinfo->input_components = 4;
-      break;
-    case PIXEL_FORMAT_Y8:
-      cinfo->in_color_space = JCS_GRAYSCALE;
-      cinfo->input_components = 1;
-      break;
-    case PIXEL_FORMAT_RGBA:
-      cinfo->in_color_space = JCS_EXT_RGBA;
-      cinfo->input_components = 4;
-      break;
-    case PIXEL_FORMAT_RGBX:
-      cinfo->in_color_space = JCS_EXT_RGBX;
-      cinfo->input_components = 4;
-      break;
-    case PIXEL_FORMAT_RGB:
-      cinfo->in_color_space = JCS_RGB;
-      cinfo->input_components = 3;
-      break;
-    case PIXEL_FORMAT_ARGB:
-      cinfo->in_color_space = JCS_EXT_ARGB;
-      cinfo->input_components = 4;
-      break;
-    default:
-      return errors::InvalidArgument("Invalid pixel format.");
-  }
+  if (!SetInputColorSpace(image.pixel_format(), cinfo.get()))
+    return errors::InvalidArgument("Invalid pixel format.");
 
   jpeg_set_defaults(cinfo.get());
-  cinfo->optimize_coding = TRUE;
+  cinfo->optimize_coding = options.optimize_coding;
 
   jpeg_set_quality(cinfo.get(), options.quality, TRUE);
   jpeg_start_compress(cinfo.get(), TRUE);
@@ -198,6 +251,167 @@ Status JpegCodec::Encode(const Image& image, const Options& options,
   return Status::OK();
 }
 
+// JpegEncoder -----------------------------------------------------------------
+
+struct JpegEncoder::Context {
+  jpeg_compress_struct cinfo;
+  CoderErrorMgr errmgr;
+  StringDestinationMgr dstmgr;
+};
+
+JpegEncoder::JpegEncoder(const JpegCodec::Options& options)
+    : context_(std::make_unique<Context>()), options_(options) {
+  jpeg_compress_struct* cinfo = &context_->cinfo;
+  cinfo->err = jpeg_std_error(&context_->errmgr.pub);
+  context_->errmgr.pub.error_exit = ErrorExit;
+  if (setjmp(context_->errmgr.setjmp_buffer)) {
+    LOG(FATAL) << "Failed to create jpeg_compress_struct.";
+  }
+  jpeg_create_compress(cinfo);
+
+  StringDestinationMgr* dstmgr = &context_->dstmgr;
+  dstmgr->init_destination = InitStringDestination;
+  dstmgr->empty_output_buffer = EmptyStringOutputBuffer;
+  dstmgr->term_destination = TermStringDestination;
+  cinfo->dest = dstmgr;
+}
+
+JpegEncoder::~JpegEncoder() { jpeg_destroy_compress(&context_->cinfo); }
+
+// static
+bool JpegEncoder::CanEncode(PixelFormat pixel_format) {
+  jpeg_compress_struct cinfo;
+  return pixel_format == PIXEL_FORMAT_I420 ||
+         SetInputColorSpace(pixel_format, &cinfo);
+}
+
+Status JpegEncoder::Encode(const Image& image, std::string* output) {
+  return Encode(image.data().cast<const uint8_t*>(), image.size(),
+                image.pixel_format(), output);
+}
+
+Status JpegEncoder::Encode(const uint8_t* data, const Sizei& size,
+                           PixelFormat pixel_format, std::string* output) {
+  if (size.width() <= 0 || size.height() <= 0)
+    return errors::InvalidArgument("Invalid size.");
+
+  jpeg_compress_struct* cinfo = &context_->cinfo;
+  const size_t start = output->size();
+  context_->dstmgr.destination = output;
+  // Most of the JPEGs from cameras are less than 1/8 of the I420.
+  context_->dstmgr.initial_size = size.area() / 8;
+
+  // jpeg_abort_compress() keeps the memory of |cinfo| for the next frame.
+  if (setjmp(context_->errmgr.setjmp_buffer)) {
+    jpeg_abort_compress(cinfo);
+    output->resize(start);
+    return errors::Unknown("Failed to encode.");
+  }
+
+  cinfo->image_width = static_cast<JDIMENSION>(size.width());
+  cinfo->image_height = static_cast<JDIMENSION>(size.height());
+  const bool is_i420 = pixel_format == PIXEL_FORMAT_I420;
+  if (is_i420) {
+    cinfo->in_color_space = JCS_YCbCr;
+    cinfo->input_components = 3;
+  } else if (!SetInputColorSpace(pixel_format, cinfo)) {
+    return errors::InvalidArgument("Invalid pixel format.");
+  }
+
+  jpeg_set_defaults(cinfo);
+  cinfo->optimize_coding = options_.optimize_coding;
+  jpeg_set_quality(cinfo, options_.quality, TRUE);
+  if (is_i420) {
+    // The planes are compressed as they are, without the color conversion
+    // and the downsampling of the chroma.
+    cinfo->raw_data_in = TRUE;
+    cinfo->comp_info[0].h_samp_factor = 2;
+    cinfo->comp_info[0].v_samp_factor = 2;
+    for (int i = 1; i < 3; ++i) {
+      cinfo->comp_info[i].h_samp_factor = 1;
+      cinfo->comp_info[i].v_samp_factor = 1;
+    }
+  }
+  jpeg_start_compress(cinfo, TRUE);
+
+  Status s = is_i420 ? WriteI420(data, size) : WriteScanlines(data);
+  if (!s.ok()) {
+    jpeg_abort_compress(cinfo);
+    output->resize(start);
+    return s;
+  }
+
+  jpeg_finish_compress(cinfo);
+  return Status::OK();
+}
+
+Status JpegEncoder::WriteScanlines(const uint8_t* data) {
+  jpeg_compress_struct* cinfo = &context_->cinfo;
+  const size_t row_stride = cinfo->image_width * cinfo->input_components;
+
+  JSAMPROW rows[2 * DCTSIZE];
+  while (cinfo->next_scanline < cinfo->image_height) {
+    const JDIMENSION num_rows = std::min<JDIMENSION>(
+        2 * DCTSIZE, cinfo->image_height - cinfo->next_scanline);
+    for (JDIMENSION row = 0; row < num_rows; ++row) {
+      rows[row] = const_cast<JSAMPROW>(
+          data + (cinfo->next_scanline + row) * row_stride);
+    }
+    if (jpeg_write_scanlines(cinfo, rows, num_rows) != num_rows)
+      return errors::InvalidArgument("Failed to write scanlines.");
+  }
+  return Status::OK();
+}
+
+Status JpegEncoder::WriteI420(const uint8_t* data, const Sizei& size) {
+  jpeg_compress_struct* cinfo = &context_->cinfo;
+  const int width = size.width();
+  const int height = size.height();
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  const int rows_per_imcu = cinfo->max_v_samp_factor * DCTSIZE;
+
+  const uint8_t* planes[3];
+  planes[0] = data;
+  planes[1] = planes[0] + width * height;
+  planes[2] = planes[1] + chroma_width * chroma_height;
+  const int plane_widths[3] = {width, chroma_width, chroma_width};
+  const int plane_heights[3] = {height, chroma_height, chroma_height};
+
+  JSAMPROW rows[3][2 * DCTSIZE];
+  JSAMPARRAY strips[3];
+  int strip_widths[3];
+  int strip_heights[3];
+  for (int i = 0; i < 3; ++i) {
+    strip_widths[i] = cinfo->comp_info[i].width_in_blocks * DCTSIZE;
+    strip_heights[i] = cinfo->comp_info[i].v_samp_factor * DCTSIZE;
+    strips_[i].resize(strip_widths[i] * strip_heights[i]);
+    for (int row = 0; row < strip_heights[i]; ++row) {
+      rows[i][row] = strips_[i].data() + row * strip_widths[i];
+    }
+    strips[i] = rows[i];
+  }
+
+  // libjpeg reads whole iMCU rows, so the edges are replicated up to the
+  // padded size.
+  while (cinfo->next_scanline < cinfo->image_height) {
+    const int luma_row = cinfo->next_scanline;
+    for (int i = 0; i < 3; ++i) {
+      const int first_row = luma_row * strip_heights[i] / rows_per_imcu;
+      for (int row = 0; row < strip_heights[i]; ++row) {
+        const int src_row = std::min(first_row + row, plane_heights[i] - 1);
+        unsigned char* dst = rows[i][row];
+        memcpy(dst, planes[i] + src_row * plane_widths[i], plane_widths[i]);
+        memset(dst + plane_widths[i], dst[plane_widths[i] - 1],
+               strip_widths[i] - plane_widths[i]);
+      }
+    }
+    if (jpeg_write_raw_data(cinfo, strips, rows_per_imcu) == 0)
+      return errors::InvalidArgument("Failed to write raw data.");
+  }
+  return Status::OK();
+}
+
 // Decoder --------------------------------------------------------------------
 
 namespace {
@@ -402,4 +616,180 @@ Status JpegCodec::Decode(const unsigned char* input, size_t input_size,
   return Status::OK();
 }
 
+// JpegDecoder -----------------------------------------------------------------
+
+struct JpegDecoder::Context {
+  jpeg_decompress_struct cinfo;
+  CoderErrorMgr errmgr;
+  jpeg_source_mgr srcmgr;
+  JpegDecoderState state{nullptr, 0};
+};
+
+JpegDecoder::JpegDecoder() : context_(std::make_unique<Context>()) {
+  jpeg_decompress_struct* cinfo = &context_->cinfo;
+  cinfo->err = jpeg_std_error(&context_->errmgr.pub);
+  context_->errmgr.pub.error_exit = ErrorExit;
+  if (setjmp(context_->errmgr.setjmp_buffer)) {
+    LOG(FATAL) << "Failed to create jpeg_decompress_struct.";
+  }
+  jpeg_create_decompress(cinfo);
+
+  // jpeg_create_decompress() clears everything but |err| and |client_data|.
+  jpeg_source_mgr* srcmgr = &context_->srcmgr;
+  srcmgr->init_source = InitSource;
+  srcmgr->fill_input_buffer = FillInputBuffer;
+  srcmgr->skip_input_data = SkipInputData;
+  srcmgr->resync_to_restart = jpeg_resync_to_restart;  // use default routine
+  srcmgr->term_source = TermSource;
+  cinfo->src = srcmgr;
+  cinfo->client_data = &context_->state;
+}
+
+JpegDecoder::~JpegDecoder() { jpeg_destroy_decompress(&context_->cinfo); }
+
+Status JpegDecoder::DecodeToI420(const unsigned char* input, size_t input_size,
+                                 const Sizei& min_size, Image* image) {
+  jpeg_decompress_struct* cinfo = &context_->cinfo;
+  context_->state = JpegDecoderState(input, input_size);
+
+  // jpeg_abort_decompress() keeps the memory of |cinfo| for the next frame,
+  // whether it succeeds or not.
+  if (setjmp(context_->errmgr.setjmp_buffer)) {
+    jpeg_abort_decompress(cinfo);
+    return errors::Unknown("Failed to decode.");
+  }
+
+  if (jpeg_read_header(cinfo, true) != JPEG_HEADER_OK) {
+    jpeg_abort_decompress(cinfo);
+    return errors::InvalidArgument("Failed to read header.");
+  }
+
+  const jpeg_component_info* comp_info = cinfo->comp_info;
+  if (cinfo->jpeg_color_space != JCS_YCbCr || cinfo->num_components != 3 ||
+      comp_info[0].h_samp_factor != 2 || comp_info[0].v_samp_factor > 2 ||
+      comp_info[1].h_samp_factor != 1 || comp_info[1].v_samp_factor != 1 ||
+      comp_info[2].h_samp_factor != 1 || comp_info[2].v_samp_factor != 1) {
+    jpeg_abort_decompress(cinfo);
+    return errors::Unimplemented(
+        "Only YCbCr of 4:2:0 or 4:2:2 can be decoded to I420.");
+  }
+
+  const int scale_denom = GetScaleDenom(
+      Sizei(cinfo->image_width, cinfo->image_height), min_size);
+  cinfo->raw_data_out = TRUE;
+  cinfo->out_color_space = JCS_YCbCr;
+  cinfo->do_fancy_upsampling = FALSE;
+  cinfo->scale_num = 1;
+  cinfo->scale_denom = scale_denom;
+  jpeg_start_decompress(cinfo);
+
+  const int width = cinfo->output_width;
+  const int height = cinfo->output_height;
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  const int block_size = DCTSIZE / scale_denom;
+  const int rows_per_imcu = cinfo->max_v_samp_factor * block_size;
+
+  image->set_size(Sizei(width, height));
+  image->set_pixel_format(PIXEL_FORMAT_I420);
+  image->data().resize(width * height + 2 * chroma_width * chroma_height);
+  unsigned char* planes[3];
+  planes[0] = image->data().cast<unsigned char*>();
+  planes[1] = planes[0] + width * height;
+  planes[2] = planes[1] + chroma_width * chroma_height;
+
+  JSAMPROW rows[3][2 * DCTSIZE];
+  JSAMPARRAY strips[3];
+  int strip_heights[3];
+  int plane_widths[3] = {width};
+  int plane_heights[3] = {height};
+  int steps_x[3] = {1};
+  int steps_y[3] = {1};
+  for (int i = 0; i < 3; ++i) {
+#if JPEG_LIB_VERSION >= 70
+    const int h_scaled_size = comp_info[i].DCT_h_scaled_size;
+    const int v_scaled_size = comp_info[i].DCT_v_scaled_size;
+#else
+    const int h_scaled_size = comp_info[i].DCT_scaled_size;
+    const int v_scaled_size = comp_info[i].DCT_scaled_size;
+#endif
+    const int strip_width = comp_info[i].width_in_blocks * h_scaled_size;
+    strip_heights[i] = comp_info[i].v_samp_factor * v_scaled_size;
+    strips_[i].resize(strip_width * strip_heights[i]);
+    for (int row = 0; row < strip_heights[i]; ++row) {
+      rows[i][row] = strips_[i].data() + row * strip_width;
+    }
+    strips[i] = rows[i];
+    if (i == 0) continue;
+
+    // libjpeg-turbo upsamples the chroma in the IDCT when it scales, and 4:2:2
+    // has the chroma of every row. Such chroma is halved at the end.
+    steps_x[i] = h_scaled_size / block_size;
+    steps_y[i] = 2 * v_scaled_size / rows_per_imcu;
+    plane_widths[i] = steps_x[i] == 1 ? chroma_width : width;
+    plane_heights[i] = steps_y[i] == 1 ? chroma_height : height;
+    if (steps_x[i] != 1 || steps_y[i] != 1) {
+      chroma_[i - 1].resize(plane_widths[i] * plane_heights[i]);
+      planes[i] = chroma_[i - 1].data();
+    }
+  }
+
+  while (cinfo->output_scanline < cinfo->output_height) {
+    const int luma_row = cinfo->output_scanline;
+    if (jpeg_read_raw_data(cinfo, strips, rows_per_imcu) == 0) {
+      jpeg_abort_decompress(cinfo);
+      return errors::InvalidArgument("Failed to read raw data.");
+    }
+
+    for (int i = 0; i < 3; ++i) {
+      const int first_row = luma_row * strip_heights[i] / rows_per_imcu;
+      for (int row = 0;
+           row < strip_heights[i] && first_row + row < plane_heights[i];
+           ++row) {
+        memcpy(planes[i] + (first_row + row) * plane_widths[i], rows[i][row],
+               plane_widths[i]);
+      }
+    }
+  }
+  // The trailing markers aren't needed.
+  jpeg_abort_decompress(cinfo);
+
+  for (int i = 1; i < 3; ++i) {
+    if (steps_x[i] == 1 && steps_y[i] == 1) continue;
+    unsigned char* dst = image->data().cast<unsigned char*>() +
+                         width * height +
+                         (i - 1) * chroma_width * chroma_height;
+    const unsigned char* src = chroma_[i - 1].data();
+    const int src_width = plane_widths[i];
+    const int src_height = plane_heights[i];
+    for (int y = 0; y < chroma_height; ++y) {
+      const int y0 = y * steps_y[i];
+      const int y1 = std::min(y0 + steps_y[i] - 1, src_height - 1);
+      for (int x = 0; x < chroma_width; ++x) {
+        const int x0 = x * steps_x[i];
+        const int x1 = std::min(x0 + steps_x[i] - 1, src_width - 1);
+        dst[y * chroma_width + x] =
+            (src[y0 * src_width + x0] + src[y0 * src_width + x1] +
+             src[y1 * src_width + x0] + src[y1 * src_width + x1] + 2) /
+            4;
+      }
+    }
+  }
+
+  return Status::OK();
+}
+
+// static
+int JpegDecoder::GetScaleDenom(const Sizei& size, const Sizei& min_size) {
+  if (min_size.width() <= 0 || min_size.height() <= 0) return 1;
+
+  for (int scale_denom = 8; scale_denom > 1; scale_denom /= 2) {
+    if ((size.width() + scale_denom - 1) / scale_denom >= min_size.width() &&
+        (size.height() + scale_denom - 1) / scale_denom >= min_size.height()) {
+      return scale_denom;
+    }
+  }
+  return 1;
+}
+
 }  // namespace felicia
\ No newline at end of file
@@ -9,8 +9,13 @@
 
 #include <stddef.h>
 
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "third_party/chromium/base/macros.h"
+
+#include "felicia/core/lib/base/export.h"
 #include "felicia/core/lib/error/status.h"
 #include "felicia/core/lib/image/image.h"
 
@@ -21,6 +26,9 @@ class JpegCodec {
   struct Options {
     // quality should be between 0 and 100
     int quality = 100;
+    // Huffman tables fit to the image make it a bit smaller, but cost a
+    // second pass. Streams usually turn it off.
+    bool optimize_coding = true;
   };
 
   static Status Encode(const Image& image, const Options& options,
@@ -30,6 +38,87 @@ class JpegCodec {
                        Image* image);
 };
 
+// Encodes a stream of images, e.g, camera frames to publish, into JPEG.
+// Unlike |JpegCodec::Encode()|, it
+//  - appends to a caller's std::string, e.g, the data of a message, without
+//    copying through an intermediate buffer.
+//  - takes PIXEL_FORMAT_I420 as well, whose planes are compressed as they
+//    are, skipping the color conversion and the downsampling of the chroma.
+//  - reuses the jpeg_compress_struct and its memory across frames.
+//
+// It's not thread safe.
+class FEL_EXPORT JpegEncoder {
+ public:
+  explicit JpegEncoder(
+      const JpegCodec::Options& options = JpegCodec::Options());
+  ~JpegEncoder();
+
+  const JpegCodec::Options& options() const { return options_; }
+  void set_options(const JpegCodec::Options& options) { options_ = options; }
+
+  // Returns true if |pixel_format| is taken by |Encode()|.
+  static bool CanEncode(PixelFormat pixel_format);
+
+  // Appends the JPEG of |data| to |output|. |output| is left as it was on
+  // failure.
+  Status Encode(const uint8_t* data, const Sizei& size,
+                PixelFormat pixel_format, std::string* output);
+  Status Encode(const Image& image, std::string* output);
+
+ private:
+  struct Context;
+
+  Status WriteScanlines(const uint8_t* data);
+  Status WriteI420(const uint8_t* data, const Sizei& size);
+
+  std::unique_ptr<Context> context_;
+  JpegCodec::Options options_;
+  // Rows of a single iMCU row, padded up to the size libjpeg reads.
+  std::vector<unsigned char> strips_[3];
+
+  DISALLOW_COPY_AND_ASSIGN(JpegEncoder);
+};
+
+// Decodes a stream of JPEGs, e.g, MJPEG from a camera, into I420. Unlike
+// |JpegCodec::Decode()|, it
+//  - reads the YCbCr planes as they are, skipping the color conversion and
+//    the upsampling of the chroma.
+//  - scales down by 1/2, 1/4 or 1/8 in the DCT domain, when a smaller size is
+//    enough.
+//  - reuses the jpeg_decompress_struct and its memory across frames.
+//
+// Only 3 component YCbCr of 4:2:0 or 4:2:2, which is what cameras send, is
+// supported. Otherwise it returns errors::Unimplemented and the caller
+// should fall back to the other decoder.
+//
+// It's not thread safe.
+class FEL_EXPORT JpegDecoder {
+ public:
+  JpegDecoder();
+  ~JpegDecoder();
+
+  // Decodes into |image| of PIXEL_FORMAT_I420. Unless |min_size| is empty,
+  // it's decoded at the smallest scale which is still as large as
+  // |min_size|, so the size of |image| may not be the size of the JPEG.
+  Status DecodeToI420(const unsigned char* input, size_t input_size,
+                      const Sizei& min_size, Image* image);
+
+  // Returns the largest of 1, 2, 4 and 8 by which |size| is scaled down and
+  // is still as large as |min_size|.
+  static int GetScaleDenom(const Sizei& size, const Sizei& min_size);
+
+ private:
+  struct Context;
+
+  std::unique_ptr<Context> context_;
+  // Rows of a single iMCU row, since libjpeg writes up to the padded size.
+  std::vector<unsigned char> strips_[3];
+  // Chroma which is decoded larger than I420 and halved at the end.
+  std::vector<unsigned char> chroma_[2];
+
+  DISALLOW_COPY_AND_ASSIGN(JpegDecoder);
+};
+
 }  // namespace felicia
 
 #endif  // FELICIA_CORE_LIB_IMAGE_JPEG_CODEC_H_
\ No newline at end of file
@@ -0,0 +1,403 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/lib/image/jpeg_codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "jpeglib.h"
+
+#include "felicia/core/lib/error/errors.h"
+
+namespace felicia {
+
+namespace {
+
+// The decoders round differently, and scaling in the DCT domain isn't quite
+// averaging the pixels.
+constexpr int kMaxDiff = 12;
+constexpr double kMaxMeanDiff = 2.0;
+
+// A smooth RGB image, so that the chroma barely changes when it's
+// subsampled.
+std::string MakeRGBImage(int width, int height) {
+  std::string rgb(width * height * 3, 0);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      char* pixel = &rgb[(y * width + x) * 3];
+      pixel[0] = static_cast<char>(64 + x);
+      pixel[1] = static_cast<char>(64 + y * 2);
+      pixel[2] = static_cast<char>(160 - x / 2);
+    }
+  }
+  return rgb;
+}
+
+// JpegCodec::Encode() always subsamples to 4:2:0, so this sets the sampling
+// factors of the luma.
+std::vector<unsigned char> EncodeJpeg(const std::string& rgb, int width,
+                                      int height, int h_samp_factor,
+                                      int v_samp_factor) {
+  jpeg_compress_struct cinfo;
+  jpeg_error_mgr jerr;
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+  unsigned char* buffer = nullptr;
+  unsigned long size = 0;
+  jpeg_mem_dest(&cinfo, &buffer, &size);
+
+  cinfo.image_width = width;
+  cinfo.image_height = height;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, 95, TRUE);
+  cinfo.comp_info[0].h_samp_factor = h_samp_factor;
+  cinfo.comp_info[0].v_samp_factor = v_samp_factor;
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW row = reinterpret_cast<JSAMPROW>(const_cast<char*>(rgb.data())) +
+                   cinfo.next_scanline * width * 3;
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+
+  std::vector<unsigned char> jpeg(buffer, buffer + size);
+  free(buffer);
+  return jpeg;
+}
+
+// A plane of full range YCbCr, as JPEG stores it.
+struct Plane {
+  int width;
+  int height;
+  std::vector<double> samples;
+
+  double at(int x, int y) const { return samples[y * width + x]; }
+};
+
+// Converts |rgb| to Y, Cb and Cr.
+void ToYCbCr(const Image& rgb, Plane planes[3]) {
+  const uint8_t* data = rgb.data().cast<const uint8_t*>();
+  for (int i = 0; i < 3; ++i) {
+    planes[i].width = rgb.width();
+    planes[i].height = rgb.height();
+    planes[i].samples.resize(rgb.width() * rgb.height());
+  }
+  for (int i = 0; i < rgb.width() * rgb.height(); ++i) {
+    const double r = data[i * 3];
+    const double g = data[i * 3 + 1];
+    const double b = data[i * 3 + 2];
+    planes[0].samples[i] = 0.299 * r + 0.587 * g + 0.114 * b;
+    planes[1].samples[i] = -0.168736 * r - 0.331264 * g + 0.5 * b + 128;
+    planes[2].samples[i] = 0.5 * r - 0.418688 * g - 0.081312 * b + 128;
+  }
+}
+
+// Compares |actual| of |width| x |height| to |plane| which is averaged over
+// every |block| x |block| pixels, clipped at the edges.
+testing::AssertionResult IsNearScaled(const Plane& plane, int block,
+                                      const uint8_t* actual, int width,
+                                      int height) {
+  int max_diff = 0;
+  double total_diff = 0;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      double sum = 0;
+      int count = 0;
+      for (int sy = y * block; sy < std::min((y + 1) * block, plane.height);
+           ++sy) {
+        for (int sx = x * block; sx < std::min((x + 1) * block, plane.width);
+             ++sx) {
+          sum += plane.at(sx, sy);
+          count++;
+        }
+      }
+      if (count == 0) {
+        return testing::AssertionFailure()
+               << "(" << x << ", " << y << ") is out of the image";
+      }
+      double diff = std::abs(sum / count - actual[y * width + x]);
+      max_diff = std::max(max_diff, static_cast<int>(diff + 0.5));
+      total_diff += diff;
+    }
+  }
+  double mean_diff = total_diff / (width * height);
+  if (max_diff > kMaxDiff || mean_diff > kMaxMeanDiff) {
+    return testing::AssertionFailure()
+           << "max diff " << max_diff << ", mean diff " << mean_diff;
+  }
+  return testing::AssertionSuccess();
+}
+
+// Compares |size| samples of |actual| to |expected|.
+testing::AssertionResult IsNear(const uint8_t* expected, const uint8_t* actual,
+                                size_t size) {
+  int max_diff = 0;
+  double total_diff = 0;
+  for (size_t i = 0; i < size; ++i) {
+    int diff = std::abs(static_cast<int>(expected[i]) - actual[i]);
+    max_diff = std::max(max_diff, diff);
+    total_diff += diff;
+  }
+  double mean_diff = total_diff / size;
+  if (max_diff > kMaxDiff || mean_diff > kMaxMeanDiff) {
+    return testing::AssertionFailure()
+           << "max diff " << max_diff << ", mean diff " << mean_diff;
+  }
+  return testing::AssertionSuccess();
+}
+
+// Converts |rgb| to I420, averaging the chroma over every 2 x 2 pixels.
+std::string ToI420(const Image& rgb) {
+  Plane planes[3];
+  ToYCbCr(rgb, planes);
+  const int width = rgb.width();
+  const int height = rgb.height();
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  std::string i420;
+  for (double sample : planes[0].samples) {
+    i420.push_back(static_cast<char>(sample + 0.5));
+  }
+  for (int i = 1; i < 3; ++i) {
+    for (int y = 0; y < chroma_height; ++y) {
+      for (int x = 0; x < chroma_width; ++x) {
+        double sum = 0;
+        int count = 0;
+        for (int sy = y * 2; sy < std::min(y * 2 + 2, height); ++sy) {
+          for (int sx = x * 2; sx < std::min(x * 2 + 2, width); ++sx) {
+            sum += planes[i].at(sx, sy);
+            count++;
+          }
+        }
+        i420.push_back(static_cast<char>(sum / count + 0.5));
+      }
+    }
+  }
+  return i420;
+}
+
+}  // namespace
+
+TEST(JpegEncoderTest, CanEncode) {
+  EXPECT_TRUE(JpegEncoder::CanEncode(PIXEL_FORMAT_I420));
+  EXPECT_TRUE(JpegEncoder::CanEncode(PIXEL_FORMAT_BGR));
+  EXPECT_TRUE(JpegEncoder::CanEncode(PIXEL_FORMAT_Y8));
+  EXPECT_FALSE(JpegEncoder::CanEncode(PIXEL_FORMAT_NV12));
+  EXPECT_FALSE(JpegEncoder::CanEncode(PIXEL_FORMAT_MJPEG));
+}
+
+// Encodes BGR after what's already in the output, and compares it with
+// what JpegCodec::Decode() gives.
+TEST(JpegEncoderTest, EncodeBGR) {
+  const int width = 96;
+  const int height = 40;
+  std::string bgr = MakeRGBImage(width, height);
+  for (size_t i = 0; i < bgr.size(); i += 3) std::swap(bgr[i], bgr[i + 2]);
+
+  JpegCodec::Options options;
+  options.quality = 95;
+  JpegEncoder encoder(options);
+  const std::string prefix = "prefix";
+  std::string output = prefix;
+  ASSERT_TRUE(encoder
+                  .Encode(reinterpret_cast<const uint8_t*>(bgr.data()),
+                          Sizei(width, height), PIXEL_FORMAT_BGR, &output)
+                  .ok());
+  ASSERT_LT(prefix.size(), output.size());
+  EXPECT_EQ(prefix, output.substr(0, prefix.size()));
+
+  Image image;
+  image.set_pixel_format(PIXEL_FORMAT_BGR);
+  ASSERT_TRUE(JpegCodec::Decode(
+                  reinterpret_cast<const unsigned char*>(output.data()) +
+                      prefix.size(),
+                  output.size() - prefix.size(), &image)
+                  .ok());
+  ASSERT_EQ(Sizei(width, height), image.size());
+  ASSERT_EQ(bgr.size(), image.data().size());
+  EXPECT_TRUE(IsNear(reinterpret_cast<const uint8_t*>(bgr.data()),
+                     image.data().cast<const uint8_t*>(), bgr.size()));
+
+  // The encoder is reused for the next frame, which is appended too.
+  const std::string jpeg = output.substr(prefix.size());
+  ASSERT_TRUE(encoder
+                  .Encode(reinterpret_cast<const uint8_t*>(bgr.data()),
+                          Sizei(width, height), PIXEL_FORMAT_BGR, &output)
+                  .ok());
+  EXPECT_EQ(prefix + jpeg + jpeg, output);
+}
+
+// Encodes the planes of I420 as they are, and compares them with what
+// JpegDecoder gives.
+TEST(JpegEncoderTest, EncodeI420) {
+  const Sizei sizes[] = {Sizei(128, 64), Sizei(97, 41)};
+  JpegCodec::Options options;
+  options.quality = 95;
+  JpegEncoder encoder(options);
+  JpegDecoder decoder;
+
+  for (const Sizei& size : sizes) {
+    SCOPED_TRACE(size.ToString());
+    const int width = size.width();
+    const int height = size.height();
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_height = (height + 1) / 2;
+    Image rgb(size, PIXEL_FORMAT_RGB, Data(MakeRGBImage(width, height)));
+    Plane planes[3];
+    ToYCbCr(rgb, planes);
+    const std::string i420 = ToI420(rgb);
+
+    std::string output;
+    ASSERT_TRUE(encoder
+                    .Encode(reinterpret_cast<const uint8_t*>(i420.data()),
+                            size, PIXEL_FORMAT_I420, &output)
+                    .ok());
+
+    Image image;
+    ASSERT_TRUE(decoder
+                    .DecodeToI420(
+                        reinterpret_cast<const unsigned char*>(output.data()),
+                        output.size(), Sizei(), &image)
+                    .ok());
+    ASSERT_EQ(size, image.size());
+    ASSERT_EQ(i420.size(), image.data().size());
+    const uint8_t* y = image.data().cast<const uint8_t*>();
+    const uint8_t* u = y + width * height;
+    const uint8_t* v = u + chroma_width * chroma_height;
+    EXPECT_TRUE(IsNearScaled(planes[0], 1, y, width, height));
+    EXPECT_TRUE(IsNearScaled(planes[1], 2, u, chroma_width, chroma_height));
+    EXPECT_TRUE(IsNearScaled(planes[2], 2, v, chroma_width, chroma_height));
+  }
+}
+
+TEST(JpegEncoderTest, EncodeFailure) {
+  const std::string rgb = MakeRGBImage(32, 32);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(rgb.data());
+  JpegEncoder encoder;
+  const std::string prefix = "prefix";
+  std::string output = prefix;
+  EXPECT_FALSE(encoder.Encode(data, Sizei(), PIXEL_FORMAT_RGB, &output).ok());
+  EXPECT_EQ(prefix, output);
+  EXPECT_FALSE(
+      encoder.Encode(data, Sizei(32, 32), PIXEL_FORMAT_NV12, &output).ok());
+  EXPECT_EQ(prefix, output);
+
+  // It still encodes the next frame.
+  EXPECT_TRUE(
+      encoder.Encode(data, Sizei(32, 32), PIXEL_FORMAT_RGB, &output).ok());
+  EXPECT_LT(prefix.size(), output.size());
+}
+
+TEST(JpegDecoderTest, GetScaleDenom) {
+  const Sizei size(1280, 720);
+  EXPECT_EQ(1, JpegDecoder::GetScaleDenom(size, Sizei()));
+  EXPECT_EQ(1, JpegDecoder::GetScaleDenom(size, size));
+  EXPECT_EQ(1, JpegDecoder::GetScaleDenom(size, Sizei(641, 360)));
+  EXPECT_EQ(2, JpegDecoder::GetScaleDenom(size, Sizei(640, 360)));
+  EXPECT_EQ(2, JpegDecoder::GetScaleDenom(size, Sizei(320, 181)));
+  EXPECT_EQ(4, JpegDecoder::GetScaleDenom(size, Sizei(320, 180)));
+  EXPECT_EQ(4, JpegDecoder::GetScaleDenom(size, Sizei(161, 90)));
+  EXPECT_EQ(8, JpegDecoder::GetScaleDenom(size, Sizei(160, 90)));
+  EXPECT_EQ(8, JpegDecoder::GetScaleDenom(size, Sizei(1, 1)));
+  // Rounded up, as libjpeg does.
+  EXPECT_EQ(8, JpegDecoder::GetScaleDenom(Sizei(100, 50), Sizei(13, 7)));
+  EXPECT_EQ(4, JpegDecoder::GetScaleDenom(Sizei(100, 50), Sizei(13, 8)));
+}
+
+// Decodes 4:2:0 and 4:2:2 at every scale, and compares the planes with what
+// JpegCodec::Decode() gives, converted to I420 and scaled down by averaging.
+TEST(JpegDecoderTest, DecodeToI420) {
+  // A single decoder is reused across the frames.
+  JpegDecoder decoder;
+  const Sizei sizes[] = {Sizei(128, 64), Sizei(96, 40)};
+  // 4:2:0 and 4:2:2
+  const int v_samp_factors[] = {2, 1};
+
+  for (const Sizei& size : sizes) {
+    const std::string rgb = MakeRGBImage(size.width(), size.height());
+    for (int v_samp_factor : v_samp_factors) {
+      std::vector<unsigned char> jpeg =
+          EncodeJpeg(rgb, size.width(), size.height(), 2, v_samp_factor);
+
+      Image expected;
+      expected.set_pixel_format(PIXEL_FORMAT_RGB);
+      ASSERT_TRUE(JpegCodec::Decode(jpeg.data(), jpeg.size(), &expected).ok());
+      ASSERT_EQ(size, expected.size());
+      Plane planes[3];
+      ToYCbCr(expected, planes);
+
+      for (int scale_denom : {1, 2, 4, 8}) {
+        SCOPED_TRACE(size.ToString() + (v_samp_factor == 2 ? " 4:2:0" :
+                                                             " 4:2:2") +
+                     " 1/" + std::to_string(scale_denom));
+        const Sizei min_size(size.width() / scale_denom,
+                             size.height() / scale_denom);
+        ASSERT_EQ(scale_denom, JpegDecoder::GetScaleDenom(size, min_size));
+
+        Image actual;
+        ASSERT_TRUE(
+            decoder.DecodeToI420(jpeg.data(), jpeg.size(), min_size, &actual)
+                .ok());
+        const int width = (size.width() + scale_denom - 1) / scale_denom;
+        const int height = (size.height() + scale_denom - 1) / scale_denom;
+        const int chroma_width = (width + 1) / 2;
+        const int chroma_height = (height + 1) / 2;
+        EXPECT_EQ(PIXEL_FORMAT_I420, actual.pixel_format());
+        ASSERT_EQ(Sizei(width, height), actual.size());
+        ASSERT_EQ(static_cast<size_t>(width * height +
+                                      2 * chroma_width * chroma_height),
+                  actual.data().size());
+
+        const uint8_t* y = actual.data().cast<const uint8_t*>();
+        const uint8_t* u = y + width * height;
+        const uint8_t* v = u + chroma_width * chroma_height;
+        EXPECT_TRUE(IsNearScaled(planes[0], scale_denom, y, width, height));
+        EXPECT_TRUE(IsNearScaled(planes[1], 2 * scale_denom, u, chroma_width,
+                                 chroma_height));
+        EXPECT_TRUE(IsNearScaled(planes[2], 2 * scale_denom, v, chroma_width,
+                                 chroma_height));
+      }
+    }
+  }
+}
+
+TEST(JpegDecoderTest, DecodeToI420Unimplemented) {
+  const std::string rgb = MakeRGBImage(32, 32);
+  // 4:4:4
+  std::vector<unsigned char> jpeg = EncodeJpeg(rgb, 32, 32, 1, 1);
+  JpegDecoder decoder;
+  Image image;
+  EXPECT_TRUE(errors::IsUnimplemented(
+      decoder.DecodeToI420(jpeg.data(), jpeg.size(), Sizei(), &image)));
+
+  // It still decodes the next frame.
+  jpeg = EncodeJpeg(rgb, 32, 32, 2, 2);
+  EXPECT_TRUE(
+      decoder.DecodeToI420(jpeg.data(), jpeg.size(), Sizei(), &image).ok());
+  EXPECT_EQ(Sizei(32, 32), image.size());
+}
+
+TEST(JpegDecoderTest, DecodeToI420Corrupted) {
+  const std::string rgb = MakeRGBImage(32, 32);
+  std::vector<unsigned char> jpeg = EncodeJpeg(rgb, 32, 32, 2, 2);
+  JpegDecoder decoder;
+  Image image;
+  EXPECT_FALSE(
+      decoder.DecodeToI420(jpeg.data(), jpeg.size() / 4, Sizei(), &image)
+          .ok());
+  EXPECT_FALSE(decoder.DecodeToI420(jpeg.data(), 2, Sizei(), &image).ok());
+
+  EXPECT_TRUE(
+      decoder.DecodeToI420(jpeg.data(), jpeg.size(), Sizei(), &image).ok());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -62,12 +62,17 @@ class PngWriteStructInfo {
   DISALLOW_COPY_AND_ASSIGN(PngWriteStructInfo);
 };
 
-}  // namespace
+// Called by libpng to write straight into the caller's std::string.
+void StringWriteCallback(png_structp png, png_bytep data, png_size_t size) {
+  std::string* output = static_cast<std::string*>(png_get_io_ptr(png));
+  output->append(reinterpret_cast<const char*>(data), size);
+}
 
-// static
-Status PngCodec::Encode(const Image& image, const Options& options,
-                        std::vector<unsigned char>* output) {
-  output->clear();
+// Encodes |data| with |write_fn|, which is given |io_ptr|.
+Status EncodeWith(const uint8_t* data, const Sizei& size,
+                  PixelFormat pixel_format,
+                  const PngCodec::Options& options, png_rw_ptr write_fn,
+                  void* io_ptr) {
   PngWriteStructInfo si;
   Status s = si.Build();
   if (!s.ok()) return s;
@@ -76,15 +81,13 @@ Status PngCodec::Encode(const Image& image, const Options& options,
     // The destroyer will ensure that the structures are cleaned up in this
     // case, even though we may get here as a jump from random parts of the
     // PNG library called below.
-    return errors::Unknown("Failed to decode.");
+    return errors::Unknown("Failed to encode.");
   }
 
-  PngEncoderState state(output);
-  png_set_write_fn(si.png_ptr_, &state, EncoderWriteCallback, 0);
+  png_set_write_fn(si.png_ptr_, io_ptr, write_fn, 0);
 
   int output_channels;
   int output_color_type;
-  PixelFormat pixel_format = image.pixel_format();
   switch (pixel_format) {
     case PIXEL_FORMAT_BGRA:
       output_channels = 4;
@@ -114,12 +117,11 @@ Status PngCodec::Encode(const Image& image, const Options& options,
       output_color_type = PNG_COLOR_TYPE_RGB;
       break;
     default:
-      NOTREACHED();
-      break;
+      return errors::InvalidArgument("Invalid pixel format.");
   }
 
   png_set_IHDR(
-      si.png_ptr_, si.info_ptr_, image.width(), image.height(),
+      si.png_ptr_, si.info_ptr_, size.width(), size.height(),
       (pixel_format == PIXEL_FORMAT_Y16 || pixel_format == PIXEL_FORMAT_Z16)
           ? 16
           : 8,
@@ -130,9 +132,9 @@ Status PngCodec::Encode(const Image& image, const Options& options,
   png_set_compression_level(si.png_ptr_, compression_level);
   png_write_info(si.png_ptr_, si.info_ptr_);
 
-  const unsigned char* rowptr = image.data().cast<const unsigned char*>();
-  int row_read_stride = image.width() * output_channels;
-  for (int row = 0; row < image.height(); row++, rowptr += row_read_stride) {
+  const unsigned char* rowptr = data;
+  int row_read_stride = size.width() * output_channels;
+  for (int row = 0; row < size.height(); row++, rowptr += row_read_stride) {
     png_write_row(si.png_ptr_, rowptr);
   }
 
@@ -140,6 +142,45 @@ Status PngCodec::Encode(const Image& image, const Options& options,
   return Status::OK();
 }
 
+}  // namespace
+
+// static
+Status PngCodec::Encode(const Image& image, const Options& options,
+                        std::vector<unsigned char>* output) {
+  output->clear();
+  PngEncoderState state(output);
+  return EncodeWith(image.data().cast<const uint8_t*>(), image.size(),
+                    image.pixel_format(), options, EncoderWriteCallback,
+                    &state);
+}
+
+// PngEncoder -----------------------------------------------------------------
+
+PngEncoder::PngEncoder(const PngCodec::Options& options) : options_(options) {}
+
+PngEncoder::~PngEncoder() = default;
+
+Status PngEncoder::Encode(const Image& image, std::string* output) {
+  return Encode(image.data().cast<const uint8_t*>(), image.size(),
+                image.pixel_format(), output);
+}
+
+Status PngEncoder::Encode(const uint8_t* data, const Sizei& size,
+                          PixelFormat pixel_format, std::string* output) {
+  const size_t start = output->size();
+  // libpng writes in small chunks, so the room for the whole image is made
+  // up front from the size of the last one.
+  output->reserve(start + last_size_);
+  Status s = EncodeWith(data, size, pixel_format, options_,
+                        StringWriteCallback, output);
+  if (!s.ok()) {
+    output->resize(start);
+    return s;
+  }
+  last_size_ = output->size() - start;
+  return Status::OK();
+}
+
 // Decoder --------------------------------------------------------------------
 //
 // This code is based on WebKit libpng interface (PNGImageDecoder), which is
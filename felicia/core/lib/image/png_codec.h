@@ -9,8 +9,11 @@
 
 #include <stddef.h>
 
+#include <string>
 #include <vector>
 
+#include "third_party/chromium/base/macros.h"
+
 #include "felicia/core/lib/base/export.h"
 #include "felicia/core/lib/error/status.h"
 #include "felicia/core/lib/image/image.h"
@@ -32,6 +35,33 @@ class FEL_EXPORT PngCodec {
                        Image* image);
 };
 
+// Encodes a stream of images into PNG. Unlike |PngCodec::Encode()|, it
+// appends to a caller's std::string, e.g, the data of a message, which is
+// reserved from the size of the last image. libpng can't reset its
+// png_struct, so the state isn't kept across images.
+//
+// It's not thread safe.
+class FEL_EXPORT PngEncoder {
+ public:
+  explicit PngEncoder(const PngCodec::Options& options = PngCodec::Options());
+  ~PngEncoder();
+
+  const PngCodec::Options& options() const { return options_; }
+  void set_options(const PngCodec::Options& options) { options_ = options; }
+
+  // Appends the PNG of |data| to |output|. |output| is left as it was on
+  // failure.
+  Status Encode(const uint8_t* data, const Sizei& size,
+                PixelFormat pixel_format, std::string* output);
+  Status Encode(const Image& image, std::string* output);
+
+ private:
+  PngCodec::Options options_;
+  size_t last_size_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(PngEncoder);
+};
+
 }  // namespace felicia
 
 #endif  // FELICIA_CORE_LIB_IMAGE_PNG_CODEC_H_
\ No newline at end of file
@@ -0,0 +1,83 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/lib/image/png_codec.h"
+
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+namespace felicia {
+
+namespace {
+
+std::string MakeRGBImage(int width, int height) {
+  std::string rgb(width * height * 3, 0);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      char* pixel = &rgb[(y * width + x) * 3];
+      pixel[0] = static_cast<char>(x * 5);
+      pixel[1] = static_cast<char>(y * 7);
+      pixel[2] = static_cast<char>(x * y);
+    }
+  }
+  return rgb;
+}
+
+}  // namespace
+
+// Appends to what's already in the output the same PNG as PngCodec::Encode()
+// does, which PngCodec::Decode() gives back losslessly.
+TEST(PngEncoderTest, Encode) {
+  const Sizei size(48, 30);
+  Image image(size, PIXEL_FORMAT_RGB,
+              Data(MakeRGBImage(size.width(), size.height())));
+  std::vector<unsigned char> expected;
+  ASSERT_TRUE(PngCodec::Encode(image, PngCodec::Options(), &expected).ok());
+
+  PngEncoder encoder;
+  const std::string prefix = "prefix";
+  std::string output = prefix;
+  ASSERT_TRUE(encoder.Encode(image, &output).ok());
+  EXPECT_EQ(prefix, output.substr(0, prefix.size()));
+  EXPECT_EQ(std::string(expected.begin(), expected.end()),
+            output.substr(prefix.size()));
+
+  Image decoded;
+  decoded.set_pixel_format(PIXEL_FORMAT_RGB);
+  ASSERT_TRUE(PngCodec::Decode(
+                  reinterpret_cast<const unsigned char*>(output.data()) +
+                      prefix.size(),
+                  output.size() - prefix.size(), &decoded)
+                  .ok());
+  EXPECT_EQ(size, decoded.size());
+  ASSERT_EQ(image.data().size(), decoded.data().size());
+  EXPECT_EQ(0, memcmp(image.data().cast<const uint8_t*>(),
+                      decoded.data().cast<const uint8_t*>(),
+                      image.data().size()));
+
+  // The encoder is reused for the next image, which is appended too.
+  ASSERT_TRUE(encoder.Encode(image, &output).ok());
+  EXPECT_EQ(prefix + std::string(expected.begin(), expected.end()) +
+                std::string(expected.begin(), expected.end()),
+            output);
+}
+
+TEST(PngEncoderTest, EncodeFailure) {
+  const std::string rgb = MakeRGBImage(16, 16);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(rgb.data());
+  PngEncoder encoder;
+  const std::string prefix = "prefix";
+  std::string output = prefix;
+  EXPECT_FALSE(
+      encoder.Encode(data, Sizei(16, 16), PIXEL_FORMAT_NV12, &output).ok());
+  EXPECT_EQ(prefix, output);
+
+  // It still encodes the next image.
+  EXPECT_TRUE(
+      encoder.Encode(data, Sizei(16, 16), PIXEL_FORMAT_RGB, &output).ok());
+  EXPECT_LT(prefix.size(), output.size());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -8,5 +8,6 @@ namespace felicia {
 
 Bytes kHeartBeatBytes = Bytes::FromBytes(128);
 Bytes kMasterNotificationBytes = Bytes::FromBytes(256);
+Bytes kDiscoveryMessageBytes = Bytes::FromKilloBytes(1);
 
 }  // namespace felicia
\ No newline at end of file
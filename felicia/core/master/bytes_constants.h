@@ -12,6 +12,7 @@ namespace felicia {
 
 FEL_EXPORT extern Bytes kHeartBeatBytes;
 FEL_EXPORT extern Bytes kMasterNotificationBytes;
+FEL_EXPORT extern Bytes kDiscoveryMessageBytes;
 
 }  // namespace felicia
 
@@ -48,6 +48,30 @@ std::unique_ptr<Client> Client::NewClient(const ClientInfo& client_info) {
   return base::WrapUnique(new Client(new_client_info));
 }
 
+// static
+std::unique_ptr<Client> Client::RestoreClient(
+    const ClientSnapshot& client_snapshot) {
+  uint32_t id = client_snapshot.client_info().id();
+  if (id == RandUint32Traits::InvalidValue() || GetIDGenerator().In(id)) {
+    LOG(ERROR) << "Failed to restore client(" << id << ")";
+    return nullptr;
+  }
+
+  GetIDGenerator().Add(id);
+  std::unique_ptr<Client> client =
+      base::WrapUnique(new Client(client_snapshot.client_info()));
+  for (auto& node_snapshot : client_snapshot.node_snapshots()) {
+    std::unique_ptr<Node> node = Node::RestoreNode(node_snapshot);
+    if (!node) {
+      LOG(ERROR) << "Failed to restore node("
+                 << node_snapshot.node_info().name() << ")";
+      continue;
+    }
+    client->AddNode(std::move(node));
+  }
+  return client;
+}
+
 Client::Client(const ClientInfo& client_info) : client_info_(client_info) {}
 
 Client::~Client() { GetIDGenerator().Return(client_info().id()); }
@@ -201,4 +225,12 @@ std::vector<std::string> Client::FindAllRequestingServices() const {
   return services;
 }
 
+void Client::ToClientSnapshot(ClientSnapshot* client_snapshot) const {
+  DFAKE_SCOPED_LOCK(add_remove_);
+  *client_snapshot->mutable_client_info() = client_info_;
+  for (auto& node : nodes_) {
+    node->ToNodeSnapshot(client_snapshot->add_node_snapshots());
+  }
+}
+
 }  // namespace felicia
\ No newline at end of file
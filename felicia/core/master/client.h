@@ -21,6 +21,11 @@ class Client {
   // Return client unless there is a unique id for client. If so,
   // return nullptr.
   static std::unique_ptr<Client> NewClient(const ClientInfo& client_info);
+  // Return client which is restored from a |client_snapshot| keeping its id.
+  // If the id is already taken, return nullptr. Nodes which fail to be
+  // restored are dropped.
+  static std::unique_ptr<Client> RestoreClient(
+      const ClientSnapshot& client_snapshot);
 
   ~Client();
 
@@ -47,6 +52,8 @@ class Client {
   // Find all requesting services
   std::vector<std::string> FindAllRequestingServices() const;
 
+  void ToClientSnapshot(ClientSnapshot* client_snapshot) const;
+
  private:
   explicit Client(const ClientInfo& client_info);
 
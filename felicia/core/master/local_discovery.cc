@@ -0,0 +1,197 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/master/local_discovery.h"
+
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/strings/string_number_conversions.h"
+
+#include "felicia/core/channel/channel_factory.h"
+#include "felicia/core/channel/message_sender.h"
+#include "felicia/core/channel/udp_channel.h"
+#include "felicia/core/master/bytes_constants.h"
+#include "felicia/core/message/ros_protocol.h"
+
+namespace felicia {
+
+namespace {
+
+// Administratively scoped multicast group, which doesn't leave the site.
+constexpr const char* kDiscoveryIp = "239.255.70.76";
+constexpr uint16_t kDiscoveryPort = 7661;
+
+ChannelDef DiscoveryChannelDef() {
+  ChannelDef channel_def;
+  channel_def.set_type(ChannelDef::CHANNEL_TYPE_UDP);
+  IPEndPoint* ip_endpoint = channel_def.mutable_ip_endpoint();
+  ip_endpoint->set_ip(kDiscoveryIp);
+  ip_endpoint->set_port(kDiscoveryPort);
+  return channel_def;
+}
+
+}  // namespace
+
+LocalDiscovery::LocalDiscovery() = default;
+
+LocalDiscovery::~LocalDiscovery() = default;
+
+// static
+bool LocalDiscovery::IsEnabled() {
+  const char* local_discovery = getenv("FEL_LOCAL_DISCOVERY");
+  if (!local_discovery) return false;
+  int value = 0;
+  return base::StringToInt(local_discovery, &value) && value != 0;
+}
+
+bool LocalDiscovery::IsStarted() const {
+  return send_channel_ ||
+         !send_discovery_message_callback_for_testing_.is_null();
+}
+
+Status LocalDiscovery::Start() {
+  DCHECK(!IsStarted());
+  ChannelDef channel_def = DiscoveryChannelDef();
+
+  send_channel_ = ChannelFactory::NewChannel(ChannelDef::CHANNEL_TYPE_UDP);
+  send_channel_->SetSendBufferSize(kDiscoveryMessageBytes);
+  StatusOr<ChannelDef> status_or =
+      send_channel_->ToUDPChannel()->Bind(channel_def);
+  if (!status_or.ok()) {
+    send_channel_.reset();
+    return status_or.status();
+  }
+
+  receive_channel_ = ChannelFactory::NewChannel(ChannelDef::CHANNEL_TYPE_UDP);
+  receive_channel_->SetReceiveBufferSize(kDiscoveryMessageBytes);
+  receive_channel_->Connect(channel_def,
+                            base::BindOnce(&LocalDiscovery::OnConnect,
+                                           base::Unretained(this)));
+  return Status::OK();
+}
+
+void LocalDiscovery::StartForTesting(SendDiscoveryMessageCallback callback) {
+  DCHECK(!IsStarted());
+  send_discovery_message_callback_for_testing_ = callback;
+}
+
+void LocalDiscovery::OnConnect(Status s) {
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to join discovery group: " << s;
+    return;
+  }
+
+  receiver_.set_channel(receive_channel_.get());
+  ReceiveDiscoveryMessage();
+}
+
+void LocalDiscovery::AnnounceTopicInfo(const TopicInfo& topic_info) {
+  if (!IsStarted() || IsUsingRosProtocol(topic_info.topic())) return;
+
+  if (topic_info.status() == TopicInfo::UNREGISTERED) {
+    publishing_topic_info_map_.erase(topic_info.topic());
+  } else {
+    publishing_topic_info_map_[topic_info.topic()] = topic_info;
+  }
+
+  DiscoveryMessage discovery_message;
+  discovery_message.set_type(DiscoveryMessage::ANNOUNCE);
+  *discovery_message.mutable_topic_info() = topic_info;
+  SendDiscoveryMessage(discovery_message);
+}
+
+void LocalDiscovery::UnannounceTopic(const std::string& topic) {
+  auto it = publishing_topic_info_map_.find(topic);
+  if (it == publishing_topic_info_map_.end()) return;
+
+  TopicInfo topic_info = it->second;
+  topic_info.set_status(TopicInfo::UNREGISTERED);
+  AnnounceTopicInfo(topic_info);
+}
+
+void LocalDiscovery::RegisterTopicInfoCallback(const std::string& topic,
+                                               NewTopicInfoCallback callback) {
+  topic_info_callback_map_[topic] = callback;
+  if (!IsStarted() || IsUsingRosProtocol(topic)) return;
+
+  DiscoveryMessage discovery_message;
+  discovery_message.set_type(DiscoveryMessage::QUERY);
+  discovery_message.set_topic(topic);
+  SendDiscoveryMessage(discovery_message);
+}
+
+void LocalDiscovery::UnregisterTopicInfoCallback(const std::string& topic) {
+  topic_info_callback_map_.erase(topic);
+  last_topic_info_map_.erase(topic);
+}
+
+void LocalDiscovery::OnTopicInfo(const TopicInfo& topic_info) {
+  auto it = topic_info_callback_map_.find(topic_info.topic());
+  if (it == topic_info_callback_map_.end()) return;
+
+  auto last_it = last_topic_info_map_.find(topic_info.topic());
+  if (last_it != last_topic_info_map_.end() &&
+      last_it->second.SerializeAsString() == topic_info.SerializeAsString()) {
+    return;
+  }
+  last_topic_info_map_[topic_info.topic()] = topic_info;
+  it->second.Run(topic_info);
+}
+
+void LocalDiscovery::SendDiscoveryMessage(
+    const DiscoveryMessage& discovery_message) {
+  if (!send_discovery_message_callback_for_testing_.is_null()) {
+    send_discovery_message_callback_for_testing_.Run(discovery_message);
+    return;
+  }
+  pending_discovery_messages_.push_back(discovery_message);
+  if (send_channel_->IsSending()) return;
+  SendPendingDiscoveryMessage();
+}
+
+void LocalDiscovery::SendPendingDiscoveryMessage() {
+  if (pending_discovery_messages_.empty()) return;
+
+  MessageSender<DiscoveryMessage> sender(send_channel_.get());
+  sender.SendMessage(pending_discovery_messages_.front(),
+                     base::BindOnce(&LocalDiscovery::OnSendDiscoveryMessage,
+                                    base::Unretained(this)));
+}
+
+void LocalDiscovery::OnSendDiscoveryMessage(Status s) {
+  LOG_IF(ERROR, !s.ok()) << "Failed to send discovery message: " << s;
+  pending_discovery_messages_.pop_front();
+  SendPendingDiscoveryMessage();
+}
+
+void LocalDiscovery::ReceiveDiscoveryMessage() {
+  receiver_.ReceiveMessage(base::BindOnce(
+      &LocalDiscovery::OnReceiveDiscoveryMessage, base::Unretained(this)));
+}
+
+void LocalDiscovery::OnReceiveDiscoveryMessage(Status s) {
+  if (s.ok()) {
+    OnDiscoveryMessage(receiver_.message());
+  } else {
+    LOG(ERROR) << "Failed to receive discovery message: " << s;
+  }
+  ReceiveDiscoveryMessage();
+}
+
+void LocalDiscovery::OnDiscoveryMessage(
+    const DiscoveryMessage& discovery_message) {
+  if (discovery_message.type() == DiscoveryMessage::ANNOUNCE) {
+    OnTopicInfo(discovery_message.topic_info());
+  } else if (discovery_message.type() == DiscoveryMessage::QUERY) {
+    auto it = publishing_topic_info_map_.find(discovery_message.topic());
+    if (it != publishing_topic_info_map_.end()) {
+      DiscoveryMessage answer;
+      answer.set_type(DiscoveryMessage::ANNOUNCE);
+      *answer.mutable_topic_info() = it->second;
+      SendDiscoveryMessage(answer);
+    }
+  }
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,93 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_MASTER_LOCAL_DISCOVERY_H_
+#define FELICIA_CORE_MASTER_LOCAL_DISCOVERY_H_
+
+#include <memory>
+#include <string>
+
+#include "third_party/chromium/base/containers/circular_deque.h"
+#include "third_party/chromium/base/containers/flat_map.h"
+#include "third_party/chromium/base/macros.h"
+
+#include "felicia/core/channel/channel.h"
+#include "felicia/core/channel/message_receiver.h"
+#include "felicia/core/master/master_notification_watcher.h"
+#include "felicia/core/protobuf/master_data.pb.h"
+
+namespace felicia {
+
+// LocalDiscovery lets subscribers find publishers by multicasting
+// |DiscoveryMessage| among clients, without waiting for the master to notify.
+// A publisher announces its TopicInfo when it is published and whenever
+// someone queries it. A subscriber queries its topic when it subscribes.
+//
+// The master is still the authoritative registry. Notifications from the
+// master are routed through |OnTopicInfo()| too, so that the subscriber
+// receives the same TopicInfo only once whichever comes first.
+//
+// It is enabled only if FEL_LOCAL_DISCOVERY is set to nonzero. Every method
+// should be called on the MainThread.
+class LocalDiscovery {
+ public:
+  using NewTopicInfoCallback = MasterNotificationWatcher::NewTopicInfoCallback;
+  using SendDiscoveryMessageCallback =
+      base::RepeatingCallback<void(const DiscoveryMessage&)>;
+
+  LocalDiscovery();
+  ~LocalDiscovery();
+
+  static bool IsEnabled();
+
+  bool IsStarted() const;
+
+  Status Start();
+  // Start without joining the group. The messages to send are handed to
+  // |callback| instead.
+  void StartForTesting(SendDiscoveryMessageCallback callback);
+
+  // Announce |topic_info| which is published on this client. If the status of
+  // |topic_info| is UNREGISTERED, it stops answering queries for it.
+  void AnnounceTopicInfo(const TopicInfo& topic_info);
+  void UnannounceTopic(const std::string& topic);
+
+  // Register |callback| and query publisher of |topic|.
+  void RegisterTopicInfoCallback(const std::string& topic,
+                                 NewTopicInfoCallback callback);
+  void UnregisterTopicInfoCallback(const std::string& topic);
+
+  // Dispatch |topic_info| to the registered callback unless it is the same
+  // with the one which was dispatched last.
+  void OnTopicInfo(const TopicInfo& topic_info);
+
+ private:
+  friend class LocalDiscoveryTest;
+
+  void OnConnect(Status s);
+
+  void SendDiscoveryMessage(const DiscoveryMessage& discovery_message);
+  void SendPendingDiscoveryMessage();
+  void OnSendDiscoveryMessage(Status s);
+
+  void ReceiveDiscoveryMessage();
+  void OnReceiveDiscoveryMessage(Status s);
+  void OnDiscoveryMessage(const DiscoveryMessage& discovery_message);
+
+  std::unique_ptr<Channel> send_channel_;
+  std::unique_ptr<Channel> receive_channel_;
+  MessageReceiver<DiscoveryMessage> receiver_;
+  base::circular_deque<DiscoveryMessage> pending_discovery_messages_;
+  SendDiscoveryMessageCallback send_discovery_message_callback_for_testing_;
+
+  base::flat_map<std::string, TopicInfo> publishing_topic_info_map_;
+  base::flat_map<std::string, NewTopicInfoCallback> topic_info_callback_map_;
+  base::flat_map<std::string, TopicInfo> last_topic_info_map_;
+
+  DISALLOW_COPY_AND_ASSIGN(LocalDiscovery);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_MASTER_LOCAL_DISCOVERY_H_
\ No newline at end of file
@@ -0,0 +1,198 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/master/local_discovery.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/bind.h"
+
+#include "felicia/core/master/bytes_constants.h"
+#include "felicia/core/message/header.h"
+#include "felicia/core/message/message_io.h"
+
+namespace felicia {
+
+namespace {
+
+TopicInfo MakeTopicInfo(const std::string& topic, uint16_t port) {
+  TopicInfo topic_info;
+  topic_info.set_topic(topic);
+  topic_info.set_type_name("felicia.drivers.CameraFrameMessage");
+  for (ChannelDef::Type type :
+       {ChannelDef::CHANNEL_TYPE_TCP, ChannelDef::CHANNEL_TYPE_UDP,
+        ChannelDef::CHANNEL_TYPE_WS}) {
+    ChannelDef* channel_def =
+        topic_info.mutable_topic_source()->add_channel_defs();
+    channel_def->set_type(type);
+    channel_def->mutable_ip_endpoint()->set_ip("192.168.0.1");
+    channel_def->mutable_ip_endpoint()->set_port(port);
+  }
+  return topic_info;
+}
+
+DiscoveryMessage MakeQuery(const std::string& topic) {
+  DiscoveryMessage discovery_message;
+  discovery_message.set_type(DiscoveryMessage::QUERY);
+  discovery_message.set_topic(topic);
+  return discovery_message;
+}
+
+bool IsSame(const google::protobuf::Message& a,
+            const google::protobuf::Message& b) {
+  return a.SerializeAsString() == b.SerializeAsString();
+}
+
+}  // namespace
+
+class LocalDiscoveryTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    local_discovery_.StartForTesting(base::BindRepeating(
+        &LocalDiscoveryTest::OnSendDiscoveryMessage, base::Unretained(this)));
+  }
+
+  void RegisterTopicInfoCallback(const std::string& topic) {
+    local_discovery_.RegisterTopicInfoCallback(
+        topic, base::BindRepeating(&LocalDiscoveryTest::OnNewTopicInfo,
+                                   base::Unretained(this)));
+  }
+
+  // As if |discovery_message| was received from the group.
+  void Receive(const DiscoveryMessage& discovery_message) {
+    local_discovery_.OnDiscoveryMessage(discovery_message);
+  }
+
+  void OnSendDiscoveryMessage(const DiscoveryMessage& discovery_message) {
+    sent_.push_back(discovery_message);
+  }
+
+  void OnNewTopicInfo(const TopicInfo& topic_info) {
+    topic_infos_.push_back(topic_info);
+  }
+
+  LocalDiscovery local_discovery_;
+  std::vector<DiscoveryMessage> sent_;
+  std::vector<TopicInfo> topic_infos_;
+};
+
+TEST_F(LocalDiscoveryTest, EncodeAndDecodeAnnouncement) {
+  const TopicInfo topic_info = MakeTopicInfo("topic", 8000);
+  local_discovery_.AnnounceTopicInfo(topic_info);
+  ASSERT_EQ(1u, sent_.size());
+  EXPECT_EQ(DiscoveryMessage::ANNOUNCE, sent_[0].type());
+  EXPECT_TRUE(IsSame(topic_info, sent_[0].topic_info()));
+
+  // Encode it as MessageSender does, which should fit in a datagram.
+  std::string content;
+  ASSERT_EQ(MessageIOError::OK,
+            MessageIO<DiscoveryMessage>::Serialize(&sent_[0], &content));
+  Header header;
+  std::string datagram;
+  ASSERT_EQ(MessageIOError::OK, header.AttachHeader(content, &datagram));
+  EXPECT_LE(static_cast<int64_t>(datagram.length()),
+            kDiscoveryMessageBytes.bytes());
+
+  // And decode it as MessageReceiver does.
+  int message_offset;
+  int message_size;
+  ASSERT_EQ(MessageIOError::OK,
+            header.ParseHeader(datagram.data(), &message_offset,
+                               &message_size));
+  DiscoveryMessage decoded;
+  ASSERT_EQ(MessageIOError::OK,
+            MessageIO<DiscoveryMessage>::Deserialize(
+                datagram.data() + message_offset, message_size, &decoded));
+  EXPECT_TRUE(IsSame(sent_[0], decoded));
+
+  RegisterTopicInfoCallback("topic");
+  Receive(decoded);
+  ASSERT_EQ(1u, topic_infos_.size());
+  EXPECT_TRUE(IsSame(topic_info, topic_infos_[0]));
+}
+
+TEST_F(LocalDiscoveryTest, AnswerQuery) {
+  Receive(MakeQuery("topic"));
+  EXPECT_TRUE(sent_.empty());
+
+  const TopicInfo topic_info = MakeTopicInfo("topic", 8000);
+  local_discovery_.AnnounceTopicInfo(topic_info);
+  sent_.clear();
+  Receive(MakeQuery("topic"));
+  ASSERT_EQ(1u, sent_.size());
+  EXPECT_EQ(DiscoveryMessage::ANNOUNCE, sent_[0].type());
+  EXPECT_TRUE(IsSame(topic_info, sent_[0].topic_info()));
+
+  Receive(MakeQuery("other_topic"));
+  EXPECT_EQ(1u, sent_.size());
+
+  // Once it is unannounced, it stops answering.
+  sent_.clear();
+  local_discovery_.UnannounceTopic("topic");
+  ASSERT_EQ(1u, sent_.size());
+  EXPECT_EQ(TopicInfo::UNREGISTERED, sent_[0].topic_info().status());
+  EXPECT_EQ("topic", sent_[0].topic_info().topic());
+  sent_.clear();
+  Receive(MakeQuery("topic"));
+  EXPECT_TRUE(sent_.empty());
+
+  // Unannouncing what isn't announced does nothing.
+  local_discovery_.UnannounceTopic("topic");
+  EXPECT_TRUE(sent_.empty());
+}
+
+TEST_F(LocalDiscoveryTest, QueryOnRegister) {
+  RegisterTopicInfoCallback("topic");
+  ASSERT_EQ(1u, sent_.size());
+  EXPECT_EQ(DiscoveryMessage::QUERY, sent_[0].type());
+  EXPECT_EQ("topic", sent_[0].topic());
+}
+
+TEST_F(LocalDiscoveryTest, SuppressDuplicates) {
+  const TopicInfo topic_info = MakeTopicInfo("topic", 8000);
+  // Not subscribed yet.
+  local_discovery_.OnTopicInfo(topic_info);
+  EXPECT_TRUE(topic_infos_.empty());
+
+  RegisterTopicInfoCallback("topic");
+  // From the master and the local discovery, whichever comes first.
+  local_discovery_.OnTopicInfo(topic_info);
+  DiscoveryMessage announcement;
+  announcement.set_type(DiscoveryMessage::ANNOUNCE);
+  *announcement.mutable_topic_info() = topic_info;
+  Receive(announcement);
+  local_discovery_.OnTopicInfo(topic_info);
+  ASSERT_EQ(1u, topic_infos_.size());
+
+  // A changed one is delivered.
+  const TopicInfo moved_topic_info = MakeTopicInfo("topic", 8001);
+  local_discovery_.OnTopicInfo(moved_topic_info);
+  ASSERT_EQ(2u, topic_infos_.size());
+  EXPECT_TRUE(IsSame(moved_topic_info, topic_infos_[1]));
+
+  // So is the one changed back.
+  Receive(announcement);
+  EXPECT_EQ(3u, topic_infos_.size());
+
+  // Other topics aren't delivered.
+  local_discovery_.OnTopicInfo(MakeTopicInfo("other_topic", 8000));
+  EXPECT_EQ(3u, topic_infos_.size());
+
+  // Subscribing again starts over.
+  local_discovery_.UnregisterTopicInfoCallback("topic");
+  local_discovery_.OnTopicInfo(topic_info);
+  EXPECT_EQ(3u, topic_infos_.size());
+  RegisterTopicInfoCallback("topic");
+  local_discovery_.OnTopicInfo(topic_info);
+  EXPECT_EQ(4u, topic_infos_.size());
+}
+
+TEST_F(LocalDiscoveryTest, IgnoreRosTopics) {
+  local_discovery_.AnnounceTopicInfo(MakeTopicInfo("ros:///chatter", 8000));
+  RegisterTopicInfoCallback("ros:///chatter");
+  EXPECT_TRUE(sent_.empty());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -16,6 +16,12 @@
 
 namespace felicia {
 
+namespace {
+
+void AssignStatus(Status* status, Status s) { *status = std::move(s); }
+
+}  // namespace
+
 Master::~Master() = default;
 
 #define CHECK_CLIENT_EXISTS(node_info)                        \
@@ -40,11 +46,45 @@ Master::~Master() = default;
 Master::Master() : thread_(std::make_unique<base::Thread>("Master")) {}
 
 void Master::Run() {
+  // Restore before starting the thread so that requests from the clients
+  // which were registered before never see their nodes missing.
+  if (state_store_) Restore();
+
   thread_->StartWithOptions(
       base::Thread::Options{base::MessageLoop::TYPE_IO, 0});
+
+  if (state_store_) {
+    std::vector<ClientInfo> client_infos;
+    {
+      base::AutoLock l(lock_);
+      for (auto& it : client_map_) {
+        client_infos.push_back(it.second->client_info());
+      }
+    }
+    for (auto& client_info : client_infos) {
+      thread_->task_runner()->PostTask(
+          FROM_HERE, base::BindOnce(&Master::DoCheckHeartBeat,
+                                    base::Unretained(this), client_info));
+    }
+    ScheduleSnapshot();
+  }
 }
 
-void Master::Stop() { thread_->Stop(); }
+void Master::Stop() {
+  if (state_store_ && thread_->IsRunning()) {
+    thread_->task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&Master::WriteSnapshot, base::Unretained(this)));
+  }
+  thread_->Stop();
+}
+
+void Master::EnableStateStore(std::unique_ptr<MasterStateStore> state_store,
+                              base::TimeDelta snapshot_interval) {
+  DCHECK(!thread_->IsRunning());
+  state_store_ = std::move(state_store);
+  snapshot_interval_ = snapshot_interval;
+}
 
 void Master::RegisterClient(const RegisterClientRequest* arg,
                             RegisterClientResponse* result,
@@ -166,6 +206,18 @@ void Master::PublishTopic(const PublishTopicRequest* arg,
                                 node_info, topic_info, std::move(callback)));
 }
 
+void Master::PublishTopics(const PublishTopicsRequest* arg,
+                           PublishTopicsResponse* result,
+                           StatusOnceCallback callback) {
+  const NodeInfo& node_info = arg->node_info();
+  CHECK_NODE_EXISTS(node_info);
+
+  thread_->task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&Master::DoPublishTopics,
+                                base::Unretained(this), arg, result,
+                                std::move(callback)));
+}
+
 void Master::UnpublishTopic(const UnpublishTopicRequest* arg,
                             UnpublishTopicResponse* result,
                             StatusOnceCallback callback) {
@@ -297,6 +349,7 @@ void Master::DoRegisterClient(std::unique_ptr<Client> client,
   uint32_t id = client_info.id();
   AddClient(id, std::move(client));
   DLOG(INFO) << "[RegisterClient]: " << base::StringPrintf("client(%u)", id);
+  RecordClient(id);
   std::move(callback).Run(Status::OK());
 
   DoCheckHeartBeat(client_info);
@@ -309,7 +362,9 @@ void Master::DoRegisterNode(std::unique_ptr<Node> node,
   DLOG(INFO) << "[RegisterNode]: "
              << base::StringPrintf("node(%s)",
                                    node->node_info().name().c_str());
+  uint32_t client_id = node->node_info().client_id();
   AddNode(std::move(node));
+  RecordClient(client_id);
   std::move(callback).Run(Status::OK());
 
   if (is_watcher) {
@@ -323,6 +378,7 @@ void Master::DoUnregisterNode(const NodeInfo& node_info,
   RemoveNode(node_info);
   DLOG(INFO) << "[UnregisterNode]: "
              << base::StringPrintf("node(%s)", node_info.name().c_str());
+  RecordClient(node_info.client_id());
   std::move(callback).Run(Status::OK());
 }
 
@@ -387,6 +443,7 @@ void Master::DoPublishTopic(const NodeInfo& node_info,
                << base::StringPrintf("topic(%s) from node(%s)",
                                      topic_info.topic().c_str(),
                                      node_info.name().c_str());
+    RecordClient(node_info.client_id());
 #if defined(HAS_ROS)
     std::string ros_topic;
     if (ConsumeRosProtocol(topic_info.topic(), &ros_topic)) {
@@ -422,6 +479,28 @@ void Master::DoPublishTopic(const NodeInfo& node_info,
   }
 }
 
+void Master::DoPublishTopics(const PublishTopicsRequest* arg,
+                             PublishTopicsResponse* result,
+                             StatusOnceCallback callback) {
+  DCHECK(thread_->task_runner()->BelongsToCurrentThread());
+  const NodeInfo& node_info = arg->node_info();
+  for (const TopicInfo& topic_info : arg->topic_infos()) {
+    Status s;
+    if (!IsValidChannelSource(topic_info.topic_source())) {
+      s = errors::ChannelSourceNotValid("topic source",
+                                        topic_info.topic_source());
+    } else {
+      // DoPublishTopic() runs |callback| synchronously.
+      DoPublishTopic(node_info, topic_info,
+                     base::BindOnce(&AssignStatus, base::Unretained(&s)));
+    }
+    StatusInfo* status_info = result->add_statuses();
+    status_info->set_error_code(s.error_code());
+    status_info->set_error_message(s.error_message());
+  }
+  std::move(callback).Run(Status::OK());
+}
+
 void Master::DoUnpublishTopic(const NodeInfo& node_info,
                               const std::string& topic,
                               StatusOnceCallback callback) {
@@ -448,6 +527,7 @@ void Master::DoUnpublishTopic(const NodeInfo& node_info,
     DLOG(INFO) << "[UnpublishTopic]: "
                << base::StringPrintf("topic(%s) from node(%s)", topic.c_str(),
                                      node_info.name().c_str());
+    RecordClient(node_info.client_id());
 #if defined(HAS_ROS)
     std::string ros_topic;
     if (ConsumeRosProtocol(topic_info.topic(), &ros_topic)) {
@@ -493,6 +573,7 @@ void Master::DoSubscribeTopic(const NodeInfo& node_info,
     DLOG(INFO) << "[SubscribeTopic]: "
                << base::StringPrintf("topic(%s) from node(%s)", topic.c_str(),
                                      node_info.name().c_str());
+    RecordClient(node_info.client_id());
 #if defined(HAS_ROS)
     std::string ros_topic;
     if (ConsumeRosProtocol(topic, &ros_topic)) {
@@ -538,6 +619,7 @@ void Master::DoUnsubscribeTopic(const NodeInfo& node_info,
     DLOG(INFO) << "[UnsubscribeTopic]: "
                << base::StringPrintf("topic(%s) from node(%s)", topic.c_str(),
                                      node_info.name().c_str());
+    RecordClient(node_info.client_id());
 #if defined(HAS_ROS)
     std::string ros_topic;
     if (ConsumeRosProtocol(topic, &ros_topic)) {
@@ -581,6 +663,7 @@ void Master::DoRegisterServiceClient(const NodeInfo& node_info,
     DLOG(INFO) << "[RegisterServiceClient]: "
                << base::StringPrintf("service(%s) from node(%s)",
                                      service.c_str(), node_info.name().c_str());
+    RecordClient(node_info.client_id());
 #if defined(HAS_ROS)
     std::string ros_service;
     if (ConsumeRosProtocol(service, &ros_service)) {
@@ -637,6 +720,7 @@ void Master::DoUnregisterServiceClient(const NodeInfo& node_info,
     DLOG(INFO) << "[UnregisterServiceClient]: "
                << base::StringPrintf("service(%s) from node(%s)",
                                      service.c_str(), node_info.name().c_str());
+    RecordClient(node_info.client_id());
     std::move(callback).Run(Status::OK());
   } else if (reason == Reason::ServiceNotRequestingOnNode) {
     std::move(callback).Run(
@@ -674,6 +758,7 @@ void Master::DoRegisterServiceServer(const NodeInfo& node_info,
                << base::StringPrintf("service(%s) from node(%s)",
                                      service_info.service().c_str(),
                                      node_info.name().c_str());
+    RecordClient(node_info.client_id());
 #if defined(HAS_ROS)
     std::string ros_service;
     if (ConsumeRosProtocol(service_info.service(), &ros_service)) {
@@ -723,6 +808,7 @@ void Master::DoUnregisterServiceServer(const NodeInfo& node_info,
     DLOG(INFO) << "[UnregisterServiceServer]: "
                << base::StringPrintf("service(%s) from node(%s)",
                                      service.c_str(), node_info.name().c_str());
+    RecordClient(node_info.client_id());
 #if defined(HAS_ROS)
     std::string ros_service;
     if (ConsumeRosProtocol(service_info.service(), &ros_service)) {
@@ -892,6 +978,7 @@ void Master::RemoveClient(const ClientInfo& client_info) {
     client_map_.erase(it);
     DLOG(INFO) << "Master::RemoveClient() " << id;
   }
+  RecordClientRemoval(client_info);
 
   for (auto& publishing_topic_info : publishing_topic_infos) {
     publishing_topic_info.set_status(TopicInfo::UNREGISTERED);
@@ -1142,6 +1229,72 @@ void Master::SetCheckHeartBeatForTesting(bool check_heart_beat) {
   check_heart_beat_ = check_heart_beat;
 }
 
+void Master::Restore() {
+  MasterSnapshot snapshot;
+  Status s = state_store_->Load(&snapshot);
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to restore master: " << s;
+    return;
+  }
+
+  for (auto& client_snapshot : snapshot.client_snapshots()) {
+    std::unique_ptr<Client> client = Client::RestoreClient(client_snapshot);
+    if (!client) continue;
+    uint32_t id = client->client_info().id();
+    AddClient(id, std::move(client));
+  }
+  LOG(INFO) << "Restored " << snapshot.client_snapshots_size() << " clients";
+}
+
+void Master::ScheduleSnapshot() {
+  thread_->task_runner()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](Master* master) {
+            master->WriteSnapshot();
+            master->ScheduleSnapshot();
+          },
+          base::Unretained(this)),
+      snapshot_interval_);
+}
+
+void Master::WriteSnapshot() {
+  DCHECK(thread_->task_runner()->BelongsToCurrentThread());
+  MasterSnapshot snapshot;
+  {
+    base::AutoLock l(lock_);
+    for (auto& it : client_map_) {
+      it.second->ToClientSnapshot(snapshot.add_client_snapshots());
+    }
+  }
+  Status s = state_store_->WriteSnapshot(snapshot);
+  LOG_IF(ERROR, !s.ok()) << "Failed to write snapshot: " << s;
+}
+
+void Master::RecordClient(uint32_t id) {
+  if (!state_store_) return;
+  DCHECK(thread_->task_runner()->BelongsToCurrentThread());
+  MasterLogEntry log_entry;
+  log_entry.set_type(MasterLogEntry::UPSERT_CLIENT);
+  {
+    base::AutoLock l(lock_);
+    auto it = client_map_.find(id);
+    if (it == client_map_.end()) return;
+    it->second->ToClientSnapshot(log_entry.mutable_client_snapshot());
+  }
+  Status s = state_store_->AppendLogEntry(log_entry);
+  LOG_IF(ERROR, !s.ok()) << "Failed to record client: " << s;
+}
+
+void Master::RecordClientRemoval(const ClientInfo& client_info) {
+  if (!state_store_) return;
+  MasterLogEntry log_entry;
+  log_entry.set_type(MasterLogEntry::REMOVE_CLIENT);
+  *log_entry.mutable_client_snapshot()->mutable_client_info() = client_info;
+  Status s = state_store_->AppendLogEntry(log_entry);
+  LOG_IF(ERROR, !s.ok()) << "Failed to record client removal: " << s;
+}
+
 void Master::DoCheckHeartBeat(const ClientInfo& client_info) {
   if (!check_heart_beat_) return;
   // |listner| is released inside.
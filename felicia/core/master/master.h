@@ -19,6 +19,7 @@
 #include "felicia/core/master/bytes_constants.h"
 #include "felicia/core/master/client.h"
 #include "felicia/core/master/errors.h"
+#include "felicia/core/master/master_state_store.h"
 #include "felicia/core/protobuf/master.pb.h"
 
 namespace felicia {
@@ -30,6 +31,12 @@ class Master {
   void Run();
   void Stop();
 
+  // Persist registrations to |state_store| and restore them on Run(). A full
+  // snapshot is written every |snapshot_interval|, changes in between are
+  // appended to the log. This should be called before Run().
+  void EnableStateStore(std::unique_ptr<MasterStateStore> state_store,
+                        base::TimeDelta snapshot_interval);
+
 #define MASTER_METHOD(Method, method, cancelable)                   \
   void Method(const Method##Request* arg, Method##Response* result, \
               StatusOnceCallback callback);
@@ -39,9 +46,11 @@ class Master {
   void Gc();
 
  private:
+  friend class MasterLoadTest;
   friend class MasterServer;
   friend class MasterTest;
   friend class RosMasterProxy;
+  friend class RosMasterProxyTest;
 
   void DoRegisterClient(std::unique_ptr<Client> client,
                         StatusOnceCallback callback);
@@ -51,6 +60,9 @@ class Master {
                    StatusOnceCallback callback);
   void DoPublishTopic(const NodeInfo& node_info, const TopicInfo& topic_info,
                       StatusOnceCallback callback);
+  void DoPublishTopics(const PublishTopicsRequest* arg,
+                       PublishTopicsResponse* result,
+                       StatusOnceCallback callback);
   void DoUnpublishTopic(const NodeInfo& node_info, const std::string& topic,
                         StatusOnceCallback callback);
   void DoSubscribeTopic(const NodeInfo& node_info, const std::string& topic,
@@ -146,6 +158,16 @@ class Master {
 
   void SetCheckHeartBeatForTesting(bool check_heart_beat);
 
+  // Restore clients from |state_store_|. Restored clients are checked by
+  // heart beat right after, so that the clients which are gone while the
+  // master was down are removed.
+  void Restore();
+  void ScheduleSnapshot();
+  void WriteSnapshot();
+  // Append the current state of the client whose id is |id| to the log.
+  void RecordClient(uint32_t id);
+  void RecordClientRemoval(const ClientInfo& client_info);
+
   // Every time a new client is registered, invoke an appropriate
   // heart beat listener for this client.
   void DoCheckHeartBeat(const ClientInfo& client_info);
@@ -160,6 +182,9 @@ class Master {
 
   bool check_heart_beat_ = true;
 
+  std::unique_ptr<MasterStateStore> state_store_;
+  base::TimeDelta snapshot_interval_;
+
   DISALLOW_COPY_AND_ASSIGN(Master);
 };
 
@@ -9,6 +9,7 @@
 
 #include "felicia/core/lib/net/net_util.h"
 #include "felicia/core/lib/strings/str_util.h"
+#include "felicia/core/master/errors.h"
 #include "felicia/core/thread/main_thread.h"
 
 #if defined(FEL_WIN_NODE_BINDING)
@@ -83,8 +84,11 @@ CLIENT_METHOD(ListClients)
 CLIENT_METHOD(RegisterNode)
 CLIENT_METHOD(UnregisterNode)
 CLIENT_METHOD(ListNodes)
-CLIENT_METHOD(PublishTopic)
-CLIENT_METHOD(UnpublishTopic)
+// PublishTopic and UnpublishTopic need additional announcement from
+// |local_discovery_|
+// CLIENT_METHOD(PublishTopic)
+// CLIENT_METHOD(UnpublishTopic)
+CLIENT_METHOD(PublishTopics)
 CLIENT_METHOD(SubscribeTopic)
 // UnsubscribeTopic needs additional remove callback from
 // |master_notification_watcher_|
@@ -110,6 +114,10 @@ void MasterProxy::Setup(base::WaitableEvent* event) {
   }
 
   master_notification_watcher_.Start();
+  if (LocalDiscovery::IsEnabled()) {
+    Status s = local_discovery_.Start();
+    LOG_IF(ERROR, !s.ok()) << "Failed to start local discovery: " << s;
+  }
   *client_info_.mutable_master_notification_watcher_source() =
       master_notification_watcher_.channel_source();
   heart_beat_signaller_.Start(
@@ -183,12 +191,161 @@ void MasterProxy::OnRegisterNodeAsync(std::unique_ptr<NodeLifecycle> node,
   nodes_.push_back(std::move(node));
 }
 
+void MasterProxy::PublishTopicAsync(const PublishTopicRequest* request,
+                                    PublishTopicResponse* response,
+                                    StatusOnceCallback callback) {
+  if (local_discovery_.IsStarted()) {
+    callback = base::BindOnce(&MasterProxy::OnPublishTopicAsync,
+                              base::Unretained(this), request->topic_info(),
+                              std::move(callback));
+  }
+
+  // Publishers which request in the same turn, typically a node publishing
+  // many topics at startup, are batched into a single round trip.
+  bool needs_flush;
+  {
+    base::AutoLock l(pending_publish_topics_lock_);
+    needs_flush = pending_publish_topics_.empty();
+    pending_publish_topics_.push_back(
+        PendingPublishTopic{request, response, std::move(callback)});
+  }
+  if (needs_flush) {
+    MainThread& main_thread = MainThread::GetInstance();
+    main_thread.PostTask(
+        FROM_HERE, base::BindOnce(&MasterProxy::FlushPendingPublishTopics,
+                                  base::Unretained(this)));
+  }
+}
+
+void MasterProxy::FlushPendingPublishTopics() {
+  std::vector<PendingPublishTopic> pending_publish_topics;
+  {
+    base::AutoLock l(pending_publish_topics_lock_);
+    pending_publish_topics.swap(pending_publish_topics_);
+  }
+
+  std::vector<std::vector<PendingPublishTopic>> groups;
+  base::flat_map<std::string, size_t> group_index_map;
+  for (auto& pending_publish_topic : pending_publish_topics) {
+    const std::string& node_name =
+        pending_publish_topic.request->node_info().name();
+    auto it = group_index_map.find(node_name);
+    if (it == group_index_map.end()) {
+      it = group_index_map.insert(std::make_pair(node_name, groups.size()))
+               .first;
+      groups.emplace_back();
+    }
+    groups[it->second].push_back(std::move(pending_publish_topic));
+  }
+
+  for (auto& group : groups) {
+    if (group.size() == 1) {
+      master_client_interface_->PublishTopicAsync(
+          group[0].request, group[0].response, std::move(group[0].callback));
+      continue;
+    }
+
+    auto request = std::make_unique<PublishTopicsRequest>();
+    auto response = std::make_unique<PublishTopicsResponse>();
+    *request->mutable_node_info() = group[0].request->node_info();
+    for (auto& pending_publish_topic : group) {
+      *request->add_topic_infos() =
+          pending_publish_topic.request->topic_info();
+    }
+    PublishTopicsRequest* request_ptr = request.get();
+    PublishTopicsResponse* response_ptr = response.get();
+    master_client_interface_->PublishTopicsAsync(
+        request_ptr, response_ptr,
+        base::BindOnce(&MasterProxy::OnPublishTopicsAsync,
+                       base::Unretained(this), std::move(request),
+                       std::move(response), std::move(group)));
+  }
+}
+
+void MasterProxy::OnPublishTopicsAsync(
+    std::unique_ptr<PublishTopicsRequest> request,
+    std::unique_ptr<PublishTopicsResponse> response,
+    std::vector<PendingPublishTopic> pending_publish_topics, Status s) {
+  // The master which doesn't know PublishTopics, falls back to PublishTopic.
+  if (s.error_code() == error::UNIMPLEMENTED) {
+    for (auto& pending_publish_topic : pending_publish_topics) {
+      master_client_interface_->PublishTopicAsync(
+          pending_publish_topic.request, pending_publish_topic.response,
+          std::move(pending_publish_topic.callback));
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < pending_publish_topics.size(); ++i) {
+    Status status = s;
+    if (s.ok()) {
+      if (i < static_cast<size_t>(response->statuses_size())) {
+        const StatusInfo& status_info = response->statuses(i);
+        status = Status(status_info.error_code(), status_info.error_message());
+      } else {
+        status = errors::FailedToPublishTopic(request->topic_infos(i));
+      }
+    }
+    std::move(pending_publish_topics[i].callback).Run(status);
+  }
+}
+
+void MasterProxy::UnpublishTopicAsync(const UnpublishTopicRequest* request,
+                                      UnpublishTopicResponse* response,
+                                      StatusOnceCallback callback) {
+  if (local_discovery_.IsStarted()) {
+    callback = base::BindOnce(&MasterProxy::OnUnpublishTopicAsync,
+                              base::Unretained(this), request->topic(),
+                              std::move(callback));
+  }
+  master_client_interface_->UnpublishTopicAsync(request, response,
+                                                std::move(callback));
+}
+
+void MasterProxy::OnPublishTopicAsync(const TopicInfo& topic_info,
+                                      StatusOnceCallback callback, Status s) {
+  // Announce only what the master accepted, so that the master remains the
+  // authoritative registry.
+  if (s.ok()) {
+    MainThread& main_thread = MainThread::GetInstance();
+    main_thread.PostTask(FROM_HERE,
+                         base::BindOnce(&LocalDiscovery::AnnounceTopicInfo,
+                                        base::Unretained(&local_discovery_),
+                                        topic_info));
+  }
+  std::move(callback).Run(s);
+}
+
+void MasterProxy::OnUnpublishTopicAsync(const std::string& topic,
+                                        StatusOnceCallback callback,
+                                        Status s) {
+  if (s.ok()) {
+    MainThread& main_thread = MainThread::GetInstance();
+    main_thread.PostTask(
+        FROM_HERE,
+        base::BindOnce(&LocalDiscovery::UnannounceTopic,
+                       base::Unretained(&local_discovery_), topic));
+  }
+  std::move(callback).Run(s);
+}
+
 void MasterProxy::SubscribeTopicAsync(
     const SubscribeTopicRequest* request, SubscribeTopicResponse* response,
     StatusOnceCallback callback,
     MasterNotificationWatcher::NewTopicInfoCallback topic_info_callback) {
-  master_notification_watcher_.RegisterTopicInfoCallback(request->topic(),
-                                                         topic_info_callback);
+  if (local_discovery_.IsStarted()) {
+    // Both of the master notification and the local discovery are funneled
+    // into |local_discovery_| to deliver the same TopicInfo only once.
+    local_discovery_.RegisterTopicInfoCallback(request->topic(),
+                                               topic_info_callback);
+    master_notification_watcher_.RegisterTopicInfoCallback(
+        request->topic(),
+        base::BindRepeating(&LocalDiscovery::OnTopicInfo,
+                            base::Unretained(&local_discovery_)));
+  } else {
+    master_notification_watcher_.RegisterTopicInfoCallback(
+        request->topic(), topic_info_callback);
+  }
   master_client_interface_->SubscribeTopicAsync(request, response,
                                                 std::move(callback));
 }
@@ -207,6 +364,7 @@ void MasterProxy::UnsubscribeTopicAsync(const UnsubscribeTopicRequest* request,
                                         UnsubscribeTopicResponse* response,
                                         StatusOnceCallback callback) {
   master_notification_watcher_.UnregisterTopicInfoCallback(request->topic());
+  local_discovery_.UnregisterTopicInfoCallback(request->topic());
   master_client_interface_->UnsubscribeTopicAsync(request, response,
                                                   std::move(callback));
 }
@@ -13,11 +13,14 @@
 #include "third_party/chromium/base/callback.h"
 #include "third_party/chromium/base/macros.h"
 #include "third_party/chromium/base/no_destructor.h"
+#include "third_party/chromium/base/synchronization/lock.h"
 #include "third_party/chromium/base/synchronization/waitable_event.h"
+#include "third_party/chromium/base/thread_annotations.h"
 
 #include "felicia/core/channel/channel.h"
 #include "felicia/core/lib/base/export.h"
 #include "felicia/core/master/heart_beat_signaller.h"
+#include "felicia/core/master/local_discovery.h"
 #include "felicia/core/master/master_client_interface.h"
 #include "felicia/core/master/master_notification_watcher.h"
 #include "felicia/core/node/node_lifecycle.h"
@@ -58,6 +61,7 @@ class FEL_EXPORT MasterProxy final : public MasterClientInterface {
 
  private:
   friend class base::NoDestructor<MasterProxy>;
+  friend class MasterProxyTest;
   friend class PyMasterProxy;
   friend class TopicInfoWatcherNode;
   template <typename MessageTy>
@@ -83,6 +87,27 @@ class FEL_EXPORT MasterProxy final : public MasterClientInterface {
                            const RegisterNodeRequest* request,
                            RegisterNodeResponse* response, Status s);
 
+  struct PendingPublishTopic {
+    const PublishTopicRequest* request;
+    PublishTopicResponse* response;
+    StatusOnceCallback callback;
+  };
+
+  // Send the pending PublishTopic requests. The requests on the same node are
+  // sent at once by PublishTopics.
+  void FlushPendingPublishTopics();
+
+  void OnPublishTopicsAsync(
+      std::unique_ptr<PublishTopicsRequest> request,
+      std::unique_ptr<PublishTopicsResponse> response,
+      std::vector<PendingPublishTopic> pending_publish_topics, Status s);
+
+  void OnPublishTopicAsync(const TopicInfo& topic_info,
+                           StatusOnceCallback callback, Status s);
+
+  void OnUnpublishTopicAsync(const std::string& topic,
+                             StatusOnceCallback callback, Status s);
+
   void SubscribeTopicAsync(
       const SubscribeTopicRequest* request, SubscribeTopicResponse* response,
       StatusOnceCallback callback,
@@ -99,9 +124,14 @@ class FEL_EXPORT MasterProxy final : public MasterClientInterface {
 
   MasterNotificationWatcher master_notification_watcher_;
   HeartBeatSignaller heart_beat_signaller_;
+  LocalDiscovery local_discovery_;
 
   std::vector<std::unique_ptr<NodeLifecycle>> nodes_;
 
+  base::Lock pending_publish_topics_lock_;
+  std::vector<PendingPublishTopic> pending_publish_topics_
+      GUARDED_BY(pending_publish_topics_lock_);
+
 #if defined(FEL_WIN_NODE_BINDING)
   bool is_client_info_set_ = false;
 #endif  // defined(FEL_WIN_NODE_BINDING)
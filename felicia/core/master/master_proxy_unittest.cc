@@ -0,0 +1,222 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/master/master_proxy.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/synchronization/waitable_event.h"
+
+#include "felicia/core/lib/error/errors.h"
+#include "felicia/core/thread/main_thread.h"
+
+namespace felicia {
+
+namespace {
+
+// Answers every request with |status_| right away.
+class FakeMasterClient : public MasterClientInterface {
+ public:
+  void set_status(const Status& status) { status_ = status; }
+
+  // MasterClientInterface methods
+  Status Start() override { return Status::OK(); }
+  Status Stop() override { return Status::OK(); }
+
+#define MASTER_METHOD(Method, method, cancelable)                         \
+  void Method##Async(const Method##Request* request,                      \
+                     Method##Response* response, StatusOnceCallback done) \
+      override {                                                          \
+    std::move(done).Run(status_);                                         \
+  }
+#include "felicia/core/master/rpc/master_method_list.h"
+#undef MASTER_METHOD
+
+ private:
+  Status status_;
+};
+
+void SetStatus(Status* status, base::WaitableEvent* event, Status s) {
+  *status = s;
+  event->Signal();
+}
+
+}  // namespace
+
+class MasterProxyTest : public testing::Test {
+ protected:
+  MasterProxyTest() {
+    auto master_client = std::make_unique<FakeMasterClient>();
+    master_client_ = master_client.get();
+    master_proxy_.master_client_interface_ = std::move(master_client);
+  }
+
+  void SetUp() override {
+    MainThread::SetBackground();
+    MainThread::GetInstance().RunBackground();
+  }
+
+  void TearDown() override { RunOnMainThread(base::DoNothing()); }
+
+  void StartLocalDiscovery() {
+    master_proxy_.local_discovery_.StartForTesting(
+        base::BindRepeating(&MasterProxyTest::OnSendDiscoveryMessage,
+                            base::Unretained(this)));
+  }
+
+  // Runs |callback| on the MainThread, and waits until it and the tasks it
+  // posted are run.
+  void RunOnMainThread(base::OnceClosure callback) {
+    MainThread& main_thread = MainThread::GetInstance();
+    main_thread.PostTask(FROM_HERE, std::move(callback));
+    base::WaitableEvent event;
+    main_thread.PostTask(FROM_HERE,
+                         base::BindOnce(&base::WaitableEvent::Signal,
+                                        base::Unretained(&event)));
+    event.Wait();
+  }
+
+  // Waits for the tasks posted before the request is done, e.g, the
+  // announcement, and returns |s|.
+  Status Flush(Status s) {
+    RunOnMainThread(base::DoNothing());
+    return s;
+  }
+
+  Status PublishTopic(const TopicInfo& topic_info) {
+    PublishTopicRequest request;
+    request.mutable_node_info()->set_name("node");
+    *request.mutable_topic_info() = topic_info;
+    PublishTopicResponse response;
+    Status s;
+    base::WaitableEvent event;
+    RunOnMainThread(base::BindOnce(&MasterProxy::PublishTopicAsync,
+                                   base::Unretained(&master_proxy_), &request,
+                                   &response,
+                                   base::BindOnce(&SetStatus, &s, &event)));
+    event.Wait();
+    return Flush(s);
+  }
+
+  Status UnpublishTopic(const std::string& topic) {
+    UnpublishTopicRequest request;
+    request.mutable_node_info()->set_name("node");
+    request.set_topic(topic);
+    UnpublishTopicResponse response;
+    Status s;
+    base::WaitableEvent event;
+    RunOnMainThread(base::BindOnce(&MasterProxy::UnpublishTopicAsync,
+                                   base::Unretained(&master_proxy_), &request,
+                                   &response,
+                                   base::BindOnce(&SetStatus, &s, &event)));
+    event.Wait();
+    return Flush(s);
+  }
+
+  Status SubscribeTopic(const std::string& topic) {
+    SubscribeTopicRequest request;
+    request.mutable_node_info()->set_name("node");
+    request.set_topic(topic);
+    SubscribeTopicResponse response;
+    Status s;
+    base::WaitableEvent event;
+    // Not the one of MasterClientInterface, which is overloaded.
+    void (MasterProxy::*subscribe_topic_async)(
+        const SubscribeTopicRequest*, SubscribeTopicResponse*,
+        StatusOnceCallback, MasterNotificationWatcher::NewTopicInfoCallback) =
+        &MasterProxy::SubscribeTopicAsync;
+    RunOnMainThread(base::BindOnce(
+        subscribe_topic_async, base::Unretained(&master_proxy_), &request,
+        &response, base::BindOnce(&SetStatus, &s, &event),
+        base::BindRepeating(&MasterProxyTest::OnNewTopicInfo,
+                            base::Unretained(this))));
+    event.Wait();
+    return Flush(s);
+  }
+
+  // As if |topic_info| was notified by the master or announced by another
+  // client.
+  void NotifyTopicInfo(const TopicInfo& topic_info) {
+    RunOnMainThread(base::BindOnce(
+        &LocalDiscovery::OnTopicInfo,
+        base::Unretained(&master_proxy_.local_discovery_), topic_info));
+  }
+
+  void OnSendDiscoveryMessage(const DiscoveryMessage& discovery_message) {
+    sent_.push_back(discovery_message);
+  }
+
+  void OnNewTopicInfo(const TopicInfo& topic_info) {
+    topic_infos_.push_back(topic_info);
+  }
+
+  MasterProxy master_proxy_;
+  FakeMasterClient* master_client_;
+  // Accessed on the MainThread, and read after RunOnMainThread() returns.
+  std::vector<DiscoveryMessage> sent_;
+  std::vector<TopicInfo> topic_infos_;
+};
+
+TEST_F(MasterProxyTest, AnnounceAcceptedTopic) {
+  StartLocalDiscovery();
+  TopicInfo topic_info;
+  topic_info.set_topic("topic");
+  EXPECT_TRUE(PublishTopic(topic_info).ok());
+  ASSERT_EQ(1u, sent_.size());
+  EXPECT_EQ(DiscoveryMessage::ANNOUNCE, sent_[0].type());
+  EXPECT_EQ("topic", sent_[0].topic_info().topic());
+  EXPECT_EQ(TopicInfo::REGISTERED, sent_[0].topic_info().status());
+
+  EXPECT_TRUE(UnpublishTopic("topic").ok());
+  ASSERT_EQ(2u, sent_.size());
+  EXPECT_EQ(DiscoveryMessage::ANNOUNCE, sent_[1].type());
+  EXPECT_EQ("topic", sent_[1].topic_info().topic());
+  EXPECT_EQ(TopicInfo::UNREGISTERED, sent_[1].topic_info().status());
+}
+
+TEST_F(MasterProxyTest, DontAnnounceRejectedTopic) {
+  StartLocalDiscovery();
+  TopicInfo topic_info;
+  topic_info.set_topic("topic");
+  master_client_->set_status(errors::Aborted("rejected"));
+  Status s = PublishTopic(topic_info);
+  EXPECT_TRUE(errors::IsAborted(s));
+  EXPECT_EQ("rejected", s.error_message());
+  EXPECT_TRUE(sent_.empty());
+
+  // Nor unannounce what the master didn't remove.
+  master_client_->set_status(Status::OK());
+  EXPECT_TRUE(PublishTopic(topic_info).ok());
+  master_client_->set_status(errors::Aborted("rejected"));
+  EXPECT_TRUE(errors::IsAborted(UnpublishTopic("topic")));
+  EXPECT_EQ(1u, sent_.size());
+}
+
+TEST_F(MasterProxyTest, WithoutLocalDiscovery) {
+  TopicInfo topic_info;
+  topic_info.set_topic("topic");
+  EXPECT_TRUE(PublishTopic(topic_info).ok());
+  EXPECT_TRUE(UnpublishTopic("topic").ok());
+  EXPECT_TRUE(SubscribeTopic("topic").ok());
+  EXPECT_TRUE(sent_.empty());
+}
+
+TEST_F(MasterProxyTest, SubscribeTopicOnce) {
+  StartLocalDiscovery();
+  EXPECT_TRUE(SubscribeTopic("topic").ok());
+  ASSERT_EQ(1u, sent_.size());
+  EXPECT_EQ(DiscoveryMessage::QUERY, sent_[0].type());
+  EXPECT_EQ("topic", sent_[0].topic());
+
+  TopicInfo topic_info;
+  topic_info.set_topic("topic");
+  NotifyTopicInfo(topic_info);
+  NotifyTopicInfo(topic_info);
+  EXPECT_EQ(1u, topic_infos_.size());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,216 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/master/master_state_store.h"
+
+#include <algorithm>
+
+#include "third_party/chromium/base/files/file_util.h"
+#include "third_party/chromium/base/files/important_file_writer.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
+
+#include "felicia/core/lib/error/errors.h"
+#include "felicia/core/lib/file/file_util.h"
+
+namespace felicia {
+
+namespace {
+
+const base::FilePath::CharType kSnapshotFileName[] =
+    FILE_PATH_LITERAL("master.snapshot");
+const base::FilePath::CharType kLogFileName[] = FILE_PATH_LITERAL("master.log");
+
+// Each log entry is prefixed with its size in 4 bytes little endian.
+constexpr size_t kLogEntryHeaderSize = sizeof(uint32_t);
+
+void WriteUint32(uint32_t value, char* buf) {
+  for (size_t i = 0; i < kLogEntryHeaderSize; ++i) {
+    buf[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint32_t ReadUint32(const char* buf) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < kLogEntryHeaderSize; ++i) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(buf[i])) << (8 * i);
+  }
+  return value;
+}
+
+class ClientIdChecker {
+ public:
+  explicit ClientIdChecker(uint32_t id) : id_(id) {}
+
+  bool operator()(const ClientSnapshot& client_snapshot) const {
+    return client_snapshot.client_info().id() == id_;
+  }
+
+ private:
+  uint32_t id_;
+};
+
+}  // namespace
+
+MasterStateStore::MasterStateStore(const base::FilePath& dir)
+    : dir_(dir),
+      snapshot_path_(dir.Append(kSnapshotFileName)),
+      log_path_(dir.Append(kLogFileName)) {}
+
+MasterStateStore::~MasterStateStore() = default;
+
+Status MasterStateStore::Load(MasterSnapshot* snapshot) {
+  snapshot->Clear();
+
+  if (base::PathExists(snapshot_path_)) {
+    std::unique_ptr<char[]> buf;
+    size_t len = 0;
+    if (!ReadFile(snapshot_path_, &buf, &len) ||
+        !snapshot->ParseFromArray(buf.get(), len)) {
+      return errors::DataLoss(base::StringPrintf(
+          "Failed to read master snapshot from %s.",
+          snapshot_path_.AsUTF8Unsafe().c_str()));
+    }
+  }
+
+  if (base::PathExists(log_path_)) {
+    std::unique_ptr<char[]> buf;
+    size_t len = 0;
+    if (!ReadFile(log_path_, &buf, &len)) {
+      return errors::DataLoss(
+          base::StringPrintf("Failed to read master log from %s.",
+                             log_path_.AsUTF8Unsafe().c_str()));
+    }
+
+    size_t offset = 0;
+    while (offset + kLogEntryHeaderSize <= len) {
+      uint32_t size = ReadUint32(buf.get() + offset);
+      size_t entry_offset = offset + kLogEntryHeaderSize;
+      // The last entry can be cut off if the master was killed while writing
+      // it. Just ignore it, the client will be reconciled by heart beat.
+      if (entry_offset + size > len) break;
+
+      MasterLogEntry log_entry;
+      if (!log_entry.ParseFromArray(buf.get() + entry_offset, size)) break;
+      ApplyLogEntry(log_entry, snapshot);
+      offset = entry_offset + size;
+    }
+
+    // Drop the ignored tail, otherwise the entries appended from now on
+    // would follow it and be ignored together on the next Load().
+    if (offset < len) {
+      LOG(WARNING) << "Drop " << len - offset
+                   << " bytes of a torn entry from the master log.";
+      base::File log_file(log_path_,
+                          base::File::FLAG_OPEN | base::File::FLAG_WRITE);
+      if (!log_file.SetLength(offset)) {
+        return errors::DataLoss(
+            base::StringPrintf("Failed to truncate master log %s.",
+                               log_path_.AsUTF8Unsafe().c_str()));
+      }
+    }
+  }
+
+  return Status::OK();
+}
+
+Status MasterStateStore::AppendLogEntry(const MasterLogEntry& log_entry) {
+  if (!log_file_.IsValid()) {
+    Status s = OpenLogFile();
+    if (!s.ok()) return s;
+  }
+
+  std::string serialized;
+  serialized.resize(kLogEntryHeaderSize);
+  WriteUint32(static_cast<uint32_t>(log_entry.ByteSizeLong()), &serialized[0]);
+  if (!log_entry.AppendToString(&serialized)) {
+    return errors::DataLoss("Failed to serialize master log entry.");
+  }
+
+  int rv = log_file_.WriteAtCurrentPos(serialized.data(), serialized.length());
+  if (rv != static_cast<int>(serialized.length())) {
+    return errors::DataLoss(
+        base::StringPrintf("Failed to write master log to %s.",
+                           log_path_.AsUTF8Unsafe().c_str()));
+  }
+  return Status::OK();
+}
+
+Status MasterStateStore::WriteSnapshot(const MasterSnapshot& snapshot) {
+  if (!log_file_.IsValid()) {
+    Status s = OpenLogFile();
+    if (!s.ok()) return s;
+  }
+
+  std::string serialized;
+  if (!snapshot.SerializeToString(&serialized)) {
+    return errors::DataLoss("Failed to serialize master snapshot.");
+  }
+
+  if (!base::ImportantFileWriter::WriteFileAtomically(snapshot_path_,
+                                                      serialized)) {
+    return errors::DataLoss(
+        base::StringPrintf("Failed to write master snapshot to %s.",
+                           snapshot_path_.AsUTF8Unsafe().c_str()));
+  }
+
+  // Every entry in the log is now reflected in the snapshot.
+  log_file_.Close();
+  log_file_.Initialize(log_path_, base::File::FLAG_CREATE_ALWAYS |
+                                      base::File::FLAG_APPEND);
+  if (!log_file_.IsValid()) {
+    return errors::DataLoss(
+        base::StringPrintf("Failed to truncate master log %s.",
+                           log_path_.AsUTF8Unsafe().c_str()));
+  }
+  return Status::OK();
+}
+
+// static
+void MasterStateStore::ApplyLogEntry(const MasterLogEntry& log_entry,
+                                     MasterSnapshot* snapshot) {
+  auto* client_snapshots = snapshot->mutable_client_snapshots();
+  uint32_t id = log_entry.client_snapshot().client_info().id();
+  auto it = std::find_if(client_snapshots->begin(), client_snapshots->end(),
+                         ClientIdChecker{id});
+
+  switch (log_entry.type()) {
+    case MasterLogEntry::UPSERT_CLIENT:
+      if (it == client_snapshots->end()) {
+        *snapshot->add_client_snapshots() = log_entry.client_snapshot();
+      } else {
+        *it = log_entry.client_snapshot();
+      }
+      break;
+    case MasterLogEntry::REMOVE_CLIENT:
+      if (it != client_snapshots->end()) client_snapshots->erase(it);
+      break;
+    default:
+      LOG(ERROR) << "Unknown master log entry type: " << log_entry.type();
+      break;
+  }
+}
+
+Status MasterStateStore::OpenLogFile() {
+  if (!base::DirectoryExists(dir_)) {
+    base::File::Error error;
+    if (!base::CreateDirectoryAndGetError(dir_, &error)) {
+      return errors::Unavailable(base::StringPrintf(
+          "Failed to create %s: %s", dir_.AsUTF8Unsafe().c_str(),
+          base::File::ErrorToString(error).c_str()));
+    }
+  }
+
+  log_file_.Initialize(log_path_,
+                       base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_APPEND);
+  if (!log_file_.IsValid()) {
+    return errors::Unavailable(
+        base::StringPrintf("Failed to open master log %s: %s",
+                           log_path_.AsUTF8Unsafe().c_str(),
+                           base::File::ErrorToString(log_file_.error_details())
+                               .c_str()));
+  }
+  return Status::OK();
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,53 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_MASTER_MASTER_STATE_STORE_H_
+#define FELICIA_CORE_MASTER_MASTER_STATE_STORE_H_
+
+#include "third_party/chromium/base/files/file.h"
+#include "third_party/chromium/base/files/file_path.h"
+#include "third_party/chromium/base/macros.h"
+
+#include "felicia/core/lib/error/status.h"
+#include "felicia/core/protobuf/master_data.pb.h"
+
+namespace felicia {
+
+// MasterStateStore persists the registrations of the Master so that the
+// master server can be restarted without every client registering again.
+// It keeps a compact |MasterSnapshot| and an append-only log of
+// |MasterLogEntry|, which is truncated every time a new snapshot is written.
+// This is not thread-safe, it should be used on the Master thread.
+class MasterStateStore {
+ public:
+  explicit MasterStateStore(const base::FilePath& dir);
+  ~MasterStateStore();
+
+  // Reads the snapshot and replays the log on top of it. It's ok that
+  // neither of them exists. A torn entry at the end of the log is ignored
+  // and cut off, so that the entries appended later can be read again.
+  Status Load(MasterSnapshot* snapshot);
+
+  Status AppendLogEntry(const MasterLogEntry& log_entry);
+
+  // Writes |snapshot| atomically and truncates the log.
+  Status WriteSnapshot(const MasterSnapshot& snapshot);
+
+  static void ApplyLogEntry(const MasterLogEntry& log_entry,
+                            MasterSnapshot* snapshot);
+
+ private:
+  Status OpenLogFile();
+
+  base::FilePath dir_;
+  base::FilePath snapshot_path_;
+  base::FilePath log_path_;
+  base::File log_file_;
+
+  DISALLOW_COPY_AND_ASSIGN(MasterStateStore);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_MASTER_MASTER_STATE_STORE_H_
\ No newline at end of file
@@ -0,0 +1,134 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/master/master_state_store.h"
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/files/file_util.h"
+#include "third_party/chromium/base/files/scoped_temp_dir.h"
+
+namespace felicia {
+
+namespace {
+
+ClientSnapshot MakeClientSnapshot(uint32_t id, const std::string& node_name,
+                                  const std::string& topic) {
+  ClientSnapshot client_snapshot;
+  client_snapshot.mutable_client_info()->set_id(id);
+  NodeSnapshot* node_snapshot = client_snapshot.add_node_snapshots();
+  node_snapshot->mutable_node_info()->set_name(node_name);
+  node_snapshot->mutable_node_info()->set_client_id(id);
+  node_snapshot->add_publishing_topic_infos()->set_topic(topic);
+  return client_snapshot;
+}
+
+void AppendLogEntry(MasterStateStore* store, MasterLogEntry::Type type,
+                    const ClientSnapshot& client_snapshot) {
+  MasterLogEntry log_entry;
+  log_entry.set_type(type);
+  *log_entry.mutable_client_snapshot() = client_snapshot;
+  EXPECT_TRUE(store->AppendLogEntry(log_entry).ok());
+}
+
+}  // namespace
+
+TEST(MasterStateStoreTest, LoadWithoutFiles) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  MasterStateStore store(dir.GetPath().AppendASCII("state"));
+  MasterSnapshot snapshot;
+  EXPECT_TRUE(store.Load(&snapshot).ok());
+  EXPECT_EQ(0, snapshot.client_snapshots_size());
+}
+
+TEST(MasterStateStoreTest, SnapshotAndLog) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  {
+    MasterStateStore store(dir.GetPath());
+    MasterSnapshot snapshot;
+    *snapshot.add_client_snapshots() = MakeClientSnapshot(1, "node1", "topic1");
+    *snapshot.add_client_snapshots() = MakeClientSnapshot(2, "node2", "topic2");
+    EXPECT_TRUE(store.WriteSnapshot(snapshot).ok());
+
+    AppendLogEntry(&store, MasterLogEntry::REMOVE_CLIENT,
+                   MakeClientSnapshot(1, "node1", "topic1"));
+    AppendLogEntry(&store, MasterLogEntry::UPSERT_CLIENT,
+                   MakeClientSnapshot(2, "node2", "topic3"));
+    AppendLogEntry(&store, MasterLogEntry::UPSERT_CLIENT,
+                   MakeClientSnapshot(3, "node3", "topic4"));
+  }
+
+  MasterStateStore store(dir.GetPath());
+  MasterSnapshot snapshot;
+  EXPECT_TRUE(store.Load(&snapshot).ok());
+  ASSERT_EQ(2, snapshot.client_snapshots_size());
+  EXPECT_EQ(2u, snapshot.client_snapshots(0).client_info().id());
+  EXPECT_EQ("topic3", snapshot.client_snapshots(0)
+                          .node_snapshots(0)
+                          .publishing_topic_infos(0)
+                          .topic());
+  EXPECT_EQ(3u, snapshot.client_snapshots(1).client_info().id());
+
+  // Writing a snapshot truncates the log.
+  EXPECT_TRUE(store.WriteSnapshot(snapshot).ok());
+  MasterSnapshot snapshot2;
+  EXPECT_TRUE(store.Load(&snapshot2).ok());
+  EXPECT_EQ(snapshot.SerializeAsString(), snapshot2.SerializeAsString());
+}
+
+TEST(MasterStateStoreTest, IgnoreTruncatedLogEntry) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  {
+    MasterStateStore store(dir.GetPath());
+    AppendLogEntry(&store, MasterLogEntry::UPSERT_CLIENT,
+                   MakeClientSnapshot(1, "node1", "topic1"));
+  }
+  // Simulate the master is killed in the middle of writing a log entry.
+  const char kPartial[] = {10, 0, 0, 0, 8};
+  ASSERT_TRUE(base::AppendToFile(dir.GetPath().AppendASCII("master.log"),
+                                 kPartial, sizeof(kPartial)));
+
+  MasterStateStore store(dir.GetPath());
+  MasterSnapshot snapshot;
+  EXPECT_TRUE(store.Load(&snapshot).ok());
+  EXPECT_EQ(1, snapshot.client_snapshots_size());
+}
+
+TEST(MasterStateStoreTest, AppendAfterTruncatedLogEntry) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  {
+    MasterStateStore store(dir.GetPath());
+    AppendLogEntry(&store, MasterLogEntry::UPSERT_CLIENT,
+                   MakeClientSnapshot(1, "node1", "topic1"));
+  }
+  const char kPartial[] = {10, 0, 0, 0, 8};
+  ASSERT_TRUE(base::AppendToFile(dir.GetPath().AppendASCII("master.log"),
+                                 kPartial, sizeof(kPartial)));
+
+  // Restart and keep appending.
+  {
+    MasterStateStore store(dir.GetPath());
+    MasterSnapshot snapshot;
+    EXPECT_TRUE(store.Load(&snapshot).ok());
+    EXPECT_EQ(1, snapshot.client_snapshots_size());
+    AppendLogEntry(&store, MasterLogEntry::UPSERT_CLIENT,
+                   MakeClientSnapshot(2, "node2", "topic2"));
+    AppendLogEntry(&store, MasterLogEntry::UPSERT_CLIENT,
+                   MakeClientSnapshot(3, "node3", "topic3"));
+  }
+
+  // Restart again, the entries appended after the torn one must survive.
+  MasterStateStore store(dir.GetPath());
+  MasterSnapshot snapshot;
+  EXPECT_TRUE(store.Load(&snapshot).ok());
+  ASSERT_EQ(3, snapshot.client_snapshots_size());
+  EXPECT_EQ(1u, snapshot.client_snapshots(0).client_info().id());
+  EXPECT_EQ(2u, snapshot.client_snapshots(1).client_info().id());
+  EXPECT_EQ(3u, snapshot.client_snapshots(2).client_info().id());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -452,6 +452,52 @@ TEST_F(MasterTest, PublishTopic) {
                base::BindOnce(&ExpectOK, event_));
 }
 
+namespace {
+
+void OnPublishTopics(std::shared_ptr<base::WaitableEvent> event,
+                     const PublishTopicsRequest& request,
+                     PublishTopicsResponse* response, Status s) {
+  EXPECT_TRUE(s.ok());
+  auto& statuses = response->statuses();
+  EXPECT_EQ(3, statuses.size());
+  if (statuses.size() == 3) {
+    Status expected = errors::TopicAlreadyPublishingOnNode(
+        request.node_info(), request.topic_infos(0));
+    EXPECT_TRUE(Status(statuses[0].error_code(),
+                       statuses[0].error_message()) == expected);
+    expected = errors::ChannelSourceNotValid(
+        "topic source", request.topic_infos(1).topic_source());
+    EXPECT_TRUE(Status(statuses[1].error_code(),
+                       statuses[1].error_message()) == expected);
+    EXPECT_EQ(error::OK, statuses[2].error_code());
+  }
+  event->Signal();
+}
+
+}  // namespace
+
+TEST_F(MasterTest, PublishTopics) {
+  DECLARE_REQUEST_AND_RESPONSE(PublishTopics);
+
+  NodeInfo* node_info = request->mutable_node_info();
+
+  EXPECT_CHECK_NODE_EXISTS(PublishTopics, node_info);
+
+  node_info->set_name(publishing_node_name_);
+  *request->add_topic_infos() = topic_info_;
+  request->add_topic_infos()->set_topic("topic2");
+  TopicInfo* topic_info = request->add_topic_infos();
+  topic_info->set_topic("topic3");
+  ChannelDef* channel_def =
+      topic_info->mutable_topic_source()->add_channel_defs();
+  channel_def->set_type(ChannelDef::CHANNEL_TYPE_TCP);
+  FillRandomTCPChannelDef(channel_def);
+
+  PublishTopics(request.get(), response.get(),
+                base::BindOnce(&OnPublishTopics, event_, *request,
+                               response.get()));
+}
+
 TEST_F(MasterTest, UnpublishTopic) {
   DECLARE_REQUEST_AND_RESPONSE(UnpublishTopic);
 
@@ -70,6 +70,30 @@ std::unique_ptr<Node> Node::NewNode(const NodeInfo& node_info) {
   return base::WrapUnique(new Node(new_node_info));
 }
 
+// static
+std::unique_ptr<Node> Node::RestoreNode(const NodeSnapshot& node_snapshot) {
+  const NodeInfo& node_info = node_snapshot.node_info();
+  if (node_info.name().empty() || GetNameGenerator().In(node_info.name())) {
+    return nullptr;
+  }
+
+  GetNameGenerator().Add(node_info.name());
+  std::unique_ptr<Node> node = base::WrapUnique(new Node(node_info));
+  for (auto& topic_info : node_snapshot.publishing_topic_infos()) {
+    node->RegisterPublishingTopic(topic_info);
+  }
+  for (auto& topic : node_snapshot.subscribing_topics()) {
+    node->RegisterSubscribingTopic(topic);
+  }
+  for (auto& service_info : node_snapshot.serving_service_infos()) {
+    node->RegisterServingService(service_info);
+  }
+  for (auto& service : node_snapshot.requesting_services()) {
+    node->RegisterRequestingService(service);
+  }
+  return node;
+}
+
 Node::Node(const NodeInfo& node_info) : node_info_(node_info) {}
 
 Node::~Node() { GetNameGenerator().Return(node_info_.name()); }
@@ -184,6 +208,22 @@ std::vector<ServiceInfo> Node::AllServingServiceInfos() const {
   return service_infos;
 }
 
+void Node::ToNodeSnapshot(NodeSnapshot* node_snapshot) const {
+  *node_snapshot->mutable_node_info() = node_info_;
+  for (auto& it : topic_info_map_) {
+    *node_snapshot->add_publishing_topic_infos() = it.second;
+  }
+  for (auto& topic : subscribing_topics_) {
+    node_snapshot->add_subscribing_topics(topic);
+  }
+  for (auto& it : service_info_map_) {
+    *node_snapshot->add_serving_service_infos() = it.second;
+  }
+  for (auto& service : requesting_services_) {
+    node_snapshot->add_requesting_services(service);
+  }
+}
+
 bool NodeNameChecker::operator()(const std::unique_ptr<Node>& node) {
   return node->name() == node_info_.name();
 }
@@ -22,6 +22,9 @@ class Node : public base::SupportsWeakPtr<Node> {
   // Return a new node unless a |node_info| contains name and there is
   // already registered with a given name. If so, return nullptr.
   static std::unique_ptr<Node> NewNode(const NodeInfo& node_info);
+  // Return a node which is restored from a |node_snapshot|. If there is
+  // already registered with a same name, return nullptr.
+  static std::unique_ptr<Node> RestoreNode(const NodeSnapshot& node_snapshot);
 
   ~Node();
 
@@ -54,6 +57,8 @@ class Node : public base::SupportsWeakPtr<Node> {
   std::vector<std::string> AllRequestingServices() const;
   std::vector<ServiceInfo> AllServingServiceInfos() const;
 
+  void ToNodeSnapshot(NodeSnapshot* node_snapshot) const;
+
  private:
   explicit Node(const NodeInfo& node_info);
 
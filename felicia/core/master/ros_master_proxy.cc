@@ -20,6 +20,11 @@ namespace felicia {
 
 namespace {
 
+// lookupService is not followed by any notification from the ROS master, so
+// the cached endpoint is trusted only for a while.
+constexpr base::TimeDelta kServiceCacheTimeout =
+    base::TimeDelta::FromSeconds(5);
+
 Status FailedToExecute(const std::string& method) {
   return errors::Unavailable(
       base::StringPrintf("Failed to execute %s.", method.c_str()));
@@ -54,6 +59,12 @@ RosMasterProxy::TopicType::TopicType(const std::string& topic,
                                      const std::string& topic_type)
     : topic(topic), topic_type(topic_type) {}
 
+RosMasterProxy::TopicCache::TopicCache() = default;
+
+RosMasterProxy::TopicCache::TopicCache(const TopicCache& other) = default;
+
+RosMasterProxy::TopicCache::~TopicCache() = default;
+
 RosMasterProxy::RosMasterProxy() = default;
 
 RosMasterProxy::~RosMasterProxy() = default;
@@ -139,6 +150,17 @@ Status RosMasterProxy::RegisterPublisher(const std::string& topic,
 
 Status RosMasterProxy::RegisterSubscriber(const std::string& topic,
                                           const std::string& topic_type) const {
+  std::vector<std::string> pub_uris;
+  bool registered = false;
+  {
+    base::AutoLock l(lock_);
+    TopicCache& topic_cache = topic_caches_[topic];
+    registered = topic_cache.subscriber_count > 0;
+    topic_cache.subscriber_count++;
+    if (registered) pub_uris = topic_cache.pub_uris;
+  }
+  if (registered) return PubUpdate(topic, pub_uris);
+
   XmlRpc::XmlRpcValue request, response, payload;
   const std::string& this_server_uri = xmlrpc_manager_->getServerURI();
   request[0] = ros::this_node::getName();
@@ -146,15 +168,21 @@ Status RosMasterProxy::RegisterSubscriber(const std::string& topic,
   request[2] = topic_type;
   request[3] = this_server_uri;
   Status s = Execute("registerSubscriber", request, response, payload, true);
-  if (!s.ok()) return s;
+  if (!s.ok()) {
+    base::AutoLock l(lock_);
+    auto it = topic_caches_.find(topic);
+    if (it != topic_caches_.end() && --it->second.subscriber_count == 0)
+      topic_caches_.erase(it);
+    return s;
+  }
 
-  std::vector<std::string> pub_uris;
   for (int i = 0; i < payload.size(); i++) {
     if (payload[i] != this_server_uri) {
       pub_uris.push_back(std::string(payload[i]));
     }
   }
 
+  UpdatePubUris(topic, pub_uris);
   return PubUpdate(topic, pub_uris);
 }
 
@@ -167,6 +195,15 @@ Status RosMasterProxy::UnregisterPublisher(const std::string& topic) const {
 }
 
 Status RosMasterProxy::UnregisterSubscriber(const std::string& topic) const {
+  {
+    base::AutoLock l(lock_);
+    auto it = topic_caches_.find(topic);
+    if (it != topic_caches_.end()) {
+      if (--it->second.subscriber_count > 0) return Status::OK();
+      topic_caches_.erase(it);
+    }
+  }
+
   XmlRpc::XmlRpcValue request, response, payload;
   request[0] = ros::this_node::getName();
   request[1] = topic;
@@ -176,6 +213,7 @@ Status RosMasterProxy::UnregisterSubscriber(const std::string& topic) const {
 
 Status RosMasterProxy::RegisterService(const std::string& service,
                                        const IPEndPoint& ip_endpoint) const {
+  InvalidateService(service);
   XmlRpc::XmlRpcValue request, response, payload;
   request[0] = ros::this_node::getName();
   request[1] = service;
@@ -186,6 +224,7 @@ Status RosMasterProxy::RegisterService(const std::string& service,
 
 Status RosMasterProxy::UnregisterService(const std::string& service,
                                          const IPEndPoint& ip_endpoint) const {
+  InvalidateService(service);
   XmlRpc::XmlRpcValue request, response, payload;
   request[0] = ros::this_node::getName();
   request[1] = service;
@@ -195,6 +234,18 @@ Status RosMasterProxy::UnregisterService(const std::string& service,
 
 Status RosMasterProxy::LookupService(const std::string& service,
                                      IPEndPoint* ip_endpoint) const {
+  {
+    base::AutoLock l(lock_);
+    auto it = service_caches_.find(service);
+    if (it != service_caches_.end()) {
+      if (it->second.expiration > base::TimeTicks::Now()) {
+        *ip_endpoint = it->second.ip_endpoint;
+        return Status::OK();
+      }
+      service_caches_.erase(it);
+    }
+  }
+
   XmlRpc::XmlRpcValue request, response, payload;
   request[0] = ros::this_node::getName();
   request[1] = service;
@@ -208,6 +259,11 @@ Status RosMasterProxy::LookupService(const std::string& service,
         base::StringPrintf("Invalid ros rpc URI: %s.", srv_uri.c_str()));
   ip_endpoint->set_ip(host);
   ip_endpoint->set_port(static_cast<uint16_t>(port));
+
+  base::AutoLock l(lock_);
+  ServiceCache& service_cache = service_caches_[service];
+  service_cache.ip_endpoint = *ip_endpoint;
+  service_cache.expiration = base::TimeTicks::Now() + kServiceCacheTimeout;
   return Status::OK();
 }
 
@@ -218,7 +274,9 @@ void RosMasterProxy::PubUpdateCallback(XmlRpc::XmlRpcValue& request,
     pub_uris.push_back(request[2][idx]);
   }
 
-  Status s = PubUpdate(std::string(request[1]), pub_uris);
+  const std::string topic = request[1];
+  UpdatePubUris(topic, pub_uris);
+  Status s = PubUpdate(topic, pub_uris);
   if (s.ok()) {
     response = ros::xmlrpc::responseInt(1, "", 0);
   } else {
@@ -271,6 +329,24 @@ void RosMasterProxy::RequestTopicCallback(XmlRpc::XmlRpcValue& request,
 
 Status RosMasterProxy::RequestTopic(const std::string& pub_uri,
                                     const std::string& topic) const {
+  IPEndPoint cached_ip_endpoint;
+  bool cached = false;
+  {
+    base::AutoLock l(lock_);
+    auto it = topic_caches_.find(topic);
+    if (it != topic_caches_.end()) {
+      auto endpoint_it = it->second.tcpros_endpoints.find(pub_uri);
+      if (endpoint_it != it->second.tcpros_endpoints.end()) {
+        cached_ip_endpoint = endpoint_it->second;
+        cached = true;
+      }
+    }
+  }
+  if (cached) {
+    NotifyTCPROSEndpoint(topic, cached_ip_endpoint);
+    return Status::OK();
+  }
+
   XmlRpc::XmlRpcValue request, response, payload;
   request[0] = ros::this_node::getName();
   request[1] = topic;
@@ -281,9 +357,8 @@ Status RosMasterProxy::RequestTopic(const std::string& pub_uri,
     return errors::InvalidArgument(
         base::StringPrintf("Invalid XMLRPC URI: %s.", pub_uri.c_str()));
 
-  XmlRpc::XmlRpcClient* c =
-      new XmlRpc::XmlRpcClient(peer_host.c_str(), peer_port, "/");
-  Status s = Execute(c, "requestTopic", request, response, payload);
+  XmlRpc::XmlRpcClient c(peer_host.c_str(), peer_port, "/");
+  Status s = Execute(&c, "requestTopic", request, response, payload);
   if (!s.ok()) return s;
 
   if (payload.size() == 0)
@@ -294,16 +369,21 @@ Status RosMasterProxy::RequestTopic(const std::string& pub_uri,
   if (protocol == "TCPROS") {
     const std::string& pub_host = payload[1];
     int pub_port = payload[2];
-    TopicInfo topic_info;
-    topic_info.set_topic(AttachRosProtocol(topic));
-    ChannelDef channel_def;
-    channel_def.set_type(ChannelDef::CHANNEL_TYPE_TCP);
-    IPEndPoint* ip_endpoint = channel_def.mutable_ip_endpoint();
-    ip_endpoint->set_ip(pub_host);
-    ip_endpoint->set_port(pub_port);
-    *topic_info.mutable_topic_source()->add_channel_defs() = channel_def;
-    topic_info.set_ros_node_name(ros::this_node::getName());
-    master_->NotifyAllSubscribers(topic_info);
+    IPEndPoint ip_endpoint;
+    ip_endpoint.set_ip(pub_host);
+    ip_endpoint.set_port(pub_port);
+    {
+      base::AutoLock l(lock_);
+      // Cache only while someone is subscribing it, otherwise nothing will
+      // invalidate it.
+      auto it = topic_caches_.find(topic);
+      if (it != topic_caches_.end() &&
+          std::find(it->second.pub_uris.begin(), it->second.pub_uris.end(),
+                    pub_uri) != it->second.pub_uris.end()) {
+        it->second.tcpros_endpoints[pub_uri] = ip_endpoint;
+      }
+    }
+    NotifyTCPROSEndpoint(topic, ip_endpoint);
     return Status::OK();
   } else if (protocol == "UDPROS") {
     return errors::Unimplemented(base::StringPrintf(
@@ -331,6 +411,43 @@ Status RosMasterProxy::PubUpdate(
   return Status::OK();
 }
 
+void RosMasterProxy::NotifyTCPROSEndpoint(const std::string& topic,
+                                          const IPEndPoint& ip_endpoint) const {
+  TopicInfo topic_info;
+  topic_info.set_topic(AttachRosProtocol(topic));
+  ChannelDef* channel_def =
+      topic_info.mutable_topic_source()->add_channel_defs();
+  channel_def->set_type(ChannelDef::CHANNEL_TYPE_TCP);
+  *channel_def->mutable_ip_endpoint() = ip_endpoint;
+  topic_info.set_ros_node_name(ros::this_node::getName());
+  master_->NotifyAllSubscribers(topic_info);
+}
+
+void RosMasterProxy::UpdatePubUris(
+    const std::string& topic, const std::vector<std::string>& pub_uris) const {
+  base::AutoLock l(lock_);
+  auto it = topic_caches_.find(topic);
+  if (it == topic_caches_.end()) return;
+
+  TopicCache& topic_cache = it->second;
+  topic_cache.pub_uris = pub_uris;
+  auto& tcpros_endpoints = topic_cache.tcpros_endpoints;
+  for (auto endpoint_it = tcpros_endpoints.begin();
+       endpoint_it != tcpros_endpoints.end();) {
+    if (std::find(pub_uris.begin(), pub_uris.end(), endpoint_it->first) ==
+        pub_uris.end()) {
+      endpoint_it = tcpros_endpoints.erase(endpoint_it);
+    } else {
+      ++endpoint_it;
+    }
+  }
+}
+
+void RosMasterProxy::InvalidateService(const std::string& service) const {
+  base::AutoLock l(lock_);
+  service_caches_.erase(service);
+}
+
 }  // namespace felicia
 
 #endif  // defined(HAS_ROS)
\ No newline at end of file
@@ -9,7 +9,11 @@
 
 #include <ros/ros.h>
 
+#include "third_party/chromium/base/containers/flat_map.h"
 #include "third_party/chromium/base/no_destructor.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
+#include "third_party/chromium/base/time/time.h"
 
 #include "felicia/core/lib/error/status.h"
 #include "felicia/core/master/master.h"
@@ -17,6 +21,18 @@
 
 namespace felicia {
 
+// RosMasterProxy bridges felicia topics and services with the ROS master.
+//
+// To avoid paying a XML-RPC round trip on every lookup, it keeps a local cache
+// of what it has learned from the ROS side.
+//  * For topics, the publisher URIs from registerSubscriber and the TCPROS
+//    endpoint from requestTopic are cached per publisher. The ROS master pushes
+//    publisherUpdate whenever the set of publishers changes, and the entries
+//    for publishers which are gone are dropped there. registerSubscriber and
+//    unregisterSubscriber are issued only for the first and the last felicia
+//    subscriber of the topic.
+//  * For services, the ROS master doesn't notify anything, so the result of
+//    lookupService is cached only for a short while.
 class RosMasterProxy {
  public:
   struct TopicType {
@@ -63,6 +79,23 @@ class RosMasterProxy {
 
  private:
   friend class base::NoDestructor<RosMasterProxy>;
+  friend class RosMasterProxyTest;
+
+  struct TopicCache {
+    TopicCache();
+    TopicCache(const TopicCache& other);
+    ~TopicCache();
+
+    int subscriber_count = 0;
+    std::vector<std::string> pub_uris;
+    // Key is a publisher URI.
+    base::flat_map<std::string, IPEndPoint> tcpros_endpoints;
+  };
+
+  struct ServiceCache {
+    IPEndPoint ip_endpoint;
+    base::TimeTicks expiration;
+  };
 
   RosMasterProxy();
   ~RosMasterProxy();
@@ -78,8 +111,24 @@ class RosMasterProxy {
   Status PubUpdate(const std::string& topic,
                    const std::vector<std::string>& pub_uris) const;
 
+  void NotifyTCPROSEndpoint(const std::string& topic,
+                            const IPEndPoint& ip_endpoint) const;
+
+  void UpdatePubUris(const std::string& topic,
+                     const std::vector<std::string>& pub_uris) const;
+
+  void InvalidateService(const std::string& service) const;
+
   ros::XMLRPCManagerPtr xmlrpc_manager_;
   mutable Master* master_;
+
+  // Accessed both on the master thread and on the XMLRPC thread, which
+  // dispatches publisherUpdate.
+  mutable base::Lock lock_;
+  mutable base::flat_map<std::string, TopicCache> topic_caches_
+      GUARDED_BY(lock_);
+  mutable base::flat_map<std::string, ServiceCache> service_caches_
+      GUARDED_BY(lock_);
 };
 
 }  // namespace felicia
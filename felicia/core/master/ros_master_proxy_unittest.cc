@@ -0,0 +1,179 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#if defined(HAS_ROS)
+
+#include "felicia/core/master/ros_master_proxy.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <memory>
+
+#include <xmlrpcpp/XmlRpc.h>
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/memory/ptr_util.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
+#include "third_party/chromium/base/threading/thread.h"
+
+#include "felicia/core/lib/net/net_util.h"
+
+namespace felicia {
+
+namespace {
+
+constexpr const char* kTopic = "/chatter";
+constexpr const char* kTopicType = "std_msgs/String";
+constexpr const char* kService = "/add_two_ints";
+
+// Answers |name| with |payload| in the ROS XML-RPC response format, counting
+// how many times it is called.
+class StubXmlRpcMethod : public XmlRpc::XmlRpcServerMethod {
+ public:
+  StubXmlRpcMethod(const std::string& name, XmlRpc::XmlRpcServer* server,
+                   const XmlRpc::XmlRpcValue& payload)
+      : XmlRpc::XmlRpcServerMethod(name, server), payload_(payload) {}
+
+  void execute(XmlRpc::XmlRpcValue& params,
+               XmlRpc::XmlRpcValue& result) override {
+    call_count_++;
+    result[0] = 1;
+    result[1] = std::string();
+    result[2] = payload_;
+  }
+
+  int call_count() const { return call_count_; }
+
+ private:
+  XmlRpc::XmlRpcValue payload_;
+  std::atomic<int> call_count_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(StubXmlRpcMethod);
+};
+
+}  // namespace
+
+// A single local XML-RPC server plays both the ROS master and the ROS node
+// which publishes |kTopic|.
+class RosMasterProxyTest : public testing::Test {
+ public:
+  RosMasterProxyTest()
+      : master_(base::WrapUnique(new Master())),
+        server_thread_("StubXmlRpcServerThread") {}
+
+  void SetUp() override {
+    uint16_t port = PickRandomPort(true);
+    stub_uri_ = base::StringPrintf("http://127.0.0.1:%u/", port);
+
+    XmlRpc::XmlRpcValue pub_uris;
+    pub_uris[0] = stub_uri_;
+    register_subscriber_ = std::make_unique<StubXmlRpcMethod>(
+        "registerSubscriber", &server_, pub_uris);
+    unregister_subscriber_ = std::make_unique<StubXmlRpcMethod>(
+        "unregisterSubscriber", &server_, XmlRpc::XmlRpcValue(1));
+    XmlRpc::XmlRpcValue tcpros_params;
+    tcpros_params[0] = "TCPROS";
+    tcpros_params[1] = "127.0.0.1";
+    tcpros_params[2] = 11411;
+    request_topic_ = std::make_unique<StubXmlRpcMethod>("requestTopic",
+                                                        &server_, tcpros_params);
+    lookup_service_ = std::make_unique<StubXmlRpcMethod>(
+        "lookupService", &server_,
+        XmlRpc::XmlRpcValue(std::string("rosrpc://127.0.0.1:11412")));
+
+    ASSERT_TRUE(server_.bindAndListen(port));
+    server_thread_.Start();
+    server_thread_.task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(&RosMasterProxyTest::RunServer,
+                                  base::Unretained(this)));
+
+    setenv("ROS_MASTER_URI", stub_uri_.c_str(), 1);
+    master_->SetCheckHeartBeatForTesting(false);
+    master_->Run();
+    RosMasterProxy& ros_master_proxy = RosMasterProxy::GetInstance();
+    ASSERT_TRUE(ros_master_proxy.Init(master_.get()).ok());
+    ASSERT_TRUE(ros_master_proxy.Start().ok());
+  }
+
+  void TearDown() override {
+    RosMasterProxy::GetInstance().Shutdown();
+    quit_ = true;
+    server_thread_.Stop();
+    server_.shutdown();
+    master_->Stop();
+  }
+
+  void RunServer() {
+    while (!quit_) server_.work(0.01);
+  }
+
+  void PubUpdate(const std::vector<std::string>& pub_uris) {
+    XmlRpc::XmlRpcValue request, response;
+    request[0] = "/master";
+    request[1] = kTopic;
+    request[2].setSize(pub_uris.size());
+    for (size_t i = 0; i < pub_uris.size(); ++i) {
+      request[2][i] = pub_uris[i];
+    }
+    RosMasterProxy::GetInstance().PubUpdateCallback(request, response);
+    EXPECT_EQ(1, int(response[0]));
+  }
+
+ protected:
+  std::unique_ptr<Master> master_;
+  XmlRpc::XmlRpcServer server_;
+  base::Thread server_thread_;
+  std::atomic<bool> quit_{false};
+  std::string stub_uri_;
+  std::unique_ptr<StubXmlRpcMethod> register_subscriber_;
+  std::unique_ptr<StubXmlRpcMethod> unregister_subscriber_;
+  std::unique_ptr<StubXmlRpcMethod> request_topic_;
+  std::unique_ptr<StubXmlRpcMethod> lookup_service_;
+};
+
+TEST_F(RosMasterProxyTest, CacheTopicAndService) {
+  RosMasterProxy& ros_master_proxy = RosMasterProxy::GetInstance();
+
+  EXPECT_TRUE(ros_master_proxy.RegisterSubscriber(kTopic, kTopicType).ok());
+  EXPECT_EQ(1, register_subscriber_->call_count());
+  EXPECT_EQ(1, request_topic_->call_count());
+
+  // Another subscriber reuses the registration and the TCPROS endpoint.
+  EXPECT_TRUE(ros_master_proxy.RegisterSubscriber(kTopic, kTopicType).ok());
+  EXPECT_EQ(1, register_subscriber_->call_count());
+  EXPECT_EQ(1, request_topic_->call_count());
+
+  // The same publisher is still there.
+  PubUpdate({stub_uri_});
+  EXPECT_EQ(1, request_topic_->call_count());
+
+  // The publisher is gone and then comes back, so it should be requested again.
+  PubUpdate({});
+  PubUpdate({stub_uri_});
+  EXPECT_EQ(2, request_topic_->call_count());
+
+  EXPECT_TRUE(ros_master_proxy.UnregisterSubscriber(kTopic).ok());
+  EXPECT_EQ(0, unregister_subscriber_->call_count());
+  EXPECT_TRUE(ros_master_proxy.UnregisterSubscriber(kTopic).ok());
+  EXPECT_EQ(1, unregister_subscriber_->call_count());
+
+  // Nobody subscribes to it, so it should go to the ROS master again.
+  EXPECT_TRUE(ros_master_proxy.RegisterSubscriber(kTopic, kTopicType).ok());
+  EXPECT_EQ(2, register_subscriber_->call_count());
+  EXPECT_EQ(3, request_topic_->call_count());
+  EXPECT_TRUE(ros_master_proxy.UnregisterSubscriber(kTopic).ok());
+
+  IPEndPoint ip_endpoint;
+  EXPECT_TRUE(ros_master_proxy.LookupService(kService, &ip_endpoint).ok());
+  EXPECT_EQ("127.0.0.1", ip_endpoint.ip());
+  EXPECT_EQ(11412, ip_endpoint.port());
+  EXPECT_TRUE(ros_master_proxy.LookupService(kService, &ip_endpoint).ok());
+  EXPECT_EQ(1, lookup_service_->call_count());
+}
+
+}  // namespace felicia
+
+#endif  // defined(HAS_ROS)
\ No newline at end of file
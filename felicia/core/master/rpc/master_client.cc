@@ -4,6 +4,8 @@
 
 #include "felicia/core/master/rpc/master_client.h"
 
+#include "felicia/core/master/rpc/master_server_info.h"
+
 namespace felicia {
 
 MasterClient::MasterClient(std::shared_ptr<::grpc::Channel> channel)
@@ -11,7 +13,11 @@ MasterClient::MasterClient(std::shared_ptr<::grpc::Channel> channel)
 
 MasterClient::~MasterClient() = default;
 
-Status MasterClient::Start() { return Run(); }
+Status MasterClient::Start() {
+  RunRpcsLoops(ResolveMasterClientRpcThreads(),
+               ResolveMasterClientCompletionQueues());
+  return Status::OK();
+}
 
 Status MasterClient::Stop() { return Shutdown(); }
 
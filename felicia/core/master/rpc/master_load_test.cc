@@ -0,0 +1,533 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Load test for the master. It runs a MasterServer in-process and lets
+// |clients| x |nodes| simulated nodes go through the real gRPC MasterService
+// doing register, subscribe, publish, unpublish, unsubscribe and unregister
+// churn. At the end, it reports p50/p99/p999 latencies of each RPC and the
+// time for a published TopicInfo to be notified to every subscriber.
+//
+// bazel run //felicia/core/master/rpc:master_load_test -- --clients 32 \
+//   --nodes 8 --topics 4 --iterations 20
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "third_party/chromium/base/barrier_closure.h"
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/synchronization/waitable_event.h"
+#include "third_party/chromium/base/threading/thread.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/felicia_init.h"
+#include "felicia/core/lib/net/net_util.h"
+#include "felicia/core/master/master_notification_watcher.h"
+#include "felicia/core/master/rpc/master_client.h"
+#include "felicia/core/master/rpc/master_server.h"
+#include "felicia/core/master/rpc/master_server_info.h"
+#include "felicia/core/rpc/grpc_util.h"
+#include "felicia/core/util/command_line_interface/flag.h"
+
+namespace felicia {
+
+namespace {
+
+// Time to wait for every subscriber to be notified.
+constexpr int64_t kNotificationTimeout = 30;  // in seconds
+
+class MasterLoadTestFlag : public FlagParser::Delegate {
+ public:
+  MasterLoadTestFlag() {
+    {
+      IntDefaultFlag::Builder builder(MakeValueStore(&clients_, 8));
+      auto flag = builder.SetLongName("--clients")
+                      .SetHelp("Number of clients (default: 8)")
+                      .Build();
+      clients_flag_ = std::make_unique<IntDefaultFlag>(flag);
+    }
+    {
+      IntDefaultFlag::Builder builder(MakeValueStore(&nodes_, 4));
+      auto flag = builder.SetLongName("--nodes")
+                      .SetHelp("Number of nodes per client (default: 4)")
+                      .Build();
+      nodes_flag_ = std::make_unique<IntDefaultFlag>(flag);
+    }
+    {
+      IntDefaultFlag::Builder builder(MakeValueStore(&topics_, 2));
+      auto flag = builder.SetLongName("--topics")
+                      .SetHelp(
+                          "Number of topics to which every node subscribes "
+                          "(default: 2)")
+                      .Build();
+      topics_flag_ = std::make_unique<IntDefaultFlag>(flag);
+    }
+    {
+      IntDefaultFlag::Builder builder(MakeValueStore(&iterations_, 10));
+      auto flag = builder.SetLongName("--iterations")
+                      .SetHelp("Number of iterations (default: 10)")
+                      .Build();
+      iterations_flag_ = std::make_unique<IntDefaultFlag>(flag);
+    }
+  }
+
+  int clients() const { return clients_; }
+  int nodes() const { return nodes_; }
+  int topics() const { return topics_; }
+  int iterations() const { return iterations_; }
+
+  bool Parse(FlagParser& parser) override {
+    return PARSE_OPTIONAL_FLAG(parser, clients_flag_, nodes_flag_, topics_flag_,
+                               iterations_flag_);
+  }
+
+  bool Validate() const override {
+    return clients_ > 0 && nodes_ > 0 && topics_ > 0 && iterations_ > 0 &&
+           topics_ <= clients_ * nodes_;
+  }
+
+  AUTO_DEFINE_USAGE_AND_HELP_TEXT_METHODS(clients_flag_, nodes_flag_,
+                                          topics_flag_, iterations_flag_)
+
+ private:
+  int clients_;
+  int nodes_;
+  int topics_;
+  int iterations_;
+  std::unique_ptr<IntDefaultFlag> clients_flag_;
+  std::unique_ptr<IntDefaultFlag> nodes_flag_;
+  std::unique_ptr<IntDefaultFlag> topics_flag_;
+  std::unique_ptr<IntDefaultFlag> iterations_flag_;
+
+  DISALLOW_COPY_AND_ASSIGN(MasterLoadTestFlag);
+};
+
+class LatencyRecorder {
+ public:
+  LatencyRecorder() = default;
+
+  void Record(base::TimeDelta latency) {
+    base::AutoLock l(lock_);
+    latencies_.push_back(latency);
+  }
+
+  void RecordFailure() {
+    base::AutoLock l(lock_);
+    failures_++;
+  }
+
+  void Report(const std::string& name) {
+    base::AutoLock l(lock_);
+    std::sort(latencies_.begin(), latencies_.end());
+    std::cout << std::left << std::setw(20) << name << std::right
+              << std::setw(8) << latencies_.size() << std::setw(8) << failures_
+              << std::setw(12) << Percentile(0.5) << std::setw(12)
+              << Percentile(0.99) << std::setw(12) << Percentile(0.999)
+              << std::setw(12)
+              << (latencies_.empty() ? 0
+                                     : latencies_.back().InMicroseconds())
+              << std::endl;
+  }
+
+ private:
+  // Returns the |p|-th percentile in microseconds. |latencies_| should be
+  // sorted before.
+  int64_t Percentile(double p) const {
+    if (latencies_.empty()) return 0;
+    size_t rank = static_cast<size_t>(std::ceil(p * latencies_.size()));
+    size_t index = std::min(std::max(rank, static_cast<size_t>(1)),
+                            latencies_.size()) -
+                   1;
+    return latencies_[index].InMicroseconds();
+  }
+
+  base::Lock lock_;
+  std::vector<base::TimeDelta> latencies_ GUARDED_BY(lock_);
+  size_t failures_ GUARDED_BY(lock_) = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(LatencyRecorder);
+};
+
+}  // namespace
+
+class MasterLoadTest {
+ public:
+  explicit MasterLoadTest(const MasterLoadTestFlag& delegate)
+      : num_clients_(delegate.clients()),
+        num_nodes_(delegate.nodes()),
+        num_topics_(delegate.topics()),
+        num_iterations_(delegate.iterations()),
+        notification_thread_("LoadTest Notification") {}
+
+  Status Run() {
+    Status s = StartServer();
+    if (!s.ok()) return s;
+    s = StartClients();
+    if (!s.ok()) return s;
+
+    for (int i = 0; i < num_iterations_; ++i) {
+      RunIteration(i);
+    }
+
+    Stop();
+    Report();
+    return Status::OK();
+  }
+
+ private:
+  struct SimulatedClient {
+    std::unique_ptr<MasterClient> master_client;
+    std::unique_ptr<MasterNotificationWatcher> watcher;
+    uint32_t id;
+  };
+
+  template <typename Request>
+  struct Call {
+    MasterClient* master_client;
+    Request request;
+  };
+
+  struct FanOut {
+    base::TimeTicks start;
+    int remaining;
+  };
+
+  template <typename Request, typename Response>
+  using AsyncMethod = void (MasterClient::*)(const Request*, Response*,
+                                             StatusOnceCallback);
+
+  Status StartServer() {
+    Status s = server_.Start();
+    if (!s.ok()) return s;
+    // Simulated clients don't run heart beat signallers.
+    server_.master()->SetCheckHeartBeatForTesting(false);
+    return server_.Run();
+  }
+
+  Status StartClients() {
+    notification_thread_.StartWithOptions(
+        base::Thread::Options{base::MessageLoop::TYPE_IO, 0});
+
+    std::string ip = HostIPAddress(HOST_IP_ONLY_ALLOW_IPV4).ToString();
+    uint16_t port = ResolveMasterServerPort();
+
+    std::vector<Call<RegisterClientRequest>> calls;
+    for (int i = 0; i < num_clients_; ++i) {
+      auto client = std::make_unique<SimulatedClient>();
+      client->master_client =
+          std::make_unique<MasterClient>(ConnectToGrpcServer(ip, port));
+      Status s = client->master_client->Start();
+      if (!s.ok()) return s;
+
+      client->watcher = std::make_unique<MasterNotificationWatcher>();
+      base::WaitableEvent event;
+      notification_thread_.task_runner()->PostTask(
+          FROM_HERE, base::BindOnce(&MasterLoadTest::StartWatcher,
+                                    base::Unretained(this),
+                                    base::Unretained(client->watcher.get()),
+                                    base::Unretained(&event)));
+      event.Wait();
+
+      Call<RegisterClientRequest> call;
+      call.master_client = client->master_client.get();
+      *call.request.mutable_client_info()
+           ->mutable_master_notification_watcher_source() =
+          client->watcher->channel_source();
+      calls.push_back(call);
+      clients_.push_back(std::move(client));
+    }
+
+    std::vector<RegisterClientResponse> responses =
+        CallConcurrently("RegisterClient", &MasterClient::RegisterClientAsync,
+                         calls);
+    for (int i = 0; i < num_clients_; ++i) {
+      clients_[i]->id = responses[i].id();
+    }
+    return Status::OK();
+  }
+
+  void StartWatcher(MasterNotificationWatcher* watcher,
+                    base::WaitableEvent* event) {
+    watcher->RegisterAllTopicInfoCallback(base::BindRepeating(
+        &MasterLoadTest::OnTopicInfo, base::Unretained(this)));
+    watcher->Start();
+    event->Signal();
+  }
+
+  void RunIteration(int iteration) {
+    std::vector<NodeInfo> node_infos;
+    for (int i = 0; i < num_clients_; ++i) {
+      for (int j = 0; j < num_nodes_; ++j) {
+        NodeInfo node_info;
+        node_info.set_client_id(clients_[i]->id);
+        node_info.set_name(base::StringPrintf("node%d", j));
+        node_infos.push_back(node_info);
+      }
+    }
+
+    // Publishers are spread over the clients.
+    std::vector<std::string> topics;
+    std::vector<NodeInfo> publisher_node_infos;
+    for (int i = 0; i < num_topics_; ++i) {
+      topics.push_back(
+          base::StringPrintf("/load_test/%d/topic%d", iteration, i));
+      publisher_node_infos.push_back(
+          node_infos[i * num_nodes_ % node_infos.size()]);
+    }
+
+    {
+      std::vector<Call<RegisterNodeRequest>> calls;
+      for (const NodeInfo& node_info : node_infos) {
+        Call<RegisterNodeRequest> call;
+        call.master_client = MasterClientOf(node_info);
+        *call.request.mutable_node_info() = node_info;
+        calls.push_back(call);
+      }
+      CallConcurrently("RegisterNode", &MasterClient::RegisterNodeAsync, calls);
+    }
+
+    {
+      std::vector<Call<SubscribeTopicRequest>> calls;
+      for (const NodeInfo& node_info : node_infos) {
+        for (const std::string& topic : topics) {
+          Call<SubscribeTopicRequest> call;
+          call.master_client = MasterClientOf(node_info);
+          *call.request.mutable_node_info() = node_info;
+          call.request.set_topic(topic);
+          call.request.set_topic_type("LoadTestMessage");
+          calls.push_back(call);
+        }
+      }
+      CallConcurrently("SubscribeTopic", &MasterClient::SubscribeTopicAsync,
+                       calls);
+    }
+
+    {
+      base::WaitableEvent event;
+      std::vector<Call<PublishTopicRequest>> calls;
+      {
+        base::AutoLock l(lock_);
+        fan_out_map_.clear();
+        fan_out_done_ = base::BarrierClosure(
+            num_topics_, base::BindOnce(&base::WaitableEvent::Signal,
+                                        base::Unretained(&event)));
+      }
+      for (int i = 0; i < num_topics_; ++i) {
+        const NodeInfo& node_info = publisher_node_infos[i];
+        Call<PublishTopicRequest> call;
+        call.master_client = MasterClientOf(node_info);
+        *call.request.mutable_node_info() = node_info;
+        TopicInfo* topic_info = call.request.mutable_topic_info();
+        topic_info->set_topic(topics[i]);
+        topic_info->set_type_name("LoadTestMessage");
+        ChannelDef* channel_def =
+            topic_info->mutable_topic_source()->add_channel_defs();
+        channel_def->set_type(ChannelDef::CHANNEL_TYPE_TCP);
+        IPEndPoint* ip_endpoint = channel_def->mutable_ip_endpoint();
+        ip_endpoint->set_ip(HostIPAddress(HOST_IP_ONLY_ALLOW_IPV4).ToString());
+        ip_endpoint->set_port(PickRandomPort(true));
+        calls.push_back(call);
+
+        base::AutoLock l(lock_);
+        fan_out_map_[topics[i]] = {base::TimeTicks::Now(),
+                                   static_cast<int>(node_infos.size())};
+      }
+      CallConcurrently("PublishTopic", &MasterClient::PublishTopicAsync, calls);
+      if (!event.TimedWait(
+              base::TimeDelta::FromSeconds(kNotificationTimeout))) {
+        LOG(ERROR) << "Timeout waiting for notifications at iteration "
+                   << iteration;
+      }
+      base::AutoLock l(lock_);
+      fan_out_map_.clear();
+      fan_out_done_.Reset();
+    }
+
+    {
+      std::vector<Call<UnpublishTopicRequest>> calls;
+      for (int i = 0; i < num_topics_; ++i) {
+        const NodeInfo& node_info = publisher_node_infos[i];
+        Call<UnpublishTopicRequest> call;
+        call.master_client = MasterClientOf(node_info);
+        *call.request.mutable_node_info() = node_info;
+        call.request.set_topic(topics[i]);
+        calls.push_back(call);
+      }
+      CallConcurrently("UnpublishTopic", &MasterClient::UnpublishTopicAsync,
+                       calls);
+    }
+
+    {
+      std::vector<Call<UnsubscribeTopicRequest>> calls;
+      for (const NodeInfo& node_info : node_infos) {
+        for (const std::string& topic : topics) {
+          Call<UnsubscribeTopicRequest> call;
+          call.master_client = MasterClientOf(node_info);
+          *call.request.mutable_node_info() = node_info;
+          call.request.set_topic(topic);
+          calls.push_back(call);
+        }
+      }
+      CallConcurrently("UnsubscribeTopic", &MasterClient::UnsubscribeTopicAsync,
+                       calls);
+    }
+
+    {
+      std::vector<Call<UnregisterNodeRequest>> calls;
+      for (const NodeInfo& node_info : node_infos) {
+        Call<UnregisterNodeRequest> call;
+        call.master_client = MasterClientOf(node_info);
+        *call.request.mutable_node_info() = node_info;
+        calls.push_back(call);
+      }
+      CallConcurrently("UnregisterNode", &MasterClient::UnregisterNodeAsync,
+                       calls);
+    }
+  }
+
+  // Issue every call in |calls| at once and wait until all of them are done.
+  template <typename Request, typename Response>
+  std::vector<Response> CallConcurrently(
+      const std::string& method_name, AsyncMethod<Request, Response> method,
+      const std::vector<Call<Request>>& calls) {
+    LatencyRecorder* recorder = GetRecorder(method_name);
+    std::vector<Response> responses(calls.size());
+    base::WaitableEvent event;
+    base::RepeatingClosure done = base::BarrierClosure(
+        static_cast<int>(calls.size()), base::BindOnce(&base::WaitableEvent::Signal,
+                                     base::Unretained(&event)));
+    for (size_t i = 0; i < calls.size(); ++i) {
+      (calls[i].master_client->*method)(
+          &calls[i].request, &responses[i],
+          base::BindOnce(&MasterLoadTest::OnCallDone, base::Unretained(this),
+                         recorder, base::TimeTicks::Now(), done));
+    }
+    event.Wait();
+    return responses;
+  }
+
+  void OnCallDone(LatencyRecorder* recorder, base::TimeTicks start,
+                  base::RepeatingClosure done, Status s) {
+    if (s.ok()) {
+      recorder->Record(base::TimeTicks::Now() - start);
+    } else {
+      LOG(ERROR) << s;
+      recorder->RecordFailure();
+    }
+    done.Run();
+  }
+
+  // Called on |notification_thread_|.
+  void OnTopicInfo(const TopicInfo& topic_info) {
+    if (topic_info.status() != TopicInfo::REGISTERED) return;
+
+    base::AutoLock l(lock_);
+    auto it = fan_out_map_.find(topic_info.topic());
+    if (it == fan_out_map_.end()) return;
+
+    base::TimeDelta elapsed = base::TimeTicks::Now() - it->second.start;
+    notification_recorder_.Record(elapsed);
+    if (--it->second.remaining == 0 && !fan_out_done_.is_null()) {
+      fan_out_recorder_.Record(elapsed);
+      fan_out_done_.Run();
+    }
+  }
+
+  MasterClient* MasterClientOf(const NodeInfo& node_info) {
+    for (auto& client : clients_) {
+      if (client->id == node_info.client_id())
+        return client->master_client.get();
+    }
+    NOTREACHED();
+    return nullptr;
+  }
+
+  LatencyRecorder* GetRecorder(const std::string& method_name) {
+    auto it = recorders_.find(method_name);
+    if (it == recorders_.end()) {
+      method_names_.push_back(method_name);
+      it = recorders_.emplace(method_name, std::make_unique<LatencyRecorder>())
+               .first;
+    }
+    return it->second.get();
+  }
+
+  void Stop() {
+    for (auto& client : clients_) {
+      client->master_client->Stop();
+    }
+    server_.Shutdown();
+
+    for (auto& client : clients_) {
+      notification_thread_.task_runner()->DeleteSoon(
+          FROM_HERE, client->watcher.release());
+    }
+    notification_thread_.Stop();
+  }
+
+  void Report() {
+    std::cout << "clients: " << num_clients_ << ", nodes per client: "
+              << num_nodes_ << ", topics: " << num_topics_
+              << ", iterations: " << num_iterations_ << std::endl;
+    std::cout << std::left << std::setw(20) << "(usec)" << std::right
+              << std::setw(8) << "count" << std::setw(8) << "failed"
+              << std::setw(12) << "p50" << std::setw(12) << "p99"
+              << std::setw(12) << "p999" << std::setw(12) << "max"
+              << std::endl;
+    for (const std::string& method_name : method_names_) {
+      recorders_[method_name]->Report(method_name);
+    }
+    // Time from sending PublishTopic until each subscriber is notified, and
+    // until the last subscriber is notified.
+    notification_recorder_.Report("Notification");
+    fan_out_recorder_.Report("FanOut");
+  }
+
+  const int num_clients_;
+  const int num_nodes_;
+  const int num_topics_;
+  const int num_iterations_;
+
+  MasterServer server_;
+  base::Thread notification_thread_;
+  std::vector<std::unique_ptr<SimulatedClient>> clients_;
+
+  std::vector<std::string> method_names_;
+  std::map<std::string, std::unique_ptr<LatencyRecorder>> recorders_;
+  LatencyRecorder notification_recorder_;
+  LatencyRecorder fan_out_recorder_;
+
+  base::Lock lock_;
+  std::map<std::string, FanOut> fan_out_map_ GUARDED_BY(lock_);
+  base::RepeatingClosure fan_out_done_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(MasterLoadTest);
+};
+
+int RealMain(int argc, char* argv[]) {
+  FeliciaInit();
+
+  MasterLoadTestFlag delegate;
+  FlagParser parser;
+  parser.set_program_name(argv[0]);
+  if (!parser.Parse(argc, argv, &delegate)) {
+    return 1;
+  }
+
+  MasterLoadTest load_test(delegate);
+  Status s = load_test.Run();
+  if (!s.ok()) {
+    std::cerr << s << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace felicia
+
+int main(int argc, char* argv[]) { return felicia::RealMain(argc, argv); }
\ No newline at end of file
@@ -9,6 +9,7 @@ MASTER_METHOD(RegisterNode, registerNode, true)
 MASTER_METHOD(UnregisterNode, unregisterNode, true)
 MASTER_METHOD(ListNodes, listNodes, false)
 MASTER_METHOD(PublishTopic, publishTopic, true)
+MASTER_METHOD(PublishTopics, publishTopics, true)
 MASTER_METHOD(UnpublishTopic, unpublishTopic, true)
 MASTER_METHOD(SubscribeTopic, subscribeTopic, true)
 MASTER_METHOD(UnsubscribeTopic, unsubscribeTopic, true)
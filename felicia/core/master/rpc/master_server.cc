@@ -6,8 +6,10 @@
 
 #include <csignal>
 
+#include "third_party/chromium/base/strings/string_number_conversions.h"
 #include "third_party/chromium/base/strings/stringprintf.h"
 
+#include "felicia/core/lib/file/file_util.h"
 #include "felicia/core/lib/net/net_util.h"
 #include "felicia/core/master/rpc/master_server_info.h"
 
@@ -17,6 +19,21 @@ namespace {
 
 MasterServer* g_master_server = nullptr;
 
+constexpr int64_t kDefaultSnapshotInterval = 60;  // in seconds
+
+base::TimeDelta ResolveSnapshotInterval() {
+  int64_t interval = kDefaultSnapshotInterval;
+  const char* interval_str = getenv("FEL_MASTER_SNAPSHOT_INTERVAL");
+  if (interval_str) {
+    if (!base::StringToInt64(interval_str, &interval) || interval <= 0) {
+      LOG(WARNING) << "Invalid snapshot interval " << interval_str
+                   << ", set to default value " << kDefaultSnapshotInterval;
+      interval = kDefaultSnapshotInterval;
+    }
+  }
+  return base::TimeDelta::FromSeconds(interval);
+}
+
 void ShutdownMasterServer(int signal) {
   if (g_master_server) {
     g_master_server->Shutdown();
@@ -35,7 +52,16 @@ std::string MasterServer::ConfigureServerAddress() {
 
 Status MasterServer::RegisterService(::grpc::ServerBuilder* builder) {
   master_ = std::unique_ptr<Master>(new Master());
-  service_ = std::make_unique<MasterService>(master_.get(), builder);
+  // When FEL_MASTER_STATE_DIR is set, the registrations are persisted there,
+  // so that the restarted master doesn't need every client to register again.
+  const char* state_dir = getenv("FEL_MASTER_STATE_DIR");
+  if (state_dir) {
+    master_->EnableStateStore(
+        std::make_unique<MasterStateStore>(ToFilePath(state_dir)),
+        ResolveSnapshotInterval());
+  }
+  service_ = std::make_unique<MasterService>(
+      master_.get(), builder, ResolveMasterServerCompletionQueues());
 
   return Status::OK();
 }
@@ -44,7 +70,7 @@ Status MasterServer::Run() {
   RegisterSignals();
   master_->Run();
 
-  RunRpcsLoops(2);
+  RunRpcsLoops(ResolveMasterServerRpcThreads());
 
   return Status::OK();
 }
@@ -13,6 +13,24 @@ namespace felicia {
 
 static const uint16_t g_default_master_port = 8881;
 
+namespace {
+
+int ResolvePositiveInt(const char* name, int default_value) {
+  const char* env = getenv(name);
+  if (env) {
+    int value;
+    if (base::StringToInt(env, &value) && value > 0) {
+      return value;
+    }
+    LOG(WARNING) << "Invalid " << name << " " << env
+                 << ", set to default value " << default_value;
+  }
+
+  return default_value;
+}
+
+}  // namespace
+
 net::IPAddress ResolveMasterServerIp() {
   const char* ip_env = getenv("FEL_MASTER_SERVER_IP");
   if (ip_env) {
@@ -39,4 +57,20 @@ uint16_t ResolveMasterServerPort() {
   return g_default_master_port;
 }
 
+int ResolveMasterServerCompletionQueues() {
+  return ResolvePositiveInt("FEL_MASTER_SERVER_COMPLETION_QUEUES", 1);
+}
+
+int ResolveMasterServerRpcThreads() {
+  return ResolvePositiveInt("FEL_MASTER_SERVER_RPC_THREADS", 2);
+}
+
+int ResolveMasterClientCompletionQueues() {
+  return ResolvePositiveInt("FEL_MASTER_CLIENT_COMPLETION_QUEUES", 1);
+}
+
+int ResolveMasterClientRpcThreads() {
+  return ResolvePositiveInt("FEL_MASTER_CLIENT_RPC_THREADS", 1);
+}
+
 }  // namespace felicia
\ No newline at end of file
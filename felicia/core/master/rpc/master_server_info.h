@@ -17,6 +17,13 @@ FEL_EXPORT net::IPAddress ResolveMasterServerIp();
 
 FEL_EXPORT uint16_t ResolveMasterServerPort();
 
+// Number of gRPC completion queues and threads polling each of them, on the
+// master server side and the client side respectively.
+FEL_EXPORT int ResolveMasterServerCompletionQueues();
+FEL_EXPORT int ResolveMasterServerRpcThreads();
+FEL_EXPORT int ResolveMasterClientCompletionQueues();
+FEL_EXPORT int ResolveMasterClientRpcThreads();
+
 }  // namespace felicia
 
 #endif  // FELICIA_CORE_MASTER_RPC_MASTER_SERVER_INFO_H_
\ No newline at end of file
@@ -6,8 +6,10 @@
 
 namespace felicia {
 
-MasterService::MasterService(Master* master, ::grpc::ServerBuilder* builder)
-    : Service<grpc::MasterService>(builder), master_(master) {}
+MasterService::MasterService(Master* master, ::grpc::ServerBuilder* builder,
+                             int num_completion_queues)
+    : Service<grpc::MasterService>(builder, num_completion_queues),
+      master_(master) {}
 
 void MasterService::EnqueueRequests() {
 #define MASTER_METHOD(Method, method, cancelable) \
@@ -13,7 +13,8 @@ namespace felicia {
 
 class MasterService : public rpc::Service<grpc::MasterService> {
  public:
-  MasterService(Master* master, ::grpc::ServerBuilder* builder);
+  MasterService(Master* master, ::grpc::ServerBuilder* builder,
+                int num_completion_queues = 1);
 
  private:
   void EnqueueRequests() override;
@@ -4,6 +4,8 @@
 
 #include "felicia/core/master/tool/topic_subscribe_command_dispatcher.h"
 
+#include "third_party/chromium/base/strings/string_split.h"
+
 #include "felicia/core/master/master_proxy.h"
 #include "felicia/core/node/dynamic_subscribing_node.h"
 #include "felicia/core/node/topic_info_watcher_node.h"
@@ -16,10 +18,12 @@ class OneTopicSubscriberDelegate
     : public DynamicSubscribingNode::OneTopicDelegate {
  public:
   OneTopicSubscriberDelegate(const std::string& topic,
-                             const communication::Settings& settings)
-      : topic_(topic), settings_(settings) {}
+                             const communication::Settings& settings,
+                             const std::vector<std::string>& fields)
+      : topic_(topic), settings_(settings), fields_(fields) {}
 
   void OnDidCreate(DynamicSubscribingNode* node) override {
+    if (!fields_.empty()) node->SetLazy(fields_);
     node->RequestSubscribe(topic_, settings_);
   }
 
@@ -40,13 +44,15 @@ class OneTopicSubscriberDelegate
  private:
   std::string topic_;
   communication::Settings settings_;
+  std::vector<std::string> fields_;
 };
 
 class MultiTopicSubscriberDelegate
     : public DynamicSubscribingNode::MultiTopicDelegate {
  public:
-  MultiTopicSubscriberDelegate(const communication::Settings& settings)
-      : settings_(settings) {}
+  MultiTopicSubscriberDelegate(const communication::Settings& settings,
+                               const std::vector<std::string>& fields)
+      : settings_(settings), fields_(fields) {}
 
   void OnDidCreate(DynamicSubscribingNode* node) override;
 
@@ -82,6 +88,7 @@ class MultiTopicSubscriberDelegate
  private:
   DynamicSubscribingNode* node_ = nullptr;  // not owned
   communication::Settings settings_;
+  std::vector<std::string> fields_;
 };
 
 class TopicInfoWatcherDelegate : public TopicInfoWatcherNode::Delegate {
@@ -101,6 +108,7 @@ class TopicInfoWatcherDelegate : public TopicInfoWatcherNode::Delegate {
 
 void MultiTopicSubscriberDelegate::OnDidCreate(DynamicSubscribingNode* node) {
   node_ = node;
+  if (!fields_.empty()) node_->SetLazy(fields_);
   MasterProxy& master_proxy = MasterProxy::GetInstance();
   NodeInfo node_info;
   node_info.set_watcher(true);
@@ -121,16 +129,23 @@ void TopicSubscribeCommandDispatcher::Dispatch(
   if (delegate.queue_size_flag()->is_set())
     settings.queue_size = delegate.queue_size_flag()->value();
   settings.is_dynamic_buffer = true;
+  std::vector<std::string> fields;
+  if (delegate.fields_flag()->is_set()) {
+    fields = base::SplitString(delegate.fields_flag()->value(), ",",
+                               base::TRIM_WHITESPACE,
+                               base::SPLIT_WANT_NONEMPTY);
+  }
 
   MasterProxy& master_proxy = MasterProxy::GetInstance();
   NodeInfo node_info;
   if (delegate.all_flag()->value()) {
     master_proxy.RequestRegisterNode<DynamicSubscribingNode>(
-        node_info, std::make_unique<MultiTopicSubscriberDelegate>(settings));
+        node_info,
+        std::make_unique<MultiTopicSubscriberDelegate>(settings, fields));
   } else {
     master_proxy.RequestRegisterNode<DynamicSubscribingNode>(
         node_info, std::make_unique<OneTopicSubscriberDelegate>(
-                       delegate.topic_flag()->value(), settings));
+                       delegate.topic_flag()->value(), settings, fields));
   }
 }
 
@@ -42,13 +42,23 @@ TopicSubscribeFlag::TopicSubscribeFlag() {
                     .Build();
     queue_size_flag_ = std::make_unique<Flag<uint8_t>>(flag);
   }
+  {
+    StringFlag::Builder builder(MakeValueStore(&fields_));
+    auto flag = builder.SetShortName("-f")
+                    .SetLongName("--fields")
+                    .SetHelp(
+                        "Comma separated fields to parse, e.g. size,timestamp. "
+                        "Others are skipped without being parsed")
+                    .Build();
+    fields_flag_ = std::make_unique<StringFlag>(flag);
+  }
 }
 
 TopicSubscribeFlag::~TopicSubscribeFlag() = default;
 
 bool TopicSubscribeFlag::Parse(FlagParser& parser) {
   return PARSE_OPTIONAL_FLAG(parser, all_flag_, topic_flag_, period_flag_,
-                             queue_size_flag_);
+                             queue_size_flag_, fields_flag_);
 }
 
 bool TopicSubscribeFlag::Validate() const {
@@ -71,6 +81,7 @@ std::vector<NamedHelpType> TopicSubscribeFlag::CollectNamedHelps() const {
                          topic_flag_->help(),
                          period_flag_->help(),
                          queue_size_flag_->help(),
+                         fields_flag_->help(),
                      }),
   };
 }
@@ -24,6 +24,7 @@ class TopicSubscribeFlag : public FlagParser::Delegate {
   const Flag<uint8_t>* queue_size_flag() const {
     return queue_size_flag_.get();
   }
+  const StringFlag* fields_flag() const { return fields_flag_.get(); }
 
   bool Parse(FlagParser& parser) override;
 
@@ -38,10 +39,12 @@ class TopicSubscribeFlag : public FlagParser::Delegate {
   std::string topic_;
   uint32_t period_;
   uint8_t queue_size_;
+  std::string fields_;
   std::unique_ptr<BoolFlag> all_flag_;
   std::unique_ptr<StringFlag> topic_flag_;
   std::unique_ptr<Flag<uint32_t>> period_flag_;
   std::unique_ptr<Flag<uint8_t>> queue_size_flag_;
+  std::unique_ptr<StringFlag> fields_flag_;
 
   DISALLOW_COPY_AND_ASSIGN(TopicSubscribeFlag);
 };
@@ -0,0 +1,83 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/arena_message.h"
+
+#include <algorithm>
+
+namespace felicia {
+
+PooledArena::PooledArena(size_t initial_block_size)
+    : initial_block_size_(initial_block_size),
+      initial_block_(new char[initial_block_size]) {
+  google::protobuf::ArenaOptions options;
+  options.initial_block = initial_block_.get();
+  options.initial_block_size = initial_block_size_;
+  arena_ = std::make_unique<google::protobuf::Arena>(options);
+}
+
+PooledArena::~PooledArena() {
+  // |arena_| must be destroyed before |initial_block_|.
+  arena_.reset();
+}
+
+uint64_t PooledArena::Reset() { return arena_->Reset(); }
+
+constexpr size_t ArenaPool::kDefaultInitialBlockSize;
+constexpr size_t ArenaPool::kMaximumInitialBlockSize;
+constexpr size_t ArenaPool::kDefaultMaxPooledArenas;
+
+// static
+ArenaPool& ArenaPool::GetInstance() {
+  static base::NoDestructor<ArenaPool> arena_pool;
+  return *arena_pool;
+}
+
+ArenaPool::ArenaPool(size_t initial_block_size, size_t max_pooled_arenas)
+    : max_pooled_arenas_(max_pooled_arenas),
+      initial_block_size_(initial_block_size) {}
+
+ArenaPool::~ArenaPool() = default;
+
+std::unique_ptr<PooledArena> ArenaPool::Acquire() {
+  size_t initial_block_size;
+  {
+    base::AutoLock l(lock_);
+    if (!pooled_arenas_.empty()) {
+      std::unique_ptr<PooledArena> pooled_arena =
+          std::move(pooled_arenas_.back());
+      pooled_arenas_.pop_back();
+      return pooled_arena;
+    }
+    initial_block_size = initial_block_size_;
+  }
+  return std::make_unique<PooledArena>(initial_block_size);
+}
+
+void ArenaPool::Release(std::unique_ptr<PooledArena> pooled_arena) {
+  size_t space_allocated = static_cast<size_t>(pooled_arena->Reset());
+
+  base::AutoLock l(lock_);
+  if (space_allocated > initial_block_size_) {
+    // The message didn't fit in the first block. Arenas created from now on
+    // get a larger one, and the ones with a smaller block are thrown away.
+    initial_block_size_ = std::min(space_allocated, kMaximumInitialBlockSize);
+    size_t initial_block_size = initial_block_size_;
+    pooled_arenas_.erase(
+        std::remove_if(
+            pooled_arenas_.begin(), pooled_arenas_.end(),
+            [initial_block_size](const std::unique_ptr<PooledArena>& arena) {
+              return arena->initial_block_size() < initial_block_size;
+            }),
+        pooled_arenas_.end());
+  }
+
+  if (pooled_arena->initial_block_size() < initial_block_size_ ||
+      pooled_arenas_.size() >= max_pooled_arenas_) {
+    return;
+  }
+  pooled_arenas_.push_back(std::move(pooled_arena));
+}
+
+}  // namespace felicia
\ No newline at end of file
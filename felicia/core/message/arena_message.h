@@ -0,0 +1,147 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_MESSAGE_ARENA_MESSAGE_H_
+#define FELICIA_CORE_MESSAGE_ARENA_MESSAGE_H_
+
+#include <memory>
+#include <vector>
+
+#include "google/protobuf/arena.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/no_destructor.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
+
+#include "felicia/core/lib/base/export.h"
+
+namespace felicia {
+
+// google::protobuf::Arena with its own first block. Unlike the blocks the
+// arena allocates later, the first block survives |Reset()|, so a recycled
+// arena can parse the next message without asking the heap.
+class FEL_EXPORT PooledArena {
+ public:
+  explicit PooledArena(size_t initial_block_size);
+  ~PooledArena();
+
+  google::protobuf::Arena* arena() { return arena_.get(); }
+
+  size_t initial_block_size() const { return initial_block_size_; }
+
+  // Frees everything allocated on the arena and returns how many bytes were
+  // allocated.
+  uint64_t Reset();
+
+ private:
+  size_t initial_block_size_;
+  std::unique_ptr<char[]> initial_block_;
+  std::unique_ptr<google::protobuf::Arena> arena_;
+
+  DISALLOW_COPY_AND_ASSIGN(PooledArena);
+};
+
+// Thread safe free list of PooledArena. The size of the first block follows
+// the largest message seen so far, so that a message fits in a single block
+// once the pool is warmed up.
+class FEL_EXPORT ArenaPool {
+ public:
+  static constexpr size_t kDefaultInitialBlockSize = 4096;
+  static constexpr size_t kMaximumInitialBlockSize = 16 * 1024 * 1024;
+  static constexpr size_t kDefaultMaxPooledArenas = 128;
+
+  static ArenaPool& GetInstance();
+
+  explicit ArenaPool(size_t initial_block_size = kDefaultInitialBlockSize,
+                     size_t max_pooled_arenas = kDefaultMaxPooledArenas);
+  ~ArenaPool();
+
+  std::unique_ptr<PooledArena> Acquire();
+  void Release(std::unique_ptr<PooledArena> pooled_arena);
+
+ private:
+  const size_t max_pooled_arenas_;
+
+  base::Lock lock_;
+  size_t initial_block_size_ GUARDED_BY(lock_);
+  std::vector<std::unique_ptr<PooledArena>> pooled_arenas_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(ArenaPool);
+};
+
+// ArenaMessage<T> owns a protobuf message |T| allocated on an arena from
+// ArenaPool. Every sub message of |T| is allocated on the same arena, which
+// saves a lot of heap allocations for deeply nested messages. The arena is
+// given back to the pool when ArenaMessage<T> is destroyed.
+//
+// To receive messages on arenas, subscribe with it instead of |T|.
+//
+//   Subscriber<ArenaMessage<PointcloudMessage>> subscriber;
+//   ...
+//   void OnMessage(ArenaMessage<PointcloudMessage>&& message) {
+//     const PointcloudMessage& pointcloud = *message;
+//   }
+template <typename T>
+class ArenaMessage {
+ public:
+  ArenaMessage() = default;
+  ArenaMessage(ArenaMessage&& other) noexcept
+      : pooled_arena_(std::move(other.pooled_arena_)),
+        message_(other.message_) {
+    other.message_ = nullptr;
+  }
+  ArenaMessage& operator=(ArenaMessage&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      pooled_arena_ = std::move(other.pooled_arena_);
+      message_ = other.message_;
+      other.message_ = nullptr;
+    }
+    return *this;
+  }
+  ~ArenaMessage() { Reset(); }
+
+  static ArenaMessage New() {
+    ArenaMessage arena_message;
+    arena_message.pooled_arena_ = ArenaPool::GetInstance().Acquire();
+    arena_message.message_ = google::protobuf::Arena::CreateMessage<T>(
+        arena_message.pooled_arena_->arena());
+    return arena_message;
+  }
+
+  bool is_null() const { return !message_; }
+
+  T* get() const { return message_; }
+  T& operator*() const {
+    DCHECK(message_);
+    return *message_;
+  }
+  T* operator->() const {
+    DCHECK(message_);
+    return message_;
+  }
+
+  google::protobuf::Arena* arena() const {
+    return pooled_arena_ ? pooled_arena_->arena() : nullptr;
+  }
+
+  void Reset() {
+    message_ = nullptr;
+    if (pooled_arena_) {
+      ArenaPool::GetInstance().Release(std::move(pooled_arena_));
+    }
+  }
+
+ private:
+  std::unique_ptr<PooledArena> pooled_arena_;
+  // Allocated on |pooled_arena_|.
+  T* message_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(ArenaMessage);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_MESSAGE_ARENA_MESSAGE_H_
\ No newline at end of file
@@ -0,0 +1,102 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/arena_message.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+#include "benchmark/benchmark.h"
+
+#include "felicia/core/message/message_io.h"
+#include "felicia/core/protobuf/master.pb.h"
+
+namespace {
+
+std::atomic<int64_t> g_allocations{0};
+
+}  // namespace
+
+// Counts every heap allocation in this binary.
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t size) noexcept { free(p); }
+
+namespace felicia {
+
+namespace {
+
+// ListTopicsResponse is as deep as a MasterNotification, and its size grows
+// with |num_topics|.
+std::string MakeSerializedListTopicsResponse(int num_topics) {
+  ListTopicsResponse response;
+  for (int i = 0; i < num_topics; ++i) {
+    TopicInfo* topic_info = response.add_topic_infos();
+    topic_info->set_topic("topic" + std::to_string(i));
+    topic_info->set_type_name("felicia.drivers.CameraFrameMessage");
+    for (ChannelDef::Type type :
+         {ChannelDef::CHANNEL_TYPE_TCP, ChannelDef::CHANNEL_TYPE_UDP,
+          ChannelDef::CHANNEL_TYPE_WS}) {
+      ChannelDef* channel_def =
+          topic_info->mutable_topic_source()->add_channel_defs();
+      channel_def->set_type(type);
+      channel_def->mutable_ip_endpoint()->set_ip("192.168.0.1");
+      channel_def->mutable_ip_endpoint()->set_port(10000 + i);
+    }
+  }
+  std::string serialized;
+  response.SerializeToString(&serialized);
+  return serialized;
+}
+
+void SetCounters(benchmark::State& state, int64_t allocations) {
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocations"] =
+      benchmark::Counter(allocations, benchmark::Counter::kIsRate);
+  state.counters["allocations_per_message"] = benchmark::Counter(
+      allocations, benchmark::Counter::kAvgIterations);
+}
+
+}  // namespace
+
+// Same as MessageReceiver<ListTopicsResponse>, whose message is moved to the
+// subscriber after every parse.
+static void BM_ParseOnHeap(benchmark::State& state) {
+  std::string serialized = MakeSerializedListTopicsResponse(state.range(0));
+  int64_t allocations = g_allocations.load();
+  for (auto _ : state) {
+    ListTopicsResponse message;
+    MessageIO<ListTopicsResponse>::Deserialize(serialized.data(),
+                                               serialized.length(), &message);
+    benchmark::DoNotOptimize(message);
+  }
+  SetCounters(state, g_allocations.load() - allocations);
+}
+
+// Same as MessageReceiver<ArenaMessage<ListTopicsResponse>>.
+static void BM_ParseOnArena(benchmark::State& state) {
+  std::string serialized = MakeSerializedListTopicsResponse(state.range(0));
+  int64_t allocations = g_allocations.load();
+  for (auto _ : state) {
+    ArenaMessage<ListTopicsResponse> message;
+    MessageIO<ArenaMessage<ListTopicsResponse>>::Deserialize(
+        serialized.data(), serialized.length(), &message);
+    benchmark::DoNotOptimize(message);
+  }
+  SetCounters(state, g_allocations.load() - allocations);
+}
+
+BENCHMARK(BM_ParseOnHeap)->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK(BM_ParseOnArena)->Arg(1)->Arg(16)->Arg(256);
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,40 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_MESSAGE_ARENA_MESSAGE_IO_H_
+#define FELICIA_CORE_MESSAGE_ARENA_MESSAGE_IO_H_
+
+#include "felicia/core/message/arena_message.h"
+
+namespace felicia {
+
+template <typename T>
+class MessageIO<ArenaMessage<T>> {
+ public:
+  static MessageIOError Serialize(const ArenaMessage<T>* arena_msg,
+                                  std::string* text) {
+    if (arena_msg->is_null()) return MessageIOError::ERR_FAILED_TO_SERIALIZE;
+    return MessageIO<T>::Serialize(arena_msg->get(), text);
+  }
+
+  // Every message is parsed on a fresh arena from ArenaPool. Parsing again
+  // into the same message would clear it, which frees nothing on the arena,
+  // so a reused |arena_msg| gives its arena back to the pool first.
+  static MessageIOError Deserialize(const char* start, size_t size,
+                                    ArenaMessage<T>* arena_msg) {
+    arena_msg->Reset();
+    *arena_msg = ArenaMessage<T>::New();
+    return MessageIO<T>::Deserialize(start, size, arena_msg->get());
+  }
+
+  static std::string TypeName() { return MessageIO<T>::TypeName(); }
+
+  static std::string Definition() { return MessageIO<T>::Definition(); }
+
+  static std::string MD5Sum() { return MessageIO<T>::MD5Sum(); }
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_MESSAGE_ARENA_MESSAGE_IO_H_
\ No newline at end of file
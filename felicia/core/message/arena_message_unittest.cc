@@ -0,0 +1,149 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/arena_message.h"
+
+#include "gtest/gtest.h"
+
+#include "felicia/core/message/message_io.h"
+#include "felicia/core/protobuf/master_data.pb.h"
+
+namespace felicia {
+
+namespace {
+
+TopicInfo MakeTopicInfo(int num_channel_defs) {
+  TopicInfo topic_info;
+  topic_info.set_topic("topic");
+  topic_info.set_type_name("felicia.drivers.CameraFrameMessage");
+  for (int i = 0; i < num_channel_defs; ++i) {
+    ChannelDef* channel_def =
+        topic_info.mutable_topic_source()->add_channel_defs();
+    channel_def->set_type(ChannelDef::CHANNEL_TYPE_TCP);
+    channel_def->mutable_ip_endpoint()->set_ip("127.0.0.1");
+    channel_def->mutable_ip_endpoint()->set_port(8000 + i);
+  }
+  return topic_info;
+}
+
+MessageIOError Deserialize(const std::string& serialized,
+                           ArenaMessage<TopicInfo>* message) {
+  return MessageIO<ArenaMessage<TopicInfo>>::Deserialize(
+      serialized.data(), serialized.length(), message);
+}
+
+}  // namespace
+
+TEST(ArenaPoolTest, RecyclesArena) {
+  ArenaPool pool(1024, 1);
+  std::unique_ptr<PooledArena> pooled_arena = pool.Acquire();
+  PooledArena* raw = pooled_arena.get();
+  EXPECT_EQ(1024u, raw->initial_block_size());
+
+  pool.Release(std::move(pooled_arena));
+  EXPECT_EQ(raw, pool.Acquire().get());
+}
+
+TEST(ArenaPoolTest, KeepsAtMostMaxPooledArenas) {
+  ArenaPool pool(1024, 1);
+  std::unique_ptr<PooledArena> pooled_arena = pool.Acquire();
+  std::unique_ptr<PooledArena> pooled_arena2 = pool.Acquire();
+  PooledArena* raw = pooled_arena.get();
+
+  pool.Release(std::move(pooled_arena));
+  // The pool is full, so it's thrown away.
+  pool.Release(std::move(pooled_arena2));
+  EXPECT_EQ(raw, pool.Acquire().get());
+}
+
+TEST(ArenaPoolTest, GrowsInitialBlock) {
+  ArenaPool pool(256, 4);
+  std::unique_ptr<PooledArena> pooled_arena = pool.Acquire();
+  google::protobuf::Arena::CreateArray<char>(pooled_arena->arena(), 4096);
+  pool.Release(std::move(pooled_arena));
+
+  // The arena with a smaller block is thrown away, and a new one gets a
+  // block large enough for the last message.
+  EXPECT_GE(pool.Acquire()->initial_block_size(), 4096u);
+}
+
+TEST(ArenaMessageTest, Parse) {
+  TopicInfo topic_info = MakeTopicInfo(3);
+  std::string serialized;
+  ASSERT_TRUE(topic_info.SerializeToString(&serialized));
+
+  ArenaMessage<TopicInfo> message;
+  EXPECT_TRUE(message.is_null());
+  EXPECT_EQ(nullptr, message.arena());
+  ASSERT_EQ(MessageIOError::OK, Deserialize(serialized, &message));
+  ASSERT_FALSE(message.is_null());
+  EXPECT_EQ(message.arena(), message->GetArena());
+  EXPECT_EQ(message.arena(),
+            message->topic_source().channel_defs(0).GetArena());
+  EXPECT_EQ(serialized, message->SerializeAsString());
+
+  std::string text;
+  ASSERT_EQ(MessageIOError::OK,
+            MessageIO<ArenaMessage<TopicInfo>>::Serialize(&message, &text));
+  EXPECT_EQ(serialized, text);
+}
+
+TEST(ArenaMessageTest, ReparseDoesNotGrowArena) {
+  std::string serialized;
+  ASSERT_TRUE(MakeTopicInfo(8).SerializeToString(&serialized));
+
+  ArenaMessage<TopicInfo> message;
+  ASSERT_EQ(MessageIOError::OK, Deserialize(serialized, &message));
+  uint64_t space_used = message.arena()->SpaceUsed();
+
+  // This is what MessageReceiver<T> does if the message isn't moved out.
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(MessageIOError::OK, Deserialize(serialized, &message));
+    EXPECT_EQ(space_used, message.arena()->SpaceUsed());
+    EXPECT_EQ(serialized, message->SerializeAsString());
+  }
+}
+
+TEST(ArenaMessageTest, MoveOut) {
+  std::string serialized;
+  ASSERT_TRUE(MakeTopicInfo(2).SerializeToString(&serialized));
+
+  ArenaMessage<TopicInfo> message;
+  ASSERT_EQ(MessageIOError::OK, Deserialize(serialized, &message));
+  google::protobuf::Arena* arena = message.arena();
+  TopicInfo* raw = message.get();
+
+  ArenaMessage<TopicInfo> moved = std::move(message);
+  EXPECT_TRUE(message.is_null());
+  EXPECT_EQ(nullptr, message.arena());
+  EXPECT_EQ(arena, moved.arena());
+  EXPECT_EQ(raw, moved.get());
+  EXPECT_EQ(serialized, moved->SerializeAsString());
+
+  // The moved-from message parses the next one on another arena.
+  ASSERT_EQ(MessageIOError::OK, Deserialize(serialized, &message));
+  EXPECT_NE(arena, message.arena());
+  EXPECT_EQ(serialized, message->SerializeAsString());
+}
+
+TEST(ArenaMessageTest, ReturnsArenaToPool) {
+  ArenaMessage<TopicInfo> message = ArenaMessage<TopicInfo>::New();
+  google::protobuf::Arena* arena = message.arena();
+  message->set_topic("topic");
+
+  message.Reset();
+  EXPECT_TRUE(message.is_null());
+  EXPECT_EQ(nullptr, message.arena());
+
+  {
+    ArenaMessage<TopicInfo> message2 = ArenaMessage<TopicInfo>::New();
+    EXPECT_EQ(arena, message2.arena());
+    EXPECT_TRUE(message2->topic().empty());
+  }
+
+  // Destroying it gives the arena back as well.
+  EXPECT_EQ(arena, ArenaMessage<TopicInfo>::New().arena());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -14,32 +14,55 @@ namespace felicia {
 DynamicProtobufMessage::DynamicProtobufMessage() = default;
 
 DynamicProtobufMessage::DynamicProtobufMessage(
-    const DynamicProtobufMessage& other) {
+    const DynamicProtobufMessage& other)
+    : lazy_(other.lazy_),
+      field_mask_filter_(other.field_mask_filter_),
+      serialized_(other.serialized_),
+      has_serialized_(other.has_serialized_) {
+  // |other| might be being parsed by another reader.
+  base::AutoLock l(other.parse_lock_);
   if (other.message_) {
     message_ = other.message_->New();
     message_->CopyFrom(*other.message_);
   }
+  parsed_ = other.parsed_.load();
 }
 
 DynamicProtobufMessage& DynamicProtobufMessage::operator=(
     const DynamicProtobufMessage& other) {
+  if (this == &other) return *this;
   delete message_;
   message_ = nullptr;
 
+  base::AutoLock l(other.parse_lock_);
   if (other.message_) {
     message_ = other.message_->New();
     message_->CopyFrom(*other.message_);
   }
+  lazy_ = other.lazy_;
+  field_mask_filter_ = other.field_mask_filter_;
+  serialized_ = other.serialized_;
+  has_serialized_ = other.has_serialized_;
+  parsed_ = other.parsed_.load();
 
   return *this;
 }
 
+// |other| keeps the type and the lazy options, because MessageReceiver<T>
+// parses the next message into it.
 DynamicProtobufMessage::DynamicProtobufMessage(
-    DynamicProtobufMessage&& other) noexcept {
+    DynamicProtobufMessage&& other) noexcept
+    : lazy_(other.lazy_),
+      field_mask_filter_(other.field_mask_filter_),
+      serialized_(std::move(other.serialized_)),
+      has_serialized_(other.has_serialized_),
+      parsed_(other.parsed_.load()) {
   if (other.message_) {
     message_ = other.message_;
     other.message_ = other.message_->New();
   }
+  other.has_serialized_ = false;
+  other.parsed_ = true;
 }
 
 DynamicProtobufMessage& DynamicProtobufMessage::operator=(
@@ -51,6 +74,13 @@ DynamicProtobufMessage& DynamicProtobufMessage::operator=(
     message_ = other.message_;
     other.message_ = other.message_->New();
   }
+  lazy_ = other.lazy_;
+  field_mask_filter_ = other.field_mask_filter_;
+  serialized_ = std::move(other.serialized_);
+  has_serialized_ = other.has_serialized_;
+  parsed_ = other.parsed_.load();
+  other.has_serialized_ = false;
+  other.parsed_ = true;
 
   return *this;
 }
@@ -58,10 +88,15 @@ DynamicProtobufMessage& DynamicProtobufMessage::operator=(
 DynamicProtobufMessage::~DynamicProtobufMessage() { delete message_; }
 
 google::protobuf::Message* DynamicProtobufMessage::message() {
+  EnsureParsed();
+  // It might be modified from now on.
+  serialized_ = SerializedMessage();
+  has_serialized_ = false;
   return message_;
 }
 
 const google::protobuf::Message* DynamicProtobufMessage::message() const {
+  EnsureParsed();
   return message_;
 }
 
@@ -69,6 +104,26 @@ void DynamicProtobufMessage::Reset(google::protobuf::Message* message) {
   DCHECK(message);
   delete message_;
   message_ = message;
+  field_mask_filter_.reset();
+  serialized_ = SerializedMessage();
+  has_serialized_ = false;
+  parsed_ = true;
+}
+
+Status DynamicProtobufMessage::SetLazy(
+    const std::vector<std::string>& field_mask) {
+  if (!message_) return errors::NotFound("message is null.");
+
+  if (field_mask.empty()) {
+    field_mask_filter_.reset();
+  } else {
+    auto field_mask_filter = std::make_shared<protobuf::FieldMaskFilter>();
+    Status s = field_mask_filter->Init(message_->GetDescriptor(), field_mask);
+    if (!s.ok()) return s;
+    field_mask_filter_ = std::move(field_mask_filter);
+  }
+  lazy_ = true;
+  return Status::OK();
 }
 
 std::string DynamicProtobufMessage::GetTypeName() const {
@@ -78,16 +133,19 @@ std::string DynamicProtobufMessage::GetTypeName() const {
 
 std::string DynamicProtobufMessage::ToString() const {
   if (!message_) return base::EmptyString();
+  EnsureParsed();
   return protobuf::ProtobufMessageToString(*message_);
 }
 
 std::string DynamicProtobufMessage::DebugString() const {
   if (!message_) return base::EmptyString();
+  EnsureParsed();
   return message_->DebugString();
 }
 
 Status DynamicProtobufMessage::MessageToJsonString(std::string* text) const {
   if (!message_) return errors::NotFound("message is null.");
+  EnsureParsed();
   google::protobuf::util::Status status =
       google::protobuf::util::MessageToJsonString(*message_, text);
   return Status(static_cast<felicia::error::Code>(status.error_code()),
@@ -96,12 +154,50 @@ Status DynamicProtobufMessage::MessageToJsonString(std::string* text) const {
 
 bool DynamicProtobufMessage::SerializeToString(std::string* text) const {
   if (!message_) return false;
+  if (has_serialized_) return serialized_.SerializeToString(text);
   return message_->SerializeToString(text);
 }
 
 bool DynamicProtobufMessage::ParseFromArray(const char* data, size_t size) {
   if (!message_) return false;
+  if (lazy_) {
+    serialized_.set_serialized(std::string(data, size));
+    has_serialized_ = true;
+    parsed_ = false;
+    return true;
+  }
   return message_->ParseFromArray(data, size);
 }
 
+bool DynamicProtobufMessage::ParseFromView(
+    scoped_refptr<base::RefCountedMemory> buffer) {
+  if (!message_) return false;
+  if (lazy_) {
+    serialized_.set_serialized_view(std::move(buffer));
+    has_serialized_ = true;
+    parsed_ = false;
+    return true;
+  }
+  return message_->ParseFromArray(buffer->front(), buffer->size());
+}
+
+void DynamicProtobufMessage::EnsureParsed() const {
+  if (parsed_.load(std::memory_order_acquire)) return;
+  base::AutoLock l(parse_lock_);
+  if (parsed_.load(std::memory_order_relaxed)) return;
+
+  base::StringPiece serialized = serialized_.serialized();
+  bool parsed;
+  if (field_mask_filter_) {
+    std::string filtered;
+    parsed = field_mask_filter_->Filter(serialized.data(), serialized.size(),
+                                        &filtered) &&
+             message_->ParseFromString(filtered);
+  } else {
+    parsed = message_->ParseFromArray(serialized.data(), serialized.size());
+  }
+  LOG_IF(ERROR, !parsed) << "Failed to parse " << message_->GetTypeName();
+  parsed_.store(true, std::memory_order_release);
+}
+
 }  // namespace felicia
\ No newline at end of file
@@ -5,14 +5,34 @@
 #ifndef FELICIA_CORE_MESSAGE_DYNAMIC_PROTOBUF_MESSAGE_H_
 #define FELICIA_CORE_MESSAGE_DYNAMIC_PROTOBUF_MESSAGE_H_
 
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "google/protobuf/message.h"
 #include "google/protobuf/util/json_util.h"
+#include "third_party/chromium/base/synchronization/lock.h"
 
 #include "felicia/core/lib/base/export.h"
 #include "felicia/core/lib/error/status.h"
+#include "felicia/core/message/protobuf_util.h"
+#include "felicia/core/message/serialized_message.h"
 
 namespace felicia {
 
+// If it is lazy, |ParseFromArray()| only keeps the wire bytes and the message
+// is parsed on the first access. When it is given a field mask, only the
+// fields in the mask are parsed, the others are skipped on the wire. Until
+// the message is accessed as mutable, |SerializeToString()| returns the wire
+// bytes as they are, so forwarding a message doesn't parse it at all.
+//
+// |ParseFromArray()| has to copy the wire bytes to keep them, while
+// |ParseFromView()| only takes a reference to the ref-counted buffer, e.g,
+// the receive buffer of a channel.
+//
+// The const accessors may be called from many threads at once, e.g, by the
+// callbacks of the subscribers sharing a message; the first one parses it.
 class FEL_EXPORT DynamicProtobufMessage {
  public:
   DynamicProtobufMessage();
@@ -27,6 +47,12 @@ class FEL_EXPORT DynamicProtobufMessage {
 
   void Reset(google::protobuf::Message* message);
 
+  // |message()| should be set before calling this. Returns an error if any of
+  // |field_mask| is not a field of the message.
+  Status SetLazy(const std::vector<std::string>& field_mask =
+                     std::vector<std::string>());
+  bool is_lazy() const { return lazy_; }
+
   std::string ToString() const;
   std::string DebugString() const;
 
@@ -35,9 +61,26 @@ class FEL_EXPORT DynamicProtobufMessage {
   Status MessageToJsonString(std::string* text) const;
   bool SerializeToString(std::string* text) const;
   bool ParseFromArray(const char* data, size_t size);
+  // Same with above, but if it is lazy, it refers to |buffer| without
+  // copying. |buffer| must not be modified while this refers to it.
+  bool ParseFromView(scoped_refptr<base::RefCountedMemory> buffer);
 
  private:
+  void EnsureParsed() const;
+
   google::protobuf::Message* message_ = nullptr;
+
+  bool lazy_ = false;
+  // Shared among the messages received by the same subscriber.
+  std::shared_ptr<const protobuf::FieldMaskFilter> field_mask_filter_;
+  // The wire bytes, which are valid if |has_serialized_| is true.
+  SerializedMessage serialized_;
+  bool has_serialized_ = false;
+  // False if |message_| is yet to be parsed from |serialized_|. It's only set
+  // to true by |EnsureParsed()| under |parse_lock_|, so that concurrent const
+  // readers don't parse |message_| at the same time.
+  mutable std::atomic<bool> parsed_{true};
+  mutable base::Lock parse_lock_;
 };
 
 }  // namespace felicia
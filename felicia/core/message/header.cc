@@ -6,44 +6,126 @@
 
 #include <string.h>
 
+#include "felicia/core/lib/hash/crc32c.h"
+
 namespace felicia {
 
+namespace {
+
+// Layout of version 2, which starts with the size like version 1.
+//   int32_t size
+//   uint32_t flags
+//   uint64_t sequence_number
+//   int64_t timestamp in microseconds
+//   uint32_t checksum
+constexpr int kHeaderV1Size = sizeof(int);
+constexpr int kHeaderV2Size = sizeof(int) + sizeof(uint32_t) +
+                              sizeof(uint64_t) + sizeof(int64_t) +
+                              sizeof(uint32_t);
+
+// Bits of the flags in version 2.
+constexpr uint32_t kHasChecksum = 1 << 0;
+constexpr uint32_t kKnownFlags = kHasChecksum;
+
+template <typename T>
+char* Write(char* buffer, T value) {
+  memcpy(buffer, &value, sizeof(T));
+  return buffer + sizeof(T);
+}
+
+template <typename T>
+const char* Read(const char* buffer, T* value) {
+  memcpy(value, buffer, sizeof(T));
+  return buffer + sizeof(T);
+}
+
+}  // namespace
+
 Header::Header() = default;
 
+Header::Header(TopicInfo::HeaderVersion version) : version_(version) {}
+
 Header::~Header() = default;
 
 MessageIOError Header::AttachHeader(const std::string& content,
                                     std::string* text) {
-  size_ = content.length();
-  text->resize(header_size() + size_);
-  char* buffer = const_cast<char*>(text->c_str());
-  memcpy(buffer, &size_, sizeof(int));
-  buffer += sizeof(int);
-  memcpy(buffer, content.c_str(), size_);
-  return MessageIOError::OK;
+  text->resize(header_size() + content.length());
+  return AttachHeaderInternally(content, const_cast<char*>(text->c_str()));
 }
 
-int Header::header_size() const { return sizeof(int); }
+int Header::header_size() const {
+  return version_ == TopicInfo::HEADER_VERSION_2 ? kHeaderV2Size
+                                                 : kHeaderV1Size;
+}
 
 MessageIOError Header::ParseHeader(const char* buffer, int* mesasge_offset,
                                    int* message_size) {
-  size_ = *reinterpret_cast<const int*>(buffer);
+  buffer = Read(buffer, &size_);
+  if (version_ == TopicInfo::HEADER_VERSION_2) {
+    uint32_t flags;
+    int64_t timestamp;
+    buffer = Read(buffer, &flags);
+    buffer = Read(buffer, &sequence_number_);
+    buffer = Read(buffer, &timestamp);
+    buffer = Read(buffer, &checksum_);
+    if (flags & ~kKnownFlags) return MessageIOError::ERR_CORRUPTED_HEADER;
+    use_checksum_ = flags & kHasChecksum;
+    timestamp_ =
+        base::TimeTicks() + base::TimeDelta::FromMicroseconds(timestamp);
+  }
   *message_size = size_;
   *mesasge_offset = header_size();
   return MessageIOError::OK;
 }
 
-MessageIOError Header::AttachHeaderInternally(const std::string& content,
+MessageIOError Header::AttachHeaderInternally(base::StringPiece content,
                                               char* buffer) {
   size_ = content.length();
-  memcpy(buffer, &size_, sizeof(int));
-  buffer += sizeof(int);
-  memcpy(buffer, content.c_str(), size_);
+  buffer = Write(buffer, size_);
+  if (version_ == TopicInfo::HEADER_VERSION_2) {
+    checksum_ = use_checksum_ ? Crc32c(content.data(), content.length()) : 0;
+    buffer = Write(buffer, use_checksum_ ? kHasChecksum : 0u);
+    buffer = Write(buffer, sequence_number_);
+    buffer = Write(buffer, (timestamp_ - base::TimeTicks()).InMicroseconds());
+    buffer = Write(buffer, checksum_);
+  }
+  memcpy(buffer, content.data(), size_);
   return MessageIOError::OK;
 }
 
+bool Header::VerifyChecksum(base::StringPiece content) const {
+  if (version_ != TopicInfo::HEADER_VERSION_2 || !use_checksum_) return true;
+  return Crc32c(content.data(), content.length()) == checksum_;
+}
+
+TopicInfo::HeaderVersion Header::version() const { return version_; }
+
+void Header::set_version(TopicInfo::HeaderVersion version) {
+  version_ = version;
+}
+
 int Header::size() const { return size_; }
 
 void Header::set_size(int size) { size_ = size; }
 
+uint64_t Header::sequence_number() const { return sequence_number_; }
+
+void Header::set_sequence_number(uint64_t sequence_number) {
+  sequence_number_ = sequence_number;
+}
+
+base::TimeTicks Header::timestamp() const { return timestamp_; }
+
+void Header::set_timestamp(base::TimeTicks timestamp) {
+  timestamp_ = timestamp;
+}
+
+bool Header::use_checksum() const { return use_checksum_; }
+
+void Header::set_use_checksum(bool use_checksum) {
+  use_checksum_ = use_checksum;
+}
+
+uint32_t Header::checksum() const { return checksum_; }
+
 }  // namespace felicia
\ No newline at end of file
@@ -8,14 +8,25 @@
 #include <stdint.h>
 #include <string>
 
+#include "third_party/chromium/base/strings/string_piece.h"
+#include "third_party/chromium/base/time/time.h"
+
 #include "felicia/core/lib/base/export.h"
 #include "felicia/core/message/message_io.h"
+#include "felicia/core/protobuf/master_data.pb.h"
 
 namespace felicia {
 
+// Header precedes every message on a channel without its own framing.
+//
+// Version 1 only carries the size of the message. Version 2 appends a
+// sequence number, a send timestamp and an optional CRC-32C of the message,
+// so that a subscriber can count the messages it missed and measure the
+// latency. Publishers announce their version through TopicInfo.
 class FEL_EXPORT Header {
  public:
   Header();
+  explicit Header(TopicInfo::HeaderVersion version);
   ~Header();
 
   // Needed by MessageSender<T>
@@ -25,14 +36,41 @@ class FEL_EXPORT Header {
   MessageIOError ParseHeader(const char* buffer, int* mesasge_offset,
                              int* message_size);
 
-  MessageIOError AttachHeaderInternally(const std::string& content,
+  MessageIOError AttachHeaderInternally(base::StringPiece content,
                                         char* buffer);
 
+  // Returns true if the header has no checksum, or |content| matches it.
+  bool VerifyChecksum(base::StringPiece content) const;
+
+  TopicInfo::HeaderVersion version() const;
+  void set_version(TopicInfo::HeaderVersion version);
+
   int size() const;
   void set_size(int size);
 
+  // Below are only for version 2.
+  uint64_t sequence_number() const;
+  void set_sequence_number(uint64_t sequence_number);
+
+  // When the message is sent, on the monotonic clock of the publisher. It
+  // can be compared to base::TimeTicks::Now() only on the same host.
+  base::TimeTicks timestamp() const;
+  void set_timestamp(base::TimeTicks timestamp);
+
+  // If it's set, AttachHeaderInternally() computes the checksum of the
+  // message.
+  bool use_checksum() const;
+  void set_use_checksum(bool use_checksum);
+
+  uint32_t checksum() const;
+
  protected:
+  TopicInfo::HeaderVersion version_ = TopicInfo::HEADER_VERSION_1;
   int size_ = 0;
+  uint64_t sequence_number_ = 0;
+  base::TimeTicks timestamp_;
+  bool use_checksum_ = false;
+  uint32_t checksum_ = 0;
 };
 
 }  // namespace felicia
@@ -0,0 +1,66 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/header.h"
+
+#include "gtest/gtest.h"
+
+namespace felicia {
+
+TEST(HeaderTest, Version1) {
+  std::string content("content");
+  std::string text;
+  Header header;
+  ASSERT_EQ(MessageIOError::OK, header.AttachHeader(content, &text));
+  EXPECT_EQ(sizeof(int) + content.length(), text.length());
+
+  Header parsed;
+  int message_offset;
+  int message_size;
+  ASSERT_EQ(MessageIOError::OK,
+            parsed.ParseHeader(text.data(), &message_offset, &message_size));
+  EXPECT_EQ(content, text.substr(message_offset, message_size));
+  EXPECT_TRUE(parsed.VerifyChecksum(base::StringPiece()));
+}
+
+TEST(HeaderTest, Version2) {
+  std::string content("content");
+  std::string text;
+  base::TimeTicks timestamp = base::TimeTicks::Now();
+  Header header(TopicInfo::HEADER_VERSION_2);
+  header.set_sequence_number(10);
+  header.set_timestamp(timestamp);
+  header.set_use_checksum(true);
+  ASSERT_EQ(MessageIOError::OK, header.AttachHeader(content, &text));
+  EXPECT_EQ(header.header_size() + content.length(), text.length());
+
+  Header parsed(TopicInfo::HEADER_VERSION_2);
+  int message_offset;
+  int message_size;
+  ASSERT_EQ(MessageIOError::OK,
+            parsed.ParseHeader(text.data(), &message_offset, &message_size));
+  base::StringPiece message(text.data() + message_offset, message_size);
+  EXPECT_EQ(content, message);
+  EXPECT_EQ(10u, parsed.sequence_number());
+  EXPECT_EQ((timestamp - base::TimeTicks()).InMicroseconds(),
+            (parsed.timestamp() - base::TimeTicks()).InMicroseconds());
+  EXPECT_TRUE(parsed.use_checksum());
+  EXPECT_TRUE(parsed.VerifyChecksum(message));
+  EXPECT_FALSE(parsed.VerifyChecksum("contents"));
+
+  // Without checksum
+  header.set_use_checksum(false);
+  ASSERT_EQ(MessageIOError::OK, header.AttachHeader(content, &text));
+  ASSERT_EQ(MessageIOError::OK,
+            parsed.ParseHeader(text.data(), &message_offset, &message_size));
+  EXPECT_FALSE(parsed.use_checksum());
+  EXPECT_TRUE(parsed.VerifyChecksum("contents"));
+
+  // Unknown flags
+  text[sizeof(int)] = '\xff';
+  EXPECT_EQ(MessageIOError::ERR_CORRUPTED_HEADER,
+            parsed.ParseHeader(text.data(), &message_offset, &message_size));
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,175 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_MESSAGE_INTERPOLATING_SYNCHRONIZER_H_
+#define FELICIA_CORE_MESSAGE_INTERPOLATING_SYNCHRONIZER_H_
+
+#include <algorithm>
+#include <utility>
+
+#include "third_party/chromium/base/callback.h"
+#include "third_party/chromium/base/containers/circular_deque.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/sequence_checker.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/message/message_timestamp.h"
+
+namespace felicia {
+
+// InterpolatingSynchronizer pairs every anchor message, e.g. a camera frame,
+// with a message of a high rate stream, e.g. 1kHz imu, at the very timestamp
+// of the anchor. The stream is kept in a ring buffer sorted by timestamp, and
+// the two stream messages around an anchor are found by a binary search and
+// given to the interpolate callback. Once an anchor is notified, the stream
+// messages before it are dropped, so that only the messages between two
+// anchors are held, unlike TimeSyncrhonizerMF which needs a queue deep enough
+// to hold every stream message until the anchor arrives.
+//
+// Both types should have |timestamp()|, see MessageTimestamp(). Each of them
+// should arrive in timestamp order.
+template <typename AnchorTy, typename StreamTy>
+class InterpolatingSynchronizer {
+ public:
+  // Returns a stream message at |timestamp|, which is in between the
+  // timestamps of |before| and |after|.
+  using InterpolateCallback = base::RepeatingCallback<StreamTy(
+      const StreamTy& before, const StreamTy& after,
+      base::TimeDelta timestamp)>;
+  using NotifyCallback = base::RepeatingCallback<void(AnchorTy&&, StreamTy&&)>;
+
+  static constexpr size_t kDefaultMaxStreamSize = 1024;
+  static constexpr size_t kDefaultMaxAnchorSize = 8;
+
+  explicit InterpolatingSynchronizer(
+      size_t max_stream_size = kDefaultMaxStreamSize,
+      size_t max_anchor_size = kDefaultMaxAnchorSize)
+      : max_stream_size_(max_stream_size), max_anchor_size_(max_anchor_size) {
+    DCHECK_GE(max_stream_size_, 2u);
+    DCHECK_GE(max_anchor_size_, 1u);
+    DETACH_FROM_SEQUENCE(sequence_checker_);
+  }
+
+  ~InterpolatingSynchronizer() {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  }
+
+  // If it's not set, the stream message nearer to the anchor is notified.
+  void set_interpolate_callback(InterpolateCallback interpolate_callback) {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    interpolate_callback_ = interpolate_callback;
+  }
+
+  void set_notify_callback(NotifyCallback notify_callback) {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    notify_callback_ = notify_callback;
+  }
+
+  // If there are already |max_anchor_size| anchors waiting for the stream,
+  // the oldest one is dropped.
+  void OnAnchorMessage(AnchorTy&& message) {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    if (!anchors_.empty() &&
+        MessageTimestamp(message) < MessageTimestamp(anchors_.back())) {
+      DLOG(WARNING) << "Drop an anchor message which is out of order.";
+      return;
+    }
+    if (anchors_.size() == max_anchor_size_) anchors_.pop_front();
+    anchors_.push_back(std::move(message));
+    Synchronize();
+  }
+
+  // If the ring buffer is full, the oldest stream message is dropped.
+  void OnStreamMessage(StreamTy&& message) {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    if (!stream_.empty() &&
+        MessageTimestamp(message) < MessageTimestamp(stream_.back())) {
+      DLOG(WARNING) << "Drop a stream message which is out of order.";
+      return;
+    }
+    if (stream_.size() == max_stream_size_) stream_.pop_front();
+    stream_.push_back(std::move(message));
+    Synchronize();
+  }
+
+  size_t anchor_size() const {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    return anchors_.size();
+  }
+
+  size_t stream_size() const {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    return stream_.size();
+  }
+
+ private:
+  void Synchronize() {
+    while (!anchors_.empty() && !stream_.empty()) {
+      base::TimeDelta timestamp = MessageTimestamp(anchors_.front());
+      // Wait until the stream passes by the anchor.
+      if (MessageTimestamp(stream_.back()) < timestamp) return;
+
+      AnchorTy anchor = std::move(anchors_.front());
+      anchors_.pop_front();
+
+      // The first stream message which is not earlier than the anchor.
+      auto after = std::lower_bound(
+          stream_.begin(), stream_.end(), timestamp,
+          [](const StreamTy& message, base::TimeDelta timestamp) {
+            return MessageTimestamp(message) < timestamp;
+          });
+      if (MessageTimestamp(*after) == timestamp) {
+        if (!notify_callback_.is_null())
+          notify_callback_.Run(std::move(anchor), StreamTy(*after));
+      } else if (after == stream_.begin()) {
+        DLOG(WARNING) << "Drop an anchor message which is older than the "
+                         "stream messages.";
+        continue;
+      } else {
+        auto before = after - 1;
+        if (!notify_callback_.is_null())
+          notify_callback_.Run(std::move(anchor),
+                               Interpolate(*before, *after, timestamp));
+      }
+
+      // The next anchors are not earlier than this one, so they don't need
+      // the stream messages before |after - 1|.
+      if (after != stream_.begin()) stream_.erase(stream_.begin(), after - 1);
+    }
+  }
+
+  StreamTy Interpolate(const StreamTy& before, const StreamTy& after,
+                       base::TimeDelta timestamp) const {
+    if (!interpolate_callback_.is_null())
+      return interpolate_callback_.Run(before, after, timestamp);
+    if (timestamp - MessageTimestamp(before) <=
+        MessageTimestamp(after) - timestamp)
+      return before;
+    return after;
+  }
+
+  const size_t max_stream_size_;
+  const size_t max_anchor_size_;
+  base::circular_deque<AnchorTy> anchors_;
+  base::circular_deque<StreamTy> stream_;
+
+  InterpolateCallback interpolate_callback_;
+  NotifyCallback notify_callback_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  DISALLOW_COPY_AND_ASSIGN(InterpolatingSynchronizer);
+};
+
+template <typename AnchorTy, typename StreamTy>
+constexpr size_t
+    InterpolatingSynchronizer<AnchorTy, StreamTy>::kDefaultMaxStreamSize;
+template <typename AnchorTy, typename StreamTy>
+constexpr size_t
+    InterpolatingSynchronizer<AnchorTy, StreamTy>::kDefaultMaxAnchorSize;
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_MESSAGE_INTERPOLATING_SYNCHRONIZER_H_
\ No newline at end of file
@@ -0,0 +1,128 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/interpolating_synchronizer.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "third_party/chromium/base/bind.h"
+
+#include "felicia/core/lib/base/template_util.h"
+#include "felicia/core/message/test/a_message.h"
+
+namespace felicia {
+
+namespace {
+
+typedef AMessage<double> DoubleMessage;
+
+DoubleMessage Lerp(const DoubleMessage& before, const DoubleMessage& after,
+                   base::TimeDelta timestamp) {
+  double t = (timestamp.InMicrosecondsF() - before.timestamp()) /
+             (after.timestamp() - before.timestamp());
+  return DoubleMessage(before.data() + (after.data() - before.data()) * t,
+                       timestamp.InMicrosecondsF());
+}
+
+class NotifyCallbackChecker {
+ public:
+  void OnNotify(IntMessage&& anchor, DoubleMessage&& stream) {
+    anchors.push_back(std::move(anchor));
+    streams.push_back(std::move(stream));
+  }
+
+  std::vector<IntMessage> anchors;
+  std::vector<DoubleMessage> streams;
+};
+
+}  // namespace
+
+TEST(InterpolatingSynchronizerTest, Interpolate) {
+  NotifyCallbackChecker checker;
+  InterpolatingSynchronizer<IntMessage, DoubleMessage> synchronizer;
+  synchronizer.set_interpolate_callback(base::BindRepeating(&Lerp));
+  synchronizer.set_notify_callback(base::BindRepeating(
+      &NotifyCallbackChecker::OnNotify, base::Unretained(&checker)));
+
+  // Stream at 1kHz, whose data is the same as its timestamp.
+  for (int i = 0; i < 40; ++i) {
+    synchronizer.OnStreamMessage(DoubleMessage(i * 1000, i * 1000));
+  }
+  EXPECT_EQ(40u, synchronizer.stream_size());
+
+  synchronizer.OnAnchorMessage(IntMessage(0, 10500));
+  ASSERT_EQ(1u, checker.streams.size());
+  EXPECT_EQ(0, checker.anchors[0].data());
+  EXPECT_DOUBLE_EQ(10500, checker.streams[0].data());
+  // Only the messages from the one right before the anchor are kept.
+  EXPECT_EQ(30u, synchronizer.stream_size());
+
+  synchronizer.OnAnchorMessage(IntMessage(1, 20000));
+  ASSERT_EQ(2u, checker.streams.size());
+  EXPECT_DOUBLE_EQ(20000, checker.streams[1].data());
+
+  // The stream hasn't passed by the anchor yet.
+  synchronizer.OnAnchorMessage(IntMessage(2, 40200));
+  EXPECT_EQ(2u, checker.streams.size());
+  EXPECT_EQ(1u, synchronizer.anchor_size());
+  synchronizer.OnStreamMessage(DoubleMessage(40000, 40000));
+  EXPECT_EQ(2u, checker.streams.size());
+  synchronizer.OnStreamMessage(DoubleMessage(41000, 41000));
+  ASSERT_EQ(3u, checker.streams.size());
+  EXPECT_EQ(2, checker.anchors[2].data());
+  EXPECT_DOUBLE_EQ(40200, checker.streams[2].data());
+  EXPECT_EQ(0u, synchronizer.anchor_size());
+  EXPECT_EQ(2u, synchronizer.stream_size());
+}
+
+TEST(InterpolatingSynchronizerTest, Nearest) {
+  NotifyCallbackChecker checker;
+  InterpolatingSynchronizer<IntMessage, DoubleMessage> synchronizer;
+  synchronizer.set_notify_callback(base::BindRepeating(
+      &NotifyCallbackChecker::OnNotify, base::Unretained(&checker)));
+
+  synchronizer.OnStreamMessage(DoubleMessage(1, 1000));
+  synchronizer.OnStreamMessage(DoubleMessage(2, 2000));
+  synchronizer.OnAnchorMessage(IntMessage(0, 1400));
+  synchronizer.OnAnchorMessage(IntMessage(1, 1600));
+  ASSERT_EQ(2u, checker.streams.size());
+  EXPECT_EQ(DoubleMessage(1, 1000), checker.streams[0]);
+  EXPECT_EQ(DoubleMessage(2, 2000), checker.streams[1]);
+}
+
+TEST(InterpolatingSynchronizerTest, Drop) {
+  NotifyCallbackChecker checker;
+  InterpolatingSynchronizer<IntMessage, DoubleMessage> synchronizer(4, 2);
+  synchronizer.set_notify_callback(base::BindRepeating(
+      &NotifyCallbackChecker::OnNotify, base::Unretained(&checker)));
+
+  // The ring buffer keeps the last 4 messages.
+  for (int i = 0; i < 10; ++i) {
+    synchronizer.OnStreamMessage(DoubleMessage(i, i * 1000));
+  }
+  EXPECT_EQ(4u, synchronizer.stream_size());
+
+  // Out of order stream message is dropped.
+  synchronizer.OnStreamMessage(DoubleMessage(0, 0));
+  EXPECT_EQ(4u, synchronizer.stream_size());
+
+  // The anchor older than the stream is dropped.
+  synchronizer.OnAnchorMessage(IntMessage(0, 1000));
+  EXPECT_EQ(0u, checker.anchors.size());
+  EXPECT_EQ(0u, synchronizer.anchor_size());
+
+  // Only the last 2 anchors wait for the stream.
+  synchronizer.OnAnchorMessage(IntMessage(1, 10000));
+  synchronizer.OnAnchorMessage(IntMessage(2, 11000));
+  synchronizer.OnAnchorMessage(IntMessage(3, 12000));
+  EXPECT_EQ(2u, synchronizer.anchor_size());
+  synchronizer.OnStreamMessage(DoubleMessage(12, 12000));
+  ASSERT_EQ(2u, checker.anchors.size());
+  EXPECT_EQ(2, checker.anchors[0].data());
+  EXPECT_EQ(3, checker.anchors[1].data());
+}
+
+}  // namespace felicia
\ No newline at end of file
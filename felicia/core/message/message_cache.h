@@ -0,0 +1,185 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_MESSAGE_MESSAGE_CACHE_H_
+#define FELICIA_CORE_MESSAGE_MESSAGE_CACHE_H_
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/callback.h"
+#include "third_party/chromium/base/containers/circular_deque.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/message/message_timestamp.h"
+
+namespace felicia {
+
+// MessageCache keeps the last |capacity| messages sorted by timestamp, and
+// looks them up by timestamp with a binary search. |T| should have
+// |timestamp()|, see MessageTimestamp(), e.g. CameraFrame, ImuFrame,
+// LidarFrame, Pointcloud or any of their protobuf messages.
+//
+// Messages are shared with the callers of the lookups, so that a lookup
+// doesn't copy a message. It is thread safe, so it can be filled on the
+// thread of a subscriber and looked up on another thread.
+//
+//   MessageCache<ImuFrameMessage> imu_cache;
+//   subscriber.RequestSubscribe(node_info, topic, ...,
+//                               imu_cache.Attach(on_cached_callback), ...);
+//   ...
+//   std::shared_ptr<const ImuFrameMessage> imu_frame =
+//       imu_cache.GetNearest(camera_frame.timestamp());
+template <typename T>
+class MessageCache {
+ public:
+  using MessagePtr = std::shared_ptr<const T>;
+  using OnMessageCallback = base::RepeatingCallback<void(T&&)>;
+  using OnCachedCallback = base::RepeatingCallback<void(MessagePtr)>;
+
+  static constexpr size_t kDefaultCapacity = 256;
+
+  explicit MessageCache(size_t capacity = kDefaultCapacity)
+      : capacity_(capacity) {
+    DCHECK_GT(capacity_, 0u);
+  }
+
+  // Returns a callback which adds a message to the cache and passes the
+  // cached one to |on_cached_callback|, if it is not null. Give it to a
+  // subscriber or a driver as their callback. The cache should outlive them.
+  OnMessageCallback Attach(
+      OnCachedCallback on_cached_callback = OnCachedCallback()) {
+    return base::BindRepeating(&MessageCache::OnMessage, base::Unretained(this),
+                               on_cached_callback);
+  }
+
+  // Messages may be added out of order. If the cache is full, the oldest one
+  // is dropped.
+  void Add(T&& message) { Add(std::make_shared<const T>(std::move(message))); }
+  void Add(const T& message) { Add(std::make_shared<const T>(message)); }
+
+  void Add(MessagePtr message) {
+    DCHECK(message);
+    base::TimeDelta timestamp = MessageTimestamp(*message);
+    base::AutoLock l(lock_);
+    if (messages_.size() == capacity_) {
+      if (timestamp < MessageTimestamp(*messages_.front())) return;
+      messages_.pop_front();
+    }
+    if (messages_.empty() ||
+        MessageTimestamp(*messages_.back()) <= timestamp) {
+      messages_.push_back(std::move(message));
+      return;
+    }
+    messages_.insert(UpperBound(timestamp), std::move(message));
+  }
+
+  // Returns the message whose timestamp is the nearest to |timestamp|, or
+  // nullptr if the cache is empty. If two are equally near, the earlier one
+  // is returned.
+  MessagePtr GetNearest(base::TimeDelta timestamp) const {
+    base::AutoLock l(lock_);
+    if (messages_.empty()) return nullptr;
+    auto after = LowerBound(timestamp);
+    if (after == messages_.begin()) return *after;
+    auto before = after - 1;
+    if (after == messages_.end() ||
+        timestamp - MessageTimestamp(**before) <=
+            MessageTimestamp(**after) - timestamp) {
+      return *before;
+    }
+    return *after;
+  }
+
+  // Returns the latest message which is not later than |timestamp|, or
+  // nullptr if there is no such message.
+  MessagePtr GetBefore(base::TimeDelta timestamp) const {
+    base::AutoLock l(lock_);
+    auto it = UpperBound(timestamp);
+    if (it == messages_.begin()) return nullptr;
+    return *(it - 1);
+  }
+
+  // Returns the earliest message which is not earlier than |timestamp|, or
+  // nullptr if there is no such message.
+  MessagePtr GetAfter(base::TimeDelta timestamp) const {
+    base::AutoLock l(lock_);
+    auto it = LowerBound(timestamp);
+    if (it == messages_.end()) return nullptr;
+    return *it;
+  }
+
+  // Returns the messages whose timestamps are in [|begin|, |end|], in
+  // timestamp order.
+  std::vector<MessagePtr> GetInterval(base::TimeDelta begin,
+                                      base::TimeDelta end) const {
+    base::AutoLock l(lock_);
+    if (end < begin) return {};
+    return std::vector<MessagePtr>(LowerBound(begin), UpperBound(end));
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  size_t size() const {
+    base::AutoLock l(lock_);
+    return messages_.size();
+  }
+
+  bool empty() const { return size() == 0; }
+
+  void Clear() {
+    base::AutoLock l(lock_);
+    messages_.clear();
+  }
+
+ private:
+  using Iterator = typename base::circular_deque<MessagePtr>::const_iterator;
+
+  void OnMessage(OnCachedCallback on_cached_callback, T&& message) {
+    MessagePtr cached = std::make_shared<const T>(std::move(message));
+    Add(cached);
+    if (!on_cached_callback.is_null()) {
+      on_cached_callback.Run(std::move(cached));
+    }
+  }
+
+  Iterator LowerBound(base::TimeDelta timestamp) const
+      EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return std::lower_bound(messages_.begin(), messages_.end(), timestamp,
+                            [](const MessagePtr& message,
+                               base::TimeDelta timestamp) {
+                              return MessageTimestamp(*message) < timestamp;
+                            });
+  }
+
+  Iterator UpperBound(base::TimeDelta timestamp) const
+      EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return std::upper_bound(messages_.begin(), messages_.end(), timestamp,
+                            [](base::TimeDelta timestamp,
+                               const MessagePtr& message) {
+                              return timestamp < MessageTimestamp(*message);
+                            });
+  }
+
+  const size_t capacity_;
+
+  mutable base::Lock lock_;
+  base::circular_deque<MessagePtr> messages_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(MessageCache);
+};
+
+template <typename T>
+constexpr size_t MessageCache<T>::kDefaultCapacity;
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_MESSAGE_MESSAGE_CACHE_H_
\ No newline at end of file
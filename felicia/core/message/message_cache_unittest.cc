@@ -0,0 +1,101 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/message_cache.h"
+
+#include "gtest/gtest.h"
+
+#include "felicia/core/lib/base/template_util.h"
+#include "felicia/core/message/test/a_message.h"
+
+namespace felicia {
+
+namespace {
+
+base::TimeDelta Us(int64_t microseconds) {
+  return base::TimeDelta::FromMicroseconds(microseconds);
+}
+
+}  // namespace
+
+TEST(MessageCacheTest, Lookup) {
+  MessageCache<IntMessage> cache;
+  EXPECT_FALSE(cache.GetNearest(Us(0)));
+
+  // Out of order messages are sorted.
+  for (int timestamp : {10, 30, 20, 40}) {
+    cache.Add(IntMessage(timestamp, timestamp));
+  }
+  EXPECT_EQ(4u, cache.size());
+
+  EXPECT_EQ(10, cache.GetNearest(Us(0))->data());
+  EXPECT_EQ(20, cache.GetNearest(Us(24))->data());
+  EXPECT_EQ(20, cache.GetNearest(Us(25))->data());
+  EXPECT_EQ(30, cache.GetNearest(Us(26))->data());
+  EXPECT_EQ(40, cache.GetNearest(Us(100))->data());
+
+  EXPECT_FALSE(cache.GetBefore(Us(9)));
+  EXPECT_EQ(20, cache.GetBefore(Us(20))->data());
+  EXPECT_EQ(20, cache.GetBefore(Us(29))->data());
+
+  EXPECT_FALSE(cache.GetAfter(Us(41)));
+  EXPECT_EQ(20, cache.GetAfter(Us(20))->data());
+  EXPECT_EQ(30, cache.GetAfter(Us(21))->data());
+
+  std::vector<MessageCache<IntMessage>::MessagePtr> messages =
+      cache.GetInterval(Us(20), Us(40));
+  ASSERT_EQ(3u, messages.size());
+  EXPECT_EQ(20, messages[0]->data());
+  EXPECT_EQ(30, messages[1]->data());
+  EXPECT_EQ(40, messages[2]->data());
+  EXPECT_TRUE(cache.GetInterval(Us(21), Us(29)).empty());
+  EXPECT_TRUE(cache.GetInterval(Us(40), Us(20)).empty());
+}
+
+TEST(MessageCacheTest, Capacity) {
+  MessageCache<IntMessage> cache(2);
+  cache.Add(IntMessage(1, 10));
+  cache.Add(IntMessage(2, 20));
+  cache.Add(IntMessage(3, 30));
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(2, cache.GetNearest(Us(0))->data());
+
+  // Older than every cached message while the cache is full.
+  cache.Add(IntMessage(0, 0));
+  EXPECT_EQ(2, cache.GetNearest(Us(0))->data());
+
+  cache.Clear();
+  EXPECT_TRUE(cache.empty());
+}
+
+TEST(MessageCacheTest, Attach) {
+  MessageCache<IntMessage> cache;
+  std::vector<MessageCache<IntMessage>::MessagePtr> received;
+  MessageCache<IntMessage>::OnMessageCallback callback =
+      cache.Attach(base::BindRepeating(
+          [](std::vector<MessageCache<IntMessage>::MessagePtr>* received,
+             MessageCache<IntMessage>::MessagePtr message) {
+            received->push_back(std::move(message));
+          },
+          &received));
+  callback.Run(IntMessage(0, 10));
+  callback.Run(IntMessage(1, 20));
+  ASSERT_EQ(2u, received.size());
+  EXPECT_EQ(0, received[0]->data());
+  EXPECT_EQ(1, received[1]->data());
+  EXPECT_EQ(2u, cache.size());
+  // The callback gets the cached message, not a copy.
+  EXPECT_EQ(received[0], cache.GetNearest(Us(10)));
+  EXPECT_EQ(received[1], cache.GetNearest(Us(20)));
+
+  // The messages which are looked up outlive the cache.
+  MessageCache<IntMessage>::MessagePtr message = cache.GetNearest(Us(20));
+  cache.Clear();
+  EXPECT_EQ(1, message->data());
+
+  cache.Attach().Run(IntMessage(2, 30));
+  EXPECT_EQ(1u, cache.size());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -5,6 +5,9 @@
 #ifndef FELICIA_CORE_MESSAGE_MESSAGE_FILTER_H_
 #define FELICIA_CORE_MESSAGE_MESSAGE_FILTER_H_
 
+#include <tuple>
+#include <utility>
+
 #include "gtest/gtest_prod.h"
 
 #include "third_party/chromium/base/callback.h"
@@ -16,116 +19,38 @@
 #include "felicia/core/lib/containers/pool.h"
 
 namespace felicia {
-namespace internal {
-
-template <uint8_t Idx, typename... Rest>
-class MessageQueueImpl;
-
-template <uint8_t Idx, typename MessageTy>
-class MessageQueueImpl<Idx, MessageTy> {
- public:
-  typedef Pool<MessageTy, uint8_t> PoolType;
-  explicit MessageQueueImpl(uint8_t capacity = 1) : pool_(capacity) {}
-
-  void reserve(uint8_t capacity) { pool_.reserve(capacity); }
-
-  PoolType& pool() { return pool_; }
-  const PoolType& pool() const { return pool_; }
-
-  PoolType& get() { return pool_; }
-
-  const PoolType& get() const { return pool_; }
-
- private:
-  PoolType pool_;
-};
 
-template <uint8_t Idx, typename MessageTy, typename... Rest>
-class MessageQueueImpl<Idx, MessageTy, Rest...> {
+// MessageFilter holds a queue for each of |Types|, and notifies a set of
+// messages, one from each queue, when every queue has a message and the
+// filter callback accepts them. |SizeType| is the index type of the queues,
+// which limits their capacity. Use BasicMessageFilter with a wider type when
+// queues of more than 255 messages are needed.
+template <typename SizeType, typename... Types>
+class BasicMessageFilter {
  public:
-  typedef Pool<MessageTy, uint8_t> PoolType;
-  explicit MessageQueueImpl(uint8_t capacity = 1) : pool_(capacity) {}
-
-  void reserve(uint8_t capacity) {
-    pool_.reserve(capacity);
-    rest_.reserve(capacity);
-  }
-
-  PoolType& pool() { return pool_; }
-  const PoolType& pool() const { return pool_; }
-
-  template <uint8_t N, std::enable_if_t<N == Idx>* = nullptr>
-  PoolType& get() {
-    return pool_;
-  }
-
-  template <uint8_t N,
-            std::enable_if_t<(N != Idx && sizeof...(Rest) > 1)>* = nullptr>
-  auto& get() {
-    return rest_.template get<N>();
-  }
-
-  template <uint8_t N,
-            std::enable_if_t<(N != Idx && sizeof...(Rest) == 1)>* = nullptr>
-  auto& get() {
-    return rest_.get();
-  }
-
-  template <uint8_t N, std::enable_if_t<N == Idx>* = nullptr>
-  const PoolType& get() const {
-    return pool_;
-  }
-
-  template <uint8_t N,
-            std::enable_if_t<(N != Idx && sizeof...(Rest) > 1)>* = nullptr>
-  const auto& get() const {
-    return rest_.template get<N>();
+  static_assert(sizeof...(Types) > 0, "MessageFilter needs at least a type.");
+
+  template <size_t N>
+  using Type = std::tuple_element_t<N, std::tuple<Types...>>;
+  using FilterCallback =
+      base::RepeatingCallback<bool(BasicMessageFilter& filter)>;
+  using NotifyCallback = base::RepeatingCallback<void(Types&&...)>;
+  enum { TypeSize = sizeof...(Types) };
+
+  explicit BasicMessageFilter(SizeType capacity = 1)
+      : non_empty_queue_count_(0) {
+    reserve(capacity);
+    DETACH_FROM_SEQUENCE(sequence_checker_);
   }
 
-  template <uint8_t N,
-            std::enable_if_t<(N != Idx && sizeof...(Rest) == 1)>* = nullptr>
-  const auto& get() const {
-    return rest_.get();
+  ~BasicMessageFilter() {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   }
 
- private:
-  PoolType pool_;
-  MessageQueueImpl<Idx + 1, Rest...> rest_;
-};
-
-template <uint8_t Idx>
-class MessageQueueImpl<Idx> {
- public:
-  MessageQueueImpl() = default;
-};
-
-}  // namespace internal
-
-template <typename... Types>
-class MessageFilter;
-
-template <typename MessageTy, typename... Rest>
-class MessageFilter<MessageTy, Rest...> {
- public:
-  typedef internal::MessageQueueImpl<0, MessageTy, Rest...>
-      MessageQueueImplType;
-  template <uint8_t N>
-  using Type =
-      internal::PickTypeListItem<N,
-                                 base::internal::TypeList<MessageTy, Rest...>>;
-  using FilterCallback = base::RepeatingCallback<bool(MessageFilter& filter)>;
-  using NotifyCallback = base::RepeatingCallback<void(MessageTy&&, Rest&&...)>;
-  enum { TypeSize = sizeof...(Rest) + 1 };
-
-  explicit MessageFilter(uint8_t capacity = 1)
-      : filter_impl_(capacity), non_empty_queue_count_(0) {
-    DETACH_FROM_SEQUENCE(sequence_checker_);
+  void reserve(SizeType capacity) {
+    reserve(capacity, std::index_sequence_for<Types...>());
   }
 
-  ~MessageFilter() { DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_); }
-
-  void reserve(uint8_t capacity) { filter_impl_.reserve(capacity); }
-
   void set_filter_callback(FilterCallback filter_callback) {
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
     filter_callback_ = filter_callback;
@@ -137,110 +62,43 @@ class MessageFilter<MessageTy, Rest...> {
   }
 
   // NOTE: Please do not call this from FilterCallback.
-  template <uint8_t N>
+  template <size_t N>
   void OnMessage(Type<N>&& message) {
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
     push<N>(std::move(message));
   }
 
-  template <uint8_t N,
-            std::enable_if_t<N<TypeSize>* = nullptr> void DropMessage() {
+  template <size_t N>
+  void DropMessage() {
+    static_assert(N < TypeSize, "N is out of range.");
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
     pop<N>();
   }
 
-  template <uint8_t N, std::enable_if_t<N >= TypeSize>* = nullptr>
-  void DropMessage() {
-    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-    NOTREACHED();
+  // Same with above, but |idx| is given at runtime. It looks up a table which
+  // is generated at compile time, so it costs the same for any |idx|.
+  void DropMessage(size_t idx) {
+    DCHECK_LT(idx, static_cast<size_t>(TypeSize));
+    DropMessageImpl(idx, std::index_sequence_for<Types...>());
   }
 
-  void DropMessage(uint8_t idx) {
-    switch (idx) {
-      case 0:
-        DropMessage<0>();
-        break;
-      case 1:
-        DropMessage<1>();
-        break;
-      case 2:
-        DropMessage<2>();
-        break;
-      case 3:
-        DropMessage<3>();
-        break;
-      case 4:
-        DropMessage<4>();
-        break;
-      case 5:
-        DropMessage<5>();
-        break;
-      case 6:
-        DropMessage<6>();
-        break;
-      case 7:
-        DropMessage<7>();
-        break;
-      case 8:
-        DropMessage<8>();
-        break;
-      default:
-        NOTIMPLEMENTED();
-    }
-  }
-
-  template <uint8_t N>
-  const auto& PeekMessage(uint8_t idx) const {
+  template <size_t N>
+  const Type<N>& PeekMessage(SizeType idx) const {
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
     return get<N>()[idx];
   }
 
-  template <uint8_t N, std::enable_if_t<N<TypeSize>* = nullptr> uint8_t
-                           MessageCount() const {
+  template <size_t N>
+  SizeType MessageCount() const {
+    static_assert(N < TypeSize, "N is out of range.");
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
     return get<N>().size();
   }
 
-  template <uint8_t N, std::enable_if_t<N >= TypeSize>* = nullptr>
-  uint8_t MessageCount() const {
-    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-    NOTREACHED();
-    return 0;
-  }
-
-  uint8_t MessageCount(uint8_t idx) {
-    switch (idx) {
-      case 0:
-        return MessageCount<0>();
-        break;
-      case 1:
-        return MessageCount<1>();
-        break;
-      case 2:
-        return MessageCount<2>();
-        break;
-      case 3:
-        return MessageCount<3>();
-        break;
-      case 4:
-        return MessageCount<4>();
-        break;
-      case 5:
-        return MessageCount<5>();
-        break;
-      case 6:
-        return MessageCount<6>();
-        break;
-      case 7:
-        return MessageCount<7>();
-        break;
-      case 8:
-        return MessageCount<8>();
-        break;
-      default:
-        NOTIMPLEMENTED();
-    }
-    return 0;
+  // Same with above, but |idx| is given at runtime.
+  SizeType MessageCount(size_t idx) const {
+    DCHECK_LT(idx, static_cast<size_t>(TypeSize));
+    return MessageCountImpl(idx, std::index_sequence_for<Types...>());
   }
 
   // Return whether all the queue have element(s).
@@ -249,7 +107,30 @@ class MessageFilter<MessageTy, Rest...> {
   }
 
  private:
-  template <uint8_t N>
+  typedef void (BasicMessageFilter::*DropMessageFunction)();
+  typedef SizeType (BasicMessageFilter::*MessageCountFunction)() const;
+
+  template <size_t... Ns>
+  void DropMessageImpl(size_t idx, std::index_sequence<Ns...>) {
+    static constexpr DropMessageFunction kDropMessages[] = {
+        &BasicMessageFilter::DropMessage<Ns>...};
+    (this->*kDropMessages[idx])();
+  }
+
+  template <size_t... Ns>
+  SizeType MessageCountImpl(size_t idx, std::index_sequence<Ns...>) const {
+    static constexpr MessageCountFunction kMessageCounts[] = {
+        &BasicMessageFilter::MessageCount<Ns>...};
+    return (this->*kMessageCounts[idx])();
+  }
+
+  template <size_t... Ns>
+  void reserve(SizeType capacity, std::index_sequence<Ns...>) {
+    int unused[] = {(get<Ns>().reserve(capacity), 0)...};
+    ALLOW_UNUSED_LOCAL(unused);
+  }
+
+  template <size_t N>
   void push(Type<N>&& message) {
     auto& p = get<N>();
     bool empty = p.empty();
@@ -260,37 +141,37 @@ class MessageFilter<MessageTy, Rest...> {
     if (DoesAllQueueHaveElement()) ApplyFilter();
   }
 
-  template <uint8_t N>
+  template <size_t N>
   void pop() {
     auto& p = get<N>();
     p.pop();
     if (p.empty()) DecrementNonEmptyQueueCount();
   }
 
-  template <uint8_t N>
-  auto& get() {
-    return filter_impl_.template get<N>();
+  template <size_t N>
+  Pool<Type<N>, SizeType>& get() {
+    return std::get<N>(queues_);
   }
 
-  template <uint8_t N>
-  const auto& get() const {
-    return filter_impl_.template get<N>();
+  template <size_t N>
+  const Pool<Type<N>, SizeType>& get() const {
+    return std::get<N>(queues_);
   }
 
-  template <uint8_t N, typename... Args, std::enable_if_t<(N == 0)>* = nullptr>
-  void Notify(Args&&... args) {
-    auto& p = get<N>();
-    auto message = std::move(p.front());
+  template <size_t N>
+  Type<N> TakeFront() {
+    Type<N> message = std::move(get<N>().front());
     pop<N>();
-    notify_callback_.Run(std::move(message), std::forward<Args>(args)...);
+    return message;
   }
 
-  template <uint8_t N, typename... Args, std::enable_if_t<(N != 0)>* = nullptr>
-  void Notify(Args&&... args) {
-    auto& p = get<N>();
-    auto message = std::move(p.front());
-    pop<N>();
-    Notify<N - 1>(std::move(message), std::forward<Args>(args)...);
+  // Moves the messages out of the queues before running |notify_callback_|,
+  // which may push messages again.
+  template <size_t... Ns>
+  void Notify(std::index_sequence<Ns...>) {
+    // The elements of a braced list are evaluated in order.
+    std::tuple<Types...> messages{TakeFront<Ns>()...};
+    notify_callback_.Run(std::move(std::get<Ns>(messages))...);
   }
 
   void ApplyFilter() {
@@ -299,7 +180,8 @@ class MessageFilter<MessageTy, Rest...> {
     if (!filter_callback_.is_null() && DoesAllQueueHaveElement()) {
       should_notify = filter_callback_.Run(*this);
     }
-    if (should_notify || filter_callback_.is_null()) Notify<TypeSize - 1>();
+    if (should_notify || filter_callback_.is_null())
+      Notify(std::index_sequence_for<Types...>());
   }
 
   // Increment |non_empty_queue_count_|, and return whether all the queue have
@@ -309,20 +191,29 @@ class MessageFilter<MessageTy, Rest...> {
   }
 
   // Decrement |non_empty_queue_count_|, and return the current value.
-  uint8_t DecrementNonEmptyQueueCount() { return --non_empty_queue_count_; }
+  size_t DecrementNonEmptyQueueCount() { return --non_empty_queue_count_; }
 
-  MessageQueueImplType filter_impl_;
-  uint8_t non_empty_queue_count_;
+  std::tuple<Pool<Types, SizeType>...> queues_;
+  size_t non_empty_queue_count_;
   FilterCallback filter_callback_;
   NotifyCallback notify_callback_;
 
   SEQUENCE_CHECKER(sequence_checker_);
+
+  DISALLOW_COPY_AND_ASSIGN(BasicMessageFilter);
 };
 
-template <typename MessageTy, typename... Rest>
-class TimeSyncrhonizerMF {
+template <typename... Types>
+using MessageFilter = BasicMessageFilter<uint8_t, Types...>;
+
+// Filter callback which accepts a set of messages whose timestamps are close
+// enough to each other. Every type should have |timestamp()| in microseconds.
+template <typename SizeType, typename... Types>
+class BasicTimeSyncrhonizerMF {
  public:
-  TimeSyncrhonizerMF()
+  typedef BasicMessageFilter<SizeType, Types...> MessageFilterType;
+
+  BasicTimeSyncrhonizerMF()
       : max_intra_time_difference_(base::TimeDelta::FromMilliseconds(100)),
         min_inter_time_difference_(base::TimeDelta::Min()),
         last_timestamp_(base::TimeDelta::Min()) {}
@@ -337,19 +228,19 @@ class TimeSyncrhonizerMF {
     min_inter_time_difference_ = min_inter_time_difference;
   }
 
-  bool Callback(MessageFilter<MessageTy, Rest...>& filter) {
-    uint8_t peek_idxs[sizeof...(Rest) + 1] = {0};
+  bool Callback(MessageFilterType& filter) {
+    SizeType peek_idxs[sizeof...(Types)] = {0};
 
     bool has_candidate = false;
-    uint8_t last_updated_peek_idx = 0;
+    size_t last_updated_peek_idx = 0;
     base::TimeDelta last_timestamp_candidate;
     while (filter.DoesAllQueueHaveElement()) {
       MessageInfo earliest_message;
       earliest_message.timestamp = base::TimeDelta::Max();
       MessageInfo latest_message;
       latest_message.timestamp = base::TimeDelta::Min();
-      FindTimestamps<sizeof...(Rest)>(filter, peek_idxs, &earliest_message,
-                                      &latest_message);
+      FindTimestamps(filter, peek_idxs, &earliest_message, &latest_message,
+                     std::index_sequence_for<Types...>());
 
       base::TimeDelta delta =
           latest_message.timestamp - earliest_message.timestamp;
@@ -385,8 +276,8 @@ class TimeSyncrhonizerMF {
     if (has_candidate) {
       last_timestamp_ = last_timestamp_candidate;
       // Drop all the messages before peek_idx, which are useless.
-      for (uint8_t i = 0; i < base::size(peek_idxs); ++i) {
-        for (uint8_t j = 0; j < peek_idxs[i]; ++j) {
+      for (size_t i = 0; i < base::size(peek_idxs); ++i) {
+        for (SizeType j = 0; j < peek_idxs[i]; ++j) {
           filter.DropMessage(i);
         }
       }
@@ -400,28 +291,29 @@ class TimeSyncrhonizerMF {
   FRIEND_TEST(MessageFilterTest, ApplyTimeSynchronizerFilterTest);
 
   struct MessageInfo {
-    uint8_t idx;
+    size_t idx;
     base::TimeDelta timestamp;
   };
 
-  template <uint8_t N>
-  void FindTimestamps(MessageFilter<MessageTy, Rest...>& filter,
-                      uint8_t* peek_idxs, MessageInfo* earliest_message,
-                      MessageInfo* latest_message) {
-    base::TimeDelta timestamp = base::TimeDelta::FromMicroseconds(
-        filter.template PeekMessage<N>(peek_idxs[N]).timestamp());
-    if (timestamp < earliest_message->timestamp) {
-      earliest_message->timestamp = timestamp;
-      earliest_message->idx = N;
-    }
-    if (timestamp > latest_message->timestamp) {
-      latest_message->timestamp = timestamp;
-      latest_message->idx = N;
+  template <size_t... Ns>
+  void FindTimestamps(const MessageFilterType& filter,
+                      const SizeType* peek_idxs, MessageInfo* earliest_message,
+                      MessageInfo* latest_message,
+                      std::index_sequence<Ns...>) {
+    const base::TimeDelta timestamps[] = {base::TimeDelta::FromMicroseconds(
+        filter.template PeekMessage<Ns>(peek_idxs[Ns]).timestamp())...};
+    // Visit from the last, so that the last one wins when there are ties.
+    for (size_t i = base::size(timestamps); i > 0; --i) {
+      const base::TimeDelta& timestamp = timestamps[i - 1];
+      if (timestamp < earliest_message->timestamp) {
+        earliest_message->timestamp = timestamp;
+        earliest_message->idx = i - 1;
+      }
+      if (timestamp > latest_message->timestamp) {
+        latest_message->timestamp = timestamp;
+        latest_message->idx = i - 1;
+      }
     }
-
-    if (N == 0) return;
-    constexpr uint8_t NEXT = N - 1;
-    FindTimestamps<NEXT>(filter, peek_idxs, earliest_message, latest_message);
   }
 
   // Maximum time difference between the earliest message and the latest mesage
@@ -432,6 +324,9 @@ class TimeSyncrhonizerMF {
   base::TimeDelta last_timestamp_;
 };
 
+template <typename... Types>
+using TimeSyncrhonizerMF = BasicTimeSyncrhonizerMF<uint8_t, Types...>;
+
 }  // namespace felicia
 
 #endif  // FELICIA_CORE_MESSAGE_MESSAGE_FILTER_H_
\ No newline at end of file
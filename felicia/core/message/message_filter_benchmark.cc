@@ -0,0 +1,81 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/message_filter.h"
+
+#include "benchmark/benchmark.h"
+#include "third_party/chromium/base/bind.h"
+
+#include "felicia/core/message/test/a_message.h"
+
+namespace felicia {
+
+namespace {
+
+constexpr size_t kStreams = 12;
+// 30 fps in microseconds.
+constexpr int64_t kFrameInterval = 33333;
+
+template <typename Seq>
+class SynchronizedStreams;
+
+// Synchronizes |sizeof...(Ns)| streams of IntMessage, like a rig of cameras
+// and IMUs whose timestamps jitter a bit.
+template <size_t... Ns>
+class SynchronizedStreams<std::index_sequence<Ns...>> {
+ public:
+  template <size_t>
+  using Message = IntMessage;
+
+  typedef TimeSyncrhonizerMF<Message<Ns>...> Synchronizer;
+  typedef typename Synchronizer::MessageFilterType Filter;
+
+  explicit SynchronizedStreams(uint8_t capacity) : filter_(capacity) {
+    filter_.set_filter_callback(base::BindRepeating(
+        &Synchronizer::Callback, base::Unretained(&synchronizer_)));
+    filter_.set_notify_callback(base::BindRepeating(
+        &SynchronizedStreams::OnNotify, base::Unretained(this)));
+  }
+
+  // Publishes a message to every stream. Every other stream arrives a bit
+  // late, and every 4th frame of the last stream is dropped.
+  void PublishFrame(int frame) {
+    int64_t timestamp = frame * kFrameInterval;
+    int unused[] = {(PublishMessage<Ns>(frame, timestamp), 0)...};
+    ALLOW_UNUSED_LOCAL(unused);
+  }
+
+  int64_t notified_count() const { return notified_count_; }
+
+ private:
+  template <size_t N>
+  void PublishMessage(int frame, int64_t timestamp) {
+    if (N == kStreams - 1 && frame % 4 == 3) return;
+    int64_t jitter = (N % 2) * 1000 + (frame % 3) * 500;
+    filter_.template OnMessage<N>(IntMessage(frame, timestamp + jitter));
+  }
+
+  void OnNotify(Message<Ns>&&... messages) { ++notified_count_; }
+
+  Filter filter_;
+  Synchronizer synchronizer_;
+  int64_t notified_count_ = 0;
+};
+
+}  // namespace
+
+static void BM_TimeSynchronizer(benchmark::State& state) {
+  SynchronizedStreams<std::make_index_sequence<kStreams>> streams(
+      state.range(0));
+  int frame = 0;
+  for (auto _ : state) {
+    streams.PublishFrame(frame++);
+  }
+  state.SetItemsProcessed(streams.notified_count());
+  state.counters["frames"] = frame;
+}
+
+BENCHMARK(BM_TimeSynchronizer)->Arg(1)->Arg(10);
+
+}  // namespace felicia
\ No newline at end of file
@@ -97,6 +97,52 @@ TEST(MessageFilterTest, ApplyBasicFilterTest) {
   EXPECT_EQ(checker.answers.size(), checker.call_count);
 }
 
+TEST(MessageFilterTest, ManyTypesTest) {
+  typedef BasicMessageFilter<uint16_t, int, int, int, int, int, int, int, int,
+                             int, int, int, int>
+      ManyTypesFilter;
+  ManyTypesFilter filter(300);
+  int call_count = 0;
+  filter.set_filter_callback(
+      base::BindRepeating([](ManyTypesFilter& filter) {
+        // Keep only the last message of the 12th queue.
+        while (filter.MessageCount(11) > 1) {
+          filter.DropMessage(11);
+        }
+        return filter.PeekMessage<11>(0) == 299;
+      }));
+  filter.set_notify_callback(base::BindRepeating(
+      [](int* call_count, int&& a0, int&& a1, int&& a2, int&& a3, int&& a4,
+         int&& a5, int&& a6, int&& a7, int&& a8, int&& a9, int&& a10,
+         int&& a11) {
+        EXPECT_EQ(0, a0);
+        EXPECT_EQ(10, a10);
+        EXPECT_EQ(299, a11);
+        (*call_count)++;
+      },
+      &call_count));
+
+  // The 12th queue holds more messages than uint8_t can count.
+  for (int i = 0; i < 300; ++i) {
+    filter.OnMessage<11>(std::move(i));
+  }
+  EXPECT_EQ(300, filter.MessageCount(11));
+  filter.OnMessage<0>(0);
+  filter.OnMessage<1>(1);
+  filter.OnMessage<2>(2);
+  filter.OnMessage<3>(3);
+  filter.OnMessage<4>(4);
+  filter.OnMessage<5>(5);
+  filter.OnMessage<6>(6);
+  filter.OnMessage<7>(7);
+  filter.OnMessage<8>(8);
+  filter.OnMessage<9>(9);
+  EXPECT_EQ(0, call_count);
+  filter.OnMessage<10>(10);
+  EXPECT_EQ(1, call_count);
+  EXPECT_FALSE(filter.DoesAllQueueHaveElement());
+}
+
 TEST(MessageFilterTest, ApplyTimeSynchronizerFilterTest) {
   NotifyCallbackChecker<IntMessage, IntMessage> checker;
   std::vector<IntMessage> messages;
@@ -7,4 +7,5 @@ MESSAGE_IO_ERR(ERR_FAILED_TO_SERIALIZE, "Failed to serialize")
 MESSAGE_IO_ERR(ERR_NOT_ENOUGH_BUFFER, "Not enough buffer")
 MESSAGE_IO_ERR(ERR_CORRUPTED_HEADER, "Corrupted header")
 MESSAGE_IO_ERR(ERR_FAILED_TO_PARSE, "Failed to parse")
-MESSAGE_IO_ERR(ERR_WS_PROTOCOL_ERROR, "Websocket protocol error")
\ No newline at end of file
+MESSAGE_IO_ERR(ERR_WS_PROTOCOL_ERROR, "Websocket protocol error")
+MESSAGE_IO_ERR(ERR_CHECKSUM_MISMATCH, "Checksum mismatch")
\ No newline at end of file
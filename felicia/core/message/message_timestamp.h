@@ -0,0 +1,35 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_MESSAGE_MESSAGE_TIMESTAMP_H_
+#define FELICIA_CORE_MESSAGE_MESSAGE_TIMESTAMP_H_
+
+#include "third_party/chromium/base/time/time.h"
+
+namespace felicia {
+
+namespace internal {
+
+inline base::TimeDelta ToTimeDelta(base::TimeDelta timestamp) {
+  return timestamp;
+}
+
+// Timestamps of protobuf messages are in microseconds.
+inline base::TimeDelta ToTimeDelta(int64_t timestamp) {
+  return base::TimeDelta::FromMicroseconds(timestamp);
+}
+
+}  // namespace internal
+
+// Returns |message.timestamp()| as base::TimeDelta. It works for both
+// messages, e.g. ImuFrameMessage, whose timestamps are in microseconds, and
+// their wrappers, e.g. ImuFrame, whose timestamps are base::TimeDelta.
+template <typename T>
+base::TimeDelta MessageTimestamp(const T& message) {
+  return internal::ToTimeDelta(message.timestamp());
+}
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_MESSAGE_MESSAGE_TIMESTAMP_H_
\ No newline at end of file
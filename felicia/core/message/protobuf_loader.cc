@@ -4,14 +4,23 @@
 
 #include "felicia/core/message/protobuf_loader.h"
 
+#include <algorithm>
+
+#include "google/protobuf/descriptor.pb.h"
+#include "third_party/chromium/base/containers/flat_set.h"
 #include "third_party/chromium/base/files/file_enumerator.h"
+#include "third_party/chromium/base/files/file_util.h"
+#include "third_party/chromium/base/files/important_file_writer.h"
+#include "third_party/chromium/base/md5.h"
 #include "third_party/chromium/base/memory/ptr_util.h"
 #include "third_party/chromium/base/strings/string_tokenizer.h"
 #include "third_party/chromium/base/strings/string_util.h"
 #include "third_party/chromium/build/build_config.h"
 
 #include "felicia/core/lib/felicia_env.h"
+#include "felicia/core/lib/file/file_util.h"
 #include "felicia/core/lib/strings/str_util.h"
+#include "felicia/core/message/protobuf_util.h"
 
 namespace felicia {
 
@@ -40,11 +49,41 @@ std::vector<base::FilePath> GetProtobufRootPath() {
   return root_paths;
 }
 
+base::FilePath GetProtobufCacheDir() {
+  const char* protobuf_cache_dir = getenv("FEL_PROTOBUF_CACHE_DIR");
+  if (!protobuf_cache_dir) return base::FilePath();
+  return ToFilePath(protobuf_cache_dir);
+}
+
+// Returns the hash of |relative_paths| and the contents of |full_paths|, which
+// is used as a key of the cache.
+std::string HashProtoFiles(const std::vector<std::string>& full_paths,
+                           const std::vector<std::string>& relative_paths) {
+  base::MD5Context context;
+  base::MD5Init(&context);
+  for (size_t i = 0; i < full_paths.size(); ++i) {
+    std::string contents;
+    base::ReadFileToString(ToFilePath(full_paths[i]), &contents);
+    // Separate each field with '\0', so that the boundary counts too.
+    base::MD5Update(&context, relative_paths[i]);
+    base::MD5Update(&context, base::StringPiece("\0", 1));
+    base::MD5Update(&context, contents);
+    base::MD5Update(&context, base::StringPiece("\0", 1));
+  }
+  base::MD5Digest digest;
+  base::MD5Final(&digest, &context);
+  return base::MD5DigestToBase16(digest);
+}
+
 }  // namespace
 
-ProtobufLoader::ProtobufLoader() = default;
+ProtobufLoader::ProtobufLoader() : cache_dir_(GetProtobufCacheDir()) {}
 
-ProtobufLoader::~ProtobufLoader() = default;
+ProtobufLoader::~ProtobufLoader() {
+  if (descriptor_pool_) {
+    protobuf::UnregisterCacheableDescriptorPool(descriptor_pool_.get());
+  }
+}
 
 // static
 ProtobufLoader& ProtobufLoader::GetInstance() {
@@ -53,14 +92,8 @@ ProtobufLoader& ProtobufLoader::GetInstance() {
 }
 
 void ProtobufLoader::Load() {
-  if (source_tree_database_) return;
+  if (descriptor_pool_) return;
   std::vector<base::FilePath> root_paths = GetProtobufRootPath();
-  google::protobuf::compiler::DiskSourceTree source_tree;
-  source_tree_database_.reset(
-      new google::protobuf::compiler::SourceTreeDescriptorDatabase(
-          &source_tree));
-  descriptor_pool_.reset(new google::protobuf::DescriptorPool(
-      source_tree_database_.get(), &error_collector_));
 
 #if defined(BAZEL_BUILD)
   {
@@ -70,12 +103,12 @@ void ProtobufLoader::Load() {
   }
 #endif  // defined(BAZEL_BUILD)
 
+  std::vector<ProtoFile> proto_files;
   for (size_t i = 0; i < root_paths.size(); ++i) {
     base::FilePath& root_path = root_paths[i];
     std::string root_path_canonicalized;
     base::ReplaceChars(root_path.MaybeAsASCII(), "\\", "/",
                        &root_path_canonicalized);
-    source_tree.MapPath("", root_path_canonicalized);
 
     base::FileEnumerator enumerator(
         root_path, true, base::FileEnumerator::FILES,
@@ -85,6 +118,7 @@ void ProtobufLoader::Load() {
 #if defined(BAZEL_BUILD)
     bool is_felicia_root = i == root_paths.size() - 1;
 #endif  // defined(BAZEL_BUILD)
+    const size_t first = proto_files.size();
 
     for (auto path = enumerator.Next(); !path.empty();
          path = enumerator.Next()) {
@@ -95,9 +129,121 @@ void ProtobufLoader::Load() {
 #if defined(BAZEL_BUILD)
       if (is_felicia_root && !StartsWith(relative_path, "felicia/")) continue;
 #endif  // defined(BAZEL_BUILD)
-      descriptor_pool_->FindFileByName(relative_path);
+      ProtoFile proto_file;
+      proto_file.root_path = root_path_canonicalized;
+      proto_file.relative_path = relative_path;
+      proto_files.push_back(proto_file);
+    }
+    // FileEnumerator doesn't keep the order, which the hash depends on. The
+    // order of the root paths is kept, since it decides which one shadows
+    // the others.
+    std::sort(proto_files.begin() + first, proto_files.end(),
+              [](const ProtoFile& a, const ProtoFile& b) {
+                return a.relative_path < b.relative_path;
+              });
+  }
+
+  if (cache_dir_.empty()) {
+    LoadFromSources(proto_files);
+    return;
+  }
+
+  std::vector<std::string> full_paths;
+  std::vector<std::string> relative_paths;
+  for (const ProtoFile& proto_file : proto_files) {
+    full_paths.push_back(proto_file.root_path + proto_file.relative_path);
+    relative_paths.push_back(proto_file.relative_path);
+  }
+  base::FilePath cache_path = cache_dir_.AppendASCII(
+      HashProtoFiles(full_paths, relative_paths) + ".desc");
+  if (LoadFromCache(cache_path)) return;
+
+  LoadFromSources(proto_files);
+  WriteCache(cache_path, proto_files);
+}
+
+bool ProtobufLoader::LoadFromCache(const base::FilePath& cache_path) {
+  std::string serialized;
+  if (!base::ReadFileToString(cache_path, &serialized)) return false;
+
+  google::protobuf::FileDescriptorSet file_descriptor_set;
+  if (!file_descriptor_set.ParseFromString(serialized)) {
+    LOG(WARNING) << "Failed to parse protobuf cache: " << cache_path;
+    return false;
+  }
+
+  auto database =
+      std::make_unique<google::protobuf::SimpleDescriptorDatabase>();
+  for (const google::protobuf::FileDescriptorProto& file :
+       file_descriptor_set.file()) {
+    if (!database->Add(file)) {
+      LOG(WARNING) << "Invalid protobuf cache: " << cache_path;
+      return false;
+    }
+  }
+
+  cached_database_ = std::move(database);
+  descriptor_pool_.reset(new google::protobuf::DescriptorPool(
+      cached_database_.get(), &error_collector_));
+  protobuf::RegisterCacheableDescriptorPool(descriptor_pool_.get());
+  return true;
+}
+
+void ProtobufLoader::LoadFromSources(
+    const std::vector<ProtoFile>& proto_files) {
+  source_tree_database_.reset(
+      new google::protobuf::compiler::SourceTreeDescriptorDatabase(
+          &source_tree_));
+  descriptor_pool_.reset(new google::protobuf::DescriptorPool(
+      source_tree_database_.get(), &error_collector_));
+  protobuf::RegisterCacheableDescriptorPool(descriptor_pool_.get());
+
+  // Map every root path before parsing, so that a .proto can import the one
+  // under another root path.
+  base::flat_set<std::string> mapped_root_paths;
+  for (const ProtoFile& proto_file : proto_files) {
+    if (mapped_root_paths.insert(proto_file.root_path).second) {
+      source_tree_.MapPath("", proto_file.root_path);
+    }
+  }
+
+  for (const ProtoFile& proto_file : proto_files) {
+    descriptor_pool_->FindFileByName(proto_file.relative_path);
+  }
+}
+
+void ProtobufLoader::WriteCache(const base::FilePath& cache_path,
+                                const std::vector<ProtoFile>& proto_files) {
+  google::protobuf::FileDescriptorSet file_descriptor_set;
+  base::flat_set<std::string> visited;
+  std::vector<const google::protobuf::FileDescriptor*> file_descriptors;
+  for (const ProtoFile& proto_file : proto_files) {
+    const google::protobuf::FileDescriptor* file_descriptor =
+        descriptor_pool_->FindFileByName(proto_file.relative_path);
+    if (file_descriptor) file_descriptors.push_back(file_descriptor);
+  }
+  while (!file_descriptors.empty()) {
+    const google::protobuf::FileDescriptor* file_descriptor =
+        file_descriptors.back();
+    file_descriptors.pop_back();
+    if (!visited.insert(file_descriptor->name()).second) continue;
+    file_descriptor->CopyTo(file_descriptor_set.add_file());
+    for (int i = 0; i < file_descriptor->dependency_count(); ++i) {
+      file_descriptors.push_back(file_descriptor->dependency(i));
     }
   }
+
+  std::string serialized;
+  if (!file_descriptor_set.SerializeToString(&serialized)) {
+    LOG(WARNING) << "Failed to serialize protobuf cache.";
+    return;
+  }
+
+  if (!base::CreateDirectory(cache_dir_) ||
+      !base::ImportantFileWriter::WriteFileAtomically(cache_path,
+                                                      serialized)) {
+    LOG(WARNING) << "Failed to write protobuf cache: " << cache_path;
+  }
 }
 
 bool ProtobufLoader::NewMessage(const std::string& type_name,
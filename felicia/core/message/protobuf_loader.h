@@ -6,8 +6,11 @@
 #define FELICIA_CORE_MESSAGE_PROTOBUF_LOADER_H_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "google/protobuf/compiler/importer.h"
+#include "google/protobuf/descriptor_database.h"
 #include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/message.h"
 #include "third_party/chromium/base/files/file_path.h"
@@ -18,6 +21,15 @@
 
 namespace felicia {
 
+// ProtobufLoader builds descriptors of every .proto under
+// FEL_PROTOBUF_ROOT_PATH, so that messages can be created only by its type
+// name.
+//
+// Parsing every .proto takes quite a long time. If FEL_PROTOBUF_CACHE_DIR is
+// set, the parsed descriptors are stored there as a serialized
+// FileDescriptorSet named after the hash of the .proto sources, and are loaded
+// from it afterwards. Any change to the sources changes the hash, which falls
+// back to parsing them again.
 class FEL_EXPORT ProtobufLoader {
  public:
   class FEL_EXPORT ErrorCollector
@@ -44,14 +56,32 @@ class FEL_EXPORT ProtobufLoader {
 
  private:
   friend class base::NoDestructor<ProtobufLoader>;
+  friend class ProtobufLoaderBenchmark;
+  friend class ProtobufLoaderTest;
+
+  struct ProtoFile {
+    std::string root_path;
+    std::string relative_path;
+  };
 
   ProtobufLoader();
   ~ProtobufLoader();
 
   void Load();
 
+  bool LoadFromCache(const base::FilePath& cache_path);
+  void LoadFromSources(const std::vector<ProtoFile>& proto_files);
+  void WriteCache(const base::FilePath& cache_path,
+                  const std::vector<ProtoFile>& proto_files);
+
+  // If it's empty, cache is disabled.
+  base::FilePath cache_dir_;
+
+  google::protobuf::compiler::DiskSourceTree source_tree_;
   std::unique_ptr<google::protobuf::compiler::SourceTreeDescriptorDatabase>
       source_tree_database_;
+  std::unique_ptr<google::protobuf::SimpleDescriptorDatabase>
+      cached_database_;
   std::unique_ptr<google::protobuf::DescriptorPool> descriptor_pool_;
   google::protobuf::DynamicMessageFactory message_factory_;
 
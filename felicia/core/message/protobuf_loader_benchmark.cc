@@ -0,0 +1,52 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/protobuf_loader.h"
+
+#include "benchmark/benchmark.h"
+#include "third_party/chromium/base/files/scoped_temp_dir.h"
+#include "third_party/chromium/base/logging.h"
+
+namespace felicia {
+
+namespace {
+
+constexpr const char* kTypeName = "felicia.TopicInfo";
+
+}  // namespace
+
+class ProtobufLoaderBenchmark {
+ public:
+  // Measures from the beginning to creating the first message, which is what
+  // a dynamic node pays on startup. The descriptors are built lazily when they
+  // are loaded from the cache.
+  static void LoadAndNewMessage(const base::FilePath& cache_dir) {
+    ProtobufLoader protobuf_loader;
+    protobuf_loader.cache_dir_ = cache_dir;
+    const google::protobuf::Message* message;
+    CHECK(protobuf_loader.NewMessage(kTypeName, &message));
+  }
+};
+
+static void BM_LoadFromSources(benchmark::State& state) {
+  for (auto _ : state) {
+    ProtobufLoaderBenchmark::LoadAndNewMessage(base::FilePath());
+  }
+}
+
+static void BM_LoadFromCache(benchmark::State& state) {
+  base::ScopedTempDir dir;
+  CHECK(dir.CreateUniqueTempDir());
+  // Warm up the cache.
+  ProtobufLoaderBenchmark::LoadAndNewMessage(dir.GetPath());
+
+  for (auto _ : state) {
+    ProtobufLoaderBenchmark::LoadAndNewMessage(dir.GetPath());
+  }
+}
+
+BENCHMARK(BM_LoadFromSources)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadFromCache)->Unit(benchmark::kMillisecond);
+
+}  // namespace felicia
\ No newline at end of file
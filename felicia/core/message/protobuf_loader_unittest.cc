@@ -0,0 +1,158 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/protobuf_loader.h"
+
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/files/file_enumerator.h"
+#include "third_party/chromium/base/files/file_util.h"
+#include "third_party/chromium/base/files/scoped_temp_dir.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
+
+namespace felicia {
+
+namespace {
+
+constexpr const char* kTypeName = "felicia.test.LoaderMessage";
+
+constexpr const char kLoaderProto[] =
+    "syntax = \"proto3\";\n"
+    "package felicia.test;\n"
+    "import \"test/loader_field.proto\";\n"
+    "message LoaderMessage {\n"
+    "  LoaderField a = 1;\n"
+    "%s"
+    "}\n";
+
+constexpr const char kLoaderFieldProto[] =
+    "syntax = \"proto3\";\n"
+    "package felicia.test;\n"
+    "message LoaderField { int32 value = 1; }\n";
+
+}  // namespace
+
+class ProtobufLoaderTest : public testing::Test {
+ protected:
+  struct LoadResult {
+    bool from_cache = false;
+    // Fields of |kTypeName|.
+    std::vector<std::string> field_names;
+  };
+
+  void SetUp() override {
+    ASSERT_TRUE(dir_.CreateUniqueTempDir());
+    root_path_ = dir_.GetPath().AppendASCII("protos");
+    cache_dir_ = dir_.GetPath().AppendASCII("cache");
+    ASSERT_TRUE(base::CreateDirectory(root_path_.AppendASCII("test")));
+    WriteProto("test/loader_field.proto", kLoaderFieldProto);
+    WriteLoaderProto("");
+
+    const char* root_path = getenv("FEL_PROTOBUF_ROOT_PATH");
+    if (root_path) old_root_path_ = root_path;
+    setenv("FEL_PROTOBUF_ROOT_PATH", root_path_.value().c_str(), 1);
+  }
+
+  void TearDown() override {
+    if (old_root_path_.empty()) {
+      unsetenv("FEL_PROTOBUF_ROOT_PATH");
+    } else {
+      setenv("FEL_PROTOBUF_ROOT_PATH", old_root_path_.c_str(), 1);
+    }
+  }
+
+  void WriteProto(const std::string& relative_path,
+                  const std::string& contents) {
+    ASSERT_EQ(static_cast<int>(contents.length()),
+              base::WriteFile(root_path_.AppendASCII(relative_path),
+                              contents.data(), contents.length()));
+  }
+
+  // |fields| are added to LoaderMessage after |a|.
+  void WriteLoaderProto(const std::string& fields) {
+    WriteProto("test/loader.proto",
+               base::StringPrintf(kLoaderProto, fields.c_str()));
+  }
+
+  // Loads with a new ProtobufLoader, as a new process does.
+  LoadResult Load() {
+    LoadResult result;
+    ProtobufLoader protobuf_loader;
+    protobuf_loader.cache_dir_ = cache_dir_;
+    const google::protobuf::Message* message = nullptr;
+    EXPECT_TRUE(protobuf_loader.NewMessage(kTypeName, &message));
+    if (!message) return result;
+
+    result.from_cache = !!protobuf_loader.cached_database_;
+    const google::protobuf::Descriptor* descriptor = message->GetDescriptor();
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      result.field_names.push_back(descriptor->field(i)->name());
+    }
+    return result;
+  }
+
+  std::vector<base::FilePath> GetCacheFiles() const {
+    std::vector<base::FilePath> cache_files;
+    base::FileEnumerator enumerator(cache_dir_, false,
+                                    base::FileEnumerator::FILES,
+                                    FILE_PATH_LITERAL("*.desc"));
+    for (auto path = enumerator.Next(); !path.empty();
+         path = enumerator.Next()) {
+      cache_files.push_back(path);
+    }
+    return cache_files;
+  }
+
+  base::ScopedTempDir dir_;
+  base::FilePath root_path_;
+  base::FilePath cache_dir_;
+  std::string old_root_path_;
+};
+
+TEST_F(ProtobufLoaderTest, LoadFromCache) {
+  LoadResult result = Load();
+  EXPECT_FALSE(result.from_cache);
+  EXPECT_EQ(std::vector<std::string>({"a"}), result.field_names);
+  EXPECT_EQ(1u, GetCacheFiles().size());
+
+  result = Load();
+  EXPECT_TRUE(result.from_cache);
+  EXPECT_EQ(std::vector<std::string>({"a"}), result.field_names);
+  EXPECT_EQ(1u, GetCacheFiles().size());
+}
+
+TEST_F(ProtobufLoaderTest, LoadFromSourcesAfterEdit) {
+  Load();
+  WriteLoaderProto("  int32 b = 2;\n");
+
+  LoadResult result = Load();
+  EXPECT_FALSE(result.from_cache);
+  EXPECT_EQ(std::vector<std::string>({"a", "b"}), result.field_names);
+  EXPECT_EQ(2u, GetCacheFiles().size());
+
+  result = Load();
+  EXPECT_TRUE(result.from_cache);
+  EXPECT_EQ(std::vector<std::string>({"a", "b"}), result.field_names);
+}
+
+TEST_F(ProtobufLoaderTest, LoadFromSourcesIfCacheIsCorrupted) {
+  Load();
+  std::vector<base::FilePath> cache_files = GetCacheFiles();
+  ASSERT_EQ(1u, cache_files.size());
+  const char kCorrupted[] = "corrupted";
+  ASSERT_EQ(static_cast<int>(sizeof(kCorrupted)),
+            base::WriteFile(cache_files[0], kCorrupted, sizeof(kCorrupted)));
+
+  LoadResult result = Load();
+  EXPECT_FALSE(result.from_cache);
+  EXPECT_EQ(std::vector<std::string>({"a"}), result.field_names);
+
+  // The cache is written again.
+  result = Load();
+  EXPECT_TRUE(result.from_cache);
+  EXPECT_EQ(std::vector<std::string>({"a"}), result.field_names);
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -4,290 +4,434 @@
 
 #include "felicia/core/message/protobuf_util.h"
 
+#include <algorithm>
+#include <memory>
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/reflection.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "third_party/chromium/base/containers/flat_map.h"
+#include "third_party/chromium/base/containers/flat_set.h"
+#include "third_party/chromium/base/no_destructor.h"
+#include "third_party/chromium/base/stl_util.h"
 #include "third_party/chromium/base/strings/strcat.h"
 #include "third_party/chromium/base/strings/string_number_conversions.h"
+#include "third_party/chromium/base/strings/string_split.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
 
+#include "felicia/core/lib/error/errors.h"
 #include "felicia/core/lib/strings/str_util.h"
 #include "felicia/core/util/command_line_interface/text_style.h"
 
 namespace felicia {
 namespace protobuf {
 
+namespace {
+
+// Bytes longer than this are printed as its length only.
 constexpr size_t kMaximumContentLength = 100;
+// Repeated fields are cut after this many elements.
+constexpr int kMaximumRepeatedCount = 100;
 
-void ProtobufMessageToString(const google::protobuf::Message& message,
-                             int depth, std::string* out);
-
-void ProtobufMessageToString(
-    std::vector<std::string>& entities, int depth,
-    const google::protobuf::Reflection* reflection,
-    const google::protobuf::Message& message,
-    const google::protobuf::FieldDescriptor* field_desc) {
-  switch (field_desc->type()) {
-    case google::protobuf::FieldDescriptor::TYPE_DOUBLE: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<double>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(base::NumberToString(repeated_field_ref.Get(i)));
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      entities.push_back(
-          base::NumberToString(reflection->GetDouble(message, field_desc)));
-      return;
-    }
+enum class FieldKind {
+  DOUBLE,
+  FLOAT,
+  INT64,
+  UINT64,
+  INT32,
+  UINT32,
+  BOOL,
+  STRING,
+  BYTES,
+  MESSAGE,
+  ENUM,
+};
+
+// What is needed to print the field at the same index of its Descriptor,
+// which is computed once per Descriptor.
+struct FieldPlan {
+  FieldKind kind;
+  // "name: " in blue.
+  std::string label;
+};
+
+struct MessagePlan {
+  std::string full_name;
+  std::vector<FieldPlan> field_plans;
+};
+
+FieldKind ToFieldKind(google::protobuf::FieldDescriptor::Type type) {
+  switch (type) {
+    case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+      return FieldKind::DOUBLE;
     case google::protobuf::FieldDescriptor::TYPE_FLOAT:
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<float>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(base::NumberToString(repeated_field_ref.Get(i)));
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      entities.push_back(
-          base::NumberToString(reflection->GetFloat(message, field_desc)));
-      return;
+      return FieldKind::FLOAT;
     case google::protobuf::FieldDescriptor::TYPE_INT64:
     case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
-    case google::protobuf::FieldDescriptor::TYPE_SINT64: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<int64_t>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(base::NumberToString(repeated_field_ref.Get(i)));
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      entities.push_back(
-          base::NumberToString(reflection->GetInt64(message, field_desc)));
-      return;
-    }
+    case google::protobuf::FieldDescriptor::TYPE_SINT64:
+      return FieldKind::INT64;
     case google::protobuf::FieldDescriptor::TYPE_UINT64:
-    case google::protobuf::FieldDescriptor::TYPE_FIXED64: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<uint64_t>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(base::NumberToString(repeated_field_ref.Get(i)));
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      entities.push_back(
-          base::NumberToString(reflection->GetUInt64(message, field_desc)));
-      return;
-    }
+    case google::protobuf::FieldDescriptor::TYPE_FIXED64:
+      return FieldKind::UINT64;
     case google::protobuf::FieldDescriptor::TYPE_INT32:
     case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
-    case google::protobuf::FieldDescriptor::TYPE_SINT32: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<int32_t>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(base::NumberToString(repeated_field_ref.Get(i)));
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      entities.push_back(
-          base::NumberToString(reflection->GetInt32(message, field_desc)));
-      return;
-    }
+    case google::protobuf::FieldDescriptor::TYPE_SINT32:
+      return FieldKind::INT32;
     case google::protobuf::FieldDescriptor::TYPE_FIXED32:
-    case google::protobuf::FieldDescriptor::TYPE_UINT32: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<uint32_t>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(base::NumberToString(repeated_field_ref.Get(i)));
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      entities.push_back(
-          base::NumberToString(reflection->GetUInt32(message, field_desc)));
-      return;
+    case google::protobuf::FieldDescriptor::TYPE_UINT32:
+      return FieldKind::UINT32;
+    case google::protobuf::FieldDescriptor::TYPE_BOOL:
+      return FieldKind::BOOL;
+    case google::protobuf::FieldDescriptor::TYPE_STRING:
+      return FieldKind::STRING;
+    case google::protobuf::FieldDescriptor::TYPE_BYTES:
+      return FieldKind::BYTES;
+    case google::protobuf::FieldDescriptor::TYPE_GROUP:
+    case google::protobuf::FieldDescriptor::TYPE_MESSAGE:
+      return FieldKind::MESSAGE;
+    case google::protobuf::FieldDescriptor::TYPE_ENUM:
+      return FieldKind::ENUM;
+  }
+  NOTREACHED();
+  return FieldKind::MESSAGE;
+}
+
+std::shared_ptr<const MessagePlan> BuildMessagePlan(
+    const google::protobuf::Descriptor* descriptor) {
+  auto message_plan = std::make_shared<MessagePlan>();
+  message_plan->full_name = descriptor->full_name();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const google::protobuf::FieldDescriptor* field_desc = descriptor->field(i);
+    message_plan->field_plans.push_back(
+        {ToFieldKind(field_desc->type()),
+         TextStyle::Blue(base::StrCat({field_desc->name(), ": "}))});
+  }
+  return message_plan;
+}
+
+// The plans of the generated pool, which lives as long as the process, and of
+// the registered pools are cached. A Descriptor of any other pool is freed
+// with its pool, and a new one can take the same address, so its plan is
+// built every time.
+class MessagePlanCache {
+ public:
+  static MessagePlanCache& GetInstance() {
+    static base::NoDestructor<MessagePlanCache> message_plan_cache;
+    return *message_plan_cache;
+  }
+
+  std::shared_ptr<const MessagePlan> Get(
+      const google::protobuf::Descriptor* descriptor) {
+    const google::protobuf::DescriptorPool* pool = descriptor->file()->pool();
+    base::AutoLock l(lock_);
+    if (pool != google::protobuf::DescriptorPool::generated_pool() &&
+        !base::ContainsKey(cacheable_pools_, pool)) {
+      return BuildMessagePlan(descriptor);
     }
-    case google::protobuf::FieldDescriptor::TYPE_BOOL: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<bool>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(
-              BoolToString(reflection->GetBool(message, field_desc)));
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      entities.push_back(
-          BoolToString(reflection->GetBool(message, field_desc)));
+
+    std::shared_ptr<const MessagePlan>& message_plan =
+        message_plans_[descriptor];
+    if (!message_plan) message_plan = BuildMessagePlan(descriptor);
+    return message_plan;
+  }
+
+  void RegisterPool(const google::protobuf::DescriptorPool* pool) {
+    base::AutoLock l(lock_);
+    cacheable_pools_.insert(pool);
+  }
+
+  // Drops the plans of |pool|, whose descriptors are still alive.
+  void UnregisterPool(const google::protobuf::DescriptorPool* pool) {
+    base::AutoLock l(lock_);
+    if (cacheable_pools_.erase(pool) == 0) return;
+    base::EraseIf(message_plans_, [pool](const auto& message_plan) {
+      return message_plan.first->file()->pool() == pool;
+    });
+  }
+
+ private:
+  friend class base::NoDestructor<MessagePlanCache>;
+
+  MessagePlanCache() = default;
+
+  base::Lock lock_;
+  base::flat_set<const google::protobuf::DescriptorPool*> cacheable_pools_
+      GUARDED_BY(lock_);
+  base::flat_map<const google::protobuf::Descriptor*,
+                 std::shared_ptr<const MessagePlan>>
+      message_plans_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(MessagePlanCache);
+};
+
+void AppendIndent(int depth, std::string* out) { out->append(depth * 2, ' '); }
+
+void AppendMessage(const google::protobuf::Message& message, int depth,
+                   std::string* out);
+
+void AppendBytes(const std::string& bytes, std::string* out) {
+  if (bytes.length() > kMaximumContentLength) {
+    base::StrAppend(out,
+                    {"[BYTES(", base::NumberToString(bytes.length()), ")]"});
+  } else {
+    out->append(bytes);
+  }
+}
+
+void AppendSubMessage(const google::protobuf::Message& message, int depth,
+                      std::string* out) {
+  out->append("{\n");
+  AppendMessage(message, depth + 1, out);
+  AppendIndent(depth, out);
+  out->push_back('}');
+}
+
+// Appends the value of |field_desc|, or its |index|-th element if it's
+// repeated.
+void AppendValue(FieldKind kind, const google::protobuf::Reflection* reflection,
+                 const google::protobuf::Message& message,
+                 const google::protobuf::FieldDescriptor* field_desc,
+                 int index, int depth, std::string* out) {
+  bool repeated = field_desc->is_repeated();
+  switch (kind) {
+    case FieldKind::DOUBLE:
+      out->append(base::NumberToString(
+          repeated ? reflection->GetRepeatedDouble(message, field_desc, index)
+                   : reflection->GetDouble(message, field_desc)));
       return;
-    }
-    case google::protobuf::FieldDescriptor::TYPE_STRING: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<std::string>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(repeated_field_ref.Get(i));
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      std::string scratch;
-      entities.push_back(
-          reflection->GetStringReference(message, field_desc, &scratch));
+    case FieldKind::FLOAT:
+      out->append(base::NumberToString(
+          repeated ? reflection->GetRepeatedFloat(message, field_desc, index)
+                   : reflection->GetFloat(message, field_desc)));
       return;
-    }
-    case google::protobuf::FieldDescriptor::TYPE_MESSAGE: {
-      if (field_desc->is_repeated()) {
-        entities.push_back("[ ");
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<google::protobuf::Message>(
-                message, field_desc);
-        std::unique_ptr<google::protobuf::Message> scratch_space(
-            repeated_field_ref.NewMessage());
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          std::string str;
-          ProtobufMessageToString(
-              repeated_field_ref.Get(i, scratch_space.get()), depth + 1, &str);
-          entities.push_back(base::StrCat({"{\n", str}));
-          for (int j = 0; j < depth; j++) entities.push_back("  ");
-          entities.push_back("}");
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      std::string str;
-      ProtobufMessageToString(reflection->GetMessage(message, field_desc),
-                              depth + 1, &str);
-      entities.push_back(base::StrCat({"{\n", str}));
-      for (int j = 0; j < depth; j++) entities.push_back("  ");
-      entities.push_back("}");
+    case FieldKind::INT64:
+      out->append(base::NumberToString(
+          repeated ? reflection->GetRepeatedInt64(message, field_desc, index)
+                   : reflection->GetInt64(message, field_desc)));
       return;
-    }
-    case google::protobuf::FieldDescriptor::TYPE_BYTES: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<std::string>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          std::string data = repeated_field_ref.Get(i);
-          if (data.size() > kMaximumContentLength) {
-            entities.push_back(base::StrCat(
-                {"[BYTES(", base::NumberToString(data.length()), ")]"}));
-          } else {
-            entities.push_back(data);
-          }
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
+    case FieldKind::UINT64:
+      out->append(base::NumberToString(
+          repeated ? reflection->GetRepeatedUInt64(message, field_desc, index)
+                   : reflection->GetUInt64(message, field_desc)));
+      return;
+    case FieldKind::INT32:
+      out->append(base::NumberToString(
+          repeated ? reflection->GetRepeatedInt32(message, field_desc, index)
+                   : reflection->GetInt32(message, field_desc)));
+      return;
+    case FieldKind::UINT32:
+      out->append(base::NumberToString(
+          repeated ? reflection->GetRepeatedUInt32(message, field_desc, index)
+                   : reflection->GetUInt32(message, field_desc)));
+      return;
+    case FieldKind::BOOL:
+      out->append(BoolToString(
+          repeated ? reflection->GetRepeatedBool(message, field_desc, index)
+                   : reflection->GetBool(message, field_desc)));
+      return;
+    case FieldKind::STRING:
+    case FieldKind::BYTES: {
       std::string scratch;
-      const std::string& data =
-          reflection->GetStringReference(message, field_desc, &scratch);
-      if (data.size() > kMaximumContentLength) {
-        entities.push_back(base::StrCat(
-            {"[BYTES(", base::NumberToString(data.length()), ")]"}));
+      const std::string& value =
+          repeated ? reflection->GetRepeatedStringReference(
+                         message, field_desc, index, &scratch)
+                   : reflection->GetStringReference(message, field_desc,
+                                                    &scratch);
+      if (kind == FieldKind::BYTES) {
+        AppendBytes(value, out);
       } else {
-        entities.push_back(data);
+        out->append(value);
       }
       return;
     }
-    case google::protobuf::FieldDescriptor::TYPE_ENUM: {
-      if (field_desc->is_repeated()) {
-        auto repeated_field_ref =
-            reflection->GetRepeatedFieldRef<int>(message, field_desc);
-        entities.push_back("[ ");
-        for (int i = 0; i < repeated_field_ref.size(); ++i) {
-          entities.push_back(
-              reflection->GetRepeatedEnum(message, field_desc, i)->name());
-          if (i != repeated_field_ref.size() - 1) {
-            entities.push_back(", ");
-          }
-        }
-        entities.push_back(" ]");
-        return;
-      }
-      const google::protobuf::EnumValueDescriptor* enum_value_desc =
-          reflection->GetEnum(message, field_desc);
-      entities.push_back(enum_value_desc->name());
+    case FieldKind::MESSAGE:
+      AppendSubMessage(
+          repeated ? reflection->GetRepeatedMessage(message, field_desc, index)
+                   : reflection->GetMessage(message, field_desc),
+          depth, out);
       return;
-    }
-    default:
-      LOG(ERROR) << "Not supported type: " << field_desc->type_name();
+    case FieldKind::ENUM:
+      out->append(
+          (repeated ? reflection->GetRepeatedEnum(message, field_desc, index)
+                    : reflection->GetEnum(message, field_desc))
+              ->name());
       return;
   }
 }
 
-void ProtobufMessageToString(const google::protobuf::Message& message,
-                             int depth, std::string* out) {
+void AppendField(FieldKind kind, const google::protobuf::Reflection* reflection,
+                 const google::protobuf::Message& message,
+                 const google::protobuf::FieldDescriptor* field_desc,
+                 int depth, std::string* out) {
+  if (!field_desc->is_repeated()) {
+    AppendValue(kind, reflection, message, field_desc, -1, depth, out);
+    return;
+  }
+
+  int size = reflection->FieldSize(message, field_desc);
+  int count = std::min(size, kMaximumRepeatedCount);
+  out->append("[ ");
+  for (int i = 0; i < count; ++i) {
+    AppendValue(kind, reflection, message, field_desc, i, depth, out);
+    if (i != size - 1) out->append(", ");
+  }
+  if (count < size) {
+    base::StrAppend(out, {"...(", base::NumberToString(size - count),
+                          " more)"});
+  }
+  out->append(" ]");
+}
+
+void AppendMessage(const google::protobuf::Message& message, int depth,
+                   std::string* out) {
   const google::protobuf::Descriptor* descriptor = message.GetDescriptor();
   const google::protobuf::Reflection* reflection = message.GetReflection();
-
-  std::vector<std::string> entities;
-  entities.reserve((descriptor->field_count() + depth) * 3);
+  std::shared_ptr<const MessagePlan> message_plan =
+      MessagePlanCache::GetInstance().Get(descriptor);
 
   for (int i = 0; i < descriptor->field_count(); ++i) {
-    const google::protobuf::FieldDescriptor* field_desc = descriptor->field(i);
-    for (int j = 0; j < depth; j++) entities.push_back("  ");
-    entities.push_back(
-        TextStyle::Blue(base::StrCat({field_desc->name(), ": "})));
-    ProtobufMessageToString(entities, depth, reflection, message, field_desc);
-    entities.push_back("\n");
+    const FieldPlan& field_plan = message_plan->field_plans[i];
+    AppendIndent(depth, out);
+    out->append(field_plan.label);
+    AppendField(field_plan.kind, reflection, message, descriptor->field(i),
+                depth, out);
+    out->push_back('\n');
   }
+}
+
+}  // namespace
+
+void AppendProtobufMessageToString(const google::protobuf::Message& message,
+                                   std::string* out) {
+  AppendMessage(message, 0, out);
+}
+
+void RegisterCacheableDescriptorPool(
+    const google::protobuf::DescriptorPool* pool) {
+  MessagePlanCache::GetInstance().RegisterPool(pool);
+}
 
-  base::StrAppend(out, entities);
+void UnregisterCacheableDescriptorPool(
+    const google::protobuf::DescriptorPool* pool) {
+  MessagePlanCache::GetInstance().UnregisterPool(pool);
 }
 
 std::string ProtobufMessageToString(const google::protobuf::Message& message) {
   std::string ret;
-  ProtobufMessageToString(message, 0, &ret);
+  AppendProtobufMessageToString(message, &ret);
   return ret;
 }
 
+struct FieldMaskFilter::Node {
+  // Key is a field number. If a node has no children, the whole field is
+  // kept.
+  base::flat_map<int, std::unique_ptr<Node>> children;
+};
+
+namespace {
+
+using google::protobuf::internal::WireFormatLite;
+
+bool FilterWireFormat(const FieldMaskFilter::Node& node,
+                      google::protobuf::io::CodedInputStream* input,
+                      google::protobuf::io::CodedOutputStream* output) {
+  const auto& children = node.children;
+  while (uint32_t tag = input->ReadTag()) {
+    auto it = children.find(WireFormatLite::GetTagFieldNumber(tag));
+    if (it == children.end()) {
+      if (!WireFormatLite::SkipField(input, tag)) return false;
+    } else if (it->second->children.empty()) {
+      // Copies the field to |output| as it is.
+      if (!WireFormatLite::SkipField(input, tag, output)) return false;
+    } else {
+      if (WireFormatLite::GetTagWireType(tag) !=
+          WireFormatLite::WIRETYPE_LENGTH_DELIMITED)
+        return false;
+      uint32_t length;
+      if (!input->ReadVarint32(&length)) return false;
+      google::protobuf::io::CodedInputStream::Limit limit =
+          input->PushLimit(length);
+      std::string sub_message;
+      {
+        google::protobuf::io::StringOutputStream sub_stream(&sub_message);
+        google::protobuf::io::CodedOutputStream sub_output(&sub_stream);
+        if (!FilterWireFormat(*it->second, input, &sub_output)) return false;
+      }
+      input->PopLimit(limit);
+      output->WriteTag(tag);
+      output->WriteVarint32(static_cast<uint32_t>(sub_message.length()));
+      output->WriteString(sub_message);
+    }
+  }
+  return input->ConsumedEntireMessage();
+}
+
+}  // namespace
+
+FieldMaskFilter::FieldMaskFilter() = default;
+
+FieldMaskFilter::~FieldMaskFilter() = default;
+
+Status FieldMaskFilter::Init(const google::protobuf::Descriptor* descriptor,
+                             const std::vector<std::string>& paths) {
+  root_ = std::make_unique<Node>();
+  for (const std::string& path : paths) {
+    std::vector<std::string> names = base::SplitString(
+        path, ".", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    if (names.empty()) {
+      return errors::InvalidArgument(
+          base::StringPrintf("Empty field path: %s.", path.c_str()));
+    }
+
+    const google::protobuf::Descriptor* current = descriptor;
+    Node* node = root_.get();
+    for (size_t i = 0; i < names.size(); ++i) {
+      const google::protobuf::FieldDescriptor* field_desc =
+          current->FindFieldByName(names[i]);
+      if (!field_desc) {
+        return errors::InvalidArgument(
+            base::StringPrintf("%s has no field %s.",
+                               descriptor->full_name().c_str(), path.c_str()));
+      }
+
+      auto& child = node->children[field_desc->number()];
+      bool is_leaf = i == names.size() - 1;
+      if (child && child->children.empty()) {
+        // The whole field is already kept by a shorter path.
+        break;
+      }
+      if (!child) child = std::make_unique<Node>();
+      if (is_leaf) {
+        child->children.clear();
+        break;
+      }
+      if (field_desc->type() !=
+          google::protobuf::FieldDescriptor::TYPE_MESSAGE) {
+        return errors::InvalidArgument(base::StringPrintf(
+            "%s can't select a sub field of %s, which is not a message.",
+            path.c_str(), names[i].c_str()));
+      }
+      current = field_desc->message_type();
+      node = child.get();
+    }
+  }
+  return Status::OK();
+}
+
+bool FieldMaskFilter::Filter(const char* data, size_t size,
+                             std::string* out) const {
+  DCHECK(root_);
+  out->clear();
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(data), static_cast<int>(size));
+  google::protobuf::io::StringOutputStream stream(out);
+  google::protobuf::io::CodedOutputStream output(&stream);
+  return FilterWireFormat(*root_, &input, &output);
+}
+
 }  // namespace protobuf
 }  // namespace felicia
\ No newline at end of file
@@ -5,16 +5,64 @@
 #ifndef FELICIA_CORE_MESSAGE_PROTOBUF_UTIL_H_
 #define FELICIA_CORE_MESSAGE_PROTOBUF_UTIL_H_
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "google/protobuf/message.h"
+#include "third_party/chromium/base/macros.h"
 
 #include "felicia/core/lib/base/export.h"
+#include "felicia/core/lib/error/status.h"
 
 namespace felicia {
 namespace protobuf {
 
+// Renders |message| in a human readable form, one field per line. Bytes longer
+// than 100 are printed only with its length, and repeated fields are cut after
+// 100 elements.
 FEL_EXPORT std::string ProtobufMessageToString(
     const google::protobuf::Message& message);
 
+// Same as above, but appends to |out|, so that the caller can reuse its
+// buffer across messages.
+FEL_EXPORT void AppendProtobufMessageToString(
+    const google::protobuf::Message& message, std::string* out);
+
+// Plans to render the messages of the generated pool are cached by the above.
+// Those of any other pool, e.g, of ProtobufLoader, are cached only if the pool
+// is registered here, and it must be unregistered before it is destroyed.
+FEL_EXPORT void RegisterCacheableDescriptorPool(
+    const google::protobuf::DescriptorPool* pool);
+FEL_EXPORT void UnregisterCacheableDescriptorPool(
+    const google::protobuf::DescriptorPool* pool);
+
+// FieldMaskFilter drops every field but the ones in the mask from a serialized
+// message, working on the wire format only. The dropped fields are skipped
+// without being decoded, so filtering a message with a large bytes field
+// costs almost nothing unless the field is in the mask.
+//
+// Each path of the mask is field names joined with '.', e.g. "image.size".
+// A path selects the whole field, including every sub field of it.
+class FEL_EXPORT FieldMaskFilter {
+ public:
+  FieldMaskFilter();
+  ~FieldMaskFilter();
+
+  Status Init(const google::protobuf::Descriptor* descriptor,
+              const std::vector<std::string>& paths);
+
+  bool Filter(const char* data, size_t size, std::string* out) const;
+
+  // Opaque, it's public only to be visible from the implementation.
+  struct Node;
+
+ private:
+  std::unique_ptr<Node> root_;
+
+  DISALLOW_COPY_AND_ASSIGN(FieldMaskFilter);
+};
+
 }  // namespace protobuf
 }  // namespace felicia
 
@@ -0,0 +1,139 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/protobuf_util.h"
+
+#include "benchmark/benchmark.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/dynamic_message.h"
+
+#include "felicia/core/lib/containers/data_constants.h"
+#include "felicia/core/message/dynamic_protobuf_message.h"
+#include "felicia/drivers/camera/camera_frame_message.pb.h"
+#include "felicia/map/map_message.pb.h"
+
+namespace felicia {
+
+namespace {
+
+drivers::CameraFrameMessage MakeCameraFrameMessage() {
+  drivers::CameraFrameMessage message;
+  message.set_data(std::string(640 * 480 * 3, 'x'));
+  drivers::CameraFormatMessage* camera_format =
+      message.mutable_camera_format();
+  camera_format->mutable_size()->set_width(640);
+  camera_format->mutable_size()->set_height(480);
+  camera_format->set_pixel_format(PIXEL_FORMAT_BGR);
+  camera_format->set_frame_rate(30);
+  message.set_timestamp(1234567890);
+  return message;
+}
+
+map::PointcloudMessage MakePointcloudMessage() {
+  constexpr size_t kPoints = 100000;
+  map::PointcloudMessage message;
+  message.mutable_points()->set_type(DATA_TYPE_32F_C3);
+  message.mutable_points()->set_data(
+      std::string(kPoints * 3 * sizeof(float), 'x'));
+  message.mutable_colors()->set_type(DATA_TYPE_8U_C3);
+  message.mutable_colors()->set_data(std::string(kPoints * 3, 'x'));
+  message.set_timestamp(1234567890);
+  return message;
+}
+
+// What the text format of protobuf gives, which copies every byte.
+void DebugString(benchmark::State& state,
+                 const google::protobuf::Message& message) {
+  for (auto _ : state) {
+    std::string text = message.DebugString();
+    benchmark::DoNotOptimize(text);
+  }
+}
+
+// What `felicia topic subscribe` does for every message, reusing its buffer.
+void AppendProtobufMessageToString(benchmark::State& state,
+                                   const google::protobuf::Message& message) {
+  std::string text;
+  for (auto _ : state) {
+    text.clear();
+    protobuf::AppendProtobufMessageToString(message, &text);
+    benchmark::DoNotOptimize(text);
+  }
+}
+
+// Builds |file| and what it imports in |pool|, as ProtobufLoader does from
+// the .proto sources.
+const google::protobuf::FileDescriptor* BuildFile(
+    google::protobuf::DescriptorPool* pool,
+    const google::protobuf::FileDescriptor* file) {
+  for (int i = 0; i < file->dependency_count(); ++i) {
+    if (!pool->FindFileByName(file->dependency(i)->name()))
+      BuildFile(pool, file->dependency(i));
+  }
+  google::protobuf::FileDescriptorProto file_proto;
+  file->CopyTo(&file_proto);
+  return pool->BuildFile(file_proto);
+}
+
+// What `felicia topic subscribe` does for a message of ProtobufLoader, which
+// is a DynamicProtobufMessage of its own pool.
+void DynamicProtobufMessageToString(benchmark::State& state,
+                                    const google::protobuf::Message& message,
+                                    bool cacheable) {
+  google::protobuf::DescriptorPool pool;
+  if (cacheable) protobuf::RegisterCacheableDescriptorPool(&pool);
+  BuildFile(&pool, message.GetDescriptor()->file());
+  google::protobuf::DynamicMessageFactory factory(&pool);
+  {
+    DynamicProtobufMessage dynamic_message;
+    dynamic_message.Reset(
+        factory
+            .GetPrototype(
+                pool.FindMessageTypeByName(message.GetTypeName()))
+            ->New());
+    dynamic_message.ParseFromArray(message.SerializeAsString().data(),
+                                   message.ByteSizeLong());
+    for (auto _ : state) {
+      std::string text = dynamic_message.ToString();
+      benchmark::DoNotOptimize(text);
+    }
+  }
+  if (cacheable) protobuf::UnregisterCacheableDescriptorPool(&pool);
+}
+
+}  // namespace
+
+static void BM_CameraFrameMessageDebugString(benchmark::State& state) {
+  DebugString(state, MakeCameraFrameMessage());
+}
+
+static void BM_CameraFrameMessageToString(benchmark::State& state) {
+  AppendProtobufMessageToString(state, MakeCameraFrameMessage());
+}
+
+static void BM_PointcloudMessageDebugString(benchmark::State& state) {
+  DebugString(state, MakePointcloudMessage());
+}
+
+static void BM_PointcloudMessageToString(benchmark::State& state) {
+  AppendProtobufMessageToString(state, MakePointcloudMessage());
+}
+
+static void BM_DynamicCameraFrameMessageToString(benchmark::State& state) {
+  DynamicProtobufMessageToString(state, MakeCameraFrameMessage(), true);
+}
+
+static void BM_DynamicCameraFrameMessageToStringUncached(
+    benchmark::State& state) {
+  DynamicProtobufMessageToString(state, MakeCameraFrameMessage(), false);
+}
+
+BENCHMARK(BM_CameraFrameMessageDebugString);
+BENCHMARK(BM_CameraFrameMessageToString);
+BENCHMARK(BM_PointcloudMessageDebugString);
+BENCHMARK(BM_PointcloudMessageToString);
+BENCHMARK(BM_DynamicCameraFrameMessageToString);
+BENCHMARK(BM_DynamicCameraFrameMessageToStringUncached);
+
+}  // namespace felicia
\ No newline at end of file
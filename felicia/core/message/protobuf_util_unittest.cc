@@ -0,0 +1,231 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/protobuf_util.h"
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/dynamic_message.h"
+#include "gtest/gtest.h"
+
+#include "felicia/core/message/dynamic_protobuf_message.h"
+#include "felicia/core/protobuf/master_data.pb.h"
+
+namespace felicia {
+namespace protobuf {
+
+namespace {
+
+TopicInfo MakeTopicInfo() {
+  TopicInfo topic_info;
+  topic_info.set_topic("topic");
+  topic_info.set_type_name(std::string(1024, 'x'));
+  for (int i = 0; i < 2; ++i) {
+    ChannelDef* channel_def =
+        topic_info.mutable_topic_source()->add_channel_defs();
+    channel_def->set_type(ChannelDef::CHANNEL_TYPE_TCP);
+    channel_def->mutable_ip_endpoint()->set_ip("127.0.0.1");
+    channel_def->mutable_ip_endpoint()->set_port(8000 + i);
+  }
+  return topic_info;
+}
+
+// Builds "test.Value" with a field "value" of |type| in a new |pool|.
+const google::protobuf::Descriptor* BuildValueDescriptor(
+    google::protobuf::DescriptorPool* pool,
+    google::protobuf::FieldDescriptorProto::Type type) {
+  google::protobuf::FileDescriptorProto file;
+  file.set_name("value.proto");
+  file.set_package("test");
+  google::protobuf::DescriptorProto* message_type = file.add_message_type();
+  message_type->set_name("Value");
+  google::protobuf::FieldDescriptorProto* field = message_type->add_field();
+  field->set_name("value");
+  field->set_number(1);
+  field->set_type(type);
+  field->set_label(google::protobuf::FieldDescriptorProto::LABEL_OPTIONAL);
+  const google::protobuf::FileDescriptor* file_desc = pool->BuildFile(file);
+  return file_desc ? file_desc->message_type(0) : nullptr;
+}
+
+}  // namespace
+
+// Messages of the same name and the same number of fields from different
+// pools are printed by their own fields.
+TEST(ProtobufMessageToStringTest, DynamicPools) {
+  for (auto type : {google::protobuf::FieldDescriptorProto::TYPE_STRING,
+                    google::protobuf::FieldDescriptorProto::TYPE_INT32}) {
+    google::protobuf::DescriptorPool pool;
+    const google::protobuf::Descriptor* descriptor =
+        BuildValueDescriptor(&pool, type);
+    ASSERT_TRUE(descriptor);
+    google::protobuf::DynamicMessageFactory factory(&pool);
+    std::unique_ptr<google::protobuf::Message> message(
+        factory.GetPrototype(descriptor)->New());
+    const google::protobuf::FieldDescriptor* field = descriptor->field(0);
+    if (type == google::protobuf::FieldDescriptorProto::TYPE_STRING) {
+      message->GetReflection()->SetString(message.get(), field, "abc");
+      EXPECT_NE(std::string::npos,
+                ProtobufMessageToString(*message).find("abc"));
+    } else {
+      message->GetReflection()->SetInt32(message.get(), field, 123);
+      EXPECT_NE(std::string::npos,
+                ProtobufMessageToString(*message).find("123"));
+    }
+  }
+}
+
+// The plans of a registered pool are cached, and dropped when it's
+// unregistered, so that a new pool at the same address isn't printed by them.
+TEST(ProtobufMessageToStringTest, RegisteredPools) {
+  for (auto type : {google::protobuf::FieldDescriptorProto::TYPE_STRING,
+                    google::protobuf::FieldDescriptorProto::TYPE_INT32}) {
+    google::protobuf::DescriptorPool pool;
+    RegisterCacheableDescriptorPool(&pool);
+    const google::protobuf::Descriptor* descriptor =
+        BuildValueDescriptor(&pool, type);
+    ASSERT_TRUE(descriptor);
+    google::protobuf::DynamicMessageFactory factory(&pool);
+    DynamicProtobufMessage message;
+    message.Reset(factory.GetPrototype(descriptor)->New());
+    const google::protobuf::FieldDescriptor* field = descriptor->field(0);
+    google::protobuf::Message* mutable_message = message.message();
+    if (type == google::protobuf::FieldDescriptorProto::TYPE_STRING) {
+      mutable_message->GetReflection()->SetString(mutable_message, field,
+                                                  "abc");
+    } else {
+      mutable_message->GetReflection()->SetInt32(mutable_message, field, 123);
+    }
+    // Twice, the second of which is printed by the cached plan.
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_NE(std::string::npos,
+                message.ToString().find(
+                    type == google::protobuf::FieldDescriptorProto::TYPE_STRING
+                        ? "abc"
+                        : "123"));
+    }
+    // |message| has to be gone before |factory| and |pool|.
+    message.Reset(new TopicInfo());
+    UnregisterCacheableDescriptorPool(&pool);
+  }
+}
+
+TEST(FieldMaskFilterTest, Init) {
+  const google::protobuf::Descriptor* descriptor = TopicInfo::descriptor();
+  FieldMaskFilter filter;
+  EXPECT_TRUE(filter.Init(descriptor, {"topic", "topic_source.channel_defs"})
+                  .ok());
+  EXPECT_FALSE(filter.Init(descriptor, {"unknown"}).ok());
+  EXPECT_FALSE(filter.Init(descriptor, {"topic.size"}).ok());
+  EXPECT_FALSE(filter.Init(descriptor, {""}).ok());
+}
+
+TEST(FieldMaskFilterTest, Filter) {
+  TopicInfo topic_info = MakeTopicInfo();
+  std::string serialized;
+  ASSERT_TRUE(topic_info.SerializeToString(&serialized));
+
+  FieldMaskFilter filter;
+  ASSERT_TRUE(filter
+                  .Init(TopicInfo::descriptor(),
+                        {"topic", "topic_source.channel_defs.type"})
+                  .ok());
+  std::string filtered;
+  ASSERT_TRUE(filter.Filter(serialized.data(), serialized.length(), &filtered));
+
+  TopicInfo expected;
+  expected.set_topic(topic_info.topic());
+  for (int i = 0; i < 2; ++i) {
+    expected.mutable_topic_source()->add_channel_defs()->set_type(
+        ChannelDef::CHANNEL_TYPE_TCP);
+  }
+  TopicInfo parsed;
+  ASSERT_TRUE(parsed.ParseFromString(filtered));
+  EXPECT_EQ(expected.SerializeAsString(), parsed.SerializeAsString());
+
+  // A shorter path keeps the whole field.
+  ASSERT_TRUE(
+      filter.Init(TopicInfo::descriptor(), {"topic_source.channel_defs.type",
+                                            "topic_source"})
+          .ok());
+  ASSERT_TRUE(filter.Filter(serialized.data(), serialized.length(), &filtered));
+  ASSERT_TRUE(parsed.ParseFromString(filtered));
+  EXPECT_EQ(topic_info.topic_source().SerializeAsString(),
+            parsed.topic_source().SerializeAsString());
+  EXPECT_TRUE(parsed.topic().empty());
+
+  EXPECT_FALSE(filter.Filter(serialized.data(), serialized.length() - 1,
+                             &filtered));
+}
+
+TEST(FieldMaskFilterTest, LazyDynamicProtobufMessage) {
+  TopicInfo topic_info = MakeTopicInfo();
+  std::string serialized;
+  ASSERT_TRUE(topic_info.SerializeToString(&serialized));
+
+  DynamicProtobufMessage message;
+  message.Reset(topic_info.New());
+  ASSERT_TRUE(message.SetLazy({"topic"}).ok());
+  ASSERT_TRUE(message.ParseFromArray(serialized.data(), serialized.length()));
+
+  // Not parsed yet, the wire bytes are forwarded as they are.
+  std::string text;
+  ASSERT_TRUE(message.SerializeToString(&text));
+  EXPECT_EQ(serialized, text);
+
+  const DynamicProtobufMessage& const_message = message;
+  const TopicInfo* parsed =
+      static_cast<const TopicInfo*>(const_message.message());
+  EXPECT_EQ(topic_info.topic(), parsed->topic());
+  EXPECT_TRUE(parsed->type_name().empty());
+  EXPECT_EQ(0, parsed->topic_source().channel_defs_size());
+
+  // The lazy options are kept by the moved-from message, which parses the
+  // next message.
+  DynamicProtobufMessage moved = std::move(message);
+  EXPECT_TRUE(message.is_lazy());
+  ASSERT_TRUE(message.ParseFromArray(serialized.data(), serialized.length()));
+  EXPECT_EQ(topic_info.topic(),
+            static_cast<const TopicInfo*>(const_message.message())->topic());
+}
+
+TEST(FieldMaskFilterTest, LazyDynamicProtobufMessageFromView) {
+  TopicInfo topic_info = MakeTopicInfo();
+  std::string serialized;
+  ASSERT_TRUE(topic_info.SerializeToString(&serialized));
+  std::string text = serialized;
+  scoped_refptr<base::RefCountedString> buffer =
+      base::RefCountedString::TakeString(&text);
+
+  DynamicProtobufMessage message;
+  message.Reset(topic_info.New());
+  ASSERT_TRUE(message.SetLazy().ok());
+  ASSERT_TRUE(message.ParseFromView(buffer));
+  // It only takes a reference to the buffer.
+  EXPECT_FALSE(buffer->HasOneRef());
+
+  ASSERT_TRUE(message.SerializeToString(&text));
+  EXPECT_EQ(serialized, text);
+
+  // Copying takes another reference rather than copying the bytes.
+  DynamicProtobufMessage copied = message;
+  EXPECT_EQ(topic_info.SerializeAsString(),
+            copied.message()->SerializeAsString());
+
+  // Once it is accessed as mutable, it doesn't need the wire bytes anymore.
+  EXPECT_EQ(topic_info.SerializeAsString(),
+            message.message()->SerializeAsString());
+  EXPECT_TRUE(buffer->HasOneRef());
+
+  // If it's not lazy, it is parsed right away without keeping the buffer.
+  DynamicProtobufMessage eager;
+  eager.Reset(topic_info.New());
+  ASSERT_TRUE(eager.ParseFromView(buffer));
+  EXPECT_TRUE(buffer->HasOneRef());
+  EXPECT_EQ(topic_info.SerializeAsString(),
+            eager.message()->SerializeAsString());
+}
+
+}  // namespace protobuf
+}  // namespace felicia
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include "felicia/core/message/serialized_message.h"
 
+#include "third_party/chromium/base/logging.h"
+
 namespace felicia {
 
 SerializedMessage::SerializedMessage() = default;
@@ -14,39 +16,69 @@ SerializedMessage& SerializedMessage::operator=(
     const SerializedMessage& other) = default;
 
 SerializedMessage::SerializedMessage(SerializedMessage&& other) noexcept
-    : serialized_(std::move(other.serialized_)) {}
+    : serialized_(std::move(other.serialized_)),
+      buffer_(std::move(other.buffer_)),
+      view_(other.view_) {
+  other.view_.clear();
+}
 
 SerializedMessage& SerializedMessage::operator=(
     SerializedMessage&& other) noexcept {
   serialized_ = std::move(other.serialized_);
+  buffer_ = std::move(other.buffer_);
+  view_ = other.view_;
+  other.view_.clear();
   return *this;
 }
 
 SerializedMessage::~SerializedMessage() = default;
 
 void SerializedMessage::set_serialized(const std::string& serialized) {
+  buffer_ = nullptr;
+  view_.clear();
   serialized_ = serialized;
 }
 
 void SerializedMessage::set_serialized(std::string&& serialized) {
+  buffer_ = nullptr;
+  view_.clear();
   serialized_ = std::move(serialized);
 }
 
-const std::string& SerializedMessage::serialized() const& {
+void SerializedMessage::set_serialized_view(
+    scoped_refptr<base::RefCountedMemory> buffer) {
+  base::StringPiece view(buffer->front_as<char>(), buffer->size());
+  set_serialized_view(std::move(buffer), view);
+}
+
+void SerializedMessage::set_serialized_view(
+    scoped_refptr<base::RefCountedMemory> buffer, base::StringPiece view) {
+  DCHECK(buffer);
+  DCHECK_GE(view.data(), buffer->front_as<char>());
+  DCHECK_LE(view.data() + view.size(),
+            buffer->front_as<char>() + buffer->size());
+  serialized_.clear();
+  buffer_ = std::move(buffer);
+  view_ = view;
+}
+
+base::StringPiece SerializedMessage::serialized() const& {
+  if (is_view()) return view_;
   return serialized_;
 }
 
-std::string&& SerializedMessage::serialized() && {
+std::string SerializedMessage::serialized() && {
+  if (is_view()) return view_.as_string();
   return std::move(serialized_);
 }
 
 bool SerializedMessage::SerializeToString(std::string* text) const& {
-  *text = serialized_;
+  serialized().CopyToString(text);
   return true;
 }
 
 bool SerializedMessage::SerializeToString(std::string* text) && {
-  *text = std::move(serialized_);
+  *text = std::move(*this).serialized();
   return true;
 }
 
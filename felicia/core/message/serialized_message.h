@@ -5,6 +5,9 @@
 #ifndef FELICIA_CORE_MESSAGE_SERIALIZED_MESSAGE_H_
 #define FELICIA_CORE_MESSAGE_SERIALIZED_MESSAGE_H_
 
+#include "third_party/chromium/base/memory/ref_counted_memory.h"
+#include "third_party/chromium/base/strings/string_piece.h"
+
 #include "felicia/core/lib/base/export.h"
 #include "felicia/core/protobuf/master_data.pb.h"
 
@@ -12,6 +15,11 @@ namespace felicia {
 
 // This class is used from other than c++ side, when from the c++ side,
 // it doens't know how to serialize or deserialize the message.
+//
+// It either owns its serialized text, or refers to a ref-counted buffer which
+// is owned by someone else, e.g, a numpy array from python or the receive
+// buffer of a channel. Copying a view only takes a reference to the buffer,
+// so the buffer must not be modified while the view is alive.
 class FEL_EXPORT SerializedMessage {
  public:
   SerializedMessage();
@@ -24,14 +32,28 @@ class FEL_EXPORT SerializedMessage {
   void set_serialized(const std::string& serialized);
   void set_serialized(std::string&& serialized);
 
-  const std::string& serialized() const&;
-  std::string&& serialized() &&;
+  // Refers to the whole |buffer| without copying.
+  void set_serialized_view(scoped_refptr<base::RefCountedMemory> buffer);
+  // Refers to |view| without copying, which should lie in |buffer|.
+  void set_serialized_view(scoped_refptr<base::RefCountedMemory> buffer,
+                           base::StringPiece view);
+
+  bool is_view() const { return !!buffer_; }
+
+  // Returns a view of the serialized text, which is valid until this is
+  // modified or destroyed.
+  base::StringPiece serialized() const&;
+  // Moves the serialized text out if it owns it, otherwise it copies.
+  std::string serialized() &&;
 
   bool SerializeToString(std::string* text) const&;
   bool SerializeToString(std::string* text) &&;
 
  private:
   std::string serialized_;
+  // Set only when it is a view, and then |serialized_| is empty.
+  scoped_refptr<base::RefCountedMemory> buffer_;
+  base::StringPiece view_;
 };
 
 FEL_EXPORT std::ostream& operator<<(std::ostream& os,
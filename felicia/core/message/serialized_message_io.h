@@ -16,10 +16,12 @@ class MessageIO<T,
                 std::enable_if_t<std::is_same<T, SerializedMessage>::value>> {
  public:
   static MessageIOError Serialize(const T* serialized_msg, std::string* text) {
-    *text = serialized_msg->serialized();
+    serialized_msg->serialized().CopyToString(text);
     return MessageIOError::OK;
   }
 
+  // MessageReceiver doesn't go through this, but makes |serialized_msg| refer
+  // to its receive buffer. See DeserializeFromChannelBuffer().
   static MessageIOError Deserialize(const char* start, size_t size,
                                     T* serialized_msg) {
     serialized_msg->set_serialized(std::string(start, size));
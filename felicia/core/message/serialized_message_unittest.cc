@@ -0,0 +1,59 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/message/serialized_message.h"
+
+#include "gtest/gtest.h"
+
+namespace felicia {
+
+TEST(SerializedMessageTest, OwnedSerialized) {
+  SerializedMessage message;
+  message.set_serialized("serialized");
+  EXPECT_FALSE(message.is_view());
+  EXPECT_EQ("serialized", message.serialized());
+
+  SerializedMessage copied = message;
+  EXPECT_EQ("serialized", copied.serialized());
+  EXPECT_NE(message.serialized().data(), copied.serialized().data());
+
+  EXPECT_EQ("serialized", std::move(message).serialized());
+}
+
+TEST(SerializedMessageTest, SerializedView) {
+  std::string text = "some serialized text";
+  scoped_refptr<base::RefCountedString> buffer =
+      base::RefCountedString::TakeString(&text);
+  const char* data = buffer->front_as<char>();
+
+  SerializedMessage message;
+  message.set_serialized_view(buffer);
+  EXPECT_TRUE(message.is_view());
+  EXPECT_EQ(data, message.serialized().data());
+  EXPECT_EQ("some serialized text", message.serialized());
+
+  // Copying only takes a reference to the buffer.
+  SerializedMessage copied = message;
+  EXPECT_EQ(data, copied.serialized().data());
+  EXPECT_FALSE(buffer->HasOneRef());
+
+  copied.set_serialized_view(buffer, base::StringPiece(data + 5, 10));
+  EXPECT_EQ("serialized", copied.serialized());
+
+  SerializedMessage moved = std::move(message);
+  EXPECT_EQ(data, moved.serialized().data());
+  EXPECT_TRUE(message.serialized().empty());
+
+  std::string serialized;
+  ASSERT_TRUE(moved.SerializeToString(&serialized));
+  EXPECT_EQ("some serialized text", serialized);
+
+  // Owning text again drops the reference to the buffer.
+  moved.set_serialized("owned");
+  copied.set_serialized("owned");
+  EXPECT_FALSE(moved.is_view());
+  EXPECT_TRUE(buffer->HasOneRef());
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -40,6 +40,12 @@ void DynamicSubscribingNode::OnError(Status s) {
   }
 }
 
+void DynamicSubscribingNode::SetLazy(
+    const std::vector<std::string>& field_mask) {
+  lazy_ = true;
+  field_mask_ = field_mask;
+}
+
 void DynamicSubscribingNode::RequestSubscribe(
     const std::string& topic, const communication::Settings& settings) {
   if (subscribers_.find(topic) != subscribers_.end()) {
@@ -49,6 +55,7 @@ void DynamicSubscribingNode::RequestSubscribe(
   }
 
   auto subscriber = std::make_unique<DynamicSubscriber>();
+  if (lazy_) subscriber->SetLazy(field_mask_);
 
   subscriber->RequestSubscribe(
       node_info_, topic, AllChannelTypes(), settings,
@@ -115,6 +122,7 @@ void DynamicSubscribingNode::Subscribe(
   }
 
   auto subscriber = std::make_unique<DynamicSubscriber>();
+  if (lazy_) subscriber->SetLazy(field_mask_);
 
   subscriber->Subscribe(
       settings,
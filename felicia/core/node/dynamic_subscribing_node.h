@@ -59,6 +59,10 @@ class FEL_EXPORT DynamicSubscribingNode : public NodeLifecycle {
 
   void OnError(Status s) override;
 
+  // Applies DynamicSubscriber::SetLazy() to the topics subscribed afterwards.
+  void SetLazy(const std::vector<std::string>& field_mask =
+                   std::vector<std::string>());
+
   // For OneTopicDelegate
   void RequestSubscribe(const std::string& topic,
                         const communication::Settings& settings);
@@ -86,6 +90,8 @@ class FEL_EXPORT DynamicSubscribingNode : public NodeLifecycle {
   std::unique_ptr<OneTopicDelegate> one_topic_delegate_;
   std::unique_ptr<MultiTopicDelegate> multi_topic_delegate_;
   NodeInfo node_info_;
+  bool lazy_ = false;
+  std::vector<std::string> field_mask_;
   base::flat_map<std::string, std::unique_ptr<DynamicSubscriber>> subscribers_;
 
   DISALLOW_COPY_AND_ASSIGN(DynamicSubscribingNode);
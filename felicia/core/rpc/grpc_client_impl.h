@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef FELIICA_CORE_RPC_GRPC_CLIENT_IMPL_H_
 #define FELIICA_CORE_RPC_GRPC_CLIENT_IMPL_H_
 
+#include <atomic>
 #include <memory>
 
 #include "grpcpp/grpcpp.h"
@@ -63,7 +64,8 @@ class FEL_GRPC_CLIENT : public ClientInterface {
 
   void WaitUntilShutdown() { threads_.clear(); }
 
-  void HandleRpcsLoop();
+  // Poll the |index|-th completion queue.
+  void HandleRpcsLoop(size_t index = 0);
 
  protected:
   typedef typename GrpcService::Stub Stub;
@@ -71,11 +73,18 @@ class FEL_GRPC_CLIENT : public ClientInterface {
   virtual std::shared_ptr<::grpc::Channel> ConnectToGrpcServer(
       const std::string& ip, uint16_t port);
 
-  void RunRpcsLoops(int num_threads);
+  // Run |num_threads| threads polling each of |num_completion_queues|
+  // completion queues. Calls are distributed over the completion queues in a
+  // round robin fashion. This should be called before any calls are made.
+  void RunRpcsLoops(int num_threads, int num_completion_queues = 1);
   void ShutdownClient();
 
+  // Returns the completion queue where the next call is going to be queued.
+  ::grpc::CompletionQueue* NextCompletionQueue();
+
   std::unique_ptr<Stub> stub_;
-  std::unique_ptr<::grpc::CompletionQueue> cq_;
+  std::vector<std::unique_ptr<::grpc::CompletionQueue>> cqs_;
+  std::atomic<size_t> next_cq_index_{0};
   std::vector<std::unique_ptr<base::Thread>> threads_;
 
   DISALLOW_COPY_AND_ASSIGN(Client);
@@ -83,23 +92,26 @@ class FEL_GRPC_CLIENT : public ClientInterface {
 
 template <typename T>
 FEL_GRPC_CLIENT::Client(std::shared_ptr<::grpc::Channel> channel)
-    : stub_(GrpcService::NewStub(channel)),
-      cq_(std::make_unique<::grpc::CompletionQueue>()) {}
+    : stub_(GrpcService::NewStub(channel)) {
+  cqs_.push_back(std::make_unique<::grpc::CompletionQueue>());
+}
 
 template <typename T>
 void FEL_GRPC_CLIENT::Connect(const IPEndPoint& ip_endpoint,
                               StatusOnceCallback callback) {
   auto channel = ConnectToGrpcServer(ip_endpoint.ip(), ip_endpoint.port());
   stub_ = GrpcService::NewStub(channel);
-  cq_ = std::make_unique<::grpc::CompletionQueue>();
+  cqs_.clear();
+  cqs_.push_back(std::make_unique<::grpc::CompletionQueue>());
   std::move(callback).Run(Status::OK());
 }
 
 template <typename T>
-void FEL_GRPC_CLIENT::HandleRpcsLoop() {
+void FEL_GRPC_CLIENT::HandleRpcsLoop(size_t index) {
+  ::grpc::CompletionQueue* cq = cqs_[index].get();
   void* tag;
   bool ok;
-  while (cq_->Next(&tag, &ok)) {
+  while (cq->Next(&tag, &ok)) {
     GrpcClientCQTag* callback_tag = static_cast<GrpcClientCQTag*>(tag);
     callback_tag->OnCompleted(ok);
   }
@@ -122,27 +134,42 @@ std::shared_ptr<::grpc::Channel> FEL_GRPC_CLIENT::ConnectToGrpcServer(
 }
 
 template <typename T>
-void FEL_GRPC_CLIENT::RunRpcsLoops(int num_threads) {
-  for (int i = 0; i < num_threads; ++i) {
-    threads_.push_back(std::make_unique<base::Thread>(
-        base::StringPrintf("%s RPC Loop%d", service_name().c_str(), (i + 1))));
+void FEL_GRPC_CLIENT::RunRpcsLoops(int num_threads,
+                                   int num_completion_queues) {
+  DCHECK_GT(num_completion_queues, 0);
+  while (cqs_.size() < static_cast<size_t>(num_completion_queues)) {
+    cqs_.push_back(std::make_unique<::grpc::CompletionQueue>());
   }
 
-  std::for_each(threads_.begin(), threads_.end(),
-                [this](const std::unique_ptr<base::Thread>& thread) {
-                  thread->Start();
-                  thread->task_runner()->PostTask(
-                      FROM_HERE, base::BindOnce(&Client::HandleRpcsLoop,
-                                                base::Unretained(this)));
-                });
+  for (size_t i = 0; i < cqs_.size(); ++i) {
+    for (int j = 0; j < num_threads; ++j) {
+      auto thread = std::make_unique<base::Thread>(
+          base::StringPrintf("%s RPC Loop%d", service_name().c_str(),
+                             static_cast<int>(threads_.size() + 1)));
+      thread->Start();
+      thread->task_runner()->PostTask(
+          FROM_HERE, base::BindOnce(&Client::HandleRpcsLoop,
+                                    base::Unretained(this), i));
+      threads_.push_back(std::move(thread));
+    }
+  }
 }
 
 template <typename T>
 void FEL_GRPC_CLIENT::ShutdownClient() {
-  cq_->Shutdown();
+  for (auto& cq : cqs_) {
+    cq->Shutdown();
+  }
   threads_.clear();
 }
 
+template <typename T>
+::grpc::CompletionQueue* FEL_GRPC_CLIENT::NextCompletionQueue() {
+  if (cqs_.size() == 1) return cqs_[0].get();
+  size_t index = next_cq_index_.fetch_add(1, std::memory_order_relaxed);
+  return cqs_[index % cqs_.size()].get();
+}
+
 #define FEL_GRPC_CLIENT_METHOD_DECLARE(method)       \
   void method##Async(const method##Request* request, \
                      method##Response* response, StatusOnceCallback done)
@@ -153,7 +180,7 @@ void FEL_GRPC_CLIENT::ShutdownClient() {
                             StatusOnceCallback done) {                \
     new GrpcAsyncClientCall<Stub, method##Request, method##Response>( \
         stub_.get(), request, response, &Stub::PrepareAsync##method,  \
-        cq_.get(), std::move(done));                                  \
+        NextCompletionQueue(), std::move(done));                      \
   }
 
 }  // namespace rpc
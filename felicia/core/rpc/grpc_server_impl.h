@@ -54,6 +54,8 @@ class FEL_GRPC_SERVER : public ServerInterface {
  protected:
   virtual Status RegisterService(::grpc::ServerBuilder* builder) = 0;
 
+  // Run |num_threads| threads polling each of the completion queues of
+  // |service_|.
   void RunRpcsLoops(int num_threads);
   void ShutdownServer();
 
@@ -83,19 +85,19 @@ Status FEL_GRPC_SERVER::Start() {
 
 template <typename T>
 void FEL_GRPC_SERVER::RunRpcsLoops(int num_threads) {
-  for (int i = 0; i < num_threads; ++i) {
-    threads_.push_back(std::make_unique<base::Thread>(base::StringPrintf(
-        "%s RPC Loop%d", Service::service_name().c_str(), (i + 1))));
+  int num_completion_queues = service_->num_completion_queues();
+  for (int i = 0; i < num_completion_queues; ++i) {
+    for (int j = 0; j < num_threads; ++j) {
+      auto thread = std::make_unique<base::Thread>(base::StringPrintf(
+          "%s RPC Loop%d", Service::service_name().c_str(),
+          static_cast<int>(threads_.size() + 1)));
+      thread->Start();
+      thread->task_runner()->PostTask(
+          FROM_HERE, base::BindOnce(&Service::HandleRpcsLoop,
+                                    base::Unretained(service_.get()), i));
+      threads_.push_back(std::move(thread));
+    }
   }
-
-  std::for_each(threads_.begin(), threads_.end(),
-                [this](const std::unique_ptr<base::Thread>& thread) {
-                  thread->Start();
-                  thread->task_runner()->PostTask(
-                      FROM_HERE,
-                      base::BindOnce(&Service::HandleRpcsLoop,
-                                     base::Unretained(service_.get())));
-                });
 }
 
 template <typename T>
@@ -21,6 +21,7 @@ limitations under the License.
 #include "third_party/chromium/base/bind.h"
 #include "third_party/chromium/base/synchronization/lock.h"
 #include "third_party/chromium/base/thread_annotations.h"
+#include "third_party/chromium/base/threading/thread_local.h"
 
 #include "felicia/core/lib/error/status.h"
 #include "felicia/core/rpc/grpc_call.h"
@@ -38,11 +39,19 @@ class FEL_GRPC_SERVICE {
 
   static std::string service_name() { return GrpcService::service_full_name(); }
 
-  explicit Service(::grpc::ServerBuilder* builder);
+  // Requests are spread over |num_completion_queues| completion queues, each
+  // of which can be polled by several threads.
+  explicit Service(::grpc::ServerBuilder* builder,
+                   int num_completion_queues = 1);
   virtual ~Service() = default;
 
+  int num_completion_queues() const {
+    return static_cast<int>(cqs_.size());
+  }
+
   void Shutdown();
-  void HandleRpcsLoop();
+  // Poll the |index|-th completion queue.
+  void HandleRpcsLoop(int index = 0);
 
  protected:
   typedef typename GrpcService::AsyncService GrpcAsyncService;
@@ -59,19 +68,28 @@ class FEL_GRPC_SERVICE {
     call->SendResponse(ToGrpcStatus(std::move(status)));
   }
 
-  std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
+  // Returns the completion queue which the current thread is polling. The
+  // requests are enqueued again to the completion queue where they came from.
+  ::grpc::ServerCompletionQueue* current_cq() { return current_cq_.Get(); }
+
+  std::vector<std::unique_ptr<::grpc::ServerCompletionQueue>> cqs_;
+  base::ThreadLocalPointer<::grpc::ServerCompletionQueue> current_cq_;
   GrpcAsyncService async_service_;
 
   base::Lock lock_;
   bool is_shutdown_ GUARDED_BY(lock_);
-  ::grpc::Alarm* shutdown_alarm_ = nullptr;
+  std::vector<std::unique_ptr<::grpc::Alarm>> shutdown_alarms_;
 };
 
 template <typename T>
-FEL_GRPC_SERVICE::Service(::grpc::ServerBuilder* builder)
+FEL_GRPC_SERVICE::Service(::grpc::ServerBuilder* builder,
+                          int num_completion_queues)
     : is_shutdown_(false) {
+  DCHECK_GT(num_completion_queues, 0);
   builder->RegisterService(&async_service_);
-  cq_ = builder->AddCompletionQueue();
+  for (int i = 0; i < num_completion_queues; ++i) {
+    cqs_.push_back(builder->AddCompletionQueue());
+  }
 }
 
 template <typename T>
@@ -89,27 +107,32 @@ void FEL_GRPC_SERVICE::Shutdown() {
     // NOTE(mrry): This enqueues a special event (with a null tag)
     // that causes the completion queue to be shut down on the
     // polling thread.
-    shutdown_alarm_ =
-        new ::grpc::Alarm(cq_.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
+    for (auto& cq : cqs_) {
+      shutdown_alarms_.push_back(std::make_unique<::grpc::Alarm>(
+          cq.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr));
+    }
   }
 }
 
 template <typename T>
-void FEL_GRPC_SERVICE::HandleRpcsLoop() {
+void FEL_GRPC_SERVICE::HandleRpcsLoop(int index) {
   typedef typename UntypedCall<FEL_GRPC_SERVICE>::Tag Tag;
+  ::grpc::ServerCompletionQueue* cq = cqs_[index].get();
+  current_cq_.Set(cq);
   void* tag;
   bool ok;
   EnqueueRequests();
-  while (cq_->Next(&tag, &ok)) {
+  while (cq->Next(&tag, &ok)) {
     Tag* callback_tag = static_cast<Tag*>(tag);
     if (callback_tag) {
       callback_tag->OnCompleted(this, ok);
     } else {
       // NOTE(mrry): A null `callback_tag` indicates that this is
       // the shutdown alarm.
-      cq_->Shutdown();
+      cq->Shutdown();
     }
   }
+  current_cq_.Set(nullptr);
 }
 
 #define FEL_ENQUEUE_REQUEST(clazz, method, supports_cancel)               \
@@ -117,8 +140,9 @@ void FEL_GRPC_SERVICE::HandleRpcsLoop() {
     base::AutoLock l(lock_);                                              \
     if (!is_shutdown_) {                                                  \
       GrpcCall<clazz, method##Request, method##Response>::EnqueueRequest( \
-          &async_service_, cq_.get(), &GrpcAsyncService::Request##method, \
-          &clazz::Handle##method, supports_cancel);                       \
+          &async_service_, current_cq(),                                  \
+          &GrpcAsyncService::Request##method, &clazz::Handle##method,     \
+          supports_cancel);                                               \
     }                                                                     \
   } while (0)
 
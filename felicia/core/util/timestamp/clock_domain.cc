@@ -0,0 +1,118 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/util/timestamp/clock_domain.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/numerics/ranges.h"
+
+namespace felicia {
+
+constexpr size_t ClockDomain::kDefaultSamplesPerBucket;
+constexpr size_t ClockDomain::kDefaultNumBuckets;
+constexpr double ClockDomain::kMaxDrift;
+
+ClockDomain::ClockDomain(size_t samples_per_bucket, size_t num_buckets)
+    : samples_per_bucket_(samples_per_bucket), num_buckets_(num_buckets) {
+  DCHECK_GT(samples_per_bucket_, 0u);
+  DCHECK_GE(num_buckets_, 2u);
+}
+
+ClockDomain::~ClockDomain() = default;
+
+base::TimeTicks ClockDomain::Update(base::TimeDelta device_time,
+                                    base::TimeTicks host_time) {
+  if (has_estimate() &&
+      (device_time - device_base_).InMicrosecondsF() < last_device_) {
+    DLOG(WARNING) << "Device clock went backwards, reset the clock domain.";
+    Reset();
+  }
+  if (!has_estimate()) {
+    device_base_ = device_time;
+    host_base_ = host_time;
+  }
+
+  Sample sample = {(device_time - device_base_).InMicrosecondsF(),
+                   (host_time - host_base_).InMicrosecondsF()};
+  last_device_ = sample.device;
+  num_samples_++;
+  if (num_current_samples_ == 0 ||
+      sample.host - sample.device < current_.host - current_.device) {
+    current_ = sample;
+  }
+  num_current_samples_++;
+
+  Estimate();
+  base::TimeTicks mapped = std::min(ToHostTime(device_time), host_time);
+
+  if (num_current_samples_ == samples_per_bucket_) {
+    if (buckets_.size() == num_buckets_) buckets_.pop_front();
+    buckets_.push_back(current_);
+    num_current_samples_ = 0;
+  }
+  return mapped;
+}
+
+base::TimeTicks ClockDomain::ToHostTime(base::TimeDelta device_time) const {
+  DCHECK(has_estimate());
+  const double device = (device_time - device_base_).InMicrosecondsF();
+  return host_base_ +
+         base::TimeDelta::FromMicrosecondsD(offset_ + skew_ * device);
+}
+
+void ClockDomain::Reset() {
+  buckets_.clear();
+  num_current_samples_ = 0;
+  num_samples_ = 0;
+  last_device_ = 0;
+  skew_ = 1.0;
+  offset_ = 0;
+}
+
+void ClockDomain::Estimate() {
+  // The bucket being filled is fitted only until there are enough buckets,
+  // since it may not have seen a low latency sample yet.
+  const bool fit_current = buckets_.size() < 2;
+  auto for_each_sample = [this, fit_current](auto callback) {
+    for (const Sample& sample : buckets_) callback(sample);
+    if (fit_current) callback(current_);
+  };
+  const size_t num_samples = buckets_.size() + (fit_current ? 1 : 0);
+
+  // Least squares fit of the host time against the device time.
+  if (num_samples >= 2) {
+    double mean_device = 0;
+    double mean_host = 0;
+    for_each_sample([&](const Sample& sample) {
+      mean_device += sample.device;
+      mean_host += sample.host;
+    });
+    mean_device /= num_samples;
+    mean_host /= num_samples;
+
+    double covariance = 0;
+    double variance = 0;
+    for_each_sample([&](const Sample& sample) {
+      const double device = sample.device - mean_device;
+      covariance += device * (sample.host - mean_host);
+      variance += device * device;
+    });
+    if (variance > 0) {
+      skew_ = base::ClampToRange(covariance / variance, 1.0 - kMaxDrift,
+                                 1.0 + kMaxDrift);
+    }
+  }
+
+  // The sample received with the least latency is the closest to the true
+  // offset.
+  offset_ = current_.host - skew_ * current_.device;
+  for (const Sample& sample : buckets_) {
+    offset_ = std::min(offset_, sample.host - skew_ * sample.device);
+  }
+}
+
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,90 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_CORE_UTIL_TIMESTAMP_CLOCK_DOMAIN_H_
+#define FELICIA_CORE_UTIL_TIMESTAMP_CLOCK_DOMAIN_H_
+
+#include "third_party/chromium/base/containers/circular_deque.h"
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/lib/base/export.h"
+
+namespace felicia {
+
+// Maps timestamps by a device's own clock, e.g, the counter of an IMU or a
+// lidar, to base::TimeTicks of the host. A device clock starts from its own
+// epoch and runs slightly faster or slower than the host's, so it is
+// estimated as host = offset + skew * device.
+//
+// Every sample pairs the device timestamp of a measurement with the time the
+// host received it, which is later by the transport latency. Only the sample
+// with the least latency out of every |samples_per_bucket| samples is kept,
+// which is the closest to the true mapping. The skew is fitted over the last
+// |num_buckets| of them, so it spans long enough to see the drift, and the
+// offset follows the least latency among them. If the device clock goes
+// backwards, e.g, the device is reset, the estimate starts over.
+//
+// Drivers stamp a measurement with it and Timestamper:
+//
+//   base::TimeTicks host_time =
+//       clock_domain_.Update(device_time, base::TimeTicks::Now());
+//   base::TimeDelta timestamp = timestamper_.timestamp(host_time);
+class FEL_EXPORT ClockDomain {
+ public:
+  static constexpr size_t kDefaultSamplesPerBucket = 64;
+  static constexpr size_t kDefaultNumBuckets = 32;
+  // Crystals are within a few hundreds ppm. A larger skew means the samples
+  // are too few or too noisy to trust.
+  static constexpr double kMaxDrift = 1e-3;
+
+  explicit ClockDomain(size_t samples_per_bucket = kDefaultSamplesPerBucket,
+                       size_t num_buckets = kDefaultNumBuckets);
+  ~ClockDomain();
+
+  // Adds a sample and returns |device_time| in the host clock, which is never
+  // later than |host_time|.
+  base::TimeTicks Update(base::TimeDelta device_time,
+                         base::TimeTicks host_time);
+
+  // Returns |device_time| in the host clock with the current estimate. It
+  // must be called after |Update()|.
+  base::TimeTicks ToHostTime(base::TimeDelta device_time) const;
+
+  bool has_estimate() const { return num_samples_ > 0; }
+  // How fast the device clock runs compared to the host clock, 1.0 if the
+  // drift is not estimated yet.
+  double skew() const { return skew_; }
+
+  void Reset();
+
+ private:
+  // In microseconds since |device_base_| and |host_base_|.
+  struct Sample {
+    double device;
+    double host;
+  };
+
+  void Estimate();
+
+  const size_t samples_per_bucket_;
+  const size_t num_buckets_;
+  base::TimeDelta device_base_;
+  base::TimeTicks host_base_;
+  // The least latency samples of the last |num_buckets_| buckets.
+  base::circular_deque<Sample> buckets_;
+  // The least latency sample of the bucket being filled.
+  Sample current_;
+  size_t num_current_samples_ = 0;
+  size_t num_samples_ = 0;
+  double last_device_ = 0;
+  double skew_ = 1.0;
+  double offset_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ClockDomain);
+};
+
+}  // namespace felicia
+
+#endif  // FELICIA_CORE_UTIL_TIMESTAMP_CLOCK_DOMAIN_H_
\ No newline at end of file
@@ -0,0 +1,114 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/core/util/timestamp/clock_domain.h"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "felicia/core/util/timestamp/timestamper.h"
+
+namespace felicia {
+
+namespace {
+
+// A device which runs |drift| faster than the host, and whose measurements
+// arrive after |min_latency| plus up to |max_jitter|.
+class SyntheticDevice {
+ public:
+  SyntheticDevice(base::TimeDelta period, double drift,
+                  base::TimeDelta min_latency, base::TimeDelta max_jitter)
+      : period_(period),
+        skew_(1.0 / (1.0 + drift)),
+        min_latency_(min_latency),
+        jitter_(0, max_jitter.InMicrosecondsF()),
+        host_base_(base::TimeTicks() + base::TimeDelta::FromSeconds(100)),
+        device_base_(base::TimeDelta::FromSeconds(12345)) {}
+
+  // Moves to the next measurement.
+  void Next() {
+    ++count_;
+    latency_ = min_latency_ +
+               base::TimeDelta::FromMicrosecondsD(jitter_(generator_));
+  }
+
+  base::TimeDelta device_time() const {
+    return device_base_ + period_ * count_;
+  }
+  // When the measurement was taken.
+  base::TimeTicks true_host_time() const {
+    return host_base_ +
+           base::TimeDelta::FromMicrosecondsD(
+               (period_ * count_).InMicrosecondsF() * skew_);
+  }
+  // When the host received it.
+  base::TimeTicks arrival_time() const { return true_host_time() + latency_; }
+
+  double skew() const { return skew_; }
+
+ private:
+  base::TimeDelta period_;
+  double skew_;
+  base::TimeDelta min_latency_;
+  std::mt19937 generator_{1234};
+  std::uniform_real_distribution<double> jitter_;
+  base::TimeTicks host_base_;
+  base::TimeDelta device_base_;
+  int64_t count_ = 0;
+  base::TimeDelta latency_;
+};
+
+}  // namespace
+
+TEST(ClockDomainTest, FiltersJitterAndDrift) {
+  const base::TimeDelta min_latency = base::TimeDelta::FromMilliseconds(1);
+  // 200Hz with 200ppm drift, arriving with up to 4ms of jitter.
+  SyntheticDevice device(base::TimeDelta::FromMilliseconds(5), 200e-6,
+                         min_latency, base::TimeDelta::FromMilliseconds(4));
+  ClockDomain clock_domain;
+
+  base::TimeDelta max_error;
+  for (int i = 0; i < 2000; ++i) {
+    device.Next();
+    base::TimeTicks host_time =
+        clock_domain.Update(device.device_time(), device.arrival_time());
+    EXPECT_LE(host_time, device.arrival_time());
+    // Skip the warm up.
+    if (i < 256) continue;
+    // The least latency can't be told from the offset.
+    max_error = std::max(
+        max_error,
+        (host_time - device.true_host_time() - min_latency).magnitude());
+  }
+  EXPECT_LT(max_error, base::TimeDelta::FromMicroseconds(200));
+  EXPECT_NEAR(device.skew(), clock_domain.skew(), 10e-6);
+}
+
+TEST(ClockDomainTest, StartsOverWhenDeviceClockGoesBackwards) {
+  ClockDomain clock_domain;
+  base::TimeTicks host_time =
+      base::TimeTicks() + base::TimeDelta::FromSeconds(1);
+  for (int i = 0; i < 10; ++i) {
+    clock_domain.Update(base::TimeDelta::FromMilliseconds(1000 + i * 10),
+                        host_time + base::TimeDelta::FromMilliseconds(i * 10));
+  }
+
+  host_time += base::TimeDelta::FromSeconds(1);
+  EXPECT_EQ(host_time, clock_domain.Update(base::TimeDelta(), host_time));
+  EXPECT_EQ(1.0, clock_domain.skew());
+  EXPECT_EQ(host_time + base::TimeDelta::FromMilliseconds(10),
+            clock_domain.ToHostTime(base::TimeDelta::FromMilliseconds(10)));
+}
+
+TEST(ClockDomainTest, Timestamper) {
+  Timestamper timestamper;
+  base::TimeTicks now = base::TimeTicks::Now();
+  EXPECT_EQ(base::TimeDelta(), timestamper.timestamp(now));
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(5),
+            timestamper.timestamp(now + base::TimeDelta::FromMilliseconds(5)));
+  EXPECT_LE(base::TimeDelta(), timestamper.timestamp());
+}
+
+}  // namespace felicia
\ No newline at end of file
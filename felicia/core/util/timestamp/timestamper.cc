@@ -11,12 +11,15 @@ Timestamper::Timestamper() = default;
 Timestamper::~Timestamper() = default;
 
 base::TimeDelta Timestamper::timestamp() {
-  const base::TimeTicks now = base::TimeTicks::Now();
+  return timestamp(base::TimeTicks::Now());
+}
+
+base::TimeDelta Timestamper::timestamp(base::TimeTicks time) {
   if (base_time_ref_.is_null()) {
-    base_time_ref_ = now;
+    base_time_ref_ = time;
   }
 
-  return now - base_time_ref_;
+  return time - base_time_ref_;
 }
 
 ThreadSafeTimestamper::ThreadSafeTimestamper() = default;
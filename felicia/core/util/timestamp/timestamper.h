@@ -20,6 +20,10 @@ class FEL_EXPORT Timestamper {
   ~Timestamper();
 
   base::TimeDelta timestamp();
+  // Returns |time| relative to the same base as |timestamp()|, e.g, when a
+  // driver stamps frames with the host clock on its own or through
+  // ClockDomain.
+  base::TimeDelta timestamp(base::TimeTicks time);
 
  protected:
   base::TimeTicks base_time_ref_;
@@ -18,5 +18,23 @@ size_t CameraBuffer::payload() const { return payload_; }
 void CameraBuffer::set_payload(size_t payload) { payload_ = payload; }
 size_t CameraBuffer::length() const { return length_; }
 
+LentCameraBuffer::LentCameraBuffer(const uint8_t* data, size_t size,
+                                   base::OnceClosure release_callback)
+    : data_(data),
+      size_(size),
+      release_callback_(std::move(release_callback)) {}
+
+LentCameraBuffer::~LentCameraBuffer() {
+  if (!release_callback_.is_null()) std::move(release_callback_).Run();
+}
+
+const unsigned char* LentCameraBuffer::front() const { return data_; }
+
+size_t LentCameraBuffer::size() const { return size_; }
+
+int LentCameraBuffer::dmabuf_fd() const { return dmabuf_fd_; }
+
+void LentCameraBuffer::set_dmabuf_fd(int dmabuf_fd) { dmabuf_fd_ = dmabuf_fd; }
+
 }  // namespace drivers
 }  // namespace felicia
@@ -10,6 +10,10 @@
 
 #include <vector>
 
+#include "third_party/chromium/base/callback.h"
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/memory/ref_counted_memory.h"
+
 #include "felicia/core/lib/base/export.h"
 
 namespace felicia {
@@ -33,6 +37,38 @@ class FEL_EXPORT CameraBuffer {
   size_t length_;
 };
 
+// A buffer which a camera driver lends to CameraFrame instead of copying it
+// out. |release_callback| is called when the last reference is dropped, on
+// whichever thread drops it, and that's when the driver gets the buffer
+// back. So a lent buffer must be released as soon as possible, otherwise the
+// driver runs out of buffers and falls back to copying.
+class FEL_EXPORT LentCameraBuffer : public base::RefCountedMemory {
+ public:
+  LentCameraBuffer(const uint8_t* data, size_t size,
+                   base::OnceClosure release_callback);
+
+  // base::RefCountedMemory methods
+  const unsigned char* front() const override;
+  size_t size() const override;
+
+  // A DMABUF file descriptor of the buffer if the driver exported it,
+  // otherwise -1. It is owned by the driver and valid as long as this is
+  // alive, so that it can be handed to a device or to another process
+  // without a copy on the CPU.
+  int dmabuf_fd() const;
+  void set_dmabuf_fd(int dmabuf_fd);
+
+ private:
+  ~LentCameraBuffer() override;
+
+  const uint8_t* data_;
+  size_t size_;
+  int dmabuf_fd_ = -1;
+  base::OnceClosure release_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(LentCameraBuffer);
+};
+
 }  // namespace drivers
 }  // namespace felicia
 
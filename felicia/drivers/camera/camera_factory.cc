@@ -9,6 +9,8 @@
 
 #if !defined(OS_MACOSX)
 #include "felicia/core/lib/felicia_env.h"
+#include "felicia/drivers/camera/file_camera.h"
+#include "felicia/drivers/camera/synthetic_camera.h"
 #if defined(OS_LINUX)
 #include "felicia/drivers/camera/linux/v4l2_camera.h"
 using Camera = felicia::drivers::V4l2Camera;
@@ -29,6 +31,11 @@ namespace drivers {
 // static
 std::unique_ptr<CameraInterface> CameraFactory::NewCamera(
     const CameraDescriptor& descriptor) {
+  if (SyntheticCamera::IsSyntheticCamera(descriptor)) {
+    return base::WrapUnique(new SyntheticCamera(descriptor));
+  } else if (FileCamera::IsFileCamera(descriptor)) {
+    return base::WrapUnique(new FileCamera(descriptor));
+  }
 #if defined(OS_WIN) && !BUILDFLAG(TRAVIS)
   if (MfCamera::PlatformSupportsMediaFoundation()) {
     return base::WrapUnique(new MfCamera(descriptor));
@@ -59,6 +66,13 @@ Status CameraFactory::GetCameraDescriptors(
 Status CameraFactory::GetSupportedCameraFormats(
     const CameraDescriptor& camera_descriptor, CameraFormats* camera_formats) {
   DCHECK(camera_formats->empty());
+  if (SyntheticCamera::IsSyntheticCamera(camera_descriptor)) {
+    return SyntheticCamera::GetSupportedCameraFormats(camera_descriptor,
+                                                      camera_formats);
+  } else if (FileCamera::IsFileCamera(camera_descriptor)) {
+    return FileCamera::GetSupportedCameraFormats(camera_descriptor,
+                                                 camera_formats);
+  }
 #if defined(OS_WIN) && !BUILDFLAG(TRAVIS)
   if (MfCamera::PlatformSupportsMediaFoundation()) {
     return MfCamera::GetSupportedCameraFormats(camera_descriptor,
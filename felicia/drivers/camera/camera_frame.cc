@@ -4,11 +4,10 @@
 
 #include "felicia/drivers/camera/camera_frame.h"
 
-#include "libyuv.h"
 #include "third_party/chromium/base/logging.h"
 
 #include "felicia/core/lib/unit/time_util.h"
-#include "felicia/drivers/camera/camera_frame_util.h"
+#include "felicia/drivers/camera/pixel_format_converter.h"
 
 namespace felicia {
 namespace drivers {
@@ -37,13 +36,22 @@ CameraFrame::CameraFrame(Image&& image, float frame_rate,
                   CameraFormat{image.size(), image.pixel_format(), frame_rate},
                   timestamp) {}
 
+CameraFrame::CameraFrame(scoped_refptr<LentCameraBuffer> lent_buffer,
+                         const CameraFormat& camera_format,
+                         base::TimeDelta timestamp)
+    : lent_buffer_(std::move(lent_buffer)),
+      camera_format_(camera_format),
+      timestamp_(timestamp) {}
+
 CameraFrame::CameraFrame(const CameraFrame& other)
     : data_(other.data_),
+      lent_buffer_(other.lent_buffer_),
       camera_format_(other.camera_format_),
       timestamp_(other.timestamp_) {}
 
 CameraFrame::CameraFrame(CameraFrame&& other) noexcept
     : data_(std::move(other.data_)),
+      lent_buffer_(std::move(other.lent_buffer_)),
       camera_format_(other.camera_format_),
       timestamp_(other.timestamp_) {}
 
@@ -52,11 +60,36 @@ CameraFrame& CameraFrame::operator=(CameraFrame&& other) = default;
 
 CameraFrame::~CameraFrame() = default;
 
-const Data& CameraFrame::data() const { return data_; }
+const Data& CameraFrame::data() const {
+  CHECK(!lent_buffer_) << "Call Materialize() or use raw_data().";
+  return data_;
+}
 
-Data& CameraFrame::data() { return data_; }
+Data& CameraFrame::data() {
+  Materialize();
+  return data_;
+}
 
-size_t CameraFrame::length() const { return data_.size(); }
+const uint8_t* CameraFrame::raw_data() const {
+  if (lent_buffer_) return lent_buffer_->front();
+  return data_.cast<const uint8_t*>();
+}
+
+size_t CameraFrame::length() const {
+  if (lent_buffer_) return lent_buffer_->size();
+  return data_.size();
+}
+
+void CameraFrame::Materialize() {
+  if (!lent_buffer_) return;
+  data_ = Data::CopyFromPool(lent_buffer_->front(), lent_buffer_->size());
+  lent_buffer_ = nullptr;
+}
+
+Data CameraFrame::TakeData() {
+  Materialize();
+  return std::move(data_);
+}
 
 const CameraFormat& CameraFrame::camera_format() const {
   return camera_format_;
@@ -80,7 +113,9 @@ base::TimeDelta CameraFrame::timestamp() const { return timestamp_; }
 
 CameraFrameMessage CameraFrame::ToCameraFrameMessage(bool copy) {
   CameraFrameMessage message;
-  if (copy) {
+  if (lent_buffer_) {
+    message.set_data(lent_buffer_->front(), lent_buffer_->size());
+  } else if (copy) {
     message.set_data(data_.data());
   } else {
     message.set_data(std::move(data_).data());
@@ -94,8 +129,10 @@ Status CameraFrame::FromCameraFrameMessage(const CameraFrameMessage& message) {
   CameraFormat camera_format;
   Status s = camera_format.FromCameraFormatMessage(message.camera_format());
   if (!s.ok()) return s;
-  *this = CameraFrame{Data{message.data()}, camera_format,
-                      base::TimeDelta::FromMicroseconds(message.timestamp())};
+  const std::string& data = message.data();
+  *this = CameraFrame{
+      Data::CopyFromPool(data.data(), data.size(), DATA_TYPE_CUSTOM_C1),
+      camera_format, base::TimeDelta::FromMicroseconds(message.timestamp())};
   return Status::OK();
 }
 
@@ -104,7 +141,7 @@ Status CameraFrame::FromCameraFrameMessage(CameraFrameMessage&& message) {
   Status s = camera_format.FromCameraFormatMessage(message.camera_format());
   if (!s.ok()) return s;
   std::unique_ptr<std::string> data(message.release_data());
-  *this = CameraFrame{Data{std::move(*data)}, camera_format,
+  *this = CameraFrame{Data::AdoptIntoPool(std::move(*data)), camera_format,
                       base::TimeDelta::FromMicroseconds(message.timestamp())};
   return Status::OK();
 }
@@ -115,7 +152,7 @@ bool CameraFrame::ToCvMat(cv::Mat* out, bool copy) {
   if (type == -1) return false;
 
   cv::Mat mat(camera_format_.height(), camera_format_.width(), type,
-              data_.cast<void*>());
+              const_cast<uint8_t*>(raw_data()));
   if (copy) {
     *out = mat.clone();
   } else {
@@ -141,7 +178,7 @@ bool CameraFrame::ToRosImage(sensor_msgs::Image* image) const {
   image->height = camera_format_.height();
   image->step = length() / height();
   image->data.resize(length());
-  memcpy(&(image->data[0]), data_.cast<const char*>(), length());
+  memcpy(&(image->data[0]), raw_data(), length());
   image->header.stamp = ToRosTime(timestamp_);
   return true;
 }
@@ -155,118 +192,12 @@ Status CameraFrame::FromRosImage(const sensor_msgs::Image& image,
 }
 #endif  // defined(HAS_ROS)
 
-namespace {
-
-base::Optional<CameraFrame> ConvertToBGRA(const uint8_t* data,
-                                          size_t data_length,
-                                          const CameraFormat& camera_format,
-                                          base::TimeDelta timestamp) {
-  PixelFormat pixel_format = camera_format.pixel_format();
-  libyuv::FourCC src_format;
-
-  if (pixel_format == PIXEL_FORMAT_BGRA) {
-    LOG(ERROR) << "Its format is already PIXEL_FORMAT_BGRA.";
-  }
-
-  src_format = camera_format.ToLibyuvPixelFormat();
-  if (src_format == libyuv::FOURCC_ANY) return base::nullopt;
-
-  const int width = camera_format.width();
-  const int height = camera_format.height();
-  CameraFormat bgra_camera_format(width, height, PIXEL_FORMAT_BGRA,
-                                  camera_format.frame_rate());
-  size_t length = bgra_camera_format.AllocationSize();
-  Data tmp_bgra;
-  tmp_bgra.resize(length);
-  uint8_t* tmp_bgra_ptr = tmp_bgra.cast<uint8_t*>();
-  if (libyuv::ConvertToARGB(data, data_length, tmp_bgra_ptr, width * 4,
-                            0 /* crop_x_pos */, 0 /* crop_y_pos */, width,
-                            height, width, height,
-                            libyuv::RotationMode::kRotate0, src_format) != 0) {
-    return base::nullopt;
-  }
-
-  return CameraFrame(std::move(tmp_bgra), bgra_camera_format, timestamp);
-}
-
-}  // namespace
-
 base::Optional<CameraFrame> ConvertToRequestedPixelFormat(
     const uint8_t* data, size_t data_length, const CameraFormat& camera_format,
     PixelFormat requested_pixel_format, base::TimeDelta timestamp) {
-  if (requested_pixel_format == PIXEL_FORMAT_MJPEG) {
-    return base::nullopt;
-  } else if (requested_pixel_format == PIXEL_FORMAT_BGRA) {
-    return ConvertToBGRA(data, data_length, camera_format, timestamp);
-  } else {
-    auto bgra_camera_frame_opt =
-        ConvertToBGRA(data, data_length, camera_format, timestamp);
-    if (!bgra_camera_frame_opt.has_value()) return base::nullopt;
-
-    CameraFrame bgra_camera_frame = std::move(bgra_camera_frame_opt.value());
-    const uint8_t* bgra_data = bgra_camera_frame.data().cast<const uint8_t*>();
-    int width = bgra_camera_frame.width();
-    int height = bgra_camera_frame.height();
-    CameraFormat camera_format = bgra_camera_frame.camera_format();
-    camera_format.set_pixel_format(requested_pixel_format);
-    size_t length = camera_format.AllocationSize();
-    Data tmp_camera_frame;
-    tmp_camera_frame.resize(length);
-    uint8_t* tmp_camera_frame_ptr = tmp_camera_frame.cast<uint8_t*>();
-
-    int ret = -1;
-    switch (requested_pixel_format) {
-      case PIXEL_FORMAT_I420:
-        ret = libyuv::ARGBToI420(
-            bgra_data, width * 4, tmp_camera_frame_ptr, width,
-            tmp_camera_frame_ptr + (width * height), width / 2,
-            tmp_camera_frame_ptr + (width * height) * 5 / 4, width / 2, width,
-            height);
-        break;
-      case PIXEL_FORMAT_YV12:
-        // No conversion in libyuv api.
-        break;
-      case PIXEL_FORMAT_NV12:
-        ret = libyuv::ARGBToNV12(bgra_data, width * 4, tmp_camera_frame_ptr,
-                                 width, tmp_camera_frame_ptr + (width * height),
-                                 width, width, height);
-        break;
-      case PIXEL_FORMAT_NV21:
-        ret = libyuv::ARGBToNV21(bgra_data, width * 4, tmp_camera_frame_ptr,
-                                 width, tmp_camera_frame_ptr + (width * height),
-                                 width, width, height);
-        break;
-      case PIXEL_FORMAT_UYVY:
-        ret = libyuv::ARGBToUYVY(bgra_data, width * 4, tmp_camera_frame_ptr,
-                                 width * 2, width, height);
-        break;
-      case PIXEL_FORMAT_YUY2:
-        ret = libyuv::ARGBToYUY2(bgra_data, width * 4, tmp_camera_frame_ptr,
-                                 width * 2, width, height);
-        break;
-      case PIXEL_FORMAT_BGR:
-        ret = libyuv::ARGBToRGB24(bgra_data, width * 4, tmp_camera_frame_ptr,
-                                  width * 3, width, height);
-        break;
-      case PIXEL_FORMAT_RGBA:
-        ret = libyuv::ARGBToABGR(bgra_data, width * 4, tmp_camera_frame_ptr,
-                                 width * 4, width, height);
-        break;
-      case PIXEL_FORMAT_RGB:
-        ret = libyuv::ARGBToRAW(bgra_data, width * 4, tmp_camera_frame_ptr,
-                                width * 3, width, height);
-        break;
-      case PIXEL_FORMAT_ARGB:
-        ret = libyuv::ARGBToBGRA(bgra_data, width * 4, tmp_camera_frame_ptr,
-                                 width * 4, width, height);
-        break;
-      default:
-        break;
-    }
-    if (ret != 0) return base::nullopt;
-
-    return CameraFrame(std::move(tmp_camera_frame), camera_format, timestamp);
-  }
+  PixelFormatConverter pixel_format_converter;
+  return pixel_format_converter.Convert(data, data_length, camera_format,
+                                        requested_pixel_format, timestamp);
 }
 
 }  // namespace drivers
@@ -23,6 +23,7 @@
 #include "felicia/core/lib/error/statusor.h"
 #include "felicia/core/lib/image/image.h"
 #include "felicia/core/lib/unit/geometry/size.h"
+#include "felicia/drivers/camera/camera_buffer.h"
 #include "felicia/drivers/camera/camera_format.h"
 #include "felicia/drivers/camera/camera_frame_message.pb.h"
 
@@ -39,15 +40,33 @@ class FEL_EXPORT CameraFrame {
   CameraFrame(const Image& image, float frame_rate, base::TimeDelta timestamp);
   CameraFrame(Image&& image, float frame_rate,
               base::TimeDelta timestamp) noexcept;
+  // Refers to |lent_buffer| without copying it.
+  CameraFrame(scoped_refptr<LentCameraBuffer> lent_buffer,
+              const CameraFormat& camera_format, base::TimeDelta timestamp);
   CameraFrame(const CameraFrame& other);
   CameraFrame(CameraFrame&& other) noexcept;
   CameraFrame& operator=(const CameraFrame& other);
   CameraFrame& operator=(CameraFrame&& other);
   ~CameraFrame();
 
+  // A lent frame has no Data until |Materialize()| is called, so this CHECKs
+  // that it is not lent. |raw_data()| and |length()| read either.
   const Data& data() const;
+  // Calls |Materialize()| first.
   Data& data();
+  const uint8_t* raw_data() const;
   size_t length() const;
+
+  // If it refers to a lent buffer, copies the buffer and gives it back to the
+  // driver. Otherwise it does nothing.
+  void Materialize();
+  // Moves out the data, calling |Materialize()| first.
+  Data TakeData();
+
+  bool is_lent() const { return !!lent_buffer_; }
+  const scoped_refptr<LentCameraBuffer>& lent_buffer() const {
+    return lent_buffer_;
+  }
   const CameraFormat& camera_format() const;
   int width() const;
   int height() const;
@@ -79,10 +98,14 @@ class FEL_EXPORT CameraFrame {
 
  protected:
   Data data_;
+  // Set only when it refers to a lent buffer, and then |data_| is empty.
+  scoped_refptr<LentCameraBuffer> lent_buffer_;
   CameraFormat camera_format_;
   base::TimeDelta timestamp_;
 };
 
+// Same as PixelFormatConverter::Convert(), but without reusing the scratch
+// buffer. Cameras should use their own PixelFormatConverter.
 FEL_EXPORT base::Optional<CameraFrame> ConvertToRequestedPixelFormat(
     const uint8_t* data, size_t data_length, const CameraFormat& camera_format,
     PixelFormat requested_pixel_format, base::TimeDelta timestamp);
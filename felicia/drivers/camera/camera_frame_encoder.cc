@@ -0,0 +1,75 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/camera_frame_encoder.h"
+
+#include "felicia/core/lib/error/errors.h"
+
+namespace felicia {
+namespace drivers {
+
+constexpr int CameraFrameEncoder::kDefaultQuality;
+
+namespace {
+
+JpegCodec::Options MakeJpegOptions(int quality) {
+  JpegCodec::Options options;
+  options.quality = quality;
+  // Frames are encoded on the camera thread, which can't afford the second
+  // pass.
+  options.optimize_coding = false;
+  return options;
+}
+
+}  // namespace
+
+CameraFrameEncoder::CameraFrameEncoder(Compression compression, int quality)
+    : compression_(compression), jpeg_encoder_(MakeJpegOptions(quality)) {}
+
+CameraFrameEncoder::~CameraFrameEncoder() = default;
+
+void CameraFrameEncoder::set_quality(int quality) {
+  jpeg_encoder_.set_options(MakeJpegOptions(quality));
+}
+
+Status CameraFrameEncoder::Encode(const CameraFrame& frame,
+                                  CameraFrameMessage* message) {
+  message->set_timestamp(frame.timestamp().InMicroseconds());
+  const CameraFormat& camera_format = frame.camera_format();
+  if (compression_ == COMPRESSION_NONE ||
+      camera_format.pixel_format() == PIXEL_FORMAT_MJPEG) {
+    message->mutable_data()->assign(
+        reinterpret_cast<const char*>(frame.raw_data()), frame.length());
+    *message->mutable_camera_format() = camera_format.ToCameraFormatMessage();
+    return Status::OK();
+  }
+
+  const uint8_t* data = frame.raw_data();
+  PixelFormat pixel_format = camera_format.pixel_format();
+  base::Optional<CameraFrame> converted;
+  if (!JpegEncoder::CanEncode(pixel_format)) {
+    converted = pixel_format_converter_.Convert(
+        data, frame.length(), camera_format, PIXEL_FORMAT_I420,
+        frame.timestamp());
+    if (!converted) {
+      return errors::InvalidArgument("Failed to convert to I420.");
+    }
+    data = converted->raw_data();
+    pixel_format = PIXEL_FORMAT_I420;
+  }
+
+  std::string* output = message->mutable_data();
+  output->clear();
+  Sizei size(frame.width(), frame.height());
+  Status s = jpeg_encoder_.Encode(data, size, pixel_format, output);
+  if (!s.ok()) return s;
+
+  *message->mutable_camera_format() =
+      CameraFormat(size, PIXEL_FORMAT_MJPEG, frame.frame_rate())
+          .ToCameraFormatMessage();
+  return Status::OK();
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
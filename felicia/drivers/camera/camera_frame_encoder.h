@@ -0,0 +1,75 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_DRIVERS_CAMERA_CAMERA_FRAME_ENCODER_H_
+#define FELICIA_DRIVERS_CAMERA_CAMERA_FRAME_ENCODER_H_
+
+#include "third_party/chromium/base/macros.h"
+
+#include "felicia/core/lib/base/export.h"
+#include "felicia/core/lib/error/status.h"
+#include "felicia/core/lib/image/jpeg_codec.h"
+#include "felicia/drivers/camera/camera_frame.h"
+#include "felicia/drivers/camera/camera_frame_message.pb.h"
+#include "felicia/drivers/camera/pixel_format_converter.h"
+
+namespace felicia {
+namespace drivers {
+
+// Fills CameraFrameMessage to publish, compressing the frames on the way
+// with COMPRESSION_MJPEG. Raw frames are an order of magnitude larger than
+// their JPEGs, which matters once subscribers are on another host. The
+// subscribers get frames of PIXEL_FORMAT_MJPEG, which PixelFormatConverter
+// decodes to the format they want.
+//
+// Frames which are MJPEG already are passed as they are. I420 and the packed
+// RGB formats are compressed directly, and the others are converted to I420
+// first. The JPEG is written straight into the data of the message, so
+// reusing a message keeps its buffer across frames.
+//
+//   CameraFrameEncoder encoder(CameraFrameEncoder::COMPRESSION_MJPEG);
+//   CameraFrameMessage message;
+//   ...
+//   void OnCameraFrame(CameraFrame&& frame) {
+//     if (encoder.Encode(frame, &message).ok()) publisher.Publish(message);
+//   }
+//
+// It's not thread safe.
+class FEL_EXPORT CameraFrameEncoder {
+ public:
+  enum Compression {
+    COMPRESSION_NONE,
+    COMPRESSION_MJPEG,
+  };
+
+  static constexpr int kDefaultQuality = 80;
+
+  explicit CameraFrameEncoder(Compression compression = COMPRESSION_MJPEG,
+                              int quality = kDefaultQuality);
+  ~CameraFrameEncoder();
+
+  Compression compression() const { return compression_; }
+  void set_compression(Compression compression) { compression_ = compression; }
+
+  // It should be between 0 and 100.
+  int quality() const { return jpeg_encoder_.options().quality; }
+  void set_quality(int quality);
+
+  // Overwrites |message| with |frame|. Unlike
+  // |CameraFrame::ToCameraFrameMessage()|, the data of |message| is reused.
+  Status Encode(const CameraFrame& frame, CameraFrameMessage* message);
+
+ private:
+  Compression compression_;
+  JpegEncoder jpeg_encoder_;
+  // Converts frames which JpegEncoder doesn't take to I420.
+  PixelFormatConverter pixel_format_converter_;
+
+  DISALLOW_COPY_AND_ASSIGN(CameraFrameEncoder);
+};
+
+}  // namespace drivers
+}  // namespace felicia
+
+#endif  // FELICIA_DRIVERS_CAMERA_CAMERA_FRAME_ENCODER_H_
\ No newline at end of file
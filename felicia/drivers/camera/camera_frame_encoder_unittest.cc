@@ -0,0 +1,193 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/camera_frame_encoder.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "libyuv.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+constexpr int kQuality = 95;
+
+// JPEG rounds each sample a few times.
+constexpr int kMaxDiff = 12;
+constexpr double kMaxMeanDiff = 2.0;
+
+const base::TimeDelta kTimestamp = base::TimeDelta::FromMilliseconds(10);
+
+// A smooth frame, so that subsampling the chroma barely changes it.
+std::string MakeBGRAFrame() {
+  std::string frame(kWidth * kHeight * 4, 0);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      char* pixel = &frame[(y * kWidth + x) * 4];
+      pixel[0] = static_cast<char>(64 + x * 2);
+      pixel[1] = static_cast<char>(64 + y * 2);
+      pixel[2] = static_cast<char>(96 + x + y);
+      pixel[3] = static_cast<char>(255);
+    }
+  }
+  return frame;
+}
+
+std::string MakeYUY2Frame() {
+  std::string bgra = MakeBGRAFrame();
+  std::string yuy2(kWidth * kHeight * 2, 0);
+  libyuv::ARGBToYUY2(reinterpret_cast<const uint8_t*>(bgra.data()), kWidth * 4,
+                     reinterpret_cast<uint8_t*>(&yuy2[0]), kWidth * 2, kWidth,
+                     kHeight);
+  return yuy2;
+}
+
+std::string ToI420(const std::string& yuy2) {
+  std::string i420(kWidth * kHeight * 3 / 2, 0);
+  uint8_t* y = reinterpret_cast<uint8_t*>(&i420[0]);
+  uint8_t* u = y + kWidth * kHeight;
+  uint8_t* v = u + kWidth * kHeight / 4;
+  libyuv::YUY2ToI420(reinterpret_cast<const uint8_t*>(yuy2.data()),
+                     kWidth * 2, y, kWidth, u, kWidth / 2, v, kWidth / 2,
+                     kWidth, kHeight);
+  return i420;
+}
+
+CameraFrame MakeCameraFrame(const std::string& data,
+                            PixelFormat pixel_format) {
+  return CameraFrame(Data(data),
+                     CameraFormat(kWidth, kHeight, pixel_format, 30),
+                     kTimestamp);
+}
+
+// Returns the JPEG of |message| as a subscriber reads it.
+std::string ReadJpeg(const CameraFrameMessage& message) {
+  CameraFrame frame;
+  EXPECT_TRUE(frame.FromCameraFrameMessage(message).ok());
+  EXPECT_EQ(PIXEL_FORMAT_MJPEG, frame.pixel_format());
+  return std::string(reinterpret_cast<const char*>(frame.raw_data()),
+                     frame.length());
+}
+
+// Returns an empty string if it fails.
+std::string DecodeToBGRA(const std::string& jpeg) {
+  Image image;
+  image.set_pixel_format(PIXEL_FORMAT_BGRA);
+  if (!JpegCodec::Decode(reinterpret_cast<const unsigned char*>(jpeg.data()),
+                         jpeg.size(), &image)
+           .ok()) {
+    return std::string();
+  }
+  EXPECT_EQ(Sizei(kWidth, kHeight), image.size());
+  return std::string(image.data().cast<const char*>(), image.data().size());
+}
+
+// Returns an empty string if it fails.
+std::string DecodeToI420(const std::string& jpeg) {
+  JpegDecoder decoder;
+  Image image;
+  if (!decoder
+           .DecodeToI420(reinterpret_cast<const unsigned char*>(jpeg.data()),
+                         jpeg.size(), Sizei(), &image)
+           .ok()) {
+    return std::string();
+  }
+  EXPECT_EQ(Sizei(kWidth, kHeight), image.size());
+  return std::string(image.data().cast<const char*>(), image.data().size());
+}
+
+testing::AssertionResult IsNear(const std::string& expected,
+                                const std::string& actual) {
+  if (expected.size() != actual.size()) {
+    return testing::AssertionFailure() << "size " << actual.size()
+                                       << " != " << expected.size();
+  }
+  int max_diff = 0;
+  double total_diff = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    int diff = std::abs(static_cast<uint8_t>(expected[i]) -
+                        static_cast<uint8_t>(actual[i]));
+    max_diff = std::max(max_diff, diff);
+    total_diff += diff;
+  }
+  double mean_diff = total_diff / expected.size();
+  if (max_diff > kMaxDiff || mean_diff > kMaxMeanDiff) {
+    return testing::AssertionFailure()
+           << "max diff " << max_diff << ", mean diff " << mean_diff;
+  }
+  return testing::AssertionSuccess();
+}
+
+void ExpectMJPEG(const CameraFrameMessage& message) {
+  EXPECT_EQ(kTimestamp.InMicroseconds(), message.timestamp());
+  EXPECT_EQ(PIXEL_FORMAT_MJPEG, message.camera_format().pixel_format());
+  EXPECT_EQ(kWidth, message.camera_format().size().width());
+  EXPECT_EQ(kHeight, message.camera_format().size().height());
+  EXPECT_EQ(30, message.camera_format().frame_rate());
+}
+
+}  // namespace
+
+// BGRA is compressed directly.
+TEST(CameraFrameEncoderTest, EncodeBGRA) {
+  const std::string bgra = MakeBGRAFrame();
+  CameraFrameEncoder encoder(CameraFrameEncoder::COMPRESSION_MJPEG, kQuality);
+  CameraFrameMessage message;
+  ASSERT_TRUE(
+      encoder.Encode(MakeCameraFrame(bgra, PIXEL_FORMAT_BGRA), &message).ok());
+  ExpectMJPEG(message);
+  EXPECT_GT(bgra.size(), message.data().size());
+  EXPECT_TRUE(IsNear(bgra, DecodeToBGRA(ReadJpeg(message))));
+
+  // Reusing the message overwrites the data of the last frame.
+  const std::string jpeg = message.data();
+  ASSERT_TRUE(
+      encoder.Encode(MakeCameraFrame(bgra, PIXEL_FORMAT_BGRA), &message).ok());
+  EXPECT_EQ(jpeg, message.data());
+}
+
+// YUY2 is converted to I420 before it's compressed.
+TEST(CameraFrameEncoderTest, EncodeYUY2) {
+  CameraFrameEncoder encoder(CameraFrameEncoder::COMPRESSION_MJPEG, kQuality);
+  CameraFrameMessage message;
+  ASSERT_TRUE(
+      encoder.Encode(MakeCameraFrame(MakeYUY2Frame(), PIXEL_FORMAT_YUY2),
+                     &message)
+          .ok());
+  ExpectMJPEG(message);
+  // The planes of I420 are compressed as they are.
+  EXPECT_TRUE(IsNear(ToI420(MakeYUY2Frame()), DecodeToI420(ReadJpeg(message))));
+}
+
+TEST(CameraFrameEncoderTest, PassThrough) {
+  const std::string bgra = MakeBGRAFrame();
+  CameraFrameEncoder encoder(CameraFrameEncoder::COMPRESSION_NONE);
+  CameraFrameMessage message;
+  ASSERT_TRUE(
+      encoder.Encode(MakeCameraFrame(bgra, PIXEL_FORMAT_BGRA), &message).ok());
+  EXPECT_EQ(PIXEL_FORMAT_BGRA, message.camera_format().pixel_format());
+  EXPECT_EQ(bgra, message.data());
+
+  // MJPEG isn't compressed again.
+  encoder.set_compression(CameraFrameEncoder::COMPRESSION_MJPEG);
+  ASSERT_TRUE(
+      encoder.Encode(MakeCameraFrame(bgra, PIXEL_FORMAT_BGRA), &message).ok());
+  const std::string jpeg = message.data();
+  CameraFrameMessage message2;
+  ASSERT_TRUE(
+      encoder.Encode(MakeCameraFrame(jpeg, PIXEL_FORMAT_MJPEG), &message2)
+          .ok());
+  ExpectMJPEG(message2);
+  EXPECT_EQ(jpeg, message2.data());
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,134 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/camera_frame.h"
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/bind.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr uint8_t kPixels[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+std::string PixelsAsString() {
+  return std::string(reinterpret_cast<const char*>(kPixels), sizeof(kPixels));
+}
+
+}  // namespace
+
+class CameraFrameTest : public testing::Test {
+ protected:
+  scoped_refptr<LentCameraBuffer> LendBuffer() {
+    return base::MakeRefCounted<LentCameraBuffer>(
+        kPixels, sizeof(kPixels),
+        base::BindOnce([](int* num_returned) { (*num_returned)++; },
+                       &num_returned_));
+  }
+
+  CameraFrame MakeLentFrame() {
+    return CameraFrame{LendBuffer(), camera_format_,
+                       base::TimeDelta::FromMilliseconds(1)};
+  }
+
+  CameraFormat camera_format_{4, 2, PIXEL_FORMAT_Y8, 30};
+  int num_returned_ = 0;
+};
+
+TEST_F(CameraFrameTest, LentFrameReadsWithoutCopy) {
+  CameraFrame frame = MakeLentFrame();
+  EXPECT_TRUE(frame.is_lent());
+  EXPECT_EQ(kPixels, frame.raw_data());
+  EXPECT_EQ(sizeof(kPixels), frame.length());
+  EXPECT_EQ(0, num_returned_);
+}
+
+TEST_F(CameraFrameTest, CopyKeepsBufferUntilLastRelease) {
+  base::Optional<CameraFrame> frame(MakeLentFrame());
+  base::Optional<CameraFrame> copied(*frame);
+  EXPECT_TRUE(copied->is_lent());
+  EXPECT_EQ(frame->raw_data(), copied->raw_data());
+
+  CameraFrame assigned;
+  assigned = *frame;
+  EXPECT_EQ(frame->raw_data(), assigned.raw_data());
+
+  frame.reset();
+  copied.reset();
+  EXPECT_EQ(0, num_returned_);
+  assigned = CameraFrame();
+  EXPECT_EQ(1, num_returned_);
+}
+
+TEST_F(CameraFrameTest, MoveTransfersBuffer) {
+  CameraFrame frame = MakeLentFrame();
+  CameraFrame moved(std::move(frame));
+  EXPECT_TRUE(moved.is_lent());
+  EXPECT_EQ(kPixels, moved.raw_data());
+
+  CameraFrame assigned;
+  assigned = std::move(moved);
+  EXPECT_TRUE(assigned.is_lent());
+  EXPECT_EQ(0, num_returned_);
+  assigned = CameraFrame();
+  EXPECT_EQ(1, num_returned_);
+}
+
+TEST_F(CameraFrameTest, MaterializeReturnsBuffer) {
+  CameraFrame frame = MakeLentFrame();
+  frame.Materialize();
+  EXPECT_FALSE(frame.is_lent());
+  EXPECT_EQ(1, num_returned_);
+  EXPECT_NE(kPixels, frame.raw_data());
+  const CameraFrame& const_frame = frame;
+  EXPECT_EQ(PixelsAsString(), const_frame.data().data());
+
+  // Does nothing on a frame which isn't lent.
+  frame.Materialize();
+  EXPECT_EQ(PixelsAsString(), const_frame.data().data());
+}
+
+TEST_F(CameraFrameTest, CopyOfLentFrameIsNotMaterialized) {
+  CameraFrame frame = MakeLentFrame();
+  CameraFrame copied(frame);
+  frame.Materialize();
+  // |copied| still holds the buffer.
+  EXPECT_EQ(0, num_returned_);
+  EXPECT_TRUE(copied.is_lent());
+  EXPECT_EQ(kPixels, copied.raw_data());
+  copied = CameraFrame();
+  EXPECT_EQ(1, num_returned_);
+}
+
+TEST_F(CameraFrameTest, TakeData) {
+  CameraFrame frame = MakeLentFrame();
+  Data data = frame.TakeData();
+  EXPECT_EQ(1, num_returned_);
+  EXPECT_EQ(PixelsAsString(), data.data());
+
+  CameraFrame owning{Data(PixelsAsString()), camera_format_,
+                     base::TimeDelta()};
+  EXPECT_EQ(PixelsAsString(), owning.TakeData().data());
+}
+
+TEST_F(CameraFrameTest, ToCameraFrameMessage) {
+  CameraFrame frame = MakeLentFrame();
+  CameraFrameMessage message = frame.ToCameraFrameMessage();
+  EXPECT_EQ(PixelsAsString(), message.data());
+  EXPECT_EQ(1000, message.timestamp());
+  // Copying into the message doesn't give the buffer back.
+  EXPECT_TRUE(frame.is_lent());
+  EXPECT_EQ(0, num_returned_);
+
+  CameraFrame received;
+  ASSERT_TRUE(received.FromCameraFrameMessage(std::move(message)).ok());
+  EXPECT_FALSE(received.is_lent());
+  EXPECT_EQ(PixelsAsString(), received.data().data());
+  EXPECT_EQ(camera_format_.ToString(), received.camera_format().ToString());
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -6,6 +6,7 @@
 #define FELICIA_DRIVERS_CAMERA_CAMERA_INTERFACE_H_
 
 #include "felicia/drivers/camera/camera_interface_base.h"
+#include "felicia/drivers/camera/pixel_format_converter.h"
 
 namespace felicia {
 namespace drivers {
@@ -20,9 +21,29 @@ class FEL_EXPORT CameraInterface : public CameraInterfaceBase {
 
   const CameraFormat& camera_format() const;
 
+  // If the driver supports, it lends its buffers to CameraFrame instead of
+  // copying them, when no conversion is needed. See LentCameraBuffer. It
+  // takes effect from the next |Start()|.
+  void set_lend_buffers(bool lend_buffers) { lend_buffers_ = lend_buffers; }
+
+  // Configures how the frames are converted, e.g, the number of threads or
+  // the size to scale to. It must not be called while capturing.
+  PixelFormatConverter* pixel_format_converter() {
+    return &pixel_format_converter_;
+  }
+
  protected:
+  // Whether the captured frames have to go through |pixel_format_converter_|.
+  bool NeedsConversion() const {
+    return requested_pixel_format_ != camera_format_.pixel_format() ||
+           pixel_format_converter_.Scales(camera_format_);
+  }
+
   CameraFormat camera_format_;
   PixelFormat requested_pixel_format_;
+  bool lend_buffers_ = false;
+  // Used on the thread which delivers the frames.
+  PixelFormatConverter pixel_format_converter_;
 
   CameraFrameCallback camera_frame_callback_;
 };
@@ -0,0 +1,285 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Benchmarks a camera through to its subscriber, on a machine without one.
+// Frames come from SyntheticCamera, or FileCamera of FEL_CAMERA_BENCHMARK_FILE
+// if it's set, which is a directory of images or a Y4M file. Each iteration
+// is a frame received by the subscriber, so items_per_second is the frame
+// rate achieved. The counters are per frame, in milliseconds:
+//  - capture: copying or converting in the camera, see MemoryCamera.
+//  - publish: compressing and serializing CameraFrameMessage.
+//  - subscribe: parsing it and converting to the requested pixel format.
+//  - latency: from when the camera delivers a frame until it's subscribed.
+// and *_cpu is the CPU time of the same stage.
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/containers/circular_deque.h"
+#include "third_party/chromium/base/files/file_path.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/stl_util.h"
+#include "third_party/chromium/base/synchronization/condition_variable.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
+
+#include "felicia/drivers/camera/camera_factory.h"
+#include "felicia/drivers/camera/camera_frame_encoder.h"
+#include "felicia/drivers/camera/file_camera.h"
+#include "felicia/drivers/camera/synthetic_camera.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr PixelFormat kSources[] = {
+    PIXEL_FORMAT_YUY2,
+    PIXEL_FORMAT_MJPEG,
+    PIXEL_FORMAT_NV12,
+};
+
+constexpr PixelFormat kTargets[] = {
+    PIXEL_FORMAT_I420,
+    PIXEL_FORMAT_BGR,
+};
+
+// As a publisher with a queue of this size, older frames are dropped when the
+// subscriber falls behind.
+constexpr size_t kMaxQueueSize = 4;
+
+// Wall and CPU time spent on a stage.
+struct StageTime {
+  void AddTo(benchmark::State& state, const std::string& name,
+             int64_t frames) const {
+    if (frames == 0) return;
+    state.counters[name] = total.InMillisecondsF() / frames;
+    state.counters[name + "_cpu"] = total_cpu.InMillisecondsF() / frames;
+  }
+
+  base::TimeDelta total;
+  base::TimeDelta total_cpu;
+};
+
+class StageTimer {
+ public:
+  StageTimer()
+      : start_(base::TimeTicks::Now()),
+        thread_start_(base::ThreadTicks::IsSupported()
+                          ? base::ThreadTicks::Now()
+                          : base::ThreadTicks()) {}
+
+  void Stop(StageTime* stage_time) {
+    stage_time->total += base::TimeTicks::Now() - start_;
+    if (base::ThreadTicks::IsSupported()) {
+      stage_time->total_cpu += base::ThreadTicks::Now() - thread_start_;
+    }
+  }
+
+ private:
+  base::TimeTicks start_;
+  base::ThreadTicks thread_start_;
+};
+
+// A camera, its publisher and a subscriber in a process. Frames are
+// published on the camera thread, as a camera node does, and subscribed on
+// the benchmark thread.
+class Pipeline {
+ public:
+  Pipeline(CameraFrameEncoder::Compression compression,
+           PixelFormat requested_pixel_format)
+      : encoder_(compression),
+        requested_pixel_format_(requested_pixel_format),
+        cv_(&lock_) {}
+
+  Status Start(const CameraDescriptor& camera_descriptor,
+               const CameraFormat& requested_camera_format) {
+    camera_ = CameraFactory::NewCamera(camera_descriptor);
+    Status s = camera_->Init();
+    if (!s.ok()) return s;
+    start_time_ = base::TimeTicks::Now();
+    return camera_->Start(
+        requested_camera_format,
+        base::BindRepeating(&Pipeline::Publish, base::Unretained(this)),
+        base::BindRepeating([](Status s) { LOG(ERROR) << s; }));
+  }
+
+  void Stop() {
+    CHECK(camera_->Stop().ok());
+    elapsed_ = base::TimeTicks::Now() - start_time_;
+  }
+
+  // Waits for the next frame.
+  void Subscribe() {
+    Message message;
+    {
+      base::AutoLock l(lock_);
+      while (queue_.empty()) cv_.Wait();
+      message = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    StageTimer timer;
+    CameraFrameMessage camera_frame_message;
+    CHECK(camera_frame_message.ParseFromString(message.serialized));
+    CameraFrame camera_frame;
+    CHECK(camera_frame.FromCameraFrameMessage(std::move(camera_frame_message))
+              .ok());
+    if (camera_frame.pixel_format() != requested_pixel_format_) {
+      base::Optional<CameraFrame> converted = pixel_format_converter_.Convert(
+          camera_frame.raw_data(), camera_frame.length(),
+          camera_frame.camera_format(), requested_pixel_format_,
+          camera_frame.timestamp());
+      CHECK(converted.has_value());
+      camera_frame = std::move(converted.value());
+    }
+    benchmark::DoNotOptimize(camera_frame);
+    timer.Stop(&subscribe_time_);
+
+    const base::TimeDelta latency = base::TimeTicks::Now() - message.delivered;
+    total_latency_ += latency;
+    max_latency_ = std::max(max_latency_, latency);
+    bytes_ += message.serialized.length();
+    frames_++;
+  }
+
+  void SetCounters(benchmark::State& state) {
+    state.SetItemsProcessed(frames_);
+    if (frames_ == 0) return;
+
+    const MemoryCamera::Stats stats =
+        static_cast<MemoryCamera*>(camera_.get())->stats();
+    state.counters["fps"] = frames_ / elapsed_.InSecondsF();
+    state.counters["capture"] =
+        stats.total_capture_time.InMillisecondsF() / stats.frames;
+    state.counters["capture_cpu"] =
+        stats.total_capture_cpu_time.InMillisecondsF() / stats.frames;
+    {
+      base::AutoLock l(lock_);
+      state.counters["dropped"] = stats.dropped_frames + queue_dropped_;
+      publish_time_.AddTo(state, "publish", published_);
+    }
+    subscribe_time_.AddTo(state, "subscribe", frames_);
+    state.counters["latency"] = total_latency_.InMillisecondsF() / frames_;
+    state.counters["max_latency"] = max_latency_.InMillisecondsF();
+    state.counters["bytes"] = static_cast<double>(bytes_) / frames_;
+  }
+
+ private:
+  struct Message {
+    std::string serialized;
+    base::TimeTicks delivered;
+  };
+
+  // Called on the camera thread.
+  void Publish(CameraFrame&& camera_frame) {
+    Message message;
+    message.delivered = base::TimeTicks::Now();
+    StageTimer timer;
+    CHECK(encoder_.Encode(camera_frame, &camera_frame_message_).ok());
+    CHECK(camera_frame_message_.SerializeToString(&message.serialized));
+
+    base::AutoLock l(lock_);
+    timer.Stop(&publish_time_);
+    published_++;
+    if (queue_.size() == kMaxQueueSize) {
+      queue_.pop_front();
+      queue_dropped_++;
+    }
+    queue_.push_back(std::move(message));
+    cv_.Signal();
+  }
+
+  std::unique_ptr<CameraInterface> camera_;
+
+  // Used on the camera thread.
+  CameraFrameEncoder encoder_;
+  CameraFrameMessage camera_frame_message_;
+
+  // Used on the benchmark thread.
+  PixelFormat requested_pixel_format_;
+  PixelFormatConverter pixel_format_converter_;
+  base::TimeTicks start_time_;
+  base::TimeDelta elapsed_;
+  StageTime subscribe_time_;
+  base::TimeDelta total_latency_;
+  base::TimeDelta max_latency_;
+  int64_t bytes_ = 0;
+  int64_t frames_ = 0;
+
+  base::Lock lock_;
+  base::ConditionVariable cv_;
+  base::circular_deque<Message> queue_ GUARDED_BY(lock_);
+  int64_t queue_dropped_ GUARDED_BY(lock_) = 0;
+  StageTime publish_time_ GUARDED_BY(lock_);
+  int64_t published_ GUARDED_BY(lock_) = 0;
+};
+
+CameraDescriptor GetCameraDescriptor(PixelFormat source) {
+  const char* path = getenv("FEL_CAMERA_BENCHMARK_FILE");
+  return path ? FileCamera::MakeCameraDescriptor(
+                    base::FilePath::FromUTF8Unsafe(path))
+              : SyntheticCamera::MakeCameraDescriptor(source);
+}
+
+// Frames of every source at 720p and 1080p, sent raw and as MJPEG. The last
+// two are as fast as the pipeline can go.
+void Args(benchmark::internal::Benchmark* b) {
+  for (size_t source = 0; source < base::size(kSources); ++source) {
+    for (int height : {720, 1080}) {
+      for (int compression : {CameraFrameEncoder::COMPRESSION_NONE,
+                              CameraFrameEncoder::COMPRESSION_MJPEG}) {
+        b->Args({static_cast<int>(source), 0, height, 30, compression});
+      }
+    }
+  }
+  b->Args({0, 1, 1080, 30, CameraFrameEncoder::COMPRESSION_MJPEG});
+  b->Args({0, 0, 1080, 1000, CameraFrameEncoder::COMPRESSION_NONE});
+  b->Args({1, 0, 1080, 1000, CameraFrameEncoder::COMPRESSION_NONE});
+}
+
+}  // namespace
+
+// Args are the pixel format of the camera, the requested one, the height,
+// the frame rate and the compression.
+static void BM_CameraPipeline(benchmark::State& state) {
+  const PixelFormat source = kSources[state.range(0)];
+  const PixelFormat target = kTargets[state.range(1)];
+  const int height = state.range(2);
+  const auto compression =
+      static_cast<CameraFrameEncoder::Compression>(state.range(4));
+  CameraFormat requested_camera_format(height * 16 / 9, height, target,
+                                       state.range(3));
+
+  Pipeline pipeline(compression, target);
+  Status s = pipeline.Start(GetCameraDescriptor(source),
+                            requested_camera_format);
+  if (!s.ok()) {
+    state.SkipWithError(s.error_message().c_str());
+    return;
+  }
+  for (auto _ : state) {
+    pipeline.Subscribe();
+  }
+  pipeline.Stop();
+
+  pipeline.SetCounters(state);
+  state.SetLabel(PixelFormat_Name(source) + " -> " + PixelFormat_Name(target) +
+                 (compression == CameraFrameEncoder::COMPRESSION_MJPEG
+                      ? " (MJPEG)"
+                      : ""));
+}
+
+BENCHMARK(BM_CameraPipeline)
+    ->Apply(Args)
+    ->MinTime(3)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -33,9 +33,9 @@ DepthCameraFrame::~DepthCameraFrame() = default;
 DepthCameraFrameMessage DepthCameraFrame::ToDepthCameraFrameMessage(bool copy) {
   DepthCameraFrameMessage message;
   if (copy) {
-    message.set_data(data_.data());
+    message.set_data(raw_data(), length());
   } else {
-    message.set_data(std::move(data_).data());
+    message.set_data(TakeData().data());
   }
   *message.mutable_camera_format() = camera_format_.ToCameraFormatMessage();
   message.set_timestamp(timestamp_.InMicroseconds());
@@ -50,8 +50,10 @@ Status DepthCameraFrame::FromDepthCameraFrameMessage(
   CameraFormat camera_format;
   Status s = camera_format.FromCameraFormatMessage(message.camera_format());
   if (!s.ok()) return s;
+  const std::string& data = message.data();
   CameraFrame camera_frame(
-      Data{message.data()}, camera_format,
+      Data::CopyFromPool(data.data(), data.size(), DATA_TYPE_CUSTOM_C1),
+      camera_format,
       base::TimeDelta::FromMicroseconds(message.timestamp()));
   *this =
       DepthCameraFrame{std::move(camera_frame), message.min(), message.max()};
@@ -65,7 +67,7 @@ Status DepthCameraFrame::FromDepthCameraFrameMessage(
   if (!s.ok()) return s;
   std::unique_ptr<std::string> data(message.release_data());
   CameraFrame camera_frame(
-      Data{std::move(*data)}, camera_format,
+      Data::AdoptIntoPool(std::move(*data)), camera_format,
       base::TimeDelta::FromMicroseconds(message.timestamp()));
   float min = message.min();
   float max = message.max();
@@ -0,0 +1,283 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/file_camera.h"
+
+#include <algorithm>
+
+#include "third_party/chromium/base/files/file.h"
+#include "third_party/chromium/base/files/file_enumerator.h"
+#include "third_party/chromium/base/files/file_util.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/strings/strcat.h"
+#include "third_party/chromium/base/strings/string_number_conversions.h"
+#include "third_party/chromium/base/strings/string_split.h"
+
+#include "felicia/core/lib/image/image.h"
+#include "felicia/core/lib/image/jpeg_codec.h"
+#include "felicia/core/lib/strings/str_util.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr const char* kDeviceIdPrefix = "file:";
+constexpr const char* kY4mMagic = "YUV4MPEG2";
+constexpr const char* kY4mFrameMagic = "FRAME";
+// Long enough for any Y4M header.
+constexpr size_t kMaxY4mLineLength = 1024;
+
+bool IsJpeg(const base::FilePath& path) {
+  return path.MatchesExtension(FILE_PATH_LITERAL(".jpg")) ||
+         path.MatchesExtension(FILE_PATH_LITERAL(".jpeg"));
+}
+
+bool IsImage(const base::FilePath& path) {
+  return IsJpeg(path) || path.MatchesExtension(FILE_PATH_LITERAL(".png"));
+}
+
+// Reads up to '\n', which isn't included in |line|.
+bool ReadLine(base::File* file, std::string* line) {
+  line->clear();
+  char c;
+  while (line->length() < kMaxY4mLineLength) {
+    if (file->ReadAtCurrentPos(&c, 1) != 1) return false;
+    if (c == '\n') return true;
+    line->push_back(c);
+  }
+  return false;
+}
+
+// Parses the stream header, e.g, "YUV4MPEG2 W1280 H720 F30:1 Ip A1:1 C420jpeg".
+Status ParseY4mHeader(const std::string& header, CameraFormat* camera_format) {
+  std::vector<base::StringPiece> tokens = base::SplitStringPiece(
+      header, " ", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  if (tokens.empty() || tokens[0] != kY4mMagic) {
+    return felicia::errors::InvalidArgument("Not a Y4M file.");
+  }
+
+  int width = 0;
+  int height = 0;
+  float frame_rate = FileCamera::kDefaultFrameRate;
+  for (size_t i = 1; i < tokens.size(); ++i) {
+    base::StringPiece value = tokens[i].substr(1);
+    switch (tokens[i][0]) {
+      case 'W':
+        if (!base::StringToInt(value, &width)) width = 0;
+        break;
+      case 'H':
+        if (!base::StringToInt(value, &height)) height = 0;
+        break;
+      case 'F': {
+        std::vector<base::StringPiece> ratio = base::SplitStringPiece(
+            value, ":", base::KEEP_WHITESPACE, base::SPLIT_WANT_ALL);
+        int numerator, denominator;
+        if (ratio.size() == 2 && base::StringToInt(ratio[0], &numerator) &&
+            base::StringToInt(ratio[1], &denominator) && numerator > 0 &&
+            denominator > 0) {
+          frame_rate = static_cast<float>(numerator) / denominator;
+        }
+        break;
+      }
+      case 'C':
+        // Only 8-bit 4:2:0, which differ just in the chroma siting. The
+        // others, e.g, "420p10", take more bytes a sample.
+        if (value != "420" && value != "420jpeg" && value != "420paldv" &&
+            value != "420mpeg2") {
+          return felicia::errors::Unimplemented(base::StrCat(
+              {"Y4M of C", value, " is not supported, only 8-bit 4:2:0 is."}));
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (width <= 0 || height <= 0) {
+    return felicia::errors::InvalidArgument(
+        "Y4M header doesn't have the size.");
+  }
+  *camera_format = CameraFormat(width, height, PIXEL_FORMAT_I420, frame_rate);
+  return Status::OK();
+}
+
+}  // namespace
+
+constexpr size_t FileCamera::kMaxBytes;
+constexpr float FileCamera::kDefaultFrameRate;
+
+FileCamera::FileCamera(const CameraDescriptor& camera_descriptor)
+    : MemoryCamera(camera_descriptor) {}
+
+FileCamera::~FileCamera() = default;
+
+// static
+CameraDescriptor FileCamera::MakeCameraDescriptor(const base::FilePath& path) {
+  return CameraDescriptor(
+      base::StrCat({"File Camera (", path.BaseName().AsUTF8Unsafe(), ")"}),
+      base::StrCat({kDeviceIdPrefix, path.AsUTF8Unsafe()}), "file");
+}
+
+// static
+bool FileCamera::IsFileCamera(const CameraDescriptor& camera_descriptor) {
+  return StartsWith(camera_descriptor.device_id(), kDeviceIdPrefix);
+}
+
+// static
+Status FileCamera::GetSupportedCameraFormats(
+    const CameraDescriptor& camera_descriptor, CameraFormats* camera_formats) {
+  CameraFormat camera_format;
+  Status s = Load(GetPath(camera_descriptor), &camera_format, nullptr);
+  if (!s.ok()) return s;
+  camera_formats->push_back(camera_format);
+  return Status::OK();
+}
+
+Status FileCamera::Init() {
+  if (!camera_state_.IsStopped()) {
+    return camera_state_.InvalidStateError();
+  }
+
+  if (frames_.empty()) {
+    Status s = Load(GetPath(camera_descriptor_), &file_camera_format_,
+                    &frames_);
+    if (!s.ok()) return s;
+  }
+
+  camera_state_.ToInitialized();
+
+  return Status::OK();
+}
+
+// static
+base::FilePath FileCamera::GetPath(const CameraDescriptor& camera_descriptor) {
+  base::StringPiece device_id = camera_descriptor.device_id();
+  ConsumePrefix(&device_id, kDeviceIdPrefix);
+  return base::FilePath::FromUTF8Unsafe(device_id);
+}
+
+// static
+Status FileCamera::Load(const base::FilePath& path,
+                        CameraFormat* camera_format,
+                        std::vector<std::string>* frames) {
+  if (base::DirectoryExists(path)) {
+    return LoadImages(path, camera_format, frames);
+  } else if (path.MatchesExtension(FILE_PATH_LITERAL(".y4m"))) {
+    return LoadY4m(path, camera_format, frames);
+  }
+  return felicia::errors::InvalidArgument(base::StrCat(
+      {path.AsUTF8Unsafe(), " is neither a directory nor a Y4M file."}));
+}
+
+// static
+Status FileCamera::LoadImages(const base::FilePath& path,
+                              CameraFormat* camera_format,
+                              std::vector<std::string>* frames) {
+  std::vector<base::FilePath> image_paths;
+  base::FileEnumerator enumerator(path, false, base::FileEnumerator::FILES);
+  for (base::FilePath image_path = enumerator.Next(); !image_path.empty();
+       image_path = enumerator.Next()) {
+    if (IsImage(image_path)) image_paths.push_back(image_path);
+  }
+  if (image_paths.empty()) {
+    return felicia::errors::NotFound(
+        base::StrCat({"No images in ", path.AsUTF8Unsafe()}));
+  }
+  std::sort(image_paths.begin(), image_paths.end());
+  const bool is_mjpeg =
+      std::all_of(image_paths.begin(), image_paths.end(), IsJpeg);
+
+  // The size is of the first image.
+  Image image;
+  Status s = image.Load(image_paths[0], PIXEL_FORMAT_BGR);
+  if (!s.ok()) return s;
+  const Sizei size = image.size();
+  *camera_format =
+      CameraFormat(size, is_mjpeg ? PIXEL_FORMAT_MJPEG : PIXEL_FORMAT_BGR,
+                   kDefaultFrameRate);
+  if (!frames) return Status::OK();
+
+  size_t bytes = 0;
+  for (const base::FilePath& image_path : image_paths) {
+    std::string frame;
+    if (is_mjpeg) {
+      if (!base::ReadFileToString(image_path, &frame)) {
+        return felicia::errors::InvalidArgument(
+            base::StrCat({"Failed to read ", image_path.AsUTF8Unsafe()}));
+      }
+    } else {
+      s = image.Load(image_path, PIXEL_FORMAT_BGR);
+      if (!s.ok()) return s;
+      if (image.size() != size) {
+        return felicia::errors::InvalidArgument(base::StrCat(
+            {image_path.AsUTF8Unsafe(), " is not of the same size."}));
+      }
+      frame = std::move(image.data()).data();
+    }
+
+    bytes += frame.length();
+    if (bytes > kMaxBytes) {
+      LOG(WARNING) << "Only " << frames->size() << " of " << image_paths.size()
+                   << " images are read, which are too large.";
+      break;
+    }
+    frames->push_back(std::move(frame));
+  }
+  return Status::OK();
+}
+
+// static
+Status FileCamera::LoadY4m(const base::FilePath& path,
+                           CameraFormat* camera_format,
+                           std::vector<std::string>* frames) {
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!file.IsValid()) {
+    return felicia::errors::InvalidArgument(
+        base::StrCat({"Failed to open ", path.AsUTF8Unsafe()}));
+  }
+
+  std::string line;
+  if (!ReadLine(&file, &line)) {
+    return felicia::errors::InvalidArgument("Failed to read the Y4M header.");
+  }
+  Status s = ParseY4mHeader(line, camera_format);
+  if (!s.ok()) return s;
+  if (!frames) return Status::OK();
+
+  const size_t frame_size = camera_format->AllocationSize();
+  size_t bytes = 0;
+  // Every frame has its own header, e.g, "FRAME", which may have parameters.
+  while (ReadLine(&file, &line)) {
+    if (!StartsWith(line, kY4mFrameMagic)) {
+      return felicia::errors::InvalidArgument(
+          "Failed to read the Y4M frame header.");
+    }
+    bytes += frame_size;
+    if (bytes > kMaxBytes) {
+      LOG(WARNING) << "Only " << frames->size()
+                   << " frames are read, which are too large.";
+      break;
+    }
+    std::string frame(frame_size, 0);
+    if (file.ReadAtCurrentPos(&frame[0], frame_size) !=
+        static_cast<int>(frame_size)) {
+      // The last frame may be cut off.
+      break;
+    }
+    frames->push_back(std::move(frame));
+  }
+  return Status::OK();
+}
+
+Status FileCamera::PrepareFrames(const CameraFormat& requested_camera_format) {
+  camera_format_ = file_camera_format_;
+  if (requested_camera_format.frame_rate() > 0) {
+    camera_format_.set_frame_rate(requested_camera_format.frame_rate());
+  }
+  return Status::OK();
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
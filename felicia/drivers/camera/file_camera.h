@@ -0,0 +1,82 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_DRIVERS_CAMERA_FILE_CAMERA_H_
+#define FELICIA_DRIVERS_CAMERA_FILE_CAMERA_H_
+
+#include <string>
+#include <vector>
+
+#include "third_party/chromium/base/files/file_path.h"
+
+#include "felicia/drivers/camera/memory_camera.h"
+
+namespace felicia {
+namespace drivers {
+
+// Camera which replays recorded frames in a loop, from either
+//  - a directory of images, which are sorted by name. If every image is a
+//    JPEG, they are delivered as they are in PIXEL_FORMAT_MJPEG, as a camera
+//    sending MJPEG does. Otherwise they are decoded to PIXEL_FORMAT_BGR.
+//    Every image should be of the same size.
+//  - a Y4M file of 4:2:0, which is raw YUV with a header telling its size
+//    and frame rate, delivered in PIXEL_FORMAT_I420.
+//
+// Frames are read on |Init()|, up to |kMaxBytes|, so that reading the disk
+// doesn't interfere with what's measured. Images are delivered at 30 fps,
+// and Y4M at its frame rate, unless it's started with another one.
+//
+// It's created by CameraFactory from the descriptor below, and isn't listed
+// by |CameraFactory::GetCameraDescriptors()|.
+//
+//   std::unique_ptr<CameraInterface> camera = CameraFactory::NewCamera(
+//       FileCamera::MakeCameraDescriptor(base::FilePath("foreman.y4m")));
+class FEL_EXPORT FileCamera : public MemoryCamera {
+ public:
+  static constexpr size_t kMaxBytes = 512 * 1024 * 1024;
+  static constexpr float kDefaultFrameRate = 30;
+
+  ~FileCamera() override;
+
+  static CameraDescriptor MakeCameraDescriptor(const base::FilePath& path);
+  static bool IsFileCamera(const CameraDescriptor& camera_descriptor);
+
+  // Needed by CameraFactory
+  static Status GetSupportedCameraFormats(
+      const CameraDescriptor& camera_descriptor, CameraFormats* camera_formats);
+
+  // CameraInterface methods
+  Status Init() override;
+
+ private:
+  friend class CameraFactory;
+
+  explicit FileCamera(const CameraDescriptor& camera_descriptor);
+
+  static base::FilePath GetPath(const CameraDescriptor& camera_descriptor);
+
+  // Reads the camera format of |path|, and its frames unless |frames| is
+  // null.
+  static Status Load(const base::FilePath& path, CameraFormat* camera_format,
+                     std::vector<std::string>* frames);
+  static Status LoadImages(const base::FilePath& path,
+                           CameraFormat* camera_format,
+                           std::vector<std::string>* frames);
+  static Status LoadY4m(const base::FilePath& path,
+                        CameraFormat* camera_format,
+                        std::vector<std::string>* frames);
+
+  // MemoryCamera methods
+  Status PrepareFrames(const CameraFormat& requested_camera_format) override;
+
+  // Of the file, whose frame rate is overridden by the requested one.
+  CameraFormat file_camera_format_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileCamera);
+};
+
+}  // namespace drivers
+}  // namespace felicia
+
+#endif  // FELICIA_DRIVERS_CAMERA_FILE_CAMERA_H_
\ No newline at end of file
@@ -8,21 +8,24 @@
 
 #include "felicia/drivers/camera/linux/v4l2_camera.h"
 
+#include <errno.h>
 #include <linux/version.h>
 #include <sys/fcntl.h>
-#include <sys/ioctl.h>
 #include <sys/mman.h>
 
+#include <algorithm>
+
 #include "third_party/chromium/base/bind.h"
 #include "third_party/chromium/base/files/file_enumerator.h"
 #include "third_party/chromium/base/files/file_util.h"
 #include "third_party/chromium/base/files/scoped_file.h"
-#include "third_party/chromium/base/posix/eintr_wrapper.h"
+#include "third_party/chromium/base/message_loop/message_loop_current.h"
 #include "third_party/chromium/base/stl_util.h"
 #include "third_party/chromium/base/strings/stringprintf.h"
 
 #include "felicia/core/lib/synchronization/scoped_event_signaller.h"
 #include "felicia/drivers/camera/camera_errors.h"
+#include "felicia/drivers/camera/linux/v4l2_capture_thread.h"
 
 namespace felicia {
 namespace drivers {
@@ -34,8 +37,6 @@ constexpr int kTypicalFramerate = 30;
 // Maximum number of ioctl retries before giving up trying to reset controls.
 constexpr int kMaxIOCtrlRetries = 5;
 
-constexpr uint32_t kNumVideoBuffers = 4;
-
 void FillV4L2Format(v4l2_format* format, uint32_t width, uint32_t height,
                     uint32_t pixelformat_fourcc) {
   memset(format, 0, sizeof(*format));
@@ -59,6 +60,25 @@ void FillV4L2RequestBuffer(v4l2_requestbuffers* requestbuffers, int count) {
   requestbuffers->count = count;
 }
 
+// Exports the |index|th buffer as a DMABUF. Not every driver supports it, and
+// then it returns an invalid fd.
+base::ScopedFD ExportDmabuf(V4l2Device* device, int fd, uint32_t index) {
+#if defined(VIDIOC_EXPBUF)
+  v4l2_exportbuffer exportbuffer;
+  memset(&exportbuffer, 0, sizeof(exportbuffer));
+  exportbuffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  exportbuffer.index = index;
+  exportbuffer.flags = O_RDONLY | O_CLOEXEC;
+  if (device->ioctl(fd, VIDIOC_EXPBUF, &exportbuffer) < 0) {
+    DVLOG(1) << "Failed to export the V4L2 buffer as a DMABUF.";
+    return base::ScopedFD();
+  }
+  return base::ScopedFD(exportbuffer.fd);
+#else
+  return base::ScopedFD();
+#endif
+}
+
 // USB VID and PID are both 4 bytes long.
 const size_t kVidPidSize = 4;
 const size_t kMaxInterfaceNameSize = 256;
@@ -131,27 +151,70 @@ class DevVideoFilePathsDeviceProvider {
 
 }  // namespace
 
-V4l2Camera::V4l2Camera(const CameraDescriptor& camera_descriptor)
-    : CameraInterface(camera_descriptor), thread_("V4l2CameraThread") {}
+// The mmap'ed V4L2 buffers of a stream. They outlive the stream while any of
+// them is lent, and are unmapped when the last one is given back.
+class V4l2Camera::MappedBuffers
+    : public base::RefCountedThreadSafe<MappedBuffers> {
+ public:
+  explicit MappedBuffers(scoped_refptr<V4l2Device> device)
+      : device(std::move(device)) {}
+
+  scoped_refptr<V4l2Device> device;
+
+  std::vector<CameraBuffer> buffers;
+  // Invalid if |lend_buffers_| is false or exporting failed.
+  std::vector<base::ScopedFD> dmabuf_fds;
+  // Accessed only on |task_runner_|.
+  std::vector<bool> lent;
+  size_t num_lent = 0;
+
+ private:
+  friend class base::RefCountedThreadSafe<MappedBuffers>;
+  ~MappedBuffers() {
+    for (auto& buffer : buffers) {
+      const int result = device->munmap(buffer.start(), buffer.length());
+      PLOG_IF(ERROR, result < 0) << "Error munmap()ing V4L2 buffer";
+    }
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(MappedBuffers);
+};
 
-V4l2Camera::~V4l2Camera() = default;
+constexpr uint32_t V4l2Camera::kDefaultNumVideoBuffers;
+
+V4l2Camera::V4l2Camera(const CameraDescriptor& camera_descriptor)
+    : V4l2Camera(camera_descriptor, base::MakeRefCounted<V4l2DeviceImpl>()) {}
+
+V4l2Camera::V4l2Camera(const CameraDescriptor& camera_descriptor,
+                       scoped_refptr<V4l2Device> device)
+    : CameraInterface(camera_descriptor),
+      device_(std::move(device)),
+      fd_watch_controller_(FROM_HERE),
+      weak_ptr_factory_(this) {}
+
+V4l2Camera::~V4l2Camera() {
+  // |fd_watch_controller_| has to stop watching on |task_runner_| before it
+  // is destroyed, otherwise the capture thread may call back into this.
+  if (camera_state_.IsStarted()) Stop();
+}
 
 // static
 Status V4l2Camera::GetCameraDescriptors(CameraDescriptors* camera_descriptors) {
   DCHECK(camera_descriptors);
 
+  scoped_refptr<V4l2Device> device = base::MakeRefCounted<V4l2DeviceImpl>();
   DevVideoFilePathsDeviceProvider device_provider;
   std::vector<std::string> filepaths;
   device_provider.GetDeviceIds(&filepaths);
   for (auto& unique_id : filepaths) {
-    base::ScopedFD fd(HANDLE_EINTR(open(unique_id.c_str(), O_RDONLY)));
+    base::ScopedFD fd(device->open(unique_id.c_str(), O_RDONLY));
     if (!fd.is_valid()) {
       DLOG(ERROR) << "Couldn't open " << unique_id;
       continue;
     }
 
     v4l2_capability cap;
-    if (!(DoIoctl(fd.get(), VIDIOC_QUERYCAP, &cap) == 0) &&
+    if (!(DoIoctl(device.get(), fd.get(), VIDIOC_QUERYCAP, &cap) == 0) &&
         (cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) &&
         !(cap.capabilities & V4L2_CAP_VIDEO_OUTPUT)) {
       continue;
@@ -169,15 +232,24 @@ Status V4l2Camera::GetCameraDescriptors(CameraDescriptors* camera_descriptors) {
 // static
 Status V4l2Camera::GetSupportedCameraFormats(
     const CameraDescriptor& camera_descriptor, CameraFormats* camera_formats) {
+  scoped_refptr<V4l2Device> device = base::MakeRefCounted<V4l2DeviceImpl>();
+  return GetSupportedCameraFormats(device.get(), camera_descriptor,
+                                   camera_formats);
+}
+
+// static
+Status V4l2Camera::GetSupportedCameraFormats(
+    V4l2Device* device, const CameraDescriptor& camera_descriptor,
+    CameraFormats* camera_formats) {
   DCHECK(camera_formats->empty());
 
   base::ScopedFD fd;
-  Status s = InitDevice(camera_descriptor, &fd);
+  Status s = InitDevice(device, camera_descriptor, &fd);
   if (!s.ok()) return s;
 
   v4l2_fmtdesc v4l2_format = {};
   v4l2_format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  for (; DoIoctl(fd.get(), VIDIOC_ENUM_FMT, &v4l2_format) == 0;
+  for (; DoIoctl(device, fd.get(), VIDIOC_ENUM_FMT, &v4l2_format) == 0;
        ++v4l2_format.index) {
     CameraFormat camera_format;
     camera_format.set_pixel_format(
@@ -187,7 +259,8 @@ Status V4l2Camera::GetSupportedCameraFormats(
 
     v4l2_frmsizeenum frame_size = {};
     frame_size.pixel_format = v4l2_format.pixelformat;
-    for (; DoIoctl(fd.get(), VIDIOC_ENUM_FRAMESIZES, &frame_size) == 0;
+    for (;
+         DoIoctl(device, fd.get(), VIDIOC_ENUM_FRAMESIZES, &frame_size) == 0;
          ++frame_size.index) {
       if (frame_size.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
         camera_format.SetSize(frame_size.discrete.width,
@@ -199,7 +272,7 @@ Status V4l2Camera::GetSupportedCameraFormats(
       }
 
       const std::vector<float> frame_rates = GetFrameRateList(
-          fd.get(), v4l2_format.pixelformat, frame_size.discrete.width,
+          device, fd.get(), v4l2_format.pixelformat, frame_size.discrete.width,
           frame_size.discrete.height);
       for (const auto& frame_rate : frame_rates) {
         camera_format.set_frame_rate(frame_rate);
@@ -217,7 +290,7 @@ Status V4l2Camera::Init() {
     return camera_state_.InvalidStateError();
   }
 
-  Status s = InitDevice(camera_descriptor_, &fd_);
+  Status s = InitDevice(device_.get(), camera_descriptor_, &fd_);
   if (!s.ok()) {
     return s;
   }
@@ -235,7 +308,8 @@ Status V4l2Camera::Start(const CameraFormat& requested_camera_format,
   }
 
   CameraFormats camera_formats;
-  Status s = GetSupportedCameraFormats(camera_descriptor_, &camera_formats);
+  Status s = GetSupportedCameraFormats(device_.get(), camera_descriptor_,
+                                       &camera_formats);
   if (!s.ok()) return s;
 
   const CameraFormat& final_camera_format =
@@ -247,31 +321,32 @@ Status V4l2Camera::Start(const CameraFormat& requested_camera_format,
   s = InitMmap();
   if (!s.ok()) return s;
 
-  for (size_t i = 0; i < buffers_.size(); ++i) {
+  for (size_t i = 0; i < buffers_->buffers.size(); ++i) {
     v4l2_buffer buffer;
     FillV4L2Buffer(&buffer, i);
 
-    if (DoIoctl(fd_.get(), VIDIOC_QBUF, &buffer) < 0) {
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_QBUF, &buffer) < 0) {
       return felicia::errors::Unavailable(
           "Failed to enqueue V4L2 buffer to the driver.");
     }
   }
 
   v4l2_buf_type capture_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  if (DoIoctl(fd_.get(), VIDIOC_STREAMON, &capture_type) < 0) {
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_STREAMON, &capture_type) < 0) {
     return felicia::errors::Unavailable("Failed to stream on.");
   }
 
-  thread_.Start();
+  task_runner_ = V4l2CaptureThread::GetInstance().Acquire();
   camera_frame_callback_ = camera_frame_callback;
   status_callback_ = status_callback;
   camera_state_.ToStarted();
 
-  if (thread_.task_runner()->BelongsToCurrentThread()) {
-    DoCapture();
+  if (task_runner_->BelongsToCurrentThread()) {
+    DoStart();
   } else {
-    thread_.task_runner()->PostTask(
-        FROM_HERE, base::BindOnce(&V4l2Camera::DoCapture, AsWeakPtr()));
+    task_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(&V4l2Camera::DoStart, weak_ptr_factory_.GetWeakPtr()));
   }
 
   return Status::OK();
@@ -283,17 +358,18 @@ Status V4l2Camera::Stop() {
   }
 
   Status s;
-  if (thread_.task_runner()->BelongsToCurrentThread()) {
+  if (task_runner_->BelongsToCurrentThread()) {
     DoStop(nullptr, &s);
   } else {
     base::WaitableEvent* event = new base::WaitableEvent();
-    thread_.task_runner()->PostTask(
-        FROM_HERE, base::BindOnce(&V4l2Camera::DoStop, AsWeakPtr(), event, &s));
+    task_runner_->PostTask(FROM_HERE,
+                           base::BindOnce(&V4l2Camera::DoStop,
+                                          base::Unretained(this), event, &s));
     event->Wait();
     delete event;
   }
 
-  if (thread_.IsRunning()) thread_.Stop();
+  V4l2CaptureThread::GetInstance().Release(std::move(task_runner_));
   fd_.reset();
 
   camera_frame_callback_.Reset();
@@ -314,7 +390,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
         camera_settings.white_balance_mode() == CAMERA_SETTINGS_MODE_AUTO;
     control.id = V4L2_CID_AUTO_WHITE_BALANCE;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting whilte_balance_mode to " << value;
   }
 
@@ -323,7 +399,8 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     {
       v4l2_control control = {};
       control.id = V4L2_CID_AUTO_WHITE_BALANCE;
-      const int result = DoIoctl(fd_.get(), VIDIOC_G_CTRL, &control);
+      const int result =
+          DoIoctl(device_.get(), fd_.get(), VIDIOC_G_CTRL, &control);
       // Color temperature can only be applied if Auto White Balance is off.
       can_set = result >= 0 && !control.value;
     }
@@ -332,7 +409,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
       const int value = camera_settings.color_temperature();
       control.id = V4L2_CID_WHITE_BALANCE_TEMPERATURE;
       control.value = value;
-      if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+      if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
         DPLOG(ERROR) << "setting color_temperature to " << value;
     }
   }
@@ -343,7 +420,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
         camera_settings.exposure_mode() == CAMERA_SETTINGS_MODE_AUTO;
     control.id = V4L2_CID_EXPOSURE_AUTO;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting exposure_mode to " << value;
   }
 
@@ -352,7 +429,8 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     {
       v4l2_control control = {};
       control.id = V4L2_CID_EXPOSURE_AUTO;
-      const int result = DoIoctl(fd_.get(), VIDIOC_G_CTRL, &control);
+      const int result =
+          DoIoctl(device_.get(), fd_.get(), VIDIOC_G_CTRL, &control);
       // Exposure Compensation is effective only when V4L2_CID_EXPOSURE_AUTO
       // control is set to AUTO, SHUTTER_PRIORITY or APERTURE_PRIORITY.
       can_set = result >= 0 && control.value != V4L2_EXPOSURE_MANUAL;
@@ -362,7 +440,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
       const int value = camera_settings.exposure_compensation();
       control.id = V4L2_CID_AUTO_EXPOSURE_BIAS;
       control.value = value;
-      if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+      if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
         DPLOG(ERROR) << "setting exposure_compensation to " << value;
     }
   }
@@ -372,7 +450,8 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     {
       v4l2_control control = {};
       control.id = V4L2_CID_EXPOSURE_AUTO;
-      const int result = DoIoctl(fd_.get(), VIDIOC_G_CTRL, &control);
+      const int result =
+          DoIoctl(device_.get(), fd_.get(), VIDIOC_G_CTRL, &control);
       // Exposure time can only be applied if V4L2_CID_EXPOSURE_AUTO is set to
       // V4L2_EXPOSURE_MANUAL or V4L2_EXPOSURE_SHUTTER_PRIORITY.
       can_set =
@@ -384,7 +463,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
       const int value = camera_settings.exposure_time();
       control.id = V4L2_CID_EXPOSURE_ABSOLUTE;
       control.value = value;
-      if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+      if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
         DPLOG(ERROR) << "setting exposure_time to " << value;
     }
   }
@@ -394,7 +473,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     const int value = camera_settings.brightness();
     control.id = V4L2_CID_BRIGHTNESS;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting brightness to " << value;
   }
 
@@ -403,7 +482,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     const int value = camera_settings.contrast();
     control.id = V4L2_CID_CONTRAST;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting contrast to " << value;
   }
 
@@ -412,7 +491,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     const int value = camera_settings.saturation();
     control.id = V4L2_CID_SATURATION;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting saturation to " << value;
   }
 
@@ -421,7 +500,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     const int value = camera_settings.sharpness();
     control.id = V4L2_CID_SHARPNESS;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting sharpness to " << value;
   }
 
@@ -430,7 +509,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     const int value = camera_settings.hue();
     control.id = V4L2_CID_HUE;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting hue to " << value;
   }
 
@@ -439,7 +518,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     const int value = camera_settings.gain();
     control.id = V4L2_CID_GAIN;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting gain to " << value;
   }
 
@@ -448,7 +527,7 @@ Status V4l2Camera::SetCameraSettings(const CameraSettings& camera_settings) {
     const int value = camera_settings.gamma();
     control.id = V4L2_CID_GAMMA;
     control.value = value;
-    if (DoIoctl(fd_.get(), VIDIOC_S_CTRL, &control) < 0)
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_CTRL, &control) < 0)
       DPLOG(ERROR) << "setting gamma to " << value;
   }
 
@@ -483,38 +562,43 @@ Status V4l2Camera::GetCameraSettingsInfo(
 
 Status V4l2Camera::InitMmap() {
   v4l2_requestbuffers requestbuffers;
-  FillV4L2RequestBuffer(&requestbuffers, kNumVideoBuffers);
+  FillV4L2RequestBuffer(&requestbuffers, num_buffers_);
 
-  if (DoIoctl(fd_.get(), VIDIOC_REQBUFS, &requestbuffers) < 0) {
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_REQBUFS, &requestbuffers) < 0) {
     return felicia::errors::Unavailable("Failed to request mmap buffers.");
   }
 
+  // Buffers mapped so far are unmapped when it returns early.
+  scoped_refptr<MappedBuffers> buffers =
+      base::MakeRefCounted<MappedBuffers>(device_);
   for (unsigned int i = 0; i < requestbuffers.count; ++i) {
     v4l2_buffer buffer;
     FillV4L2Buffer(&buffer, i);
 
-    if (DoIoctl(fd_.get(), VIDIOC_QUERYBUF, &buffer) < 0) {
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_QUERYBUF, &buffer) < 0) {
       return felicia::errors::Unavailable("Failed to query buffers.");
     }
 
-    void* const start = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE,
-                             MAP_SHARED, fd_.get(), buffer.m.offset);
+    void* const start =
+        device_->mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd_.get(), buffer.m.offset);
     if (start == MAP_FAILED) {
       return felicia::errors::Unavailable("Failed to mmap buffers.");
     }
-    buffers_.emplace_back(static_cast<uint8_t*>(start), buffer.length);
+    buffers->buffers.emplace_back(static_cast<uint8_t*>(start), buffer.length);
+    buffers->dmabuf_fds.push_back(
+        lend_buffers_ ? ExportDmabuf(device_.get(), fd_.get(), i)
+                      : base::ScopedFD());
   }
+  buffers->lent.resize(buffers->buffers.size(), false);
+  buffers_ = std::move(buffers);
 
   return Status::OK();
 }
 
 Status V4l2Camera::ClearMmap() {
-  for (auto& buffer : buffers_) {
-    const int result = munmap(buffer.start(), buffer.length());
-    PLOG_IF(ERROR, result < 0) << "Error munmap()ing V4L2 buffer";
-  }
-
-  buffers_.clear();
+  // The lent buffers are unmapped when they are given back.
+  buffers_ = nullptr;
 
   return Status::OK();
 }
@@ -523,13 +607,13 @@ Status V4l2Camera::SetCameraFormat(const CameraFormat& camera_format) {
   v4l2_format format;
   FillV4L2Format(&format, camera_format.width(), camera_format.height(),
                  camera_format.ToV4l2PixelFormat());
-  if (DoIoctl(fd_.get(), VIDIOC_S_FMT, &format) < 0) {
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_FMT, &format) < 0) {
     return felicia::errors::Unavailable("Failed to set v4l2 format.");
   }
 
   v4l2_streamparm streamparm = {};
   streamparm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  if (DoIoctl(fd_.get(), VIDIOC_G_PARM, &streamparm) < 0) {
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_G_PARM, &streamparm) < 0) {
     return errors::FailedToGetFrameRate();
   }
 
@@ -540,7 +624,7 @@ Status V4l2Camera::SetCameraFormat(const CameraFormat& camera_format) {
             ? (camera_format.frame_rate() * kFrameRatePrecision)
             : (kTypicalFramerate * kFrameRatePrecision);
 
-    if (DoIoctl(fd_.get(), VIDIOC_S_PARM, &streamparm) < 0) {
+    if (DoIoctl(device_.get(), fd_.get(), VIDIOC_S_PARM, &streamparm) < 0) {
       return errors::FailedToSetFrameRate();
     }
   } else {
@@ -553,16 +637,30 @@ Status V4l2Camera::SetCameraFormat(const CameraFormat& camera_format) {
   return Status::OK();
 }
 
+void V4l2Camera::DoStart() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  if (!base::MessageLoopCurrentForIO::Get()->WatchFileDescriptor(
+          fd_.get(), true /* persistent */, base::MessagePumpForIO::WATCH_READ,
+          &fd_watch_controller_, this)) {
+    status_callback_.Run(
+        felicia::errors::Unavailable("Failed to watch the V4L2 device."));
+  }
+}
+
 void V4l2Camera::DoStop(base::WaitableEvent* event, Status* status) {
-  DCHECK(thread_.task_runner()->BelongsToCurrentThread());
+  DCHECK(task_runner_->BelongsToCurrentThread());
   ScopedEventSignaller signaller(event);
 
+  fd_watch_controller_.StopWatchingFileDescriptor();
+  weak_ptr_factory_.InvalidateWeakPtrs();
+
   v4l2_buf_type capture_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  if (DoIoctl(fd_.get(), VIDIOC_STREAMOFF, &capture_type) < 0) {
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_STREAMOFF, &capture_type) < 0) {
     *status = felicia::errors::Unavailable("Failed to stream off.");
     return;
   }
 
+  const bool has_lent_buffers = buffers_ && buffers_->num_lent > 0;
   Status s = ClearMmap();
   if (!s.ok()) {
     *status = s;
@@ -571,19 +669,39 @@ void V4l2Camera::DoStop(base::WaitableEvent* event, Status* status) {
 
   v4l2_requestbuffers requestbuffers;
   FillV4L2RequestBuffer(&requestbuffers, 0);
-  if (DoIoctl(fd_.get(), VIDIOC_REQBUFS, &requestbuffers) < 0) {
-    *status = felicia::errors::Unavailable("Failed to request mmap buffers.");
-    return;
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_REQBUFS, &requestbuffers) < 0) {
+    // The driver refuses to free the buffers which are still mapped. They
+    // are freed when they are given back, and then the camera can start
+    // again.
+    if (has_lent_buffers) {
+      LOG(WARNING) << "Stopped while some buffers are still lent.";
+    } else {
+      *status =
+          felicia::errors::Unavailable("Failed to request mmap buffers.");
+      return;
+    }
   }
 
   *status = Status::OK();
 }
 
+void V4l2Camera::OnFileCanReadWithoutBlocking(int fd) {
+  DCHECK_EQ(fd, fd_.get());
+  DoCapture();
+}
+
+void V4l2Camera::OnFileCanWriteWithoutBlocking(int fd) { NOTREACHED(); }
+
 void V4l2Camera::DoCapture() {
-  DCHECK(thread_.task_runner()->BelongsToCurrentThread());
+  DCHECK(task_runner_->BelongsToCurrentThread());
   v4l2_buffer buffer;
   FillV4L2Buffer(&buffer, 0);
-  if (DoIoctl(fd_.get(), VIDIOC_DQBUF, &buffer) < 0) {
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_DQBUF, &buffer) < 0) {
+    // Every buffer is lent or the wakeup was spurious.
+    if (errno == EAGAIN) return;
+    // Stops watching, otherwise a broken device, e.g, unplugged one, keeps
+    // waking up the thread.
+    fd_watch_controller_.StopWatchingFileDescriptor();
     status_callback_.Run(felicia::errors::Unavailable(
         "Failed to dequeue V4L2 buffer from the driver."));
     return;
@@ -602,17 +720,26 @@ void V4l2Camera::DoCapture() {
     buffer.bytesused = 0;
     status_callback_.Run(errors::InvalidNumberOfBytesInBuffer());
   } else {
-    CameraBuffer& camera_buffer = buffers_[buffer.index];
+    CameraBuffer& camera_buffer = buffers_->buffers[buffer.index];
     camera_buffer.set_payload(buffer.bytesused);
-    base::TimeDelta timestamp = timestamper_.timestamp();
-    if (requested_pixel_format_ == camera_format_.pixel_format()) {
-      Data data(camera_buffer.start(), camera_buffer.payload());
+    base::TimeDelta timestamp = GetTimestamp(buffer);
+    if (!NeedsConversion() && lend_buffers_ &&
+        buffers_->num_lent + 1 < buffers_->buffers.size()) {
+      // At least one buffer is kept in the driver to capture the next frame.
+      // It's not given back to the driver until the frame is released.
+      camera_frame_callback_.Run(
+          CameraFrame{LendBuffer(buffer.index), camera_format_, timestamp});
+      return;
+    } else if (!NeedsConversion()) {
+      Data data =
+          Data::CopyFromPool(camera_buffer.start(), camera_buffer.payload());
       camera_frame_callback_.Run(
           CameraFrame{std::move(data), camera_format_, timestamp});
     } else {
-      base::Optional<CameraFrame> camera_frame = ConvertToRequestedPixelFormat(
-          camera_buffer.start(), camera_buffer.payload(), camera_format_,
-          requested_pixel_format_, timestamp);
+      base::Optional<CameraFrame> camera_frame =
+          pixel_format_converter_.Convert(
+              camera_buffer.start(), camera_buffer.payload(), camera_format_,
+              requested_pixel_format_, timestamp);
       if (camera_frame.has_value()) {
         camera_frame_callback_.Run(std::move(camera_frame.value()));
       } else {
@@ -622,14 +749,73 @@ void V4l2Camera::DoCapture() {
     }
   }
 
-  if (DoIoctl(fd_.get(), VIDIOC_QBUF, &buffer) < 0) {
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_QBUF, &buffer) < 0) {
     status_callback_.Run(felicia::errors::Unavailable(
         "Failed to enqueue V4L2 buffer to the driver."));
-    return;
   }
+}
 
-  thread_.task_runner()->PostTask(
-      FROM_HERE, base::BindOnce(&V4l2Camera::DoCapture, AsWeakPtr()));
+base::TimeDelta V4l2Camera::GetTimestamp(const v4l2_buffer& buffer) {
+  const base::TimeTicks now = base::TimeTicks::Now();
+  if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) !=
+          V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC ||
+      (buffer.timestamp.tv_sec == 0 && buffer.timestamp.tv_usec == 0)) {
+    return timestamper_.timestamp(now);
+  }
+
+  // The driver stamps the buffer by CLOCK_MONOTONIC, which is the clock of
+  // base::TimeTicks, when the frame was captured. It doesn't include how long
+  // it took to be dequeued.
+  const base::TimeTicks captured =
+      base::TimeTicks() +
+      base::TimeDelta::FromMicroseconds(
+          buffer.timestamp.tv_sec * base::Time::kMicrosecondsPerSecond +
+          buffer.timestamp.tv_usec);
+  return timestamper_.timestamp(std::min(captured, now));
+}
+
+scoped_refptr<LentCameraBuffer> V4l2Camera::LendBuffer(uint32_t index) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK(!buffers_->lent[index]);
+  buffers_->lent[index] = true;
+  buffers_->num_lent++;
+
+  const CameraBuffer& camera_buffer = buffers_->buffers[index];
+  scoped_refptr<LentCameraBuffer> lent_buffer =
+      base::MakeRefCounted<LentCameraBuffer>(
+          camera_buffer.start(), camera_buffer.payload(),
+          base::BindOnce(&V4l2Camera::ReturnBuffer, task_runner_,
+                         weak_ptr_factory_.GetWeakPtr(), buffers_, index));
+  lent_buffer->set_dmabuf_fd(buffers_->dmabuf_fds[index].get());
+  return lent_buffer;
+}
+
+// static
+void V4l2Camera::ReturnBuffer(
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner,
+    base::WeakPtr<V4l2Camera> camera, scoped_refptr<MappedBuffers> buffers,
+    uint32_t index) {
+  // If the camera is already stopped, |buffers| is just released.
+  task_runner->PostTask(
+      FROM_HERE, base::BindOnce(&V4l2Camera::RequeueBuffer, camera,
+                                std::move(buffers), index));
+}
+
+void V4l2Camera::RequeueBuffer(scoped_refptr<MappedBuffers> buffers,
+                               uint32_t index) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK(buffers->lent[index]);
+  buffers->lent[index] = false;
+  buffers->num_lent--;
+  // The stream it was lent from is already stopped.
+  if (buffers != buffers_) return;
+
+  v4l2_buffer buffer;
+  FillV4L2Buffer(&buffer, index);
+  if (DoIoctl(device_.get(), fd_.get(), VIDIOC_QBUF, &buffer) < 0) {
+    status_callback_.Run(felicia::errors::Unavailable(
+        "Failed to enqueue V4L2 buffer to the driver."));
+  }
 }
 
 namespace {
@@ -652,7 +838,7 @@ void V4l2Camera::GetCameraSetting(int control_id,
   v4l2_query_ext_ctrl query_ext_ctrl = {};
   query_ext_ctrl.id = control_id;
   query_ext_ctrl.type = V4L2_CTRL_TYPE_INTEGER;
-  if (!RunIoctl(fd_.get(), VIDIOC_QUERYCTRL, &query_ext_ctrl)) {
+  if (!RunIoctl(device_.get(), fd_.get(), VIDIOC_QUERYCTRL, &query_ext_ctrl)) {
     value->Clear();
     return;
   }
@@ -663,7 +849,7 @@ void V4l2Camera::GetCameraSetting(int control_id,
 
   v4l2_control control = {};
   control.id = control_id;
-  if (!RunIoctl(fd_.get(), VIDIOC_G_CTRL, &control)) {
+  if (!RunIoctl(device_.get(), fd_.get(), VIDIOC_G_CTRL, &control)) {
     value->Clear();
     return;
   }
@@ -674,7 +860,8 @@ void V4l2Camera::GetCameraSetting(int control_id,
                                   CameraSettingsRangedValue* value) {
   v4l2_query_ext_ctrl query_ext_ctrl = {};
   query_ext_ctrl.id = control_id;
-  if (!RunIoctl(fd_.get(), VIDIOC_QUERY_EXT_CTRL, &query_ext_ctrl)) {
+  if (!RunIoctl(device_.get(), fd_.get(), VIDIOC_QUERY_EXT_CTRL,
+                &query_ext_ctrl)) {
     value->Clear();
     return;
   }
@@ -686,7 +873,7 @@ void V4l2Camera::GetCameraSetting(int control_id,
 
   v4l2_control control = {};
   control.id = control_id;
-  if (!RunIoctl(fd_.get(), VIDIOC_G_CTRL, &control)) {
+  if (!RunIoctl(device_.get(), fd_.get(), VIDIOC_G_CTRL, &control)) {
     value->Clear();
     return;
   }
@@ -694,16 +881,19 @@ void V4l2Camera::GetCameraSetting(int control_id,
 }
 
 // static
-int V4l2Camera::DoIoctl(int fd, int request, void* argp) {
-  int ret = HANDLE_EINTR(ioctl(fd, request, argp));
+int V4l2Camera::DoIoctl(V4l2Device* device, int fd, int request,
+                        void* argp) {
+  int ret = device->ioctl(fd, request, argp);
   DPLOG_IF(ERROR, ret < 0) << "ioctl";
   return ret;
 }
 
 // static
-bool V4l2Camera::RunIoctl(int fd, int request, void* argp) {
+bool V4l2Camera::RunIoctl(V4l2Device* device, int fd, int request,
+                          void* argp) {
   int num_retries = 0;
-  for (; DoIoctl(fd, request, argp) < 0 && num_retries < kMaxIOCtrlRetries;
+  for (; DoIoctl(device, fd, request, argp) < 0 &&
+         num_retries < kMaxIOCtrlRetries;
        ++num_retries) {
     DPLOG(WARNING) << "ioctl";
   }
@@ -712,16 +902,20 @@ bool V4l2Camera::RunIoctl(int fd, int request, void* argp) {
 }
 
 // static
-Status V4l2Camera::InitDevice(const CameraDescriptor& camera_descriptor,
+Status V4l2Camera::InitDevice(V4l2Device* device,
+                              const CameraDescriptor& camera_descriptor,
                               base::ScopedFD* fd) {
   const std::string& device_id = camera_descriptor.device_id();
-  base::ScopedFD fd_temp(HANDLE_EINTR(open(device_id.c_str(), O_RDWR)));
+  // Non blocking, so that VIDIOC_DQBUF never blocks the capture thread
+  // shared with other cameras.
+  base::ScopedFD fd_temp(
+      device->open(device_id.c_str(), O_RDWR | O_NONBLOCK));
   if (fd_temp == base::kInvalidPlatformFile)
     return felicia::errors::Unavailable(
         base::StringPrintf("Failed to open %s.", device_id.c_str()));
 
   v4l2_capability cap;
-  if (!(DoIoctl(fd_temp.get(), VIDIOC_QUERYCAP, &cap) == 0) &&
+  if (!(DoIoctl(device, fd_temp.get(), VIDIOC_QUERYCAP, &cap) == 0) &&
       (cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) &&
       !(cap.capabilities & V4L2_CAP_VIDEO_OUTPUT)) {
     return errors::NoVideoCapbility();
@@ -732,8 +926,8 @@ Status V4l2Camera::InitDevice(const CameraDescriptor& camera_descriptor,
 }
 
 // static
-std::vector<float> V4l2Camera::GetFrameRateList(int fd, uint32_t fourcc,
-                                                uint32_t width,
+std::vector<float> V4l2Camera::GetFrameRateList(V4l2Device* device, int fd,
+                                                uint32_t fourcc, uint32_t width,
                                                 uint32_t height) {
   std::vector<float> frame_rates;
 
@@ -741,7 +935,8 @@ std::vector<float> V4l2Camera::GetFrameRateList(int fd, uint32_t fourcc,
   frame_interval.pixel_format = fourcc;
   frame_interval.width = width;
   frame_interval.height = height;
-  for (; DoIoctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &frame_interval) == 0;
+  for (;
+       DoIoctl(device, fd, VIDIOC_ENUM_FRAMEINTERVALS, &frame_interval) == 0;
        ++frame_interval.index) {
     if (frame_interval.type == V4L2_FRMIVAL_TYPE_DISCRETE) {
       if (frame_interval.discrete.numerator != 0) {
@@ -12,20 +12,27 @@
 
 #include "third_party/chromium/base/files/platform_file.h"
 #include "third_party/chromium/base/files/scoped_file.h"
+#include "third_party/chromium/base/memory/ref_counted.h"
 #include "third_party/chromium/base/memory/weak_ptr.h"
+#include "third_party/chromium/base/message_loop/message_pump_for_io.h"
+#include "third_party/chromium/base/single_thread_task_runner.h"
 #include "third_party/chromium/base/synchronization/waitable_event.h"
-#include "third_party/chromium/base/threading/thread.h"
 
 #include "felicia/core/util/timestamp/timestamper.h"
 #include "felicia/drivers/camera/camera_buffer.h"
 #include "felicia/drivers/camera/camera_interface.h"
+#include "felicia/drivers/camera/linux/v4l2_device.h"
 
 namespace felicia {
 namespace drivers {
 
+// Frames are dequeued on one of the threads of V4l2CaptureThread, when the
+// fd becomes readable.
 class V4l2Camera : public CameraInterface,
-                   public base::SupportsWeakPtr<V4l2Camera> {
+                   public base::MessagePumpForIO::FdWatcher {
  public:
+  static constexpr uint32_t kDefaultNumVideoBuffers = 4;
+
   ~V4l2Camera();
 
   // Needed by CameraFactory
@@ -44,35 +51,76 @@ class V4l2Camera : public CameraInterface,
   Status GetCameraSettingsInfo(
       CameraSettingsInfoMessage* camera_settings) override;
 
+  // The number of buffers requested to the driver, which takes effect from
+  // the next |Start()|. When the buffers are lent, it bounds how many frames
+  // can be held at the same time before it falls back to copying.
+  void set_num_buffers(uint32_t num_buffers) { num_buffers_ = num_buffers; }
+
+  // base::MessagePumpForIO::FdWatcher methods
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override;
+
  private:
   friend class CameraFactory;
+  friend class V4l2CameraTest;
+
+  class MappedBuffers;
 
   V4l2Camera(const CameraDescriptor& camera_descriptor);
+  // Tests pass a fake |device|.
+  V4l2Camera(const CameraDescriptor& camera_descriptor,
+             scoped_refptr<V4l2Device> device);
 
   Status InitMmap();
   Status ClearMmap();
   Status SetCameraFormat(const CameraFormat& camera_format);
+  void DoStart();
   void DoStop(base::WaitableEvent* event, Status* status);
   void DoCapture();
+  // Prefers the timestamp by the driver to when it is dequeued, which has
+  // the jitter of scheduling.
+  base::TimeDelta GetTimestamp(const v4l2_buffer& buffer);
+
+  scoped_refptr<LentCameraBuffer> LendBuffer(uint32_t index);
+  // Called when the buffer lent by |LendBuffer()| is released, which may be
+  // on any thread.
+  static void ReturnBuffer(
+      scoped_refptr<base::SingleThreadTaskRunner> task_runner,
+      base::WeakPtr<V4l2Camera> camera, scoped_refptr<MappedBuffers> buffers,
+      uint32_t index);
+  void RequeueBuffer(scoped_refptr<MappedBuffers> buffers, uint32_t index);
 
   void GetCameraSetting(int control_id, CameraSettingsModeValue* value);
   void GetCameraSetting(int control_id, CameraSettingsRangedValue* value);
 
-  static int DoIoctl(int fd, int request, void* argp);
-  static bool RunIoctl(int fd, int request, void* argp);
+  static int DoIoctl(V4l2Device* device, int fd, int request, void* argp);
+  static bool RunIoctl(V4l2Device* device, int fd, int request, void* argp);
 
-  static Status InitDevice(const CameraDescriptor& camera_descriptor,
+  static Status GetSupportedCameraFormats(
+      V4l2Device* device, const CameraDescriptor& camera_descriptor,
+      CameraFormats* camera_formats);
+  static Status InitDevice(V4l2Device* device,
+                           const CameraDescriptor& camera_descriptor,
                            base::ScopedFD* fd);
-  static std::vector<float> GetFrameRateList(int fd, uint32_t fourcc,
-                                             uint32_t width, uint32_t height);
+  static std::vector<float> GetFrameRateList(V4l2Device* device, int fd,
+                                             uint32_t fourcc, uint32_t width,
+                                             uint32_t height);
 
+  scoped_refptr<V4l2Device> device_;
   base::ScopedFD fd_;
 
-  std::vector<CameraBuffer> buffers_;
-  base::Thread thread_;
+  uint32_t num_buffers_ = kDefaultNumVideoBuffers;
+  scoped_refptr<MappedBuffers> buffers_;
+  // Acquired from V4l2CaptureThread while started.
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  base::MessagePumpForIO::FdWatchController fd_watch_controller_;
 
   Timestamper timestamper_;
 
+  // Invalidated on |task_runner_| when it stops, so that the buffers given
+  // back afterwards aren't requeued.
+  base::WeakPtrFactory<V4l2Camera> weak_ptr_factory_;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(V4l2Camera);
 };
 
@@ -0,0 +1,354 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/linux/v4l2_camera.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/synchronization/waitable_event.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr uint32_t kWidth = 4;
+constexpr uint32_t kHeight = 2;
+// YUYV takes 2 bytes a pixel.
+constexpr size_t kBufferSize = kWidth * kHeight * 2;
+constexpr off_t kBufferOffsetStep = 4096;
+
+// Emulates a camera which supports only YUYV at 4x2, 30fps. Frames are
+// captured only by |CaptureFrame()|, and the fd becomes readable while any
+// captured frame is waiting to be dequeued. Like a real driver, it refuses
+// to free the buffers while any of them is mapped.
+class FakeV4l2Device : public V4l2Device {
+ public:
+  FakeV4l2Device() = default;
+
+  // Fills the first queued buffer with |value|, and returns false if no
+  // buffer is queued.
+  bool CaptureFrame(uint8_t value) {
+    base::AutoLock l(lock_);
+    if (queued_.empty()) return false;
+    uint32_t index = queued_.front();
+    queued_.pop_front();
+    memset(buffers_[index]->data(), value, kBufferSize);
+    done_.push_back(index);
+    const uint64_t one = 1;
+    return write(stream_fd_, &one, sizeof(one)) == sizeof(one);
+  }
+
+  size_t num_queued() const {
+    base::AutoLock l(lock_);
+    return queued_.size();
+  }
+
+  int num_mapped() const {
+    base::AutoLock l(lock_);
+    return num_mapped_;
+  }
+
+  bool streaming() const {
+    base::AutoLock l(lock_);
+    return streaming_;
+  }
+
+  // V4l2Device methods
+  int open(const char* device_name, int flags) override {
+    return eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+  }
+
+  int ioctl(int fd, int request, void* argp) override {
+    base::AutoLock l(lock_);
+    // The requests don't fit in int.
+    switch (static_cast<uint32_t>(request)) {
+      case VIDIOC_QUERYCAP: {
+        v4l2_capability* cap = static_cast<v4l2_capability*>(argp);
+        memset(cap, 0, sizeof(*cap));
+        cap->capabilities = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+        return 0;
+      }
+      case VIDIOC_ENUM_FMT: {
+        v4l2_fmtdesc* format = static_cast<v4l2_fmtdesc*>(argp);
+        if (format->index > 0) break;
+        format->pixelformat = V4L2_PIX_FMT_YUYV;
+        return 0;
+      }
+      case VIDIOC_ENUM_FRAMESIZES: {
+        v4l2_frmsizeenum* frame_size = static_cast<v4l2_frmsizeenum*>(argp);
+        if (frame_size->index > 0) break;
+        frame_size->type = V4L2_FRMSIZE_TYPE_DISCRETE;
+        frame_size->discrete.width = kWidth;
+        frame_size->discrete.height = kHeight;
+        return 0;
+      }
+      case VIDIOC_ENUM_FRAMEINTERVALS: {
+        v4l2_frmivalenum* frame_interval =
+            static_cast<v4l2_frmivalenum*>(argp);
+        if (frame_interval->index > 0) break;
+        frame_interval->type = V4L2_FRMIVAL_TYPE_DISCRETE;
+        frame_interval->discrete.numerator = 1;
+        frame_interval->discrete.denominator = 30;
+        return 0;
+      }
+      case VIDIOC_S_FMT:
+      case VIDIOC_G_PARM:
+        return 0;
+      case VIDIOC_REQBUFS: {
+        v4l2_requestbuffers* requestbuffers =
+            static_cast<v4l2_requestbuffers*>(argp);
+        if (num_mapped_ > 0) {
+          errno = EBUSY;
+          return -1;
+        }
+        buffers_.clear();
+        for (uint32_t i = 0; i < requestbuffers->count; ++i) {
+          buffers_.push_back(std::make_unique<std::vector<uint8_t>>(
+              kBufferSize));
+        }
+        return 0;
+      }
+      case VIDIOC_QUERYBUF: {
+        v4l2_buffer* buffer = static_cast<v4l2_buffer*>(argp);
+        if (buffer->index >= buffers_.size()) break;
+        buffer->length = kBufferSize;
+        buffer->m.offset = buffer->index * kBufferOffsetStep;
+        return 0;
+      }
+      case VIDIOC_QBUF: {
+        v4l2_buffer* buffer = static_cast<v4l2_buffer*>(argp);
+        if (buffer->index >= buffers_.size()) break;
+        queued_.push_back(buffer->index);
+        return 0;
+      }
+      case VIDIOC_DQBUF: {
+        uint64_t value;
+        if (read(fd, &value, sizeof(value)) < 0) return -1;
+        v4l2_buffer* buffer = static_cast<v4l2_buffer*>(argp);
+        buffer->index = done_.front();
+        buffer->bytesused = kBufferSize;
+        buffer->flags = 0;
+        buffer->timestamp = {};
+        done_.pop_front();
+        return 0;
+      }
+      case VIDIOC_STREAMON:
+        stream_fd_ = fd;
+        streaming_ = true;
+        return 0;
+      case VIDIOC_STREAMOFF:
+        // Every buffer is dequeued.
+        queued_.clear();
+        done_.clear();
+        streaming_ = false;
+        return 0;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  void* mmap(void* start, size_t length, int prot, int flags, int fd,
+             off_t offset) override {
+    base::AutoLock l(lock_);
+    size_t index = offset / kBufferOffsetStep;
+    if (index >= buffers_.size() || length != kBufferSize) return MAP_FAILED;
+    num_mapped_++;
+    return buffers_[index]->data();
+  }
+
+  int munmap(void* start, size_t length) override {
+    base::AutoLock l(lock_);
+    num_mapped_--;
+    return 0;
+  }
+
+ private:
+  ~FakeV4l2Device() override = default;
+
+  mutable base::Lock lock_;
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> buffers_;
+  std::deque<uint32_t> queued_;
+  std::deque<uint32_t> done_;
+  int num_mapped_ = 0;
+  int stream_fd_ = -1;
+  bool streaming_ = false;
+};
+
+}  // namespace
+
+class V4l2CameraTest : public testing::Test {
+ protected:
+  V4l2CameraTest()
+      : frame_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                     base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  void SetUp() override {
+    device_ = base::MakeRefCounted<FakeV4l2Device>();
+    camera_.reset(new V4l2Camera(
+        CameraDescriptor("Fake Camera", "/dev/video0", "fake"), device_));
+    ASSERT_TRUE(camera_->Init().ok());
+  }
+
+  void Start(bool lend_buffers, uint32_t num_buffers) {
+    camera_->set_lend_buffers(lend_buffers);
+    camera_->set_num_buffers(num_buffers);
+    ASSERT_TRUE(camera_
+                    ->Start(CameraFormat(kWidth, kHeight, PIXEL_FORMAT_YUY2,
+                                         30),
+                            base::BindRepeating(&V4l2CameraTest::OnCameraFrame,
+                                                base::Unretained(this)),
+                            base::BindRepeating(&V4l2CameraTest::OnCameraError,
+                                                base::Unretained(this)))
+                    .ok());
+    ASSERT_EQ(num_buffers, device_->num_queued());
+    task_runner_ = camera_->task_runner_;
+  }
+
+  // Captures a frame filled with |value|, and waits until the camera
+  // delivers it.
+  CameraFrame Capture(uint8_t value) {
+    EXPECT_TRUE(device_->CaptureFrame(value));
+    frame_event_.Wait();
+    base::AutoLock l(lock_);
+    CameraFrame camera_frame = std::move(camera_frames_.front());
+    camera_frames_.pop_front();
+    return camera_frame;
+  }
+
+  // Waits until the tasks posted to the capture thread so far are run, e.g,
+  // requeueing the buffers given back.
+  void FlushCaptureThread() {
+    base::WaitableEvent event;
+    task_runner_->PostTask(FROM_HERE,
+                           base::BindOnce(&base::WaitableEvent::Signal,
+                                          base::Unretained(&event)));
+    event.Wait();
+  }
+
+  void OnCameraFrame(CameraFrame&& camera_frame) {
+    {
+      base::AutoLock l(lock_);
+      camera_frames_.push_back(std::move(camera_frame));
+    }
+    frame_event_.Signal();
+  }
+
+  void OnCameraError(Status s) { ADD_FAILURE() << s; }
+
+  scoped_refptr<FakeV4l2Device> device_;
+  std::unique_ptr<V4l2Camera> camera_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  base::Lock lock_;
+  std::deque<CameraFrame> camera_frames_;
+  base::WaitableEvent frame_event_;
+};
+
+TEST_F(V4l2CameraTest, CopiesWhenNotLending) {
+  Start(false, 3);
+  CameraFrame camera_frame = Capture(7);
+  EXPECT_FALSE(camera_frame.is_lent());
+  EXPECT_EQ(kBufferSize, camera_frame.length());
+  EXPECT_EQ(7, camera_frame.raw_data()[0]);
+  FlushCaptureThread();
+  EXPECT_EQ(3u, device_->num_queued());
+  EXPECT_TRUE(camera_->Stop().ok());
+  EXPECT_EQ(0, device_->num_mapped());
+}
+
+TEST_F(V4l2CameraTest, RequeuesLentBufferWhenReleased) {
+  Start(true, 3);
+  base::Optional<CameraFrame> camera_frame(Capture(7));
+  EXPECT_TRUE(camera_frame->is_lent());
+  EXPECT_EQ(kBufferSize, camera_frame->length());
+  EXPECT_EQ(7, camera_frame->raw_data()[kBufferSize - 1]);
+  // The driver can't export it.
+  EXPECT_EQ(-1, camera_frame->lent_buffer()->dmabuf_fd());
+  EXPECT_EQ(2u, device_->num_queued());
+
+  // The copy and the moved one refer to the same buffer.
+  base::Optional<CameraFrame> copied(*camera_frame);
+  CameraFrame moved(std::move(*camera_frame));
+  camera_frame.reset();
+  copied.reset();
+  FlushCaptureThread();
+  EXPECT_EQ(2u, device_->num_queued());
+  EXPECT_EQ(7, moved.raw_data()[0]);
+
+  moved = CameraFrame();
+  FlushCaptureThread();
+  EXPECT_EQ(3u, device_->num_queued());
+  EXPECT_TRUE(camera_->Stop().ok());
+  EXPECT_EQ(0, device_->num_mapped());
+}
+
+TEST_F(V4l2CameraTest, MaterializeRequeuesLentBuffer) {
+  Start(true, 3);
+  CameraFrame camera_frame = Capture(7);
+  camera_frame.Materialize();
+  EXPECT_FALSE(camera_frame.is_lent());
+  FlushCaptureThread();
+  EXPECT_EQ(3u, device_->num_queued());
+  // The buffer can be filled again without changing the frame.
+  EXPECT_TRUE(device_->CaptureFrame(8) && device_->CaptureFrame(8) &&
+              device_->CaptureFrame(8));
+  EXPECT_EQ(7, camera_frame.raw_data()[0]);
+}
+
+TEST_F(V4l2CameraTest, KeepsOneBufferInDriver) {
+  Start(true, 2);
+  CameraFrame lent = Capture(1);
+  EXPECT_TRUE(lent.is_lent());
+  EXPECT_EQ(1u, device_->num_queued());
+
+  // Lending the last buffer would stall the driver, so it is copied.
+  CameraFrame copied = Capture(2);
+  EXPECT_FALSE(copied.is_lent());
+  EXPECT_EQ(2, copied.raw_data()[0]);
+  EXPECT_EQ(1, lent.raw_data()[0]);
+  FlushCaptureThread();
+  EXPECT_EQ(1u, device_->num_queued());
+
+  lent = CameraFrame();
+  FlushCaptureThread();
+  EXPECT_EQ(2u, device_->num_queued());
+  EXPECT_TRUE(Capture(3).is_lent());
+}
+
+TEST_F(V4l2CameraTest, LentBufferOutlivesStop) {
+  Start(true, 3);
+  CameraFrame camera_frame = Capture(7);
+  EXPECT_TRUE(camera_->Stop().ok());
+  EXPECT_FALSE(device_->streaming());
+  // Every buffer stays mapped until the frame is released.
+  EXPECT_EQ(3, device_->num_mapped());
+  EXPECT_EQ(7, camera_frame.raw_data()[0]);
+
+  camera_frame = CameraFrame();
+  FlushCaptureThread();
+  EXPECT_EQ(0, device_->num_mapped());
+  // It isn't requeued to the stopped stream.
+  EXPECT_EQ(0u, device_->num_queued());
+}
+
+TEST_F(V4l2CameraTest, StopsWhenDestroyed) {
+  Start(true, 3);
+  camera_.reset();
+  EXPECT_FALSE(device_->streaming());
+  EXPECT_EQ(0, device_->num_mapped());
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
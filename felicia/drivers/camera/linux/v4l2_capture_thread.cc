@@ -0,0 +1,68 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/linux/v4l2_capture_thread.h"
+
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
+
+namespace felicia {
+namespace drivers {
+
+constexpr size_t V4l2CaptureThread::kDefaultMaxCamerasPerThread;
+
+// static
+V4l2CaptureThread& V4l2CaptureThread::GetInstance() {
+  static base::NoDestructor<V4l2CaptureThread> capture_thread;
+  return *capture_thread;
+}
+
+V4l2CaptureThread::V4l2CaptureThread()
+    : max_cameras_per_thread_(kDefaultMaxCamerasPerThread) {}
+
+V4l2CaptureThread::~V4l2CaptureThread() = default;
+
+void V4l2CaptureThread::set_max_cameras_per_thread(
+    size_t max_cameras_per_thread) {
+  DCHECK_GT(max_cameras_per_thread, 0u);
+  base::AutoLock l(lock_);
+  max_cameras_per_thread_ = max_cameras_per_thread;
+}
+
+scoped_refptr<base::SingleThreadTaskRunner> V4l2CaptureThread::Acquire() {
+  base::AutoLock l(lock_);
+  Entry* least_busy = nullptr;
+  for (auto& entry : entries_) {
+    if (!least_busy || entry.num_cameras < least_busy->num_cameras)
+      least_busy = &entry;
+  }
+
+  if (!least_busy || least_busy->num_cameras >= max_cameras_per_thread_) {
+    Entry entry;
+    entry.thread = std::make_unique<base::Thread>(
+        base::StringPrintf("V4l2CaptureThread%zu", entries_.size()));
+    entry.thread->StartWithOptions(
+        base::Thread::Options{base::MessageLoop::TYPE_IO, 0});
+    entries_.push_back(std::move(entry));
+    least_busy = &entries_.back();
+  }
+  least_busy->num_cameras++;
+  return least_busy->thread->task_runner();
+}
+
+void V4l2CaptureThread::Release(
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner) {
+  base::AutoLock l(lock_);
+  for (auto& entry : entries_) {
+    if (entry.thread->task_runner() == task_runner) {
+      DCHECK_GT(entry.num_cameras, 0u);
+      entry.num_cameras--;
+      return;
+    }
+  }
+  NOTREACHED();
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,65 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_DRIVERS_CAMERA_LINUX_V4L2_CAPTURE_THREAD_H_
+#define FELICIA_DRIVERS_CAMERA_LINUX_V4L2_CAPTURE_THREAD_H_
+
+#include <memory>
+#include <vector>
+
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/no_destructor.h"
+#include "third_party/chromium/base/single_thread_task_runner.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
+#include "third_party/chromium/base/threading/thread.h"
+
+#include "felicia/core/lib/base/export.h"
+
+namespace felicia {
+namespace drivers {
+
+// IO threads shared by every V4l2Camera in the process. A camera doesn't own
+// a thread, but watches its fd on one of these, which sleeps in epoll until
+// any of its cameras has a frame. A new thread is started only when every
+// thread already serves |max_cameras_per_thread| cameras, so that
+// converting the frames of many cameras doesn't pile up on a single thread.
+class FEL_EXPORT V4l2CaptureThread {
+ public:
+  static constexpr size_t kDefaultMaxCamerasPerThread = 4;
+
+  static V4l2CaptureThread& GetInstance();
+
+  // Takes effect on the cameras started from now on.
+  void set_max_cameras_per_thread(size_t max_cameras_per_thread);
+
+  // Returns the task runner of the least busy thread, on which a camera
+  // watches its fd until it calls |Release()|.
+  scoped_refptr<base::SingleThreadTaskRunner> Acquire();
+  void Release(scoped_refptr<base::SingleThreadTaskRunner> task_runner);
+
+ private:
+  friend class base::NoDestructor<V4l2CaptureThread>;
+
+  struct Entry {
+    std::unique_ptr<base::Thread> thread;
+    size_t num_cameras = 0;
+  };
+
+  V4l2CaptureThread();
+  ~V4l2CaptureThread();
+
+  base::Lock lock_;
+  size_t max_cameras_per_thread_ GUARDED_BY(lock_);
+  // Threads are kept running once started. They cost nothing while they
+  // have no fd to watch.
+  std::vector<Entry> entries_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(V4l2CaptureThread);
+};
+
+}  // namespace drivers
+}  // namespace felicia
+
+#endif  // FELICIA_DRIVERS_CAMERA_LINUX_V4L2_CAPTURE_THREAD_H_
\ No newline at end of file
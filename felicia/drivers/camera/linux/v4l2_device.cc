@@ -0,0 +1,38 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/linux/v4l2_device.h"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include "third_party/chromium/base/posix/eintr_wrapper.h"
+
+namespace felicia {
+namespace drivers {
+
+V4l2DeviceImpl::V4l2DeviceImpl() = default;
+
+V4l2DeviceImpl::~V4l2DeviceImpl() = default;
+
+int V4l2DeviceImpl::open(const char* device_name, int flags) {
+  return HANDLE_EINTR(::open(device_name, flags));
+}
+
+int V4l2DeviceImpl::ioctl(int fd, int request, void* argp) {
+  return HANDLE_EINTR(::ioctl(fd, request, argp));
+}
+
+void* V4l2DeviceImpl::mmap(void* start, size_t length, int prot, int flags,
+                           int fd, off_t offset) {
+  return ::mmap(start, length, prot, flags, fd, offset);
+}
+
+int V4l2DeviceImpl::munmap(void* start, size_t length) {
+  return ::munmap(start, length);
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,61 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_DRIVERS_CAMERA_LINUX_V4L2_DEVICE_H_
+#define FELICIA_DRIVERS_CAMERA_LINUX_V4L2_DEVICE_H_
+
+#include <sys/types.h>
+
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/memory/ref_counted.h"
+
+#include "felicia/core/lib/base/export.h"
+
+namespace felicia {
+namespace drivers {
+
+// The system calls which V4l2Camera makes on a device, so that it can be
+// tested against a fake one. It's ref-counted because the buffers lent to
+// CameraFrame are unmapped through it, even after the camera is destroyed.
+// The fd returned by |open()| is closed by close(2).
+class FEL_EXPORT V4l2Device : public base::RefCountedThreadSafe<V4l2Device> {
+ public:
+  V4l2Device() = default;
+
+  virtual int open(const char* device_name, int flags) = 0;
+  virtual int ioctl(int fd, int request, void* argp) = 0;
+  virtual void* mmap(void* start, size_t length, int prot, int flags, int fd,
+                     off_t offset) = 0;
+  virtual int munmap(void* start, size_t length) = 0;
+
+ protected:
+  friend class base::RefCountedThreadSafe<V4l2Device>;
+  virtual ~V4l2Device() = default;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(V4l2Device);
+};
+
+// Makes the calls on the real device.
+class FEL_EXPORT V4l2DeviceImpl : public V4l2Device {
+ public:
+  V4l2DeviceImpl();
+
+  // V4l2Device methods
+  int open(const char* device_name, int flags) override;
+  int ioctl(int fd, int request, void* argp) override;
+  void* mmap(void* start, size_t length, int prot, int flags, int fd,
+             off_t offset) override;
+  int munmap(void* start, size_t length) override;
+
+ private:
+  ~V4l2DeviceImpl() override;
+
+  DISALLOW_COPY_AND_ASSIGN(V4l2DeviceImpl);
+};
+
+}  // namespace drivers
+}  // namespace felicia
+
+#endif  // FELICIA_DRIVERS_CAMERA_LINUX_V4L2_DEVICE_H_
\ No newline at end of file
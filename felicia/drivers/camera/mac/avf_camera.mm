@@ -149,11 +149,11 @@ void AvfCamera::ReceiveFrame(const uint8_t* video_frame, int video_frame_length,
     return;
   }
 
-  if (requested_pixel_format_ == camera_format_.pixel_format()) {
-    Data data(video_frame, video_frame_length);
+  if (!NeedsConversion()) {
+    Data data = Data::CopyFromPool(video_frame, video_frame_length);
     camera_frame_callback_.Run(CameraFrame{std::move(data), camera_format_, timestamp});
   } else {
-    base::Optional<CameraFrame> camera_frame = ConvertToRequestedPixelFormat(
+    base::Optional<CameraFrame> camera_frame = pixel_format_converter_.Convert(
         video_frame, video_frame_length, camera_format_, requested_pixel_format_, timestamp);
     if (camera_frame.has_value()) {
       camera_frame_callback_.Run(std::move(camera_frame.value()));
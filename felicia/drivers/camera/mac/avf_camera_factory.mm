@@ -6,13 +6,20 @@
 
 #include "third_party/chromium/base/memory/ptr_util.h"
 
+#include "felicia/drivers/camera/file_camera.h"
 #include "felicia/drivers/camera/mac/avf_camera.h"
+#include "felicia/drivers/camera/synthetic_camera.h"
 
 namespace felicia {
 namespace drivers {
 
 // static
 std::unique_ptr<CameraInterface> CameraFactory::NewCamera(const CameraDescriptor& descriptor) {
+  if (SyntheticCamera::IsSyntheticCamera(descriptor)) {
+    return base::WrapUnique(new SyntheticCamera(descriptor));
+  } else if (FileCamera::IsFileCamera(descriptor)) {
+    return base::WrapUnique(new FileCamera(descriptor));
+  }
   return base::WrapUnique(new AvfCamera(descriptor));
 }
 
@@ -26,6 +33,11 @@ Status CameraFactory::GetCameraDescriptors(CameraDescriptors* camera_descriptors
 Status CameraFactory::GetSupportedCameraFormats(const CameraDescriptor& camera_descriptor,
                                                 CameraFormats* camera_formats) {
   DCHECK(camera_formats->empty());
+  if (SyntheticCamera::IsSyntheticCamera(camera_descriptor)) {
+    return SyntheticCamera::GetSupportedCameraFormats(camera_descriptor, camera_formats);
+  } else if (FileCamera::IsFileCamera(camera_descriptor)) {
+    return FileCamera::GetSupportedCameraFormats(camera_descriptor, camera_formats);
+  }
   return AvfCamera::GetSupportedCameraFormats(camera_descriptor, camera_formats);
 }
 
@@ -0,0 +1,133 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/memory_camera.h"
+
+#include <algorithm>
+
+#include "third_party/chromium/base/bind.h"
+
+#include "felicia/drivers/camera/camera_errors.h"
+
+namespace felicia {
+namespace drivers {
+
+MemoryCamera::MemoryCamera(const CameraDescriptor& camera_descriptor)
+    : CameraInterface(camera_descriptor), thread_("MemoryCameraThread") {}
+
+MemoryCamera::~MemoryCamera() {
+  if (camera_state_.IsStarted()) Stop();
+}
+
+Status MemoryCamera::Start(const CameraFormat& requested_camera_format,
+                           CameraFrameCallback camera_frame_callback,
+                           StatusCallback status_callback) {
+  if (!camera_state_.IsInitialized()) {
+    return camera_state_.InvalidStateError();
+  }
+
+  Status s = PrepareFrames(requested_camera_format);
+  if (!s.ok()) return s;
+  if (frames_.empty() || camera_format_.frame_rate() <= 0) {
+    return felicia::errors::InvalidArgument("No frames to deliver.");
+  }
+  requested_pixel_format_ = requested_camera_format.pixel_format();
+  DVLOG(0) << "Set CameraFormat to " << camera_format_.ToString();
+
+  if (!thread_.Start()) {
+    return felicia::errors::Unavailable("Failed to start the camera thread.");
+  }
+
+  {
+    base::AutoLock l(lock_);
+    stats_ = Stats();
+  }
+  interval_ = base::TimeDelta::FromSecondsD(1.0 / camera_format_.frame_rate());
+  next_capture_time_ = base::TimeTicks::Now();
+  next_frame_ = 0;
+  camera_frame_callback_ = camera_frame_callback;
+  status_callback_ = status_callback;
+  camera_state_.ToStarted();
+
+  thread_.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&MemoryCamera::DoCapture, base::Unretained(this)));
+
+  return Status::OK();
+}
+
+Status MemoryCamera::Stop() {
+  if (!camera_state_.IsStarted()) {
+    return camera_state_.InvalidStateError();
+  }
+
+  // Waits for the frame being delivered, and drops the next one.
+  thread_.Stop();
+
+  camera_frame_callback_.Reset();
+  status_callback_.Reset();
+  camera_state_.ToStopped();
+
+  return Status::OK();
+}
+
+MemoryCamera::Stats MemoryCamera::stats() const {
+  base::AutoLock l(lock_);
+  return stats_;
+}
+
+void MemoryCamera::DoCapture() {
+  DCHECK(thread_.task_runner()->BelongsToCurrentThread());
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const int64_t missed = (now - next_capture_time_) / interval_;
+  if (missed > 0) {
+    next_capture_time_ += interval_ * missed;
+    next_frame_ += missed;
+  }
+
+  const bool has_thread_ticks = base::ThreadTicks::IsSupported();
+  const base::ThreadTicks thread_now =
+      has_thread_ticks ? base::ThreadTicks::Now() : base::ThreadTicks();
+  const std::string& frame = frames_[next_frame_ % frames_.size()];
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(frame.data());
+  const base::TimeDelta timestamp = timestamper_.timestamp(now);
+  base::Optional<CameraFrame> camera_frame;
+  if (!NeedsConversion()) {
+    camera_frame.emplace(Data::CopyFromPool(data, frame.length()),
+                         camera_format_, timestamp);
+  } else {
+    camera_frame = pixel_format_converter_.Convert(
+        data, frame.length(), camera_format_, requested_pixel_format_,
+        timestamp);
+  }
+
+  {
+    base::AutoLock l(lock_);
+    if (camera_frame.has_value()) stats_.frames++;
+    stats_.dropped_frames += std::max(missed, int64_t{0});
+    stats_.total_capture_time += base::TimeTicks::Now() - now;
+    if (has_thread_ticks) {
+      stats_.total_capture_cpu_time += base::ThreadTicks::Now() - thread_now;
+    }
+  }
+
+  if (camera_frame.has_value()) {
+    camera_frame_callback_.Run(std::move(camera_frame.value()));
+  } else {
+    status_callback_.Run(
+        errors::FailedToConvertToRequestedPixelFormat(requested_pixel_format_));
+  }
+
+  next_frame_++;
+  next_capture_time_ += interval_;
+  // If the next frame is already due, it is captured right away, and the ones
+  // missed are dropped then.
+  thread_.task_runner()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&MemoryCamera::DoCapture, base::Unretained(this)),
+      std::max(base::TimeDelta(), next_capture_time_ - base::TimeTicks::Now()));
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
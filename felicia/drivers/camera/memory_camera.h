@@ -0,0 +1,85 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_DRIVERS_CAMERA_MEMORY_CAMERA_H_
+#define FELICIA_DRIVERS_CAMERA_MEMORY_CAMERA_H_
+
+#include <string>
+#include <vector>
+
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
+#include "third_party/chromium/base/threading/thread.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/util/timestamp/timestamper.h"
+#include "felicia/drivers/camera/camera_interface.h"
+
+namespace felicia {
+namespace drivers {
+
+// Base of the cameras without a device, which deliver frames held in memory
+// over and over at the frame rate, as if they were captured. Frames are
+// copied into buffers from DataPool or converted by |pixel_format_converter_|
+// on its own thread, as a device driver does, so what comes after the
+// camera can be measured without a device. Buffers are never lent.
+//
+// If a frame is delivered later than the next one is due, e.g, the callback
+// or the conversion takes longer than the frame interval, the frames missed
+// in the meantime are dropped as a camera does.
+class FEL_EXPORT MemoryCamera : public CameraInterface {
+ public:
+  // How the camera kept up with the frame rate.
+  struct Stats {
+    int64_t frames = 0;
+    int64_t dropped_frames = 0;
+    // Copying or converting frames, until they are passed to the callback.
+    base::TimeDelta total_capture_time;
+    // CPU time of the same, which is zero if base::ThreadTicks isn't
+    // supported.
+    base::TimeDelta total_capture_cpu_time;
+  };
+
+  ~MemoryCamera() override;
+
+  // CameraInterface methods
+  Status Start(const CameraFormat& requested_camera_format,
+               CameraFrameCallback camera_frame_callback,
+               StatusCallback status_callback) override;
+  Status Stop() override;
+
+  // Thread safe. It's reset on |Start()|.
+  Stats stats() const;
+
+ protected:
+  explicit MemoryCamera(const CameraDescriptor& camera_descriptor);
+
+  // Fills |frames_| and sets |camera_format_| for |requested_camera_format|.
+  // Every frame should be of |camera_format_|.
+  virtual Status PrepareFrames(const CameraFormat& requested_camera_format) = 0;
+
+  std::vector<std::string> frames_;
+
+ private:
+  void DoCapture();
+
+  base::Thread thread_;
+  Timestamper timestamper_;
+
+  // Used on |thread_|.
+  base::TimeDelta interval_;
+  base::TimeTicks next_capture_time_;
+  size_t next_frame_ = 0;
+
+  mutable base::Lock lock_;
+  Stats stats_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryCamera);
+};
+
+}  // namespace drivers
+}  // namespace felicia
+
+#endif  // FELICIA_DRIVERS_CAMERA_MEMORY_CAMERA_H_
\ No newline at end of file
@@ -0,0 +1,211 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/memory_camera.h"
+
+#include <string.h>
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/files/file_util.h"
+#include "third_party/chromium/base/files/scoped_temp_dir.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/synchronization/waitable_event.h"
+#include "third_party/chromium/base/threading/platform_thread.h"
+
+#include "felicia/drivers/camera/camera_factory.h"
+#include "felicia/drivers/camera/file_camera.h"
+#include "felicia/drivers/camera/synthetic_camera.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr int kY4mWidth = 8;
+constexpr int kY4mHeight = 4;
+constexpr size_t kY4mFrameSize = kY4mWidth * kY4mHeight * 3 / 2;
+
+// Writes a Y4M of two 4:2:0 frames filled with 1 and 2, followed by a third
+// one which is cut off.
+bool WriteY4m(const base::FilePath& path) {
+  std::string y4m = "YUV4MPEG2 W8 H4 F25:1 Ip A1:1 C420jpeg\n";
+  for (char value : {1, 2}) {
+    y4m += "FRAME\n";
+    y4m += std::string(kY4mFrameSize, value);
+  }
+  y4m += "FRAME\n";
+  y4m += std::string(kY4mFrameSize / 2, 3);
+  return base::WriteFile(path, y4m.data(), y4m.length()) ==
+         static_cast<int>(y4m.length());
+}
+
+}  // namespace
+
+class MemoryCameraTest : public testing::Test {
+ protected:
+  MemoryCameraTest()
+      : frame_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                     base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  void Start(const CameraDescriptor& camera_descriptor,
+             const CameraFormat& requested_camera_format) {
+    camera_ = CameraFactory::NewCamera(camera_descriptor);
+    ASSERT_TRUE(camera_);
+    ASSERT_TRUE(camera_->Init().ok());
+    Status s = camera_->Start(
+        requested_camera_format,
+        base::BindRepeating(&MemoryCameraTest::OnCameraFrame,
+                            base::Unretained(this)),
+        base::BindRepeating(&MemoryCameraTest::OnCameraError,
+                            base::Unretained(this)));
+    ASSERT_TRUE(s.ok()) << s;
+  }
+
+  // Waits until |num_frames| frames are delivered, and stops the camera.
+  std::vector<CameraFrame> WaitAndStop(size_t num_frames) {
+    while (true) {
+      {
+        base::AutoLock l(lock_);
+        if (camera_frames_.size() >= num_frames) break;
+      }
+      frame_event_.Wait();
+    }
+    EXPECT_TRUE(camera_->Stop().ok());
+    base::AutoLock l(lock_);
+    return std::move(camera_frames_);
+  }
+
+  MemoryCamera::Stats stats() const {
+    return static_cast<MemoryCamera*>(camera_.get())->stats();
+  }
+
+  void OnCameraFrame(CameraFrame&& camera_frame) {
+    {
+      base::AutoLock l(lock_);
+      camera_frames_.push_back(std::move(camera_frame));
+    }
+    if (!first_frame_delay_.is_zero()) {
+      base::PlatformThread::Sleep(first_frame_delay_);
+      first_frame_delay_ = base::TimeDelta();
+    }
+    frame_event_.Signal();
+  }
+
+  void OnCameraError(Status s) { ADD_FAILURE() << s; }
+
+  std::unique_ptr<CameraInterface> camera_;
+  // The callback blocks the camera this long on the first frame.
+  base::TimeDelta first_frame_delay_;
+  base::Lock lock_;
+  std::vector<CameraFrame> camera_frames_;
+  base::WaitableEvent frame_event_;
+};
+
+TEST_F(MemoryCameraTest, FileCameraReplaysY4m) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  const base::FilePath path = dir.GetPath().AppendASCII("frames.y4m");
+  ASSERT_TRUE(WriteY4m(path));
+  const CameraDescriptor camera_descriptor =
+      FileCamera::MakeCameraDescriptor(path);
+
+  CameraFormats camera_formats;
+  ASSERT_TRUE(CameraFactory::GetSupportedCameraFormats(camera_descriptor,
+                                                       &camera_formats)
+                  .ok());
+  ASSERT_EQ(1u, camera_formats.size());
+  EXPECT_EQ(kY4mWidth, camera_formats[0].width());
+  EXPECT_EQ(kY4mHeight, camera_formats[0].height());
+  EXPECT_EQ(PIXEL_FORMAT_I420, camera_formats[0].pixel_format());
+  EXPECT_EQ(25, camera_formats[0].frame_rate());
+
+  // Faster than the file to finish soon.
+  Start(camera_descriptor, CameraFormat(0, 0, PIXEL_FORMAT_I420, 100));
+  std::vector<CameraFrame> camera_frames = WaitAndStop(5);
+  const MemoryCamera::Stats stats = this->stats();
+  EXPECT_EQ(static_cast<int64_t>(camera_frames.size()), stats.frames);
+
+  // The frame which is cut off is never delivered, and it loops over the
+  // other two.
+  int expected = 1;
+  for (const CameraFrame& camera_frame : camera_frames) {
+    EXPECT_EQ(kY4mWidth, camera_frame.camera_format().width());
+    EXPECT_EQ(kY4mHeight, camera_frame.camera_format().height());
+    EXPECT_EQ(PIXEL_FORMAT_I420, camera_frame.camera_format().pixel_format());
+    EXPECT_EQ(100, camera_frame.camera_format().frame_rate());
+    ASSERT_EQ(kY4mFrameSize, camera_frame.length());
+    const int value = camera_frame.raw_data()[0];
+    EXPECT_TRUE(value == 1 || value == 2) << value;
+    EXPECT_EQ(std::string(kY4mFrameSize, static_cast<char>(value)),
+              std::string(reinterpret_cast<const char*>(
+                              camera_frame.raw_data()),
+                          camera_frame.length()));
+    // Frames are in order unless any of them is dropped.
+    if (stats.dropped_frames == 0) EXPECT_EQ(expected, value);
+    expected = 3 - expected;
+  }
+}
+
+TEST_F(MemoryCameraTest, FileCameraRejectsBadY4m) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  const base::FilePath path = dir.GetPath().AppendASCII("frames.y4m");
+  std::unique_ptr<CameraInterface> camera;
+  // Neither 4:4:4 nor high bit depth 4:2:0 is supported.
+  for (const char* chroma : {"444", "420p10", "420p12"}) {
+    const std::string y4m =
+        std::string("YUV4MPEG2 W8 H4 C") + chroma + "\nFRAME\n";
+    ASSERT_EQ(static_cast<int>(y4m.length()),
+              base::WriteFile(path, y4m.data(), y4m.length()));
+    camera = CameraFactory::NewCamera(FileCamera::MakeCameraDescriptor(path));
+    EXPECT_TRUE(felicia::errors::IsUnimplemented(camera->Init())) << chroma;
+  }
+
+  camera = CameraFactory::NewCamera(FileCamera::MakeCameraDescriptor(
+      dir.GetPath().AppendASCII("missing.y4m")));
+  EXPECT_FALSE(camera->Init().ok());
+}
+
+TEST_F(MemoryCameraTest, SyntheticCameraConverts) {
+  Start(SyntheticCamera::MakeCameraDescriptor(PIXEL_FORMAT_YUY2),
+        CameraFormat(64, 48, PIXEL_FORMAT_I420, 100));
+  std::vector<CameraFrame> camera_frames = WaitAndStop(3);
+  EXPECT_EQ(static_cast<int64_t>(camera_frames.size()), stats().frames);
+
+  const CameraFormat i420(64, 48, PIXEL_FORMAT_I420, 100);
+  for (const CameraFrame& camera_frame : camera_frames) {
+    EXPECT_EQ(64, camera_frame.camera_format().width());
+    EXPECT_EQ(48, camera_frame.camera_format().height());
+    EXPECT_EQ(PIXEL_FORMAT_I420, camera_frame.camera_format().pixel_format());
+    EXPECT_EQ(i420.AllocationSize(), camera_frame.length());
+  }
+  // The scene pans.
+  EXPECT_NE(0, memcmp(camera_frames[0].raw_data(), camera_frames[1].raw_data(),
+                      camera_frames[0].length()));
+}
+
+TEST_F(MemoryCameraTest, SyntheticCameraDropsLateFrames) {
+  // At 100 fps, the callback blocking for 45ms makes the camera miss at least
+  // 3 frames.
+  first_frame_delay_ = base::TimeDelta::FromMilliseconds(45);
+  Start(SyntheticCamera::MakeCameraDescriptor(PIXEL_FORMAT_I420),
+        CameraFormat(32, 16, PIXEL_FORMAT_I420, 100));
+  std::vector<CameraFrame> camera_frames = WaitAndStop(3);
+
+  const MemoryCamera::Stats stats = this->stats();
+  EXPECT_EQ(static_cast<int64_t>(camera_frames.size()), stats.frames);
+  EXPECT_GE(stats.dropped_frames, 3);
+  for (const CameraFrame& camera_frame : camera_frames) {
+    EXPECT_EQ(PIXEL_FORMAT_I420, camera_frame.camera_format().pixel_format());
+    EXPECT_EQ(32, camera_frame.camera_format().width());
+    EXPECT_EQ(16, camera_frame.camera_format().height());
+  }
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,558 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/pixel_format_converter.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "libyuv.h"
+#include "third_party/chromium/base/barrier_closure.h"
+#include "third_party/chromium/base/bind.h"
+#include "third_party/chromium/base/strings/stringprintf.h"
+#include "third_party/chromium/base/synchronization/waitable_event.h"
+
+#include "felicia/core/lib/error/errors.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+// Bands shorter than this aren't worth a thread hop.
+constexpr int kMinBandHeight = 64;
+
+bool IsI420Like(PixelFormat pixel_format) {
+  return pixel_format == PIXEL_FORMAT_I420 || pixel_format == PIXEL_FORMAT_YV12;
+}
+
+bool IsRGB(PixelFormat pixel_format) {
+  switch (pixel_format) {
+    case PIXEL_FORMAT_BGR:
+    case PIXEL_FORMAT_RGB:
+    case PIXEL_FORMAT_RGBA:
+    case PIXEL_FORMAT_ARGB:
+      return true;
+    default:
+      return false;
+  }
+}
+
+int HalfOf(int value) { return (value + 1) / 2; }
+
+size_t FrameSize(int width, int height, PixelFormat pixel_format) {
+  return CameraFormat(width, height, pixel_format, 0).AllocationSize();
+}
+
+uint32_t ToFourCC(PixelFormat pixel_format) {
+  CameraFormat camera_format;
+  camera_format.set_pixel_format(pixel_format);
+  return camera_format.ToLibyuvPixelFormat();
+}
+
+// Planes of a frame at |row|, which must be even for the subsampled formats.
+// The chroma planes of YV12 are swapped, so that they are always in the
+// order of Y, U and V.
+struct Planes {
+  uint8_t* data[3];
+  int stride[3];
+};
+
+bool GetPlanes(const uint8_t* frame, int width, int height,
+               PixelFormat pixel_format, int row, Planes* planes) {
+  uint8_t* base = const_cast<uint8_t*>(frame);
+  const int half_width = HalfOf(width);
+  const size_t y_size = width * height;
+  const size_t uv_size = half_width * HalfOf(height);
+  memset(planes, 0, sizeof(*planes));
+
+  switch (pixel_format) {
+    case PIXEL_FORMAT_I420:
+    case PIXEL_FORMAT_YV12: {
+      uint8_t* u = base + y_size + (row / 2) * half_width;
+      uint8_t* v = base + y_size + uv_size + (row / 2) * half_width;
+      if (pixel_format == PIXEL_FORMAT_YV12) std::swap(u, v);
+      planes->data[0] = base + row * width;
+      planes->data[1] = u;
+      planes->data[2] = v;
+      planes->stride[0] = width;
+      planes->stride[1] = half_width;
+      planes->stride[2] = half_width;
+      return true;
+    }
+    case PIXEL_FORMAT_NV12:
+    case PIXEL_FORMAT_NV21:
+      planes->data[0] = base + row * width;
+      planes->data[1] = base + y_size + (row / 2) * half_width * 2;
+      planes->stride[0] = width;
+      planes->stride[1] = half_width * 2;
+      return true;
+    case PIXEL_FORMAT_YUY2:
+    case PIXEL_FORMAT_UYVY:
+      planes->stride[0] = half_width * 4;
+      break;
+    case PIXEL_FORMAT_BGRA:
+    case PIXEL_FORMAT_RGBA:
+    case PIXEL_FORMAT_ARGB:
+      planes->stride[0] = width * 4;
+      break;
+    case PIXEL_FORMAT_BGR:
+    case PIXEL_FORMAT_RGB:
+      planes->stride[0] = width * 3;
+      break;
+    default:
+      return false;
+  }
+  planes->data[0] = base + row * planes->stride[0];
+  return true;
+}
+
+// Converts between planes. |from| is one of I420, YV12, BGRA and YUY2.
+bool ConvertPlanes(const Planes& src, PixelFormat from, const Planes& dst,
+                   PixelFormat to, int width, int height) {
+  const uint8_t* const* s = const_cast<const uint8_t* const*>(src.data);
+  const int* ss = src.stride;
+  uint8_t* const* d = dst.data;
+  const int* ds = dst.stride;
+
+  // libyuv names formats after the order of a 32 bit word on a little endian
+  // machine, e.g, what libyuv calls ARGB is BGRA in memory.
+  if (from == PIXEL_FORMAT_BGRA) {
+    switch (to) {
+      case PIXEL_FORMAT_NV12:
+        return libyuv::ARGBToNV12(s[0], ss[0], d[0], ds[0], d[1], ds[1], width,
+                                  height) == 0;
+      case PIXEL_FORMAT_NV21:
+        return libyuv::ARGBToNV21(s[0], ss[0], d[0], ds[0], d[1], ds[1], width,
+                                  height) == 0;
+      case PIXEL_FORMAT_YUY2:
+        return libyuv::ARGBToYUY2(s[0], ss[0], d[0], ds[0], width, height) ==
+               0;
+      case PIXEL_FORMAT_UYVY:
+        return libyuv::ARGBToUYVY(s[0], ss[0], d[0], ds[0], width, height) ==
+               0;
+      case PIXEL_FORMAT_BGR:
+        return libyuv::ARGBToRGB24(s[0], ss[0], d[0], ds[0], width, height) ==
+               0;
+      case PIXEL_FORMAT_RGB:
+        return libyuv::ARGBToRAW(s[0], ss[0], d[0], ds[0], width, height) == 0;
+      case PIXEL_FORMAT_RGBA:
+        return libyuv::ARGBToABGR(s[0], ss[0], d[0], ds[0], width, height) ==
+               0;
+      case PIXEL_FORMAT_ARGB:
+        return libyuv::ARGBToBGRA(s[0], ss[0], d[0], ds[0], width, height) ==
+               0;
+      default:
+        return false;
+    }
+  }
+
+  if (from == PIXEL_FORMAT_YUY2) {
+    if (to != PIXEL_FORMAT_NV12) return false;
+    return libyuv::YUY2ToNV12(s[0], ss[0], d[0], ds[0], d[1], ds[1], width,
+                              height) == 0;
+  }
+
+  if (!IsI420Like(from)) return false;
+  switch (to) {
+    case PIXEL_FORMAT_NV12:
+      return libyuv::I420ToNV12(s[0], ss[0], s[1], ss[1], s[2], ss[2], d[0],
+                                ds[0], d[1], ds[1], width, height) == 0;
+    case PIXEL_FORMAT_NV21:
+      return libyuv::I420ToNV21(s[0], ss[0], s[1], ss[1], s[2], ss[2], d[0],
+                                ds[0], d[1], ds[1], width, height) == 0;
+    case PIXEL_FORMAT_YUY2:
+      return libyuv::I420ToYUY2(s[0], ss[0], s[1], ss[1], s[2], ss[2], d[0],
+                                ds[0], width, height) == 0;
+    case PIXEL_FORMAT_UYVY:
+      return libyuv::I420ToUYVY(s[0], ss[0], s[1], ss[1], s[2], ss[2], d[0],
+                                ds[0], width, height) == 0;
+    case PIXEL_FORMAT_BGR:
+      return libyuv::I420ToRGB24(s[0], ss[0], s[1], ss[1], s[2], ss[2], d[0],
+                                 ds[0], width, height) == 0;
+    case PIXEL_FORMAT_RGB:
+      return libyuv::I420ToRAW(s[0], ss[0], s[1], ss[1], s[2], ss[2], d[0],
+                               ds[0], width, height) == 0;
+    case PIXEL_FORMAT_RGBA:
+      return libyuv::I420ToABGR(s[0], ss[0], s[1], ss[1], s[2], ss[2], d[0],
+                                ds[0], width, height) == 0;
+    case PIXEL_FORMAT_ARGB:
+      return libyuv::I420ToBGRA(s[0], ss[0], s[1], ss[1], s[2], ss[2], d[0],
+                                ds[0], width, height) == 0;
+    default:
+      return false;
+  }
+}
+
+void RunBand(const base::RepeatingCallback<bool(int, int)>& callback,
+             int begin, int end, bool* result, base::OnceClosure done) {
+  *result = callback.Run(begin, end);
+  std::move(done).Run();
+}
+
+}  // namespace
+
+PixelFormatConverter::Stats::Stats() = default;
+
+PixelFormatConverter::Stats::Stats(const Stats& other) = default;
+
+PixelFormatConverter::Stats::~Stats() = default;
+
+std::string PixelFormatConverter::Stats::ToString() const {
+  if (frames == 0) return "No frames";
+  return base::StringPrintf(
+      "%" PRId64
+      " frames, convert: last %.2fms max %.2fms mean %.2fms, scale: last "
+      "%.2fms max %.2fms mean %.2fms",
+      frames, last_convert_time.InMillisecondsF(),
+      max_convert_time.InMillisecondsF(),
+      total_convert_time.InMillisecondsF() / frames,
+      last_scale_time.InMillisecondsF(), max_scale_time.InMillisecondsF(),
+      total_scale_time.InMillisecondsF() / frames);
+}
+
+PixelFormatConverter::PixelFormatConverter() = default;
+
+PixelFormatConverter::~PixelFormatConverter() = default;
+
+// static
+bool PixelFormatConverter::IsDirect(PixelFormat source, PixelFormat target) {
+  if (source == target) return true;
+  switch (target) {
+    case PIXEL_FORMAT_I420:
+    case PIXEL_FORMAT_YV12:
+    case PIXEL_FORMAT_BGRA:
+      return true;
+    case PIXEL_FORMAT_NV12:
+      return source == PIXEL_FORMAT_YUY2 || source == PIXEL_FORMAT_BGRA ||
+             IsI420Like(source);
+    case PIXEL_FORMAT_NV21:
+    case PIXEL_FORMAT_YUY2:
+    case PIXEL_FORMAT_UYVY:
+      return source == PIXEL_FORMAT_BGRA || IsI420Like(source);
+    case PIXEL_FORMAT_BGR:
+    case PIXEL_FORMAT_RGB:
+    case PIXEL_FORMAT_RGBA:
+    case PIXEL_FORMAT_ARGB:
+      return source == PIXEL_FORMAT_BGRA || IsI420Like(source);
+    default:
+      return false;
+  }
+}
+
+void PixelFormatConverter::set_num_threads(size_t num_threads) {
+  DCHECK_GE(num_threads, 1u);
+  workers_.clear();
+  for (size_t i = 1; i < num_threads; ++i) {
+    auto worker = std::make_unique<base::Thread>(
+        base::StringPrintf("PixelFormatConverterWorker%zu", i));
+    worker->Start();
+    workers_.push_back(std::move(worker));
+  }
+}
+
+bool PixelFormatConverter::Scales(const CameraFormat& camera_format) const {
+  return Scales(Sizei(camera_format.width(), camera_format.height()));
+}
+
+bool PixelFormatConverter::Scales(const Sizei& size) const {
+  return output_size_.width() > 0 && output_size_.height() > 0 &&
+         output_size_ != size;
+}
+
+Sizei PixelFormatConverter::GetMinDecodeSize(
+    const CameraFormat& camera_format) const {
+  if (!Scales(camera_format)) return Sizei();
+
+  // The part which is cropped has to be still as large as |output_size_|.
+  const double scale =
+      std::max(static_cast<double>(output_size_.width()) /
+                   camera_format.width(),
+               static_cast<double>(output_size_.height()) /
+                   camera_format.height());
+  return Sizei(static_cast<int>(std::ceil(camera_format.width() * scale)),
+               static_cast<int>(std::ceil(camera_format.height() * scale)));
+}
+
+base::Optional<CameraFrame> PixelFormatConverter::Convert(
+    const uint8_t* data, size_t data_length, const CameraFormat& camera_format,
+    PixelFormat requested_pixel_format, base::TimeDelta timestamp) {
+  if (requested_pixel_format == PIXEL_FORMAT_MJPEG) return base::nullopt;
+
+  const PixelFormat pixel_format = camera_format.pixel_format();
+  if (pixel_format != PIXEL_FORMAT_MJPEG &&
+      data_length < camera_format.AllocationSize()) {
+    return base::nullopt;
+  }
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  base::TimeDelta scale_time;
+  Source source = {data,
+                   data_length,
+                   camera_format.width(),
+                   camera_format.height(),
+                   pixel_format,
+                   0 /* crop_x */,
+                   0 /* crop_y */};
+  CameraFormat requested_camera_format = camera_format;
+  requested_camera_format.set_pixel_format(requested_pixel_format);
+  Data converted;
+
+  if (pixel_format == PIXEL_FORMAT_MJPEG) {
+    // |decoded_| is given away when it's returned as it is. The full size
+    // I420 is the largest it's decoded to.
+    if (decoded_.data().empty()) {
+      CameraFormat i420_camera_format = camera_format;
+      i420_camera_format.set_pixel_format(PIXEL_FORMAT_I420);
+      decoded_.data() =
+          Data::AllocateFromPool(i420_camera_format.AllocationSize());
+    }
+    Status s = jpeg_decoder_.DecodeToI420(
+        data, data_length, GetMinDecodeSize(camera_format), &decoded_);
+    if (s.ok()) {
+      source = {decoded_.data().cast<const uint8_t*>(),
+                decoded_.data().size(),
+                decoded_.width(),
+                decoded_.height(),
+                PIXEL_FORMAT_I420,
+                0 /* crop_x */,
+                0 /* crop_y */};
+      requested_camera_format.SetSize(decoded_.width(), decoded_.height());
+      if (requested_pixel_format == PIXEL_FORMAT_I420 &&
+          !Scales(decoded_.size())) {
+        UpdateStats(base::TimeTicks::Now() - start, scale_time);
+        return CameraFrame(std::move(decoded_.data()), requested_camera_format,
+                           timestamp);
+      }
+    } else if (!errors::IsUnimplemented(s)) {
+      return base::nullopt;
+    }
+    // Otherwise libyuv decodes it.
+  }
+
+  if (Scales(Sizei(source.width, source.height))) {
+    const int width = source.width;
+    const int height = source.height;
+    const int output_width = output_size_.width();
+    const int output_height = output_size_.height();
+    requested_camera_format.SetSize(output_width, output_height);
+
+    // Crops at the center to the aspect ratio of |output_size_|, on even
+    // pixels not to split the chroma samples.
+    int crop_width = width;
+    int crop_height = height;
+    if (static_cast<int64_t>(width) * output_height >
+        static_cast<int64_t>(height) * output_width) {
+      crop_width = height * output_width / output_height;
+    } else {
+      crop_height = width * output_height / output_width;
+    }
+    crop_width &= ~1;
+    crop_height &= ~1;
+    source.crop_x = ((width - crop_width) / 2) & ~1;
+    source.crop_y = ((height - crop_height) / 2) & ~1;
+
+    // Scales in I420 unless the frame ends up in RGB.
+    const PixelFormat scale_pixel_format =
+        IsRGB(requested_pixel_format) ||
+                requested_pixel_format == PIXEL_FORMAT_BGRA
+            ? PIXEL_FORMAT_BGRA
+            : PIXEL_FORMAT_I420;
+    cropped_.resize(FrameSize(crop_width, crop_height, scale_pixel_format));
+    if (!ConvertFrame(source, crop_width, crop_height, scale_pixel_format,
+                      cropped_.cast<uint8_t*>())) {
+      return base::nullopt;
+    }
+
+    uint8_t* scaled;
+    if (requested_pixel_format == scale_pixel_format) {
+      converted =
+          Data::AllocateFromPool(requested_camera_format.AllocationSize());
+      scaled = converted.cast<uint8_t*>();
+    } else {
+      scaled_.resize(
+          FrameSize(output_width, output_height, scale_pixel_format));
+      scaled = scaled_.cast<uint8_t*>();
+    }
+    base::TimeTicks scale_start = base::TimeTicks::Now();
+    if (!Scale(cropped_.cast<const uint8_t*>(), Sizei(crop_width, crop_height),
+               scale_pixel_format, scaled)) {
+      return base::nullopt;
+    }
+    scale_time = base::TimeTicks::Now() - scale_start;
+
+    if (requested_pixel_format == scale_pixel_format) {
+      UpdateStats(base::TimeTicks::Now() - start - scale_time, scale_time);
+      return CameraFrame(std::move(converted), requested_camera_format,
+                         timestamp);
+    }
+    source = {scaled,
+              scaled_.size(),
+              output_width,
+              output_height,
+              scale_pixel_format,
+              0 /* crop_x */,
+              0 /* crop_y */};
+  }
+
+  converted = Data::AllocateFromPool(requested_camera_format.AllocationSize());
+  if (!ConvertFrame(source, requested_camera_format.width(),
+                    requested_camera_format.height(), requested_pixel_format,
+                    converted.cast<uint8_t*>())) {
+    return base::nullopt;
+  }
+  UpdateStats(base::TimeTicks::Now() - start - scale_time, scale_time);
+
+  return CameraFrame(std::move(converted), requested_camera_format, timestamp);
+}
+
+PixelFormatConverter::Stats PixelFormatConverter::stats() const {
+  base::AutoLock l(lock_);
+  return stats_;
+}
+
+bool PixelFormatConverter::ConvertFrame(const Source& source, int width,
+                                        int height, PixelFormat target,
+                                        uint8_t* out) {
+  const bool cropped = source.crop_x != 0 || source.crop_y != 0 ||
+                       source.width != width || source.height != height;
+  if (source.pixel_format == target && !cropped) {
+    memcpy(out, source.data, FrameSize(width, height, target));
+    return true;
+  }
+
+  PixelFormat intermediate = PIXEL_FORMAT_UNKNOWN;
+  if (!IsDirect(source.pixel_format, target)) {
+    intermediate = IsRGB(target) ? PIXEL_FORMAT_BGRA : PIXEL_FORMAT_I420;
+    scratch_.resize(FrameSize(width, height, intermediate));
+  }
+  // Only I420, YV12 and BGRA are converted from a cropped frame, otherwise
+  // the planes of the source would have to be offset by |crop_x|.
+  DCHECK(!cropped || target == PIXEL_FORMAT_I420 ||
+         target == PIXEL_FORMAT_YV12 || target == PIXEL_FORMAT_BGRA);
+
+  // MJPEG has to be decoded as a whole.
+  return RunBands(height, source.pixel_format != PIXEL_FORMAT_MJPEG,
+                  base::BindRepeating(&PixelFormatConverter::ConvertBand,
+                                      base::Unretained(this), source, width,
+                                      height, target, intermediate, out));
+}
+
+bool PixelFormatConverter::ConvertBand(const Source& source, int width,
+                                       int height, PixelFormat target,
+                                       PixelFormat intermediate, uint8_t* out,
+                                       int begin, int end) {
+  const int rows = end - begin;
+  Planes dst;
+  if (!GetPlanes(out, width, height, target, begin, &dst)) return false;
+
+  auto sample_to = [&source, width, begin, rows](PixelFormat pixel_format,
+                                                 const Planes& planes) {
+    const uint32_t fourcc = ToFourCC(source.pixel_format);
+    if (pixel_format == PIXEL_FORMAT_BGRA) {
+      return libyuv::ConvertToARGB(
+                 source.data, source.data_length, planes.data[0],
+                 planes.stride[0], source.crop_x, source.crop_y + begin,
+                 source.width, source.height, width, rows,
+                 libyuv::RotationMode::kRotate0, fourcc) == 0;
+    }
+    return libyuv::ConvertToI420(
+               source.data, source.data_length, planes.data[0],
+               planes.stride[0], planes.data[1], planes.stride[1],
+               planes.data[2], planes.stride[2], source.crop_x,
+               source.crop_y + begin, source.width, source.height, width,
+               rows, libyuv::RotationMode::kRotate0, fourcc) == 0;
+  };
+
+  if (IsI420Like(target) || target == PIXEL_FORMAT_BGRA)
+    return sample_to(target, dst);
+
+  Planes src;
+  PixelFormat from = source.pixel_format;
+  if (intermediate != PIXEL_FORMAT_UNKNOWN) {
+    // Each band uses its own rows of |scratch_|.
+    if (!GetPlanes(scratch_.cast<uint8_t*>(), width, height, intermediate,
+                   begin, &src) ||
+        !sample_to(intermediate, src)) {
+      return false;
+    }
+    from = intermediate;
+  } else if (!GetPlanes(source.data, source.width, source.height, from, begin,
+                        &src)) {
+    return false;
+  }
+  return ConvertPlanes(src, from, dst, target, width, rows);
+}
+
+bool PixelFormatConverter::Scale(const uint8_t* data, const Sizei& size,
+                                 PixelFormat pixel_format, uint8_t* out) {
+  Planes src;
+  Planes dst;
+  GetPlanes(data, size.width(), size.height(), pixel_format, 0, &src);
+  GetPlanes(out, output_size_.width(), output_size_.height(), pixel_format, 0,
+            &dst);
+  if (pixel_format == PIXEL_FORMAT_BGRA) {
+    return libyuv::ARGBScale(src.data[0], src.stride[0], size.width(),
+                             size.height(), dst.data[0], dst.stride[0],
+                             output_size_.width(), output_size_.height(),
+                             libyuv::kFilterBilinear) == 0;
+  }
+  return libyuv::I420Scale(src.data[0], src.stride[0], src.data[1],
+                           src.stride[1], src.data[2], src.stride[2],
+                           size.width(), size.height(), dst.data[0],
+                           dst.stride[0], dst.data[1], dst.stride[1],
+                           dst.data[2], dst.stride[2], output_size_.width(),
+                           output_size_.height(),
+                           libyuv::kFilterBilinear) == 0;
+}
+
+bool PixelFormatConverter::RunBands(int height, bool splittable,
+                                    const BandCallback& callback) {
+  size_t num_bands = 1;
+  if (splittable) {
+    num_bands = std::min(num_threads(),
+                         static_cast<size_t>(height / kMinBandHeight));
+  }
+  if (num_bands <= 1) return callback.Run(0, height);
+
+  // Even, so that every band starts on a chroma row.
+  int band_height = ((height + num_bands - 1) / num_bands + 1) & ~1;
+  std::unique_ptr<bool[]> results(new bool[num_bands]);
+  base::WaitableEvent event;
+  base::RepeatingClosure done = base::BarrierClosure(
+      num_bands - 1,
+      base::BindOnce(&base::WaitableEvent::Signal, base::Unretained(&event)));
+  for (size_t i = 1; i < num_bands; ++i) {
+    int begin = std::min(height, static_cast<int>(i) * band_height);
+    int end = std::min(height, begin + band_height);
+    workers_[i - 1]->task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(&RunBand, callback, begin, end, &results[i],
+                                  done));
+  }
+  results[0] = callback.Run(0, std::min(height, band_height));
+  event.Wait();
+
+  for (size_t i = 0; i < num_bands; ++i) {
+    if (!results[i]) return false;
+  }
+  return true;
+}
+
+void PixelFormatConverter::UpdateStats(base::TimeDelta convert_time,
+                                       base::TimeDelta scale_time) {
+  base::AutoLock l(lock_);
+  stats_.frames++;
+  stats_.last_convert_time = convert_time;
+  stats_.max_convert_time = std::max(stats_.max_convert_time, convert_time);
+  stats_.total_convert_time += convert_time;
+  stats_.last_scale_time = scale_time;
+  stats_.max_scale_time = std::max(stats_.max_scale_time, scale_time);
+  stats_.total_scale_time += scale_time;
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,159 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_DRIVERS_CAMERA_PIXEL_FORMAT_CONVERTER_H_
+#define FELICIA_DRIVERS_CAMERA_PIXEL_FORMAT_CONVERTER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "third_party/chromium/base/callback.h"
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/optional.h"
+#include "third_party/chromium/base/synchronization/lock.h"
+#include "third_party/chromium/base/thread_annotations.h"
+#include "third_party/chromium/base/threading/thread.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/lib/base/export.h"
+#include "felicia/core/lib/containers/data.h"
+#include "felicia/core/lib/image/image.h"
+#include "felicia/core/lib/image/jpeg_codec.h"
+#include "felicia/core/lib/unit/geometry/size.h"
+#include "felicia/drivers/camera/camera_format.h"
+#include "felicia/drivers/camera/camera_frame.h"
+
+namespace felicia {
+namespace drivers {
+
+// Converts camera frames to the requested pixel format. It uses a direct
+// libyuv routine when there is one, e.g, YUY2 to I420 or I420 to BGR, so
+// that the frame is read only once. Otherwise it converts through I420 or
+// BGRA, whichever loses less, into a scratch buffer which is reused across
+// frames.
+//
+// MJPEG is decoded by JpegDecoder straight to I420, at 1/2, 1/4 or 1/8 of
+// its size if it's scaled down that far anyway.
+//
+// Frames can be split into bands of rows, which are converted on worker
+// threads in parallel. |Convert()| returns when every band is done, so the
+// frames are delivered in order. Frames can also be cropped and scaled to
+// |output_size|.
+//
+// Every camera owns one, and |Convert()| must be called on a single thread.
+class FEL_EXPORT PixelFormatConverter {
+ public:
+  // Time spent on each stage, to see if conversion keeps up with the camera.
+  struct FEL_EXPORT Stats {
+    Stats();
+    Stats(const Stats& other);
+    ~Stats();
+
+    std::string ToString() const;
+
+    int64_t frames = 0;
+    // Converting pixel formats, including cropping.
+    base::TimeDelta last_convert_time;
+    base::TimeDelta max_convert_time;
+    base::TimeDelta total_convert_time;
+    // Scaling to |output_size|.
+    base::TimeDelta last_scale_time;
+    base::TimeDelta max_scale_time;
+    base::TimeDelta total_scale_time;
+  };
+
+  PixelFormatConverter();
+  ~PixelFormatConverter();
+
+  // Returns true if |source| is converted to |target| in a single pass.
+  static bool IsDirect(PixelFormat source, PixelFormat target);
+
+  // Converts on |num_threads| threads including the calling one. It's 1 by
+  // default. It must not be called while converting.
+  void set_num_threads(size_t num_threads);
+  size_t num_threads() const { return workers_.size() + 1; }
+
+  // If it's not empty, frames are cropped at the center to the aspect ratio
+  // of |output_size| and then scaled to it. It must not be called while
+  // converting.
+  void set_output_size(const Sizei& output_size) {
+    output_size_ = output_size;
+  }
+  const Sizei& output_size() const { return output_size_; }
+
+  // Returns true if frames of |camera_format| are cropped or scaled.
+  bool Scales(const CameraFormat& camera_format) const;
+
+  base::Optional<CameraFrame> Convert(const uint8_t* data, size_t data_length,
+                                      const CameraFormat& camera_format,
+                                      PixelFormat requested_pixel_format,
+                                      base::TimeDelta timestamp);
+
+  // Thread safe.
+  Stats stats() const;
+
+ private:
+  using BandCallback = base::RepeatingCallback<bool(int, int)>;
+
+  bool Scales(const Sizei& size) const;
+  // How large MJPEG has to be decoded to be cropped and scaled to
+  // |output_size_|. It's empty if it's not scaled.
+  Sizei GetMinDecodeSize(const CameraFormat& camera_format) const;
+
+  // A frame to read from, which may be a part of a larger |data|.
+  struct Source {
+    const uint8_t* data;
+    size_t data_length;
+    // The size of the whole |data|.
+    int width;
+    int height;
+    PixelFormat pixel_format;
+    // The part to convert.
+    int crop_x;
+    int crop_y;
+  };
+
+  // Converts |source| to |out|, which is |width| x |height| of |target|.
+  // |source| is cropped at (|crop_x|, |crop_y|) by the same size.
+  bool ConvertFrame(const Source& source, int width, int height,
+                    PixelFormat target, uint8_t* out);
+
+  // Converts rows [|begin|, |end|) of |source| to |out|.
+  bool ConvertBand(const Source& source, int width, int height,
+                   PixelFormat target, PixelFormat intermediate, uint8_t* out,
+                   int begin, int end);
+
+  bool Scale(const uint8_t* data, const Sizei& size, PixelFormat pixel_format,
+             uint8_t* out);
+
+  // Calls |callback| for bands of |height| rows on the workers, and returns
+  // true if every call returns true.
+  bool RunBands(int height, bool splittable, const BandCallback& callback);
+
+  void UpdateStats(base::TimeDelta convert_time, base::TimeDelta scale_time);
+
+  Sizei output_size_;
+  std::vector<std::unique_ptr<base::Thread>> workers_;
+
+  // MJPEG is decoded to I420 by |jpeg_decoder_| into |decoded_|, scaled down
+  // in the DCT domain if it's scaled, unless the JPEG isn't 4:2:0 or 4:2:2.
+  JpegDecoder jpeg_decoder_;
+  Image decoded_;
+  // Intermediate frame when there is no direct conversion.
+  Data scratch_;
+  // Cropped and scaled frames.
+  Data cropped_;
+  Data scaled_;
+
+  mutable base::Lock lock_;
+  Stats stats_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(PixelFormatConverter);
+};
+
+}  // namespace drivers
+}  // namespace felicia
+
+#endif  // FELICIA_DRIVERS_CAMERA_PIXEL_FORMAT_CONVERTER_H_
\ No newline at end of file
@@ -0,0 +1,270 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/pixel_format_converter.h"
+
+#include "benchmark/benchmark.h"
+#include "libyuv.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/stl_util.h"
+
+#include "felicia/core/lib/image/jpeg_codec.h"
+#include "felicia/drivers/camera/camera_frame_encoder.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr PixelFormat kSources[] = {
+    PIXEL_FORMAT_YUY2,
+    PIXEL_FORMAT_NV12,
+    PIXEL_FORMAT_I420,
+    PIXEL_FORMAT_BGRA,
+};
+
+constexpr PixelFormat kTargets[] = {
+    PIXEL_FORMAT_I420,
+    PIXEL_FORMAT_NV12,
+    PIXEL_FORMAT_BGR,
+    PIXEL_FORMAT_RGBA,
+};
+
+// 720p, 1080p and 4K
+constexpr int kHeights[] = {720, 1080, 2160};
+
+CameraFormat MakeCameraFormat(PixelFormat pixel_format, int height) {
+  return CameraFormat(height * 16 / 9, height, pixel_format, 30);
+}
+
+std::string MakeFrame(const CameraFormat& camera_format) {
+  std::string frame(camera_format.AllocationSize(), 0);
+  for (size_t i = 0; i < frame.length(); ++i) {
+    frame[i] = static_cast<char>(i * 7);
+  }
+  return frame;
+}
+
+void SetLabel(benchmark::State& state, PixelFormat source,
+              PixelFormat target) {
+  state.SetLabel(PixelFormat_Name(source) + " -> " + PixelFormat_Name(target));
+}
+
+void Args(benchmark::internal::Benchmark* b) {
+  for (size_t source = 0; source < base::size(kSources); ++source) {
+    for (size_t target = 0; target < base::size(kTargets); ++target) {
+      if (kSources[source] == kTargets[target]) continue;
+      for (int height : kHeights) {
+        b->Args({static_cast<int>(source), static_cast<int>(target), height});
+      }
+    }
+  }
+}
+
+// A 1080p MJPEG frame, which is 4:2:0 since JpegCodec encodes so.
+std::vector<unsigned char> MakeMJPEGFrame() {
+  CameraFormat camera_format = MakeCameraFormat(PIXEL_FORMAT_BGR, 1080);
+  std::string frame = MakeFrame(camera_format);
+  Image image(Sizei(camera_format.width(), camera_format.height()),
+              PIXEL_FORMAT_BGR, Data(std::move(frame)));
+  JpegCodec::Options options;
+  options.quality = 80;
+  std::vector<unsigned char> mjpeg;
+  CHECK(JpegCodec::Encode(image, options, &mjpeg).ok());
+  return mjpeg;
+}
+
+// Decodes to I420, or to BGR, at the full size and at 640x360, which is 1/2
+// and 1/3 of 1080p.
+void MJPEGArgs(benchmark::internal::Benchmark* b) {
+  for (int target : {0, 2}) {
+    for (int height : {0, 540, 360}) {
+      b->Args({target, height});
+    }
+  }
+}
+
+void ThreadArgs(benchmark::internal::Benchmark* b) {
+  for (size_t target = 0; target < base::size(kTargets); ++target) {
+    for (int num_threads : {1, 2, 4}) {
+      b->Args({static_cast<int>(target), num_threads});
+    }
+  }
+}
+
+}  // namespace
+
+static void BM_Convert(benchmark::State& state) {
+  PixelFormat source = kSources[state.range(0)];
+  PixelFormat target = kTargets[state.range(1)];
+  CameraFormat camera_format = MakeCameraFormat(source, state.range(2));
+  std::string frame = MakeFrame(camera_format);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(frame.data());
+
+  PixelFormatConverter converter;
+  for (auto _ : state) {
+    base::Optional<CameraFrame> camera_frame = converter.Convert(
+        data, frame.length(), camera_format, target, base::TimeDelta());
+    CHECK(camera_frame.has_value());
+    benchmark::DoNotOptimize(camera_frame);
+  }
+  SetLabel(state, source, target);
+  state.SetBytesProcessed(state.iterations() * frame.length());
+}
+
+// The way it used to be, every frame is converted to BGRA first and then to
+// the target.
+static void BM_ConvertThroughBGRA(benchmark::State& state) {
+  PixelFormat source = kSources[state.range(0)];
+  PixelFormat target = kTargets[state.range(1)];
+  CameraFormat camera_format = MakeCameraFormat(source, state.range(2));
+  std::string frame = MakeFrame(camera_format);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(frame.data());
+
+  PixelFormatConverter converter;
+  for (auto _ : state) {
+    base::Optional<CameraFrame> bgra_frame =
+        converter.Convert(data, frame.length(), camera_format,
+                          PIXEL_FORMAT_BGRA, base::TimeDelta());
+    CHECK(bgra_frame.has_value());
+    base::Optional<CameraFrame> camera_frame = converter.Convert(
+        bgra_frame->raw_data(), bgra_frame->length(),
+        bgra_frame->camera_format(), target, base::TimeDelta());
+    CHECK(camera_frame.has_value());
+    benchmark::DoNotOptimize(camera_frame);
+  }
+  SetLabel(state, source, target);
+  state.SetBytesProcessed(state.iterations() * frame.length());
+}
+
+// Converts a 4K YUY2 frame with 1, 2 and 4 threads.
+static void BM_ConvertInBands(benchmark::State& state) {
+  PixelFormat target = kTargets[state.range(0)];
+  CameraFormat camera_format = MakeCameraFormat(PIXEL_FORMAT_YUY2, 2160);
+  std::string frame = MakeFrame(camera_format);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(frame.data());
+
+  PixelFormatConverter converter;
+  converter.set_num_threads(state.range(1));
+  for (auto _ : state) {
+    base::Optional<CameraFrame> camera_frame = converter.Convert(
+        data, frame.length(), camera_format, target, base::TimeDelta());
+    CHECK(camera_frame.has_value());
+    benchmark::DoNotOptimize(camera_frame);
+  }
+  SetLabel(state, PIXEL_FORMAT_YUY2, target);
+  state.SetBytesProcessed(state.iterations() * frame.length());
+}
+
+// Crops and scales a 1080p YUY2 frame down to 640x480.
+static void BM_ConvertAndScale(benchmark::State& state) {
+  PixelFormat target = kTargets[state.range(0)];
+  CameraFormat camera_format = MakeCameraFormat(PIXEL_FORMAT_YUY2, 1080);
+  std::string frame = MakeFrame(camera_format);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(frame.data());
+
+  PixelFormatConverter converter;
+  converter.set_output_size(Sizei(640, 480));
+  for (auto _ : state) {
+    base::Optional<CameraFrame> camera_frame = converter.Convert(
+        data, frame.length(), camera_format, target, base::TimeDelta());
+    CHECK(camera_frame.has_value());
+    benchmark::DoNotOptimize(camera_frame);
+  }
+  state.SetLabel(PixelFormat_Name(PIXEL_FORMAT_YUY2) + " -> " +
+                 PixelFormat_Name(target) + ", " +
+                 converter.stats().ToString());
+  state.SetBytesProcessed(state.iterations() * frame.length());
+}
+
+static void BM_ConvertMJPEG(benchmark::State& state) {
+  PixelFormat target = kTargets[state.range(0)];
+  CameraFormat camera_format = MakeCameraFormat(PIXEL_FORMAT_MJPEG, 1080);
+  std::vector<unsigned char> mjpeg = MakeMJPEGFrame();
+
+  PixelFormatConverter converter;
+  if (state.range(1) > 0) {
+    converter.set_output_size(
+        Sizei(state.range(1) * 16 / 9, state.range(1)));
+  }
+  for (auto _ : state) {
+    base::Optional<CameraFrame> camera_frame = converter.Convert(
+        mjpeg.data(), mjpeg.size(), camera_format, target, base::TimeDelta());
+    CHECK(camera_frame.has_value());
+    benchmark::DoNotOptimize(camera_frame);
+  }
+  SetLabel(state, PIXEL_FORMAT_MJPEG, target);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// The way it used to be, libyuv decodes every frame to I420 at the full
+// size with a new jpeg_decompress_struct.
+static void BM_ConvertMJPEGWithLibyuv(benchmark::State& state) {
+  PixelFormat target = kTargets[state.range(0)];
+  CameraFormat camera_format = MakeCameraFormat(PIXEL_FORMAT_MJPEG, 1080);
+  CameraFormat i420_camera_format = MakeCameraFormat(PIXEL_FORMAT_I420, 1080);
+  std::vector<unsigned char> mjpeg = MakeMJPEGFrame();
+  const int width = camera_format.width();
+  const int height = camera_format.height();
+  std::vector<uint8_t> i420(i420_camera_format.AllocationSize());
+  uint8_t* u = i420.data() + width * height;
+  uint8_t* v = u + (width / 2) * (height / 2);
+
+  PixelFormatConverter converter;
+  if (state.range(1) > 0) {
+    converter.set_output_size(
+        Sizei(state.range(1) * 16 / 9, state.range(1)));
+  }
+  for (auto _ : state) {
+    CHECK_EQ(0, libyuv::MJPGToI420(mjpeg.data(), mjpeg.size(), i420.data(),
+                                   width, u, width / 2, v, width / 2, width,
+                                   height, width, height));
+    base::Optional<CameraFrame> camera_frame =
+        converter.Convert(i420.data(), i420.size(), i420_camera_format,
+                          target, base::TimeDelta());
+    CHECK(camera_frame.has_value());
+    benchmark::DoNotOptimize(camera_frame);
+  }
+  SetLabel(state, PIXEL_FORMAT_MJPEG, target);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Compresses 1080p frames of |kSources| to publish. |compression_ratio| is
+// how much less is sent than the raw frame.
+static void BM_EncodeToMJPEGMessage(benchmark::State& state) {
+  PixelFormat source = kSources[state.range(0)];
+  CameraFormat camera_format = MakeCameraFormat(source, 1080);
+  CameraFrame camera_frame(Data(MakeFrame(camera_format)), camera_format,
+                           base::TimeDelta());
+
+  CameraFrameEncoder encoder(CameraFrameEncoder::COMPRESSION_MJPEG);
+  CameraFrameMessage message;
+  for (auto _ : state) {
+    CHECK(encoder.Encode(camera_frame, &message).ok());
+    benchmark::DoNotOptimize(message);
+  }
+  SetLabel(state, source, PIXEL_FORMAT_MJPEG);
+  state.SetItemsProcessed(state.iterations());
+  state.counters["compression_ratio"] =
+      static_cast<double>(camera_frame.length()) / message.data().size();
+}
+
+BENCHMARK(BM_Convert)->Apply(Args)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ConvertThroughBGRA)->Apply(Args)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ConvertInBands)
+    ->Apply(ThreadArgs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ConvertAndScale)
+    ->DenseRange(0, 3)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ConvertMJPEG)->Apply(MJPEGArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ConvertMJPEGWithLibyuv)
+    ->Apply(MJPEGArgs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_EncodeToMJPEGMessage)
+    ->DenseRange(0, 3)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,251 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/pixel_format_converter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "libyuv.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr PixelFormat kPixelFormats[] = {
+    PIXEL_FORMAT_I420, PIXEL_FORMAT_YV12, PIXEL_FORMAT_NV12,
+    PIXEL_FORMAT_NV21, PIXEL_FORMAT_YUY2, PIXEL_FORMAT_UYVY,
+    PIXEL_FORMAT_BGRA, PIXEL_FORMAT_BGR,  PIXEL_FORMAT_RGB,
+    PIXEL_FORMAT_RGBA, PIXEL_FORMAT_ARGB,
+};
+
+constexpr int kWidth = 32;
+constexpr int kHeight = 24;
+
+// Going through RGB rounds each sample a few times.
+constexpr int kMaxDiff = 10;
+constexpr double kMaxMeanDiff = 2.0;
+
+// A smooth frame, so that subsampling the chroma barely changes it.
+std::string MakeBGRAFrame(int width, int height) {
+  std::string frame(width * height * 4, 0);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      char* pixel = &frame[(y * width + x) * 4];
+      pixel[0] = static_cast<char>(64 + x * 2);
+      pixel[1] = static_cast<char>(64 + y * 2);
+      pixel[2] = static_cast<char>(96 + x + y);
+      pixel[3] = static_cast<char>(255);
+    }
+  }
+  return frame;
+}
+
+CameraFormat MakeCameraFormat(PixelFormat pixel_format) {
+  return CameraFormat(kWidth, kHeight, pixel_format, 30);
+}
+
+// Returns an empty string if it fails.
+std::string Convert(PixelFormatConverter* converter, const std::string& frame,
+                    PixelFormat source, PixelFormat target) {
+  base::Optional<CameraFrame> camera_frame = converter->Convert(
+      reinterpret_cast<const uint8_t*>(frame.data()), frame.length(),
+      MakeCameraFormat(source), target, base::TimeDelta());
+  if (!camera_frame.has_value()) return std::string();
+  EXPECT_EQ(target, camera_frame->pixel_format());
+  EXPECT_EQ(MakeCameraFormat(target).AllocationSize(), camera_frame->length());
+  return std::string(reinterpret_cast<const char*>(camera_frame->raw_data()),
+                     camera_frame->length());
+}
+
+testing::AssertionResult IsNear(const std::string& expected,
+                                const std::string& actual) {
+  if (expected.length() != actual.length()) {
+    return testing::AssertionFailure() << expected.length() << " bytes vs "
+                                       << actual.length() << " bytes";
+  }
+  int max_diff = 0;
+  int64_t total_diff = 0;
+  for (size_t i = 0; i < expected.length(); ++i) {
+    int diff = abs(static_cast<uint8_t>(expected[i]) -
+                   static_cast<uint8_t>(actual[i]));
+    max_diff = std::max(max_diff, diff);
+    total_diff += diff;
+  }
+  double mean_diff = static_cast<double>(total_diff) / expected.length();
+  if (max_diff > kMaxDiff || mean_diff > kMaxMeanDiff) {
+    return testing::AssertionFailure()
+           << "max diff " << max_diff << ", mean diff " << mean_diff;
+  }
+  return testing::AssertionSuccess();
+}
+
+}  // namespace
+
+// Every pair has to match how it used to be converted, first to BGRA and
+// then to the target.
+TEST(PixelFormatConverterTest, ConvertMatchesThroughBGRA) {
+  PixelFormatConverter converter;
+  const std::string bgra = MakeBGRAFrame(kWidth, kHeight);
+
+  for (PixelFormat source : kPixelFormats) {
+    std::string frame = Convert(&converter, bgra, PIXEL_FORMAT_BGRA, source);
+    ASSERT_FALSE(frame.empty()) << PixelFormat_Name(source);
+    std::string through_bgra =
+        Convert(&converter, frame, source, PIXEL_FORMAT_BGRA);
+    ASSERT_FALSE(through_bgra.empty()) << PixelFormat_Name(source);
+
+    for (PixelFormat target : kPixelFormats) {
+      SCOPED_TRACE(PixelFormat_Name(source) + " -> " +
+                   PixelFormat_Name(target));
+      std::string expected =
+          Convert(&converter, through_bgra, PIXEL_FORMAT_BGRA, target);
+      std::string actual = Convert(&converter, frame, source, target);
+      ASSERT_FALSE(expected.empty());
+      ASSERT_FALSE(actual.empty());
+      EXPECT_TRUE(IsNear(expected, actual));
+    }
+  }
+}
+
+TEST(PixelFormatConverterTest, SamePixelFormatIsCopied) {
+  PixelFormatConverter converter;
+  const std::string bgra = MakeBGRAFrame(kWidth, kHeight);
+  for (PixelFormat pixel_format : kPixelFormats) {
+    std::string frame =
+        Convert(&converter, bgra, PIXEL_FORMAT_BGRA, pixel_format);
+    EXPECT_EQ(frame, Convert(&converter, frame, pixel_format, pixel_format))
+        << PixelFormat_Name(pixel_format);
+  }
+}
+
+// Bands are converted on their own, so they have to join without a seam,
+// including when the bands don't divide the height or it is odd.
+TEST(PixelFormatConverterTest, BandsMatchSingleThread) {
+  PixelFormatConverter single;
+  for (int height : {128, 255, 301}) {
+    const std::string bgra = MakeBGRAFrame(kWidth, height);
+    for (size_t num_threads : {2, 3, 4}) {
+      PixelFormatConverter banded;
+      banded.set_num_threads(num_threads);
+      for (PixelFormat source : kPixelFormats) {
+        CameraFormat source_format(kWidth, height, source, 30);
+        base::Optional<CameraFrame> frame = single.Convert(
+            reinterpret_cast<const uint8_t*>(bgra.data()), bgra.length(),
+            CameraFormat(kWidth, height, PIXEL_FORMAT_BGRA, 30), source,
+            base::TimeDelta());
+        ASSERT_TRUE(frame.has_value());
+        for (PixelFormat target : kPixelFormats) {
+          SCOPED_TRACE(PixelFormat_Name(source) + " -> " +
+                       PixelFormat_Name(target) + ", height " +
+                       std::to_string(height) + ", threads " +
+                       std::to_string(num_threads));
+          base::Optional<CameraFrame> expected =
+              single.Convert(frame->raw_data(), frame->length(), source_format,
+                             target, base::TimeDelta());
+          base::Optional<CameraFrame> actual =
+              banded.Convert(frame->raw_data(), frame->length(), source_format,
+                             target, base::TimeDelta());
+          ASSERT_TRUE(expected.has_value());
+          ASSERT_TRUE(actual.has_value());
+          ASSERT_EQ(expected->length(), actual->length());
+          EXPECT_EQ(0, memcmp(expected->raw_data(), actual->raw_data(),
+                              expected->length()));
+        }
+      }
+    }
+  }
+}
+
+TEST(PixelFormatConverterTest, Scales) {
+  PixelFormatConverter converter;
+  const CameraFormat camera_format = MakeCameraFormat(PIXEL_FORMAT_BGRA);
+  EXPECT_FALSE(converter.Scales(camera_format));
+  converter.set_output_size(Sizei(kWidth, kHeight));
+  EXPECT_FALSE(converter.Scales(camera_format));
+  converter.set_output_size(Sizei(kWidth / 2, kHeight / 2));
+  EXPECT_TRUE(converter.Scales(camera_format));
+}
+
+// Frames are cropped at the center, on even pixels, to the aspect ratio of
+// the output size and then scaled to it.
+TEST(PixelFormatConverterTest, CropAndScale) {
+  constexpr int kFrameWidth = 64;
+  constexpr int kFrameHeight = 48;
+  const std::string bgra = MakeBGRAFrame(kFrameWidth, kFrameHeight);
+  const CameraFormat camera_format(kFrameWidth, kFrameHeight,
+                                   PIXEL_FORMAT_BGRA, 30);
+
+  struct {
+    Sizei output_size;
+    // The part which is expected to be cropped.
+    int crop_x;
+    int crop_y;
+    int crop_width;
+    int crop_height;
+  } cases[] = {
+      // The same aspect ratio isn't cropped.
+      {Sizei(32, 24), 0, 0, 64, 48},
+      // Wider
+      {Sizei(30, 20), 0, 2, 64, 42},
+      // Narrower
+      {Sizei(32, 32), 8, 0, 48, 48},
+      {Sizei(16, 32), 20, 0, 24, 48},
+  };
+
+  for (const auto& c : cases) {
+    SCOPED_TRACE(c.output_size.ToString());
+    PixelFormatConverter converter;
+    converter.set_output_size(c.output_size);
+    base::Optional<CameraFrame> actual = converter.Convert(
+        reinterpret_cast<const uint8_t*>(bgra.data()), bgra.length(),
+        camera_format, PIXEL_FORMAT_BGRA, base::TimeDelta());
+    ASSERT_TRUE(actual.has_value());
+    EXPECT_EQ(c.output_size.width(), actual->width());
+    EXPECT_EQ(c.output_size.height(), actual->height());
+
+    // Scaling the expected part alone gives the same frame.
+    std::string expected(actual->length(), 0);
+    const int stride = kFrameWidth * 4;
+    ASSERT_EQ(0, libyuv::ARGBScale(
+                     reinterpret_cast<const uint8_t*>(bgra.data()) +
+                         c.crop_y * stride + c.crop_x * 4,
+                     stride, c.crop_width, c.crop_height,
+                     reinterpret_cast<uint8_t*>(&expected[0]),
+                     c.output_size.width() * 4, c.output_size.width(),
+                     c.output_size.height(), libyuv::kFilterBilinear));
+    EXPECT_EQ(0,
+              memcmp(expected.data(), actual->raw_data(), expected.length()));
+
+    // Every other format is scaled to the same size.
+    for (PixelFormat target : kPixelFormats) {
+      base::Optional<CameraFrame> camera_frame = converter.Convert(
+          reinterpret_cast<const uint8_t*>(bgra.data()), bgra.length(),
+          camera_format, target, base::TimeDelta());
+      ASSERT_TRUE(camera_frame.has_value()) << PixelFormat_Name(target);
+      EXPECT_EQ(c.output_size.width(), camera_frame->width());
+      EXPECT_EQ(c.output_size.height(), camera_frame->height());
+      EXPECT_EQ(CameraFormat(c.output_size, target, 30).AllocationSize(),
+                camera_frame->length());
+    }
+  }
+}
+
+TEST(PixelFormatConverterTest, RejectsShortFrame) {
+  PixelFormatConverter converter;
+  std::string bgra = MakeBGRAFrame(kWidth, kHeight);
+  bgra.resize(bgra.length() - 1);
+  EXPECT_FALSE(converter
+                   .Convert(reinterpret_cast<const uint8_t*>(bgra.data()),
+                            bgra.length(), MakeCameraFormat(PIXEL_FORMAT_BGRA),
+                            PIXEL_FORMAT_I420, base::TimeDelta())
+                   .has_value());
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,218 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/synthetic_camera.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "third_party/chromium/base/strings/strcat.h"
+
+#include "felicia/core/lib/image/jpeg_codec.h"
+#include "felicia/core/lib/strings/str_util.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr const char* kDeviceIdPrefix = "synthetic:";
+constexpr int kPanPerFrame = 4;
+
+// Fills |canvas|, an I420 of |width| x |height|, with a checkerboard, textured
+// and a bit noisy like a sensor, so that compressing it isn't too easy.
+void DrawCanvas(int width, int height, std::string* canvas) {
+  const int chroma_width = width / 2;
+  const int chroma_height = height / 2;
+  canvas->resize(width * height + chroma_width * chroma_height * 2);
+  char* y_plane = &(*canvas)[0];
+  char* u_plane = y_plane + width * height;
+  char* v_plane = u_plane + chroma_width * chroma_height;
+  uint32_t seed = 1;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      seed = seed * 1103515245 + 12345;
+      y_plane[y * width + x] = static_cast<char>(
+          ((x / 32 + y / 32) % 2 ? 160 : 64) + (x * y) % 23 +
+          static_cast<int>((seed >> 16) % 5));
+    }
+  }
+  for (int y = 0; y < chroma_height; ++y) {
+    for (int x = 0; x < chroma_width; ++x) {
+      u_plane[y * chroma_width + x] =
+          static_cast<char>(128 + (x / 64) % 4 * 16);
+      v_plane[y * chroma_width + x] =
+          static_cast<char>(128 - (y / 64) % 4 * 8);
+    }
+  }
+}
+
+// Copies |width| x |height| at (|x|, 0) of |canvas|, which is |canvas_width|
+// wide, to |frame|. |x| should be even.
+void CropCanvas(const std::string& canvas, int canvas_width, int x, int width,
+                int height, std::string* frame) {
+  const int chroma_width = width / 2;
+  const int chroma_height = height / 2;
+  const int canvas_chroma_width = canvas_width / 2;
+  frame->resize(width * height + chroma_width * chroma_height * 2);
+  const char* src = canvas.data();
+  char* dst = &(*frame)[0];
+  for (int y = 0; y < height; ++y) {
+    memcpy(dst + y * width, src + y * canvas_width + x, width);
+  }
+  src += canvas_width * height;
+  dst += width * height;
+  for (int plane = 0; plane < 2; ++plane) {
+    for (int y = 0; y < chroma_height; ++y) {
+      memcpy(dst + y * chroma_width, src + y * canvas_chroma_width + x / 2,
+             chroma_width);
+    }
+    src += canvas_chroma_width * chroma_height;
+    dst += chroma_width * chroma_height;
+  }
+}
+
+}  // namespace
+
+constexpr size_t SyntheticCamera::kMaxLoopFrames;
+constexpr size_t SyntheticCamera::kMaxLoopBytes;
+constexpr int SyntheticCamera::kDefaultWidth;
+constexpr int SyntheticCamera::kDefaultHeight;
+constexpr float SyntheticCamera::kDefaultFrameRate;
+
+SyntheticCamera::SyntheticCamera(const CameraDescriptor& camera_descriptor)
+    : MemoryCamera(camera_descriptor) {}
+
+SyntheticCamera::~SyntheticCamera() = default;
+
+// static
+CameraDescriptor SyntheticCamera::MakeCameraDescriptor(
+    PixelFormat pixel_format) {
+  return CameraDescriptor(
+      "Synthetic Camera",
+      base::StrCat({kDeviceIdPrefix, PixelFormat_Name(pixel_format)}),
+      "synthetic");
+}
+
+// static
+bool SyntheticCamera::IsSyntheticCamera(
+    const CameraDescriptor& camera_descriptor) {
+  return StartsWith(camera_descriptor.device_id(), kDeviceIdPrefix);
+}
+
+// static
+Status SyntheticCamera::GetSupportedCameraFormats(
+    const CameraDescriptor& camera_descriptor, CameraFormats* camera_formats) {
+  PixelFormat pixel_format;
+  Status s = GetPixelFormat(camera_descriptor, &pixel_format);
+  if (!s.ok()) return s;
+
+  // Any size is fine, and these are just the common ones.
+  const Sizei sizes[] = {{320, 240},   {640, 480},   {1280, 720},
+                         {1920, 1080}, {3840, 2160}};
+  for (const Sizei& size : sizes) {
+    for (float frame_rate : {kDefaultFrameRate, kDefaultFrameRate * 2}) {
+      camera_formats->emplace_back(size, pixel_format, frame_rate);
+    }
+  }
+  return Status::OK();
+}
+
+Status SyntheticCamera::Init() {
+  if (!camera_state_.IsStopped()) {
+    return camera_state_.InvalidStateError();
+  }
+
+  Status s = GetPixelFormat(camera_descriptor_, &pixel_format_);
+  if (!s.ok()) return s;
+
+  camera_state_.ToInitialized();
+
+  return Status::OK();
+}
+
+// static
+Status SyntheticCamera::GetPixelFormat(
+    const CameraDescriptor& camera_descriptor, PixelFormat* pixel_format) {
+  base::StringPiece device_id = camera_descriptor.device_id();
+  if (!ConsumePrefix(&device_id, kDeviceIdPrefix) ||
+      !PixelFormat_Parse(device_id.as_string(), pixel_format) ||
+      *pixel_format == PIXEL_FORMAT_UNKNOWN) {
+    return felicia::errors::InvalidArgument(base::StrCat(
+        {"Invalid device id of the synthetic camera: ",
+         camera_descriptor.device_id()}));
+  }
+  return Status::OK();
+}
+
+Status SyntheticCamera::PrepareFrames(
+    const CameraFormat& requested_camera_format) {
+  // Rounds up to even, since the scene is drawn in I420.
+  const int width = requested_camera_format.width() > 0
+                        ? (requested_camera_format.width() + 1) & ~1
+                        : kDefaultWidth;
+  const int height = requested_camera_format.height() > 0
+                         ? (requested_camera_format.height() + 1) & ~1
+                         : kDefaultHeight;
+  const float frame_rate = requested_camera_format.frame_rate() > 0
+                               ? requested_camera_format.frame_rate()
+                               : kDefaultFrameRate;
+  CameraFormat camera_format(width, height, pixel_format_, frame_rate);
+  if (!frames_.empty() && camera_format_.width() == width &&
+      camera_format_.height() == height &&
+      camera_format_.pixel_format() == pixel_format_) {
+    camera_format_ = camera_format;
+    return Status::OK();
+  }
+
+  CameraFormat i420_camera_format = camera_format;
+  i420_camera_format.set_pixel_format(PIXEL_FORMAT_I420);
+  // MJPEG is a lot smaller than the others.
+  const size_t frame_size = pixel_format_ == PIXEL_FORMAT_MJPEG
+                                ? i420_camera_format.AllocationSize() / 10
+                                : camera_format.AllocationSize();
+  const size_t num_frames = std::max(
+      std::min(kMaxLoopBytes / std::max(frame_size, size_t{1}), kMaxLoopFrames),
+      size_t{1});
+
+  const int canvas_width = width + kPanPerFrame * num_frames;
+  std::string canvas;
+  DrawCanvas(canvas_width, height, &canvas);
+
+  std::vector<std::string> frames;
+  JpegEncoder jpeg_encoder;
+  PixelFormatConverter pixel_format_converter;
+  std::string i420;
+  for (size_t i = 0; i < num_frames; ++i) {
+    CropCanvas(canvas, canvas_width, kPanPerFrame * i, width, height, &i420);
+    if (pixel_format_ == PIXEL_FORMAT_I420) {
+      frames.push_back(i420);
+    } else if (pixel_format_ == PIXEL_FORMAT_MJPEG) {
+      std::string jpeg;
+      Status s = jpeg_encoder.Encode(
+          reinterpret_cast<const uint8_t*>(i420.data()), Sizei(width, height),
+          PIXEL_FORMAT_I420, &jpeg);
+      if (!s.ok()) return s;
+      frames.push_back(std::move(jpeg));
+    } else {
+      base::Optional<CameraFrame> camera_frame = pixel_format_converter.Convert(
+          reinterpret_cast<const uint8_t*>(i420.data()), i420.length(),
+          i420_camera_format, pixel_format_, base::TimeDelta());
+      if (!camera_frame.has_value()) {
+        return felicia::errors::InvalidArgument(
+            base::StrCat({"Failed to draw frames of ",
+                          CameraFormat::PixelFormatToString(pixel_format_)}));
+      }
+      frames.push_back(std::move(camera_frame->data()).data());
+    }
+  }
+
+  frames_ = std::move(frames);
+  camera_format_ = camera_format;
+  return Status::OK();
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
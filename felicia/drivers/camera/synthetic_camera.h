@@ -0,0 +1,67 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_DRIVERS_CAMERA_SYNTHETIC_CAMERA_H_
+#define FELICIA_DRIVERS_CAMERA_SYNTHETIC_CAMERA_H_
+
+#include "felicia/drivers/camera/memory_camera.h"
+
+namespace felicia {
+namespace drivers {
+
+// Camera which delivers a generated scene, a textured pattern panning by a
+// few pixels a frame, in the pixel format of its descriptor. It captures at
+// whatever size and frame rate it's started with, so that the pipeline can
+// be benchmarked at any of them without a device.
+//
+// It's created by CameraFactory from the descriptor below, and isn't listed
+// by |CameraFactory::GetCameraDescriptors()|.
+//
+//   std::unique_ptr<CameraInterface> camera = CameraFactory::NewCamera(
+//       SyntheticCamera::MakeCameraDescriptor(PIXEL_FORMAT_YUY2));
+//   camera->Init();
+//   camera->Start(CameraFormat(1280, 720, PIXEL_FORMAT_I420, 30), ...);
+class FEL_EXPORT SyntheticCamera : public MemoryCamera {
+ public:
+  // The scene loops over this many frames at most, fewer if they take more
+  // than |kMaxLoopBytes|.
+  static constexpr size_t kMaxLoopFrames = 30;
+  static constexpr size_t kMaxLoopBytes = 64 * 1024 * 1024;
+  // Used when the requested camera format doesn't have them.
+  static constexpr int kDefaultWidth = 640;
+  static constexpr int kDefaultHeight = 480;
+  static constexpr float kDefaultFrameRate = 30;
+
+  ~SyntheticCamera() override;
+
+  static CameraDescriptor MakeCameraDescriptor(PixelFormat pixel_format);
+  static bool IsSyntheticCamera(const CameraDescriptor& camera_descriptor);
+
+  // Needed by CameraFactory
+  static Status GetSupportedCameraFormats(
+      const CameraDescriptor& camera_descriptor, CameraFormats* camera_formats);
+
+  // CameraInterface methods
+  Status Init() override;
+
+ private:
+  friend class CameraFactory;
+
+  explicit SyntheticCamera(const CameraDescriptor& camera_descriptor);
+
+  static Status GetPixelFormat(const CameraDescriptor& camera_descriptor,
+                               PixelFormat* pixel_format);
+
+  // MemoryCamera methods
+  Status PrepareFrames(const CameraFormat& requested_camera_format) override;
+
+  PixelFormat pixel_format_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyntheticCamera);
+};
+
+}  // namespace drivers
+}  // namespace felicia
+
+#endif  // FELICIA_DRIVERS_CAMERA_SYNTHETIC_CAMERA_H_
\ No newline at end of file
@@ -0,0 +1,292 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/video_codec.h"
+
+#include <algorithm>
+
+#if defined(HAS_VPX)
+#include "libyuv.h"
+#include "vpx/vp8cx.h"
+#include "vpx/vp8dx.h"
+#include "vpx/vpx_decoder.h"
+#include "vpx/vpx_encoder.h"
+#endif  // defined(HAS_VPX)
+#include "third_party/chromium/base/strings/stringprintf.h"
+
+#include "felicia/core/lib/error/errors.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+#if defined(HAS_VPX)
+Status VpxError(const char* message, vpx_codec_ctx_t* codec) {
+  const char* detail = vpx_codec_error_detail(codec);
+  return errors::Unknown(base::StringPrintf("%s: %s%s%s", message,
+                                            vpx_codec_error(codec),
+                                            detail ? ", " : "",
+                                            detail ? detail : ""));
+}
+#else
+Status NoVpxError() {
+  return errors::Unimplemented(
+      "Video codecs need libvpx, build with --define has_vpx=true.");
+}
+#endif  // defined(HAS_VPX)
+
+}  // namespace
+
+// VideoEncoder ----------------------------------------------------------------
+
+struct VideoEncoder::Context {
+#if defined(HAS_VPX)
+  ~Context() {
+    if (initialized) vpx_codec_destroy(&codec);
+  }
+
+  vpx_codec_ctx_t codec;
+  vpx_codec_enc_cfg_t config;
+  vpx_image_t image;
+  bool initialized = false;
+#endif  // defined(HAS_VPX)
+};
+
+VideoEncoder::VideoEncoder() : VideoEncoder(Options()) {}
+
+VideoEncoder::VideoEncoder(const Options& options)
+    : options_(options),
+      context_(std::make_unique<Context>()),
+      keyframe_requested_(false) {}
+
+VideoEncoder::~VideoEncoder() = default;
+
+void VideoEncoder::RequestKeyframe() { keyframe_requested_.store(true); }
+
+Status VideoEncoder::Encode(const CameraFrame& frame,
+                            VideoFrameMessage* message) {
+#if defined(HAS_VPX)
+  const CameraFormat& camera_format = frame.camera_format();
+  const uint8_t* data = frame.raw_data();
+  base::Optional<CameraFrame> converted;
+  if (camera_format.pixel_format() != PIXEL_FORMAT_I420) {
+    converted = pixel_format_converter_.Convert(
+        data, frame.length(), camera_format, PIXEL_FORMAT_I420,
+        frame.timestamp());
+    if (!converted) {
+      return errors::InvalidArgument("Failed to convert to I420.");
+    }
+    data = converted->raw_data();
+  }
+
+  const Sizei size(frame.width(), frame.height());
+  if (!context_->initialized || size != size_) {
+    Status s = Initialize(size);
+    if (!s.ok()) return s;
+  }
+
+  const int width = size.width();
+  const int height = size.height();
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  uint8_t* y = const_cast<uint8_t*>(data);
+  vpx_image_t* image = &context_->image;
+  vpx_img_wrap(image, VPX_IMG_FMT_I420, width, height, 1, y);
+  // vpx_img_wrap() rounds the chroma of odd sizes down, unlike CameraFormat.
+  image->planes[VPX_PLANE_U] = y + width * height;
+  image->planes[VPX_PLANE_V] =
+      image->planes[VPX_PLANE_U] + chroma_width * chroma_height;
+  image->stride[VPX_PLANE_Y] = width;
+  image->stride[VPX_PLANE_U] = chroma_width;
+  image->stride[VPX_PLANE_V] = chroma_width;
+
+  vpx_enc_frame_flags_t flags = 0;
+  if (keyframe_requested_.exchange(false) || frame_number_ == 0 ||
+      frame.timestamp() - last_keyframe_timestamp_ >=
+          options_.keyframe_interval) {
+    flags |= VPX_EFLAG_FORCE_KF;
+  }
+  // libvpx wants increasing timestamps, which the frames of a camera have
+  // unless its clock is reset.
+  const int64_t pts =
+      std::max(frame.timestamp().InMicroseconds(), last_pts_ + 1);
+  const unsigned long duration =
+      frame.frame_rate() > 0
+          ? static_cast<unsigned long>(base::Time::kMicrosecondsPerSecond /
+                                       frame.frame_rate())
+          : 1;
+  if (vpx_codec_encode(&context_->codec, image, pts, duration, flags,
+                       VPX_DL_REALTIME) != VPX_CODEC_OK) {
+    return VpxError("Failed to encode", &context_->codec);
+  }
+  last_pts_ = pts;
+
+  std::string* output = message->mutable_data();
+  output->clear();
+  bool keyframe = false;
+  vpx_codec_iter_t iter = nullptr;
+  while (const vpx_codec_cx_pkt_t* packet =
+             vpx_codec_get_cx_data(&context_->codec, &iter)) {
+    if (packet->kind != VPX_CODEC_CX_FRAME_PKT) continue;
+    output->append(static_cast<const char*>(packet->data.frame.buf),
+                   packet->data.frame.sz);
+    keyframe |= (packet->data.frame.flags & VPX_FRAME_IS_KEY) != 0;
+  }
+  if (output->empty()) return errors::Unavailable("No frame is encoded.");
+  if (keyframe) last_keyframe_timestamp_ = frame.timestamp();
+
+  message->set_codec(options_.codec);
+  *message->mutable_camera_format() =
+      CameraFormat(size, PIXEL_FORMAT_I420, frame.frame_rate())
+          .ToCameraFormatMessage();
+  message->set_timestamp(frame.timestamp().InMicroseconds());
+  message->set_keyframe(keyframe);
+  message->set_frame_number(frame_number_++);
+  return Status::OK();
+#else
+  return NoVpxError();
+#endif  // defined(HAS_VPX)
+}
+
+Status VideoEncoder::Initialize(const Sizei& size) {
+#if defined(HAS_VPX)
+  if (options_.codec != VIDEO_CODEC_VP8) {
+    return errors::InvalidArgument(base::StringPrintf(
+        "Unsupported codec: %s.", VideoCodec_Name(options_.codec).c_str()));
+  }
+
+  if (context_->initialized) {
+    vpx_codec_destroy(&context_->codec);
+    context_->initialized = false;
+  }
+
+  vpx_codec_iface_t* iface = vpx_codec_vp8_cx();
+  vpx_codec_enc_cfg_t* config = &context_->config;
+  if (vpx_codec_enc_config_default(iface, config, 0) != VPX_CODEC_OK) {
+    return errors::Unknown("Failed to get the default config.");
+  }
+  config->g_w = size.width();
+  config->g_h = size.height();
+  config->g_timebase.num = 1;
+  config->g_timebase.den = base::Time::kMicrosecondsPerSecond;
+  config->g_threads = options_.num_threads;
+  // Every frame comes out as soon as it goes in, for the latency.
+  config->g_lag_in_frames = 0;
+  config->g_error_resilient = VPX_ERROR_RESILIENT_DEFAULT;
+  config->rc_end_usage = VPX_CBR;
+  config->rc_target_bitrate = options_.bitrate;
+  config->rc_dropframe_thresh = 0;
+  // Keyframes are forced by |Encode()|.
+  config->kf_mode = VPX_KF_DISABLED;
+
+  if (vpx_codec_enc_init(&context_->codec, iface, config, 0) !=
+      VPX_CODEC_OK) {
+    return VpxError("Failed to initialize the encoder", &context_->codec);
+  }
+  context_->initialized = true;
+  vpx_codec_control(&context_->codec, VP8E_SET_CPUUSED, options_.speed);
+
+  size_ = size;
+  frame_number_ = 0;
+  return Status::OK();
+#else
+  return NoVpxError();
+#endif  // defined(HAS_VPX)
+}
+
+// VideoDecoder ----------------------------------------------------------------
+
+struct VideoDecoder::Context {
+#if defined(HAS_VPX)
+  ~Context() {
+    if (initialized) vpx_codec_destroy(&codec);
+  }
+
+  vpx_codec_ctx_t codec;
+  bool initialized = false;
+#endif  // defined(HAS_VPX)
+};
+
+VideoDecoder::VideoDecoder(int num_threads)
+    : num_threads_(num_threads), context_(std::make_unique<Context>()) {}
+
+VideoDecoder::~VideoDecoder() = default;
+
+Status VideoDecoder::Decode(const VideoFrameMessage& message,
+                            CameraFrame* frame) {
+#if defined(HAS_VPX)
+  if (!context_->initialized) {
+    Status s = Initialize(message.codec());
+    if (!s.ok()) return s;
+  }
+
+  if (!waiting_for_keyframe_ &&
+      message.frame_number() != last_frame_number_ + 1) {
+    waiting_for_keyframe_ = true;
+  }
+  last_frame_number_ = message.frame_number();
+  if (waiting_for_keyframe_ && !message.keyframe()) {
+    return errors::Unavailable("Waiting for a keyframe.");
+  }
+
+  const std::string& data = message.data();
+  if (vpx_codec_decode(&context_->codec,
+                       reinterpret_cast<const uint8_t*>(data.data()),
+                       static_cast<unsigned int>(data.size()), nullptr,
+                       0) != VPX_CODEC_OK) {
+    waiting_for_keyframe_ = true;
+    return VpxError("Failed to decode", &context_->codec);
+  }
+  waiting_for_keyframe_ = false;
+
+  vpx_codec_iter_t iter = nullptr;
+  vpx_image_t* image = vpx_codec_get_frame(&context_->codec, &iter);
+  if (!image) return errors::Unavailable("No frame is decoded.");
+
+  const int width = image->d_w;
+  const int height = image->d_h;
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  CameraFormat camera_format(width, height, PIXEL_FORMAT_I420,
+                             message.camera_format().frame_rate());
+  Data decoded = Data::AllocateFromPool(camera_format.AllocationSize());
+  uint8_t* y = decoded.cast<uint8_t*>();
+  uint8_t* u = y + width * height;
+  uint8_t* v = u + chroma_width * chroma_height;
+  libyuv::I420Copy(image->planes[VPX_PLANE_Y], image->stride[VPX_PLANE_Y],
+                   image->planes[VPX_PLANE_U], image->stride[VPX_PLANE_U],
+                   image->planes[VPX_PLANE_V], image->stride[VPX_PLANE_V], y,
+                   width, u, chroma_width, v, chroma_width, width, height);
+
+  *frame = CameraFrame(std::move(decoded), camera_format,
+                       base::TimeDelta::FromMicroseconds(message.timestamp()));
+  return Status::OK();
+#else
+  return NoVpxError();
+#endif  // defined(HAS_VPX)
+}
+
+Status VideoDecoder::Initialize(VideoCodec codec) {
+#if defined(HAS_VPX)
+  if (codec != VIDEO_CODEC_VP8) {
+    return errors::InvalidArgument(base::StringPrintf(
+        "Unsupported codec: %s.", VideoCodec_Name(codec).c_str()));
+  }
+
+  vpx_codec_dec_cfg_t config = {};
+  config.threads = num_threads_;
+  if (vpx_codec_dec_init(&context_->codec, vpx_codec_vp8_dx(), &config, 0) !=
+      VPX_CODEC_OK) {
+    return VpxError("Failed to initialize the decoder", &context_->codec);
+  }
+  context_->initialized = true;
+  return Status::OK();
+#else
+  return NoVpxError();
+#endif  // defined(HAS_VPX)
+}
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,121 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FELICIA_DRIVERS_CAMERA_VIDEO_CODEC_H_
+#define FELICIA_DRIVERS_CAMERA_VIDEO_CODEC_H_
+
+#include <atomic>
+#include <memory>
+
+#include "third_party/chromium/base/macros.h"
+#include "third_party/chromium/base/time/time.h"
+
+#include "felicia/core/lib/base/export.h"
+#include "felicia/core/lib/error/status.h"
+#include "felicia/core/lib/unit/geometry/size.h"
+#include "felicia/drivers/camera/camera_frame.h"
+#include "felicia/drivers/camera/pixel_format_converter.h"
+#include "felicia/drivers/camera/video_frame_message.pb.h"
+
+namespace felicia {
+namespace drivers {
+
+// Compresses a stream of camera frames into VideoFrameMessage. Unlike
+// CameraFrameEncoder, frames are predicted from the previous ones, which
+// takes a fraction of the bits of MJPEG. VIDEO_CODEC_VP8 by libvpx is
+// supported when it's built with --define has_vpx=true. Otherwise
+// |Encode()| returns errors::Unimplemented.
+//
+// Only keyframes can be decoded alone, so a keyframe is made
+//  - every |keyframe_interval|, for subscribers which lost a frame, e.g,
+//    over UDP.
+//  - on |RequestKeyframe()|, e.g, when a subscriber connects late.
+//
+//   VideoEncoder encoder;
+//   publisher.set_subscriber_connected_callback(base::BindRepeating(
+//       &VideoEncoder::RequestKeyframe, base::Unretained(&encoder)));
+//   ...
+//   void OnCameraFrame(CameraFrame&& frame) {
+//     VideoFrameMessage message;
+//     if (encoder.Encode(frame, &message).ok()) publisher.Publish(message);
+//   }
+//
+// Frames which aren't I420 are converted to I420 first. But
+// |RequestKeyframe()|, it's not thread safe.
+class FEL_EXPORT VideoEncoder {
+ public:
+  struct Options {
+    VideoCodec codec = VIDEO_CODEC_VP8;
+    // Target bitrate in kbps.
+    int bitrate = 1000;
+    base::TimeDelta keyframe_interval = base::TimeDelta::FromSeconds(3);
+    // From -16 to 16. The larger the absolute value, the faster and the
+    // worse. -6 is what WebRTC uses for realtime.
+    int speed = -6;
+    int num_threads = 1;
+  };
+
+  VideoEncoder();
+  explicit VideoEncoder(const Options& options);
+  ~VideoEncoder();
+
+  const Options& options() const { return options_; }
+
+  // The next frame is encoded as a keyframe. It's thread safe.
+  void RequestKeyframe();
+
+  // Overwrites |message| with |frame|. The encoder starts over when the size
+  // of frames changes.
+  Status Encode(const CameraFrame& frame, VideoFrameMessage* message);
+
+ private:
+  struct Context;
+
+  Status Initialize(const Sizei& size);
+
+  Options options_;
+  std::unique_ptr<Context> context_;
+  // The size the encoder is initialized with.
+  Sizei size_;
+  std::atomic<bool> keyframe_requested_;
+  base::TimeDelta last_keyframe_timestamp_;
+  int64_t last_pts_ = -1;
+  uint64_t frame_number_ = 0;
+  PixelFormatConverter pixel_format_converter_;
+
+  DISALLOW_COPY_AND_ASSIGN(VideoEncoder);
+};
+
+// Decodes VideoFrameMessage from VideoEncoder into CameraFrame of
+// PIXEL_FORMAT_I420. A frame after a lost one would be decoded broken, so
+// frames are skipped with errors::Unavailable until the next keyframe.
+//
+// It's not thread safe.
+class FEL_EXPORT VideoDecoder {
+ public:
+  explicit VideoDecoder(int num_threads = 1);
+  ~VideoDecoder();
+
+  // True until a keyframe is decoded, and again once a frame is lost.
+  bool waiting_for_keyframe() const { return waiting_for_keyframe_; }
+
+  Status Decode(const VideoFrameMessage& message, CameraFrame* frame);
+
+ private:
+  struct Context;
+
+  Status Initialize(VideoCodec codec);
+
+  int num_threads_;
+  std::unique_ptr<Context> context_;
+  bool waiting_for_keyframe_ = true;
+  uint64_t last_frame_number_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(VideoDecoder);
+};
+
+}  // namespace drivers
+}  // namespace felicia
+
+#endif  // FELICIA_DRIVERS_CAMERA_VIDEO_CODEC_H_
\ No newline at end of file
@@ -0,0 +1,202 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/video_codec.h"
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "third_party/chromium/base/files/file_path.h"
+#include "third_party/chromium/base/logging.h"
+#include "third_party/chromium/base/no_destructor.h"
+
+#include "felicia/core/bag/bag_reader.h"
+#include "felicia/drivers/camera/camera_frame_encoder.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr const char* kCameraFrameMessageTypeName =
+    "felicia.drivers.CameraFrameMessage";
+constexpr int kSyntheticFrames = 90;
+constexpr float kSyntheticFrameRate = 30;
+
+// Frames of the first camera topic in the bag at FEL_VIDEO_BENCHMARK_BAG.
+std::vector<CameraFrame> ReadFramesFromBag(const char* path) {
+  BagReader reader;
+  CHECK(reader.Open(base::FilePath::FromUTF8Unsafe(path)).ok());
+  uint32_t connection_id = 0;
+  bool found = false;
+  for (const BagConnection& connection : reader.connections()) {
+    if (connection.type_name() == kCameraFrameMessageTypeName) {
+      connection_id = connection.id();
+      found = true;
+      break;
+    }
+  }
+  CHECK(found) << "No " << kCameraFrameMessageTypeName << " in " << path;
+
+  std::vector<CameraFrame> frames;
+  for (size_t i = 0; i < reader.size(); ++i) {
+    BagReader::Message message;
+    CHECK(reader.ReadMessage(i, &message).ok());
+    if (message.connection_id != connection_id) continue;
+    CameraFrameMessage camera_frame_message;
+    CHECK(camera_frame_message.ParseFromArray(message.data->front(),
+                                              message.data->size()));
+    CameraFrame frame;
+    CHECK(frame.FromCameraFrameMessage(std::move(camera_frame_message)).ok());
+    frames.push_back(std::move(frame));
+  }
+  return frames;
+}
+
+// A textured 720p scene panning by 4 pixels a frame, with a bit of noise
+// like a sensor.
+std::vector<CameraFrame> MakeSyntheticFrames() {
+  const int width = 1280;
+  const int height = 720;
+  CameraFormat camera_format(width, height, PIXEL_FORMAT_I420,
+                             kSyntheticFrameRate);
+  const int chroma_width = width / 2;
+  const int chroma_height = height / 2;
+
+  std::vector<CameraFrame> frames;
+  uint32_t seed = 1;
+  for (int i = 0; i < kSyntheticFrames; ++i) {
+    std::string data(camera_format.AllocationSize(), 0);
+    const int shift = 4 * i;
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        const int sx = x + shift;
+        seed = seed * 1103515245 + 12345;
+        data[y * width + x] = static_cast<char>(
+            ((sx / 32 + y / 32) % 2 ? 160 : 64) + (sx * y) % 23 +
+            static_cast<int>((seed >> 16) % 5));
+      }
+    }
+    for (int y = 0; y < chroma_height; ++y) {
+      for (int x = 0; x < chroma_width; ++x) {
+        const int sx = x + shift / 2;
+        data[width * height + y * chroma_width + x] =
+            static_cast<char>(128 + (sx / 64) % 4 * 16);
+        data[width * height + chroma_width * chroma_height +
+             y * chroma_width + x] = static_cast<char>(128 - (y / 64) * 8);
+      }
+    }
+    frames.emplace_back(
+        Data(std::move(data)), camera_format,
+        base::TimeDelta::FromSecondsD(i / kSyntheticFrameRate));
+  }
+  return frames;
+}
+
+const std::vector<CameraFrame>& GetFrames() {
+  static base::NoDestructor<std::vector<CameraFrame>> frames([]() {
+    const char* path = getenv("FEL_VIDEO_BENCHMARK_BAG");
+    return path ? ReadFramesFromBag(path) : MakeSyntheticFrames();
+  }());
+  return *frames;
+}
+
+// |bitrate| is what's actually sent in kbps, and |raw_bitrate| is that of
+// the frames as they are.
+void SetCounters(benchmark::State& state, const CameraFrame& frame,
+                 int64_t frames, int64_t bytes) {
+  state.SetItemsProcessed(frames);
+  const float frame_rate =
+      frame.frame_rate() > 0 ? frame.frame_rate() : kSyntheticFrameRate;
+  const double seconds = frames / frame_rate;
+  state.counters["bitrate"] = bytes * 8 / seconds / 1000;
+  state.counters["raw_bitrate"] =
+      frame.length() * frames * 8 / seconds / 1000;
+}
+
+}  // namespace
+
+// Encodes the sequence at |state.range(0)| kbps. The time per frame is the
+// latency the encoder adds.
+static void BM_EncodeVP8(benchmark::State& state) {
+  const std::vector<CameraFrame>& frames = GetFrames();
+  VideoEncoder::Options options;
+  options.bitrate = state.range(0);
+  VideoEncoder encoder(options);
+
+  VideoFrameMessage message;
+  int64_t num_frames = 0;
+  int64_t bytes = 0;
+  int64_t keyframes = 0;
+  for (auto _ : state) {
+    const CameraFrame& frame = frames[num_frames % frames.size()];
+    Status s = encoder.Encode(frame, &message);
+    if (!s.ok()) {
+      state.SkipWithError(s.error_message().c_str());
+      break;
+    }
+    bytes += message.data().size();
+    keyframes += message.keyframe();
+    ++num_frames;
+  }
+  if (num_frames == 0) return;
+  SetCounters(state, frames[0], num_frames, bytes);
+  state.counters["keyframes"] = keyframes;
+}
+
+// Decodes the sequence encoded at |state.range(0)| kbps.
+static void BM_DecodeVP8(benchmark::State& state) {
+  const std::vector<CameraFrame>& frames = GetFrames();
+  VideoEncoder::Options options;
+  options.bitrate = state.range(0);
+  VideoEncoder encoder(options);
+  std::vector<VideoFrameMessage> messages(frames.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    Status s = encoder.Encode(frames[i], &messages[i]);
+    if (!s.ok()) {
+      state.SkipWithError(s.error_message().c_str());
+      return;
+    }
+  }
+
+  VideoDecoder decoder;
+  CameraFrame frame;
+  size_t i = 0;
+  for (auto _ : state) {
+    // The sequence starts over with a keyframe.
+    CHECK(decoder.Decode(messages[i], &frame).ok());
+    i = (i + 1) % messages.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Same as BM_EncodeVP8, but each frame is a JPEG.
+static void BM_EncodeMJPEG(benchmark::State& state) {
+  const std::vector<CameraFrame>& frames = GetFrames();
+  CameraFrameEncoder encoder(CameraFrameEncoder::COMPRESSION_MJPEG);
+
+  CameraFrameMessage message;
+  int64_t num_frames = 0;
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    const CameraFrame& frame = frames[num_frames % frames.size()];
+    CHECK(encoder.Encode(frame, &message).ok());
+    bytes += message.data().size();
+    ++num_frames;
+  }
+  SetCounters(state, frames[0], num_frames, bytes);
+}
+
+BENCHMARK(BM_EncodeVP8)
+    ->Arg(500)
+    ->Arg(1000)
+    ->Arg(2000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DecodeVP8)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EncodeMJPEG)->Unit(benchmark::kMillisecond);
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
@@ -0,0 +1,198 @@
+// Copyright (c) 2019 The Felicia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "felicia/drivers/camera/video_codec.h"
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "felicia/core/lib/error/errors.h"
+
+namespace felicia {
+namespace drivers {
+
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+constexpr float kFrameRate = 30;
+
+// Mean absolute difference of the luma after a lossy round trip.
+constexpr double kMaxMeanDiff = 4.0;
+
+base::TimeDelta TimestampAt(int index) {
+  return base::TimeDelta::FromMilliseconds(33 * index);
+}
+
+// A smooth I420 frame of |size|, panning by 2 pixels every |index|.
+CameraFrame MakeFrame(const Sizei& size, int index) {
+  const int width = size.width();
+  const int height = size.height();
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  std::string i420;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      i420.push_back(static_cast<char>(32 + (x + index * 2) * 2 + y));
+    }
+  }
+  for (int plane = 0; plane < 2; ++plane) {
+    for (int y = 0; y < chroma_height; ++y) {
+      for (int x = 0; x < chroma_width; ++x) {
+        i420.push_back(static_cast<char>(plane == 0 ? 96 + x : 160 - y));
+      }
+    }
+  }
+  return CameraFrame(Data(std::move(i420)),
+                     CameraFormat(size, PIXEL_FORMAT_I420, kFrameRate),
+                     TimestampAt(index));
+}
+
+#if defined(HAS_VPX)
+double MeanLumaDiff(const CameraFrame& expected, const CameraFrame& actual) {
+  const int area = expected.width() * expected.height();
+  const uint8_t* a = expected.raw_data();
+  const uint8_t* b = actual.raw_data();
+  double total_diff = 0;
+  for (int i = 0; i < area; ++i) {
+    total_diff += std::abs(static_cast<int>(a[i]) - b[i]);
+  }
+  return total_diff / area;
+}
+#endif  // defined(HAS_VPX)
+
+}  // namespace
+
+#if defined(HAS_VPX)
+
+TEST(VideoCodecTest, RoundTrip) {
+  const Sizei size(kWidth, kHeight);
+  VideoEncoder encoder;
+  VideoDecoder decoder;
+  EXPECT_TRUE(decoder.waiting_for_keyframe());
+  for (int i = 0; i < 10; ++i) {
+    SCOPED_TRACE(i);
+    CameraFrame frame = MakeFrame(size, i);
+    VideoFrameMessage message;
+    ASSERT_TRUE(encoder.Encode(frame, &message).ok());
+    EXPECT_EQ(VIDEO_CODEC_VP8, message.codec());
+    // Only the first frame is a keyframe, since the default interval is
+    // longer than the frames.
+    EXPECT_EQ(i == 0, message.keyframe());
+    EXPECT_EQ(static_cast<uint64_t>(i), message.frame_number());
+    EXPECT_GT(frame.length(), message.data().size());
+
+    CameraFrame decoded;
+    ASSERT_TRUE(decoder.Decode(message, &decoded).ok());
+    EXPECT_FALSE(decoder.waiting_for_keyframe());
+    EXPECT_EQ(PIXEL_FORMAT_I420, decoded.pixel_format());
+    EXPECT_EQ(size, Sizei(decoded.width(), decoded.height()));
+    EXPECT_EQ(kFrameRate, decoded.frame_rate());
+    EXPECT_EQ(frame.timestamp(), decoded.timestamp());
+    ASSERT_EQ(frame.length(), decoded.length());
+    EXPECT_GT(kMaxMeanDiff, MeanLumaDiff(frame, decoded));
+  }
+}
+
+TEST(VideoCodecTest, Keyframes) {
+  const Sizei size(kWidth, kHeight);
+  VideoEncoder::Options options;
+  options.keyframe_interval = base::TimeDelta::FromMilliseconds(100);
+  VideoEncoder encoder(options);
+
+  // The frames are 33ms apart, so the interval makes frames 4 and 8
+  // keyframes, and the request makes frame 10 one.
+  std::vector<int> keyframes;
+  for (int i = 0; i < 12; ++i) {
+    if (i == 10) encoder.RequestKeyframe();
+    VideoFrameMessage message;
+    ASSERT_TRUE(encoder.Encode(MakeFrame(size, i), &message).ok());
+    if (message.keyframe()) keyframes.push_back(i);
+  }
+  EXPECT_EQ(std::vector<int>({0, 4, 8, 10}), keyframes);
+}
+
+TEST(VideoCodecTest, WaitForKeyframeAfterLostFrame) {
+  const Sizei size(kWidth, kHeight);
+  VideoEncoder encoder;
+  std::vector<VideoFrameMessage> messages(8);
+  for (int i = 0; i < 8; ++i) {
+    // A subscriber asks for a keyframe after it lost a frame.
+    if (i == 5) encoder.RequestKeyframe();
+    ASSERT_TRUE(encoder.Encode(MakeFrame(size, i), &messages[i]).ok());
+  }
+  ASSERT_TRUE(messages[0].keyframe());
+  ASSERT_TRUE(messages[5].keyframe());
+
+  CameraFrame decoded;
+  {
+    // A subscriber which joins late skips the frames until a keyframe.
+    VideoDecoder decoder;
+    EXPECT_TRUE(errors::IsUnavailable(decoder.Decode(messages[1], &decoded)));
+    EXPECT_TRUE(decoder.waiting_for_keyframe());
+    EXPECT_TRUE(decoder.Decode(messages[5], &decoded).ok());
+  }
+
+  VideoDecoder decoder;
+  EXPECT_TRUE(decoder.Decode(messages[0], &decoded).ok());
+  EXPECT_TRUE(decoder.Decode(messages[1], &decoded).ok());
+  // The 3rd frame is lost.
+  EXPECT_TRUE(errors::IsUnavailable(decoder.Decode(messages[3], &decoded)));
+  EXPECT_TRUE(decoder.waiting_for_keyframe());
+  EXPECT_TRUE(errors::IsUnavailable(decoder.Decode(messages[4], &decoded)));
+  EXPECT_TRUE(decoder.waiting_for_keyframe());
+
+  // It resumes from the keyframe.
+  ASSERT_TRUE(decoder.Decode(messages[5], &decoded).ok());
+  EXPECT_FALSE(decoder.waiting_for_keyframe());
+  EXPECT_EQ(TimestampAt(5), decoded.timestamp());
+  EXPECT_GT(kMaxMeanDiff, MeanLumaDiff(MakeFrame(size, 5), decoded));
+  EXPECT_TRUE(decoder.Decode(messages[6], &decoded).ok());
+  EXPECT_TRUE(decoder.Decode(messages[7], &decoded).ok());
+}
+
+TEST(VideoCodecTest, SizeChange) {
+  VideoEncoder encoder;
+  VideoDecoder decoder;
+  const Sizei sizes[] = {Sizei(kWidth, kHeight), Sizei(kWidth / 2, 30)};
+  int index = 0;
+  for (const Sizei& size : sizes) {
+    SCOPED_TRACE(size.ToString());
+    for (int i = 0; i < 3; ++i, ++index) {
+      CameraFrame frame = MakeFrame(size, index);
+      VideoFrameMessage message;
+      ASSERT_TRUE(encoder.Encode(frame, &message).ok());
+      // The encoder starts over with a keyframe.
+      EXPECT_EQ(i == 0, message.keyframe());
+      EXPECT_EQ(static_cast<uint64_t>(i), message.frame_number());
+
+      CameraFrame decoded;
+      ASSERT_TRUE(decoder.Decode(message, &decoded).ok());
+      EXPECT_EQ(size, Sizei(decoded.width(), decoded.height()));
+      ASSERT_EQ(frame.length(), decoded.length());
+      EXPECT_GT(kMaxMeanDiff, MeanLumaDiff(frame, decoded));
+    }
+  }
+}
+
+#else
+
+TEST(VideoCodecTest, Unimplemented) {
+  VideoEncoder encoder;
+  VideoFrameMessage message;
+  EXPECT_TRUE(errors::IsUnimplemented(
+      encoder.Encode(MakeFrame(Sizei(kWidth, kHeight), 0), &message)));
+
+  VideoDecoder decoder;
+  CameraFrame decoded;
+  EXPECT_TRUE(errors::IsUnimplemented(decoder.Decode(message, &decoded)));
+}
+
+#endif  // defined(HAS_VPX)
+
+}  // namespace drivers
+}  // namespace felicia
\ No newline at end of file
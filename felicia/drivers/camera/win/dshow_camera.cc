@@ -506,12 +506,12 @@ void DshowCamera::FrameReceived(const uint8_t* buffer, int length,
   // timestamp.
   if (timestamp == kNoTimestamp) timestamp = timestamper_.timestamp();
 
-  if (requested_pixel_format_ == camera_format_.pixel_format()) {
-    Data data(buffer, length);
+  if (!NeedsConversion()) {
+    Data data = Data::CopyFromPool(buffer, length);
     camera_frame_callback_.Run(
         CameraFrame{std::move(data), camera_format_, timestamp});
   } else {
-    base::Optional<CameraFrame> camera_frame = ConvertToRequestedPixelFormat(
+    base::Optional<CameraFrame> camera_frame = pixel_format_converter_.Convert(
         buffer, length, camera_format_, requested_pixel_format_, timestamp);
     if (camera_frame.has_value()) {
       camera_frame_callback_.Run(std::move(camera_frame.value()));
@@ -783,12 +783,12 @@ void MfCamera::OnIncomingCapturedData(const uint8_t* data, int length,
     return;
   }
 
-  if (requested_pixel_format_ == camera_format_.pixel_format()) {
-    Data new_data(data, length);
+  if (!NeedsConversion()) {
+    Data new_data = Data::CopyFromPool(data, length);
     camera_frame_callback_.Run(
         CameraFrame{std::move(new_data), camera_format_, timestamp});
   } else {
-    base::Optional<CameraFrame> camera_frame = ConvertToRequestedPixelFormat(
+    base::Optional<CameraFrame> camera_frame = pixel_format_converter_.Convert(
         data, length, camera_format_, requested_pixel_format_, timestamp);
     if (camera_frame.has_value()) {
       camera_frame_callback_.Run(std::move(camera_frame.value()));
@@ -71,10 +71,26 @@ ImuFrameMessage ImuFrame::ToImuFrameMessage() const {
 Status ImuFrame::FromImuFrameMessage(const ImuFrameMessage& message) {
   *this = ImuFrame{QuaternionfMessageToQuaternionf(message.orientation()),
                    Vector3fMessageToVector3f(message.angular_velocity()),
-                   Vector3fMessageToVector3f(message.angular_velocity()),
+                   Vector3fMessageToVector3f(message.linear_acceleration()),
                    base::TimeDelta::FromMicroseconds(message.timestamp())};
   return Status::OK();
 }
 
+ImuFrame InterpolateImuFrame(const ImuFrame& before, const ImuFrame& after,
+                             base::TimeDelta timestamp) {
+  base::TimeDelta duration = after.timestamp() - before.timestamp();
+  if (duration.is_zero()) return before;
+  double t = (timestamp - before.timestamp()).InMicrosecondsF() /
+             duration.InMicrosecondsF();
+
+  return ImuFrame{
+      before.orientation().Slerp(after.orientation(), t),
+      before.angular_velocity() +
+          (after.angular_velocity() - before.angular_velocity()) * t,
+      before.linear_acceleration() +
+          (after.linear_acceleration() - before.linear_acceleration()) * t,
+      timestamp};
+}
+
 }  // namespace drivers
 }  // namespace felicia
\ No newline at end of file
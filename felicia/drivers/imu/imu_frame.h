@@ -47,6 +47,14 @@ class FEL_EXPORT ImuFrame {
   base::TimeDelta timestamp_;
 };
 
+// Returns the frame at |timestamp|, which is in between the timestamps of
+// |before| and |after|. The orientation is slerped, and the others are
+// interpolated linearly. It can be bound to the interpolate callback of
+// InterpolatingSynchronizer.
+FEL_EXPORT ImuFrame InterpolateImuFrame(const ImuFrame& before,
+                                        const ImuFrame& after,
+                                        base::TimeDelta timestamp);
+
 typedef base::RepeatingCallback<void(const ImuFrame&)> ImuFrameCallback;
 
 }  // namespace drivers
@@ -25,6 +25,7 @@ void AddCommunication(py::module& m) {
       .def_readwrite("is_dynamic_buffer",
                      &communication::Settings::is_dynamic_buffer)
       .def_readwrite("queue_size", &communication::Settings::queue_size)
+      .def_readwrite("use_checksum", &communication::Settings::use_checksum)
       .def_readwrite("channel_settings",
                      &communication::Settings::channel_settings);
 
@@ -6,6 +6,7 @@
 
 #include "felicia/python/communication/serialized_message_publisher_py.h"
 
+#include "felicia/core/lib/error/errors.h"
 #include "felicia/python/message/message_util.h"
 #include "felicia/python/type_conversion/callback.h"
 #include "felicia/python/type_conversion/protobuf.h"
@@ -14,6 +15,46 @@ namespace felicia {
 
 using PySendMessageCallback = PyCallback<void(ChannelDef::Type, Status)>;
 
+namespace {
+
+// Refers to the memory of a python object which supports the buffer protocol,
+// such as bytes or numpy array, keeping the object alive.
+class PyBufferMemory : public base::RefCountedMemory {
+ public:
+  PyBufferMemory(py::buffer buffer, std::unique_ptr<py::buffer_info> info)
+      : buffer_(std::move(buffer)), info_(std::move(info)) {}
+
+  const unsigned char* front() const override {
+    return static_cast<const unsigned char*>(info_->ptr);
+  }
+  size_t size() const override { return info_->size * info_->itemsize; }
+
+ private:
+  ~PyBufferMemory() override {
+    // The last reference is usually dropped on the main thread after the
+    // message is sent, which doesn't hold the GIL.
+    py::gil_scoped_acquire acquire;
+    info_.reset();
+    buffer_ = py::buffer();
+  }
+
+  py::buffer buffer_;
+  std::unique_ptr<py::buffer_info> info_;
+
+  DISALLOW_COPY_AND_ASSIGN(PyBufferMemory);
+};
+
+bool IsCContiguous(const py::buffer_info& info) {
+  ssize_t stride = info.itemsize;
+  for (ssize_t i = info.ndim - 1; i >= 0; --i) {
+    if (info.shape[i] != 1 && info.strides[i] != stride) return false;
+    stride *= info.shape[i];
+  }
+  return true;
+}
+
+}  // namespace
+
 PySerializedMessagePublisher::PySerializedMessagePublisher(
     py::object message_type, TopicInfo::ImplType impl_type) {
 #if defined(HAS_ROS)
@@ -55,6 +96,27 @@ void PySerializedMessagePublisher::RequestUnpublish(const NodeInfo& node_info,
 
 void PySerializedMessagePublisher::PublishFromSerialized(
     py::object message, py::function py_callback) {
+  // An object which supports the buffer protocol is regarded as a message
+  // serialized already, and it is published without copying.
+  if (py::isinstance<py::buffer>(message)) {
+    py::buffer buffer = py::reinterpret_borrow<py::buffer>(message);
+    auto info = std::make_unique<py::buffer_info>(buffer.request());
+    if (!IsCContiguous(*info)) {
+      py_callback(ChannelDef::CHANNEL_TYPE_NONE,
+                  errors::InvalidArgument("buffer is not contiguous."));
+      return;
+    }
+    scoped_refptr<base::RefCountedMemory> memory =
+        base::MakeRefCounted<PyBufferMemory>(std::move(buffer),
+                                             std::move(info));
+    SendMessageCallback callback = MakeSendMessageCallback(py_callback);
+
+    py::gil_scoped_release release;
+    SerializedMessagePublisher::PublishFromSerialized(std::move(memory),
+                                                      callback);
+    return;
+  }
+
   std::string text;
   Status s = Serialize(message, impl_type_, &text);
   if (!s.ok()) {
@@ -62,16 +124,21 @@ void PySerializedMessagePublisher::PublishFromSerialized(
     return;
   }
 
+  SendMessageCallback callback = MakeSendMessageCallback(py_callback);
+
   py::gil_scoped_release release;
-  SendMessageCallback callback;
-  if (!py_callback.is_none()) {
-    callback = base::BindRepeating(
-        &PySendMessageCallback::Invoke,
-        base::Owned(new PySendMessageCallback(py_callback)));
-  }
   SerializedMessagePublisher::PublishFromSerialized(std::move(text), callback);
 }
 
+// static
+SendMessageCallback PySerializedMessagePublisher::MakeSendMessageCallback(
+    py::function py_callback) {
+  if (py_callback.is_none()) return SendMessageCallback();
+  return base::BindRepeating(
+      &PySendMessageCallback::Invoke,
+      base::Owned(new PySendMessageCallback(py_callback)));
+}
+
 void AddSerializedMessagePublisher(py::module& m) {
   py::class_<PySerializedMessagePublisher>(m, "Publisher")
       .def(py::init<py::object, TopicInfo::ImplType>(), py::arg("message_type"),
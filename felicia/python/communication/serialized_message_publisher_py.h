@@ -29,8 +29,14 @@ class PySerializedMessagePublisher : public SerializedMessagePublisher {
   void RequestUnpublish(const NodeInfo& node_info, const std::string& topic,
                         py::function py_callback = py::none());
 
+  // |message| is either a message of |message_type| or a bytes-like object,
+  // e.g, bytes or numpy array, which holds a serialized message. The latter
+  // is published without copying, so it must not be modified until sent.
   void PublishFromSerialized(py::object message,
                              py::function py_callback = py::none());
+
+ private:
+  static SendMessageCallback MakeSendMessageCallback(py::function py_callback);
 };
 
 void AddSerializedMessagePublisher(py::module& m);
@@ -23,11 +23,9 @@ class PyMessageCallback {
         callback_(callback) {}
 
   void Invoke(SerializedMessage&& message) {
-    std::string text = std::move(message).serialized();
-
     py::gil_scoped_acquire acquire;
     py::object py_message = message_type_();
-    Status s = Deserialize(text, impl_type_, &py_message);
+    Status s = Deserialize(message.serialized(), impl_type_, &py_message);
     if (!s.ok()) {
       return;
     }
@@ -35,16 +35,16 @@ Status Serialize(const py::object& message, TopicInfo::ImplType impl_type,
   return Status::OK();
 }
 
-Status Deserialize(const std::string& text, TopicInfo::ImplType impl_type,
+Status Deserialize(base::StringPiece text, TopicInfo::ImplType impl_type,
                    py::object* message) {
   try {
     switch (impl_type) {
       case TopicInfo::PROTOBUF: {
-        message->attr("ParseFromString")(py::bytes(text));
+        message->attr("ParseFromString")(py::bytes(text.data(), text.size()));
         break;
       }
       case TopicInfo::ROS: {
-        message->attr("deserialize")(py::bytes(text));
+        message->attr("deserialize")(py::bytes(text.data(), text.size()));
         break;
       }
       case TopicInfo_ImplType_TopicInfo_ImplType_INT_MIN_SENTINEL_DO_NOT_USE_:
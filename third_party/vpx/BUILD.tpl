@@ -0,0 +1,11 @@
+package(default_visibility = ["//visibility:public"])
+
+cc_library(
+    name = "vpx",
+    defines = [
+        "HAS_VPX",
+    ],
+    linkopts = [
+        "-lvpx",
+    ],
+)
@@ -0,0 +1,20 @@
+def _vpx_configure_impl(repository_ctx):
+    repository_ctx.template(
+        "BUILD",
+        Label("//third_party/vpx:BUILD.tpl"),
+        {},
+    )
+
+vpx_configure = repository_rule(
+    implementation = _vpx_configure_impl,
+)
+"""Detects and configure the libvpx header and library
+
+Add the following to your WORKSPACE FILE:
+
+```python
+vpx_configure(name = "local_config_vpx")
+```
+Args:
+    name: A unique name for the workspace rule.
+"""